@@ -97,11 +97,13 @@
 #define FILE_SHARE_READ ...
 #define FILE_SHARE_WRITE ...
 #define FILE_ATTRIBUTE_ARCHIVE ...
+#define FILE_ATTRIBUTE_DIRECTORY ...
 #define FILE_ATTRIBUTE_ENCRYPTED ...
 #define FILE_ATTRIBUTE_HIDDEN ...
 #define FILE_ATTRIBUTE_NORMAL ...
 #define FILE_ATTRIBUTE_OFFLINE ...
 #define FILE_ATTRIBUTE_READONLY ...
+#define FILE_ATTRIBUTE_REPARSE_POINT ...
 #define FILE_ATTRIBUTE_SYSTEM ...
 #define FILE_ATTRIBUTE_TEMPORARY ...
 #define FILE_FLAG_BACKUP_SEMANTICS ...
@@ -121,6 +123,11 @@
 #define OPEN_EXISTING ...
 #define TRUNCATE_EXISTING ...
 
+// Flags for SetFilePointerEx
+#define FILE_BEGIN ...
+#define FILE_CURRENT ...
+#define FILE_END ...
+
 // Flags for pywincffi.kernel32.pipe (may be shared with other modules too)
 #define PIPE_TYPE_MESSAGE ...
 #define PIPE_READMODE_BYTE ...
@@ -146,6 +153,88 @@
 #define MOVEFILE_REPLACE_EXISTING ...
 #define MOVEFILE_WRITE_THROUGH ...
 
+// File mapping
+// https://msdn.microsoft.com/en-us/library/aa366537
+#define PAGE_READONLY ...
+#define PAGE_READWRITE ...
+#define PAGE_WRITECOPY ...
+#define PAGE_EXECUTE_READ ...
+#define PAGE_EXECUTE_READWRITE ...
+#define PAGE_EXECUTE_WRITECOPY ...
+#define SEC_COMMIT ...
+#define SEC_IMAGE ...
+#define SEC_LARGE_PAGES ...
+#define SEC_NOCACHE ...
+#define SEC_RESERVE ...
+#define SEC_WRITECOMBINE ...
+#define FILE_MAP_ALL_ACCESS ...
+#define FILE_MAP_COPY ...
+#define FILE_MAP_EXECUTE ...
+#define FILE_MAP_READ ...
+#define FILE_MAP_WRITE ...
+
+// Virtual memory
+// https://msdn.microsoft.com/en-us/library/aa366887
+#define MEM_COMMIT ...
+#define MEM_RESERVE ...
+#define MEM_DECOMMIT ...
+#define MEM_RELEASE ...
+
+// Directory enumeration
+// https://msdn.microsoft.com/en-us/library/aa364419
+// https://msdn.microsoft.com/en-us/library/aa364953
+#define FindExInfoStandard ...
+#define FindExInfoBasic ...
+#define FindExSearchNameMatch ...
+#define FindExSearchLimitToDirectories ...
+#define FIND_FIRST_EX_CASE_SENSITIVE ...
+#define FIND_FIRST_EX_LARGE_FETCH ...
+#define FileIdBothDirectoryInfo ...
+#define FileIdBothDirectoryRestartInfo ...
+
+// File allocation and sparse files
+// https://msdn.microsoft.com/en-us/library/aa365539
+// https://msdn.microsoft.com/en-us/library/aa364596
+// https://msdn.microsoft.com/en-us/library/aa364597
+#define FileAllocationInfo ...
+#define FileEndOfFileInfo ...
+#define FSCTL_SET_SPARSE ...
+#define FSCTL_SET_ZERO_DATA ...
+
+// Directory change notifications
+// https://msdn.microsoft.com/en-us/library/aa365465
+// https://msdn.microsoft.com/en-us/library/aa364391
+#define FILE_NOTIFY_CHANGE_FILE_NAME ...
+#define FILE_NOTIFY_CHANGE_DIR_NAME ...
+#define FILE_NOTIFY_CHANGE_ATTRIBUTES ...
+#define FILE_NOTIFY_CHANGE_SIZE ...
+#define FILE_NOTIFY_CHANGE_LAST_WRITE ...
+#define FILE_NOTIFY_CHANGE_LAST_ACCESS ...
+#define FILE_NOTIFY_CHANGE_CREATION ...
+#define FILE_NOTIFY_CHANGE_SECURITY ...
+#define FILE_ACTION_ADDED ...
+#define FILE_ACTION_REMOVED ...
+#define FILE_ACTION_MODIFIED ...
+#define FILE_ACTION_RENAMED_OLD_NAME ...
+#define FILE_ACTION_RENAMED_NEW_NAME ...
+
+// Flags for CopyFileEx
+// https://msdn.microsoft.com/en-us/library/aa363852
+#define COPY_FILE_ALLOW_DECRYPTED_DESTINATION ...
+#define COPY_FILE_FAIL_IF_EXISTS ...
+#define COPY_FILE_NO_BUFFERING ...
+#define COPY_FILE_OPEN_SOURCE_FOR_WRITE ...
+#define COPY_FILE_RESTARTABLE ...
+
+// Return values and reasons for LPPROGRESS_ROUTINE
+// https://msdn.microsoft.com/en-us/library/aa363854
+#define PROGRESS_CANCEL ...
+#define PROGRESS_CONTINUE ...
+#define PROGRESS_QUIET ...
+#define PROGRESS_STOP ...
+#define CALLBACK_CHUNK_FINISHED ...
+#define CALLBACK_STREAM_SWITCH ...
+
 // Flags for LockFileEx
 #define LOCKFILE_EXCLUSIVE_LOCK ...
 #define LOCKFILE_FAIL_IMMEDIATELY ...
@@ -174,7 +263,21 @@
 #define ERROR_FILE_NOT_FOUND ...
 #define ERROR_PATH_NOT_FOUND ...
 #define ERROR_IO_PENDING ...
+#define ERROR_HANDLE_EOF ...
+#define ERROR_NO_MORE_FILES ...
+#define ERROR_BROKEN_PIPE ...
 #define ERROR_BAD_EXE_FORMAT ...
+#define ERROR_REQUEST_ABORTED ...
+#define ERROR_OPERATION_ABORTED ...
+#define ERROR_NOT_FOUND ...
+#define ERROR_NOTIFY_ENUM_DIR ...
+#define ERROR_DISK_FULL ...
+#define ERROR_WRITE_FAULT ...
+#define ERROR_LOCK_VIOLATION ...
+#define ERROR_NOT_SUPPORTED ...
+#define ERROR_NOT_OWNER ...
+#define ERROR_TOO_MANY_POSTS ...
+#define ERROR_TIMEOUT ...
 
 // Events
 #define DELETE ...
@@ -187,10 +290,21 @@
 #define MUTEX_MODIFY_STATE ...
 #define SEMAPHORE_ALL_ACCESS ...
 #define SEMAPHORE_MODIFY_STATE ...
+#define CREATE_MUTEX_INITIAL_OWNER ...
+#define CONDITION_VARIABLE_LOCKMODE_SHARED ...
 #define TIMER_ALL_ACCESS ...
 #define TIMER_MODIFY_STATE ...
 #define TIMER_QUERY_STATE ...
 
+// Waitable timers and timer queues
+#define CREATE_WAITABLE_TIMER_MANUAL_RESET ...
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION ...
+#define WT_EXECUTEDEFAULT ...
+#define WT_EXECUTEINTIMERTHREAD ...
+#define WT_EXECUTEINPERSISTENTTHREAD ...
+#define WT_EXECUTELONGFUNCTION ...
+#define WT_EXECUTEONLYONCE ...
+
 // STARTUPINFO
 // https://msdn.microsoft.com/en-us/library/ms686331
 #define STARTF_FORCEONFEEDBACK ...
@@ -221,6 +335,40 @@
 #define CE_PTO ...
 #define CE_TXFULL ...
 
+// SetCommMask and WaitCommEvent
+#define EV_BREAK ...
+#define EV_CTS ...
+#define EV_DSR ...
+#define EV_ERR ...
+#define EV_RING ...
+#define EV_RLSD ...
+#define EV_RXCHAR ...
+#define EV_RXFLAG ...
+#define EV_TXEMPTY ...
+
+// PurgeComm
+#define PURGE_RXABORT ...
+#define PURGE_RXCLEAR ...
+#define PURGE_TXABORT ...
+#define PURGE_TXCLEAR ...
+
+// DCB
+#define NOPARITY ...
+#define ODDPARITY ...
+#define EVENPARITY ...
+#define MARKPARITY ...
+#define SPACEPARITY ...
+#define ONESTOPBIT ...
+#define ONE5STOPBITS ...
+#define TWOSTOPBITS ...
+#define DTR_CONTROL_DISABLE ...
+#define DTR_CONTROL_ENABLE ...
+#define DTR_CONTROL_HANDSHAKE ...
+#define RTS_CONTROL_DISABLE ...
+#define RTS_CONTROL_ENABLE ...
+#define RTS_CONTROL_HANDSHAKE ...
+#define RTS_CONTROL_TOGGLE ...
+
 // MsgWaitForMultipleObjects
 #define MAXIMUM_WAIT_OBJECTS ...
 #define QS_ALLEVENTS ...
@@ -253,6 +401,56 @@
 #define FD_ADDRESS_LIST_CHANGE ...
 #define FD_MAX_EVENTS ...
 
+// WSAEnumNetworkEvents
+// https://msdn.microsoft.com/en-us/library/ms741572
+#define FD_READ_BIT ...
+#define FD_WRITE_BIT ...
+#define FD_OOB_BIT ...
+#define FD_ACCEPT_BIT ...
+#define FD_CONNECT_BIT ...
+#define FD_CLOSE_BIT ...
+
+// WSAPoll
+// https://msdn.microsoft.com/en-us/library/ms741669
+#define POLLRDNORM ...
+#define POLLRDBAND ...
+#define POLLIN ...
+#define POLLPRI ...
+#define POLLWRNORM ...
+#define POLLOUT ...
+#define POLLWRBAND ...
+#define POLLERR ...
+#define POLLHUP ...
+#define POLLNVAL ...
+
+// WSAWaitForMultipleEvents
+// https://msdn.microsoft.com/en-us/library/ms742219
+#define WSA_MAXIMUM_WAIT_EVENTS ...
+#define WSA_INFINITE ...
+#define WSA_WAIT_EVENT_0 ...
+#define WSA_WAIT_IO_COMPLETION ...
+#define WSA_WAIT_TIMEOUT ...
+#define WSA_WAIT_FAILED ...
+
+// WSAIoctl and the Winsock extension functions
+// https://msdn.microsoft.com/en-us/library/ms741621
+#define SIO_GET_EXTENSION_FUNCTION_POINTER ...
+#define SOL_SOCKET ...
+#define SO_UPDATE_ACCEPT_CONTEXT ...
+#define SO_UPDATE_CONNECT_CONTEXT ...
+
+// Registered I/O
+// https://msdn.microsoft.com/en-us/library/hh437192
+#define SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER ...
+#define WSA_FLAG_REGISTERED_IO ...
+#define RIO_CORRUPT_CQ ...
+#define RIO_MSG_DONT_NOTIFY ...
+#define RIO_MSG_DEFER ...
+#define RIO_MSG_WAITALL ...
+#define RIO_MSG_COMMIT_ONLY ...
+#define RIO_EVENT_COMPLETION ...
+#define RIO_IOCP_COMPLETION ...
+
 // Windows socket error codes
 // https://msdn.microsoft.com/en-us/library/ms740668
 #define WSA_INVALID_HANDLE ...
@@ -371,6 +569,33 @@
 #define COMMON_LVB_REVERSE_VIDEO ...
 #define COMMON_LVB_UNDERSCORE ...
 
+// see https://docs.microsoft.com/en-us/windows/console/input-record-str
+#define KEY_EVENT ...
+#define MOUSE_EVENT ...
+#define WINDOW_BUFFER_SIZE_EVENT ...
+#define MENU_EVENT ...
+#define FOCUS_EVENT ...
+
+// see https://docs.microsoft.com/en-us/windows/console/key-event-record-str
+#define CAPSLOCK_ON ...
+#define ENHANCED_KEY ...
+#define LEFT_ALT_PRESSED ...
+#define LEFT_CTRL_PRESSED ...
+#define NUMLOCK_ON ...
+#define RIGHT_ALT_PRESSED ...
+#define RIGHT_CTRL_PRESSED ...
+#define SCROLLLOCK_ON ...
+#define SHIFT_PRESSED ...
+
+// see https://docs.microsoft.com/en-us/windows/console/mouse-event-record-str
+#define FROM_LEFT_1ST_BUTTON_PRESSED ...
+#define FROM_LEFT_2ND_BUTTON_PRESSED ...
+#define RIGHTMOST_BUTTON_PRESSED ...
+#define DOUBLE_CLICK ...
+#define MOUSE_HWHEELED ...
+#define MOUSE_MOVED ...
+#define MOUSE_WHEELED ...
+
 // For the moment, we can't define this here.  When cffi
 // parses the header this returns -1 and cffi seems to
 // only handle positive integers right now.
@@ -106,6 +106,80 @@ BOOL WINAPI ReadFile(
   _Inout_opt_ LPOVERLAPPED lpOverlapped
 );
 
+// https://msdn.microsoft.com/en-us/aa365469
+BOOL WINAPI ReadFileScatter(
+  _In_       HANDLE               hFile,
+  _In_       FILE_SEGMENT_ELEMENT aSegmentArray[],
+  _In_       DWORD                nNumberOfBytesToRead,
+  _Reserved_ LPDWORD              lpReserved,
+  _Inout_    LPOVERLAPPED         lpOverlapped
+);
+
+// https://msdn.microsoft.com/en-us/aa365749
+BOOL WINAPI WriteFileGather(
+  _In_       HANDLE               hFile,
+  _In_       FILE_SEGMENT_ELEMENT aSegmentArray[],
+  _In_       DWORD                nNumberOfBytesToWrite,
+  _Reserved_ LPDWORD              lpReserved,
+  _Inout_    LPOVERLAPPED         lpOverlapped
+);
+
+// https://msdn.microsoft.com/en-us/aa365542
+BOOL WINAPI SetFilePointerEx(
+  _In_      HANDLE         hFile,
+  _In_      LARGE_INTEGER  liDistanceToMove,
+  _Out_opt_ PLARGE_INTEGER lpNewFilePointer,
+  _In_      DWORD          dwMoveMethod
+);
+
+// https://msdn.microsoft.com/en-us/aa364957
+BOOL WINAPI GetFileSizeEx(
+  _In_  HANDLE         hFile,
+  _Out_ PLARGE_INTEGER lpFileSize
+);
+
+// https://msdn.microsoft.com/en-us/aa365531
+BOOL WINAPI SetEndOfFile(
+  _In_ HANDLE hFile
+);
+
+// https://msdn.microsoft.com/en-us/aa365539
+BOOL WINAPI SetFileInformationByHandle(
+  _In_ HANDLE                    hFile,
+  _In_ FILE_INFO_BY_HANDLE_CLASS FileInformationClass,
+  _In_ LPVOID                    lpFileInformation,
+  _In_ DWORD                     dwBufferSize
+);
+
+// https://msdn.microsoft.com/en-us/aa363216
+BOOL WINAPI DeviceIoControl(
+  _In_        HANDLE       hDevice,
+  _In_        DWORD        dwIoControlCode,
+  _In_opt_    LPVOID       lpInBuffer,
+  _In_        DWORD        nInBufferSize,
+  _Out_opt_   LPVOID       lpOutBuffer,
+  _In_        DWORD        nOutBufferSize,
+  _Out_opt_   LPDWORD      lpBytesReturned,
+  _Inout_opt_ LPOVERLAPPED lpOverlapped
+);
+
+// https://msdn.microsoft.com/en-us/aa363852
+BOOL WINAPI CopyFileEx(
+  _In_     LPCTSTR            lpExistingFileName,
+  _In_     LPCTSTR            lpNewFileName,
+  _In_opt_ LPPROGRESS_ROUTINE lpProgressRoutine,
+  _In_opt_ LPVOID             lpData,
+  _In_opt_ LPBOOL             pbCancel,
+  _In_     DWORD              dwCopyFlags
+);
+
+// Implemented in Python by pywincffi.kernel32.filecopy and passed to
+// CopyFileEx as the LPPROGRESS_ROUTINE.
+extern "Python" DWORD WINAPI _copy_progress_routine(
+  LARGE_INTEGER, LARGE_INTEGER, LARGE_INTEGER, LARGE_INTEGER, DWORD, DWORD,
+  HANDLE, HANDLE, LPVOID
+);
+
 // https://msdn.microsoft.com/en-us/aa365240
 BOOL WINAPI MoveFileEx(
   _In_     LPCTSTR lpExistingFileName,
@@ -132,6 +206,205 @@ BOOL WINAPI UnlockFileEx(
   _Inout_    LPOVERLAPPED lpOverlapped
 );
 
+// https://msdn.microsoft.com/en-us/aa364419
+HANDLE WINAPI FindFirstFileEx(
+  _In_       LPCTSTR            lpFileName,
+  _In_       FINDEX_INFO_LEVELS fInfoLevelId,
+  _Out_      LPVOID             lpFindFileData,
+  _In_       FINDEX_SEARCH_OPS  fSearchOp,
+  _Reserved_ LPVOID             lpSearchFilter,
+  _In_       DWORD              dwAdditionalFlags
+);
+
+// https://msdn.microsoft.com/en-us/aa364428
+BOOL WINAPI FindNextFile(
+  _In_  HANDLE             hFindFile,
+  _Out_ LPWIN32_FIND_DATA  lpFindFileData
+);
+
+// https://msdn.microsoft.com/en-us/aa364413
+BOOL WINAPI FindClose(
+  _Inout_ HANDLE hFindFile
+);
+
+// https://msdn.microsoft.com/en-us/aa364953
+BOOL WINAPI GetFileInformationByHandleEx(
+  _In_  HANDLE                    hFile,
+  _In_  FILE_INFO_BY_HANDLE_CLASS FileInformationClass,
+  _Out_ LPVOID                    lpFileInformation,
+  _In_  DWORD                     dwBufferSize
+);
+
+// https://msdn.microsoft.com/en-us/aa365465
+BOOL WINAPI ReadDirectoryChangesW(
+  _In_        HANDLE                          hDirectory,
+  _Out_       LPVOID                          lpBuffer,
+  _In_        DWORD                           nBufferLength,
+  _In_        BOOL                            bWatchSubtree,
+  _In_        DWORD                           dwNotifyFilter,
+  _Out_opt_   LPDWORD                         lpBytesReturned,
+  _Inout_opt_ LPOVERLAPPED                    lpOverlapped,
+  _In_opt_    LPOVERLAPPED_COMPLETION_ROUTINE lpCompletionRoutine
+);
+
+// https://msdn.microsoft.com/en-us/aa364935
+BOOL WINAPI GetDiskFreeSpace(
+  _In_  LPCTSTR lpRootPathName,
+  _Out_ LPDWORD lpSectorsPerCluster,
+  _Out_ LPDWORD lpBytesPerSector,
+  _Out_ LPDWORD lpNumberOfFreeClusters,
+  _Out_ LPDWORD lpTotalNumberOfClusters
+);
+
+// https://msdn.microsoft.com/en-us/aa364996
+BOOL WINAPI GetVolumePathName(
+  _In_  LPCTSTR lpszFileName,
+  _Out_ LPTSTR  lpszVolumePathName,
+  _In_  DWORD   cchBufferLength
+);
+
+///////////////////////
+// Time
+///////////////////////
+
+// https://msdn.microsoft.com/en-us/library/ms644904
+BOOL WINAPI QueryPerformanceCounter(
+  _Out_ PLARGE_INTEGER lpPerformanceCount
+);
+
+// https://msdn.microsoft.com/en-us/library/ms644905
+BOOL WINAPI QueryPerformanceFrequency(
+  _Out_ PLARGE_INTEGER lpFrequency
+);
+
+// https://msdn.microsoft.com/en-us/library/ms724411
+ULONGLONG WINAPI GetTickCount64(void);
+
+// https://msdn.microsoft.com/en-us/library/ms682494
+HANDLE WINAPI CreateWaitableTimerEx(
+  _In_opt_ LPSECURITY_ATTRIBUTES lpTimerAttributes,
+  _In_opt_ LPCTSTR               lpTimerName,
+  _In_     DWORD                 dwFlags,
+  _In_     DWORD                 dwDesiredAccess
+);
+
+// https://msdn.microsoft.com/en-us/library/ms686289
+BOOL WINAPI SetWaitableTimer(
+  _In_           HANDLE           hTimer,
+  _In_     const LARGE_INTEGER    *pDueTime,
+  _In_           LONG             lPeriod,
+  _In_opt_       PTIMERAPCROUTINE pfnCompletionRoutine,
+  _In_opt_       LPVOID           lpArgToCompletionRoutine,
+  _In_           BOOL             fResume
+);
+
+// https://msdn.microsoft.com/en-us/library/ms681985
+BOOL WINAPI CancelWaitableTimer(
+  _In_ HANDLE hTimer
+);
+
+// https://msdn.microsoft.com/en-us/library/ms682483
+HANDLE WINAPI CreateTimerQueue(void);
+
+// https://msdn.microsoft.com/en-us/library/ms682485
+BOOL WINAPI CreateTimerQueueTimer(
+  _Out_    PHANDLE             phNewTimer,
+  _In_opt_ HANDLE              TimerQueue,
+  _In_     WAITORTIMERCALLBACK Callback,
+  _In_opt_ PVOID               Parameter,
+  _In_     DWORD               DueTime,
+  _In_     DWORD               Period,
+  _In_     ULONG               Flags
+);
+
+// https://msdn.microsoft.com/en-us/library/ms682569
+BOOL WINAPI DeleteTimerQueueTimer(
+  _In_opt_ HANDLE TimerQueue,
+  _In_     HANDLE Timer,
+  _In_opt_ HANDLE CompletionEvent
+);
+
+// https://msdn.microsoft.com/en-us/library/ms682568
+BOOL WINAPI DeleteTimerQueueEx(
+  _In_     HANDLE TimerQueue,
+  _In_opt_ HANDLE CompletionEvent
+);
+
+// Implemented in Python by pywincffi.kernel32.timers and passed to
+// CreateTimerQueueTimer as the WAITORTIMERCALLBACK.
+extern "Python" void WINAPI _timer_queue_callback(PVOID, BOOLEAN);
+
+///////////////////////
+// Memory
+///////////////////////
+
+// https://msdn.microsoft.com/en-us/ms724381
+void WINAPI GetSystemInfo(
+  _Out_ LPSYSTEM_INFO lpSystemInfo
+);
+
+// https://msdn.microsoft.com/en-us/aa366887
+LPVOID WINAPI VirtualAlloc(
+  _In_opt_ LPVOID lpAddress,
+  _In_     SIZE_T dwSize,
+  _In_     DWORD  flAllocationType,
+  _In_     DWORD  flProtect
+);
+
+// https://msdn.microsoft.com/en-us/aa366892
+BOOL WINAPI VirtualFree(
+  _In_ LPVOID lpAddress,
+  _In_ SIZE_T dwSize,
+  _In_ DWORD  dwFreeType
+);
+
+// https://msdn.microsoft.com/en-us/aa366537
+HANDLE WINAPI CreateFileMapping(
+  _In_     HANDLE                hFile,
+  _In_opt_ LPSECURITY_ATTRIBUTES lpAttributes,
+  _In_     DWORD                 flProtect,
+  _In_     DWORD                 dwMaximumSizeHigh,
+  _In_     DWORD                 dwMaximumSizeLow,
+  _In_opt_ LPCTSTR               lpName
+);
+
+// https://msdn.microsoft.com/en-us/aa366791
+HANDLE WINAPI OpenFileMapping(
+  _In_ DWORD   dwDesiredAccess,
+  _In_ BOOL    bInheritHandle,
+  _In_ LPCTSTR lpName
+);
+
+// https://msdn.microsoft.com/en-us/aa366761
+LPVOID WINAPI MapViewOfFile(
+  _In_ HANDLE hFileMappingObject,
+  _In_ DWORD  dwDesiredAccess,
+  _In_ DWORD  dwFileOffsetHigh,
+  _In_ DWORD  dwFileOffsetLow,
+  _In_ SIZE_T dwNumberOfBytesToMap
+);
+
+// https://msdn.microsoft.com/en-us/aa366763
+LPVOID WINAPI MapViewOfFileEx(
+  _In_     HANDLE hFileMappingObject,
+  _In_     DWORD  dwDesiredAccess,
+  _In_     DWORD  dwFileOffsetHigh,
+  _In_     DWORD  dwFileOffsetLow,
+  _In_     SIZE_T dwNumberOfBytesToMap,
+  _In_opt_ LPVOID lpBaseAddress
+);
+
+// https://msdn.microsoft.com/en-us/aa366563
+BOOL WINAPI FlushViewOfFile(
+  _In_ LPCVOID lpBaseAddress,
+  _In_ SIZE_T  dwNumberOfBytesToFlush
+);
+
+// https://msdn.microsoft.com/en-us/aa366882
+BOOL WINAPI UnmapViewOfFile(
+  _In_ LPCVOID lpBaseAddress
+);
+
 ///////////////////////
 // Files
 ///////////////////////
@@ -152,6 +425,14 @@ DWORD WINAPI WaitForSingleObject(
   _In_ DWORD  dwMilliseconds
 );
 
+// https://msdn.microsoft.com/en-us/ms687025
+DWORD WINAPI WaitForMultipleObjects(
+  _In_       DWORD  nCount,
+  _In_ const HANDLE *lpHandles,
+  _In_       BOOL   bWaitAll,
+  _In_       DWORD  dwMilliseconds
+);
+
 // https://msdn.microsoft.com/en-us/ms724329
 BOOL WINAPI GetHandleInformation(
   _In_  HANDLE  hObject,
@@ -221,6 +502,94 @@ BOOL WINAPI SetEvent(
   _In_ HANDLE hEvent
 );
 
+// https://msdn.microsoft.com/en-us/library/ms682438
+HANDLE WINAPI CreateSemaphoreEx(
+  _In_opt_   LPSECURITY_ATTRIBUTES lpSemaphoreAttributes,
+  _In_       LONG                  lInitialCount,
+  _In_       LONG                  lMaximumCount,
+  _In_opt_   LPCTSTR               lpName,
+  _Reserved_ DWORD                 dwFlags,
+  _In_       DWORD                 dwDesiredAccess
+);
+
+// https://msdn.microsoft.com/en-us/library/ms685071
+BOOL WINAPI ReleaseSemaphore(
+  _In_      HANDLE hSemaphore,
+  _In_      LONG   lReleaseCount,
+  _Out_opt_ LPLONG lpPreviousCount
+);
+
+// https://msdn.microsoft.com/en-us/library/ms682418
+HANDLE WINAPI CreateMutexEx(
+  _In_opt_ LPSECURITY_ATTRIBUTES lpMutexAttributes,
+  _In_opt_ LPCTSTR               lpName,
+  _In_     DWORD                 dwFlags,
+  _In_     DWORD                 dwDesiredAccess
+);
+
+// https://msdn.microsoft.com/en-us/library/ms685066
+BOOL WINAPI ReleaseMutex(
+  _In_ HANDLE hMutex
+);
+
+// https://msdn.microsoft.com/en-us/library/ms683483
+void WINAPI InitializeSRWLock(
+  _Out_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/ms681930
+void WINAPI AcquireSRWLockExclusive(
+  _Inout_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/ms681934
+void WINAPI AcquireSRWLockShared(
+  _Inout_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/dd405523
+BOOLEAN WINAPI TryAcquireSRWLockExclusive(
+  _Inout_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/dd405524
+BOOLEAN WINAPI TryAcquireSRWLockShared(
+  _Inout_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/ms685076
+void WINAPI ReleaseSRWLockExclusive(
+  _Inout_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/ms685080
+void WINAPI ReleaseSRWLockShared(
+  _Inout_ PSRWLOCK SRWLock
+);
+
+// https://msdn.microsoft.com/en-us/library/ms683469
+void WINAPI InitializeConditionVariable(
+  _Out_ PCONDITION_VARIABLE ConditionVariable
+);
+
+// https://msdn.microsoft.com/en-us/library/ms686304
+BOOL WINAPI SleepConditionVariableSRW(
+  _Inout_ PCONDITION_VARIABLE ConditionVariable,
+  _Inout_ PSRWLOCK            SRWLock,
+  _In_    DWORD               dwMilliseconds,
+  _In_    ULONG               Flags
+);
+
+// https://msdn.microsoft.com/en-us/library/ms687080
+void WINAPI WakeConditionVariable(
+  _Inout_ PCONDITION_VARIABLE ConditionVariable
+);
+
+// https://msdn.microsoft.com/en-us/library/ms687076
+void WINAPI WakeAllConditionVariable(
+  _Inout_ PCONDITION_VARIABLE ConditionVariable
+);
+
 ///////////////////////
 // Communications
 ///////////////////////
@@ -237,6 +606,43 @@ BOOL WINAPI ClearCommError(
   _Out_opt_ LPCOMSTAT lpStat
 );
 
+// https://msdn.microsoft.com/en-us/library/aa363260
+BOOL WINAPI GetCommState(
+  _In_    HANDLE hFile,
+  _Inout_ LPDCB  lpDCB
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363436
+BOOL WINAPI SetCommState(
+  _In_ HANDLE hFile,
+  _In_ LPDCB  lpDCB
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363437
+BOOL WINAPI SetCommTimeouts(
+  _In_ HANDLE         hFile,
+  _In_ LPCOMMTIMEOUTS lpCommTimeouts
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363257
+BOOL WINAPI SetCommMask(
+  _In_ HANDLE hFile,
+  _In_ DWORD  dwEvtMask
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363479
+BOOL WINAPI WaitCommEvent(
+  _In_  HANDLE       hFile,
+  _Out_ LPDWORD      lpEvtMask,
+  _In_  LPOVERLAPPED lpOverlapped
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363428
+BOOL WINAPI PurgeComm(
+  _In_ HANDLE hFile,
+  _In_ DWORD  dwFlags
+);
+
 // https://msdn.microsoft.com/en-us/ms741576
 int WSAEventSelect(
   _In_ SOCKET   s,
@@ -257,11 +663,80 @@ int WSAEnumNetworkEvents(
   _Out_ LPWSANETWORKEVENTS lpNetworkEvents
 );
 
+// https://msdn.microsoft.com/en-us/ms741669
+int WSAPoll(
+  _Inout_ LPWSAPOLLFD fdArray,
+  _In_    ULONG       fds,
+  _In_    INT         timeout
+);
+
+// https://msdn.microsoft.com/en-us/ms741688
+int WSARecv(
+  _In_    SOCKET                             s,
+  _Inout_ LPWSABUF                           lpBuffers,
+  _In_    DWORD                              dwBufferCount,
+  _Out_   LPDWORD                            lpNumberOfBytesRecvd,
+  _Inout_ LPDWORD                            lpFlags,
+  _In_    LPOVERLAPPED                       lpOverlapped,
+  _In_    LPWSAOVERLAPPED_COMPLETION_ROUTINE lpCompletionRoutine
+);
+
+// https://msdn.microsoft.com/en-us/ms742203
+int WSASend(
+  _In_  SOCKET                             s,
+  _In_  LPWSABUF                           lpBuffers,
+  _In_  DWORD                              dwBufferCount,
+  _Out_ LPDWORD                            lpNumberOfBytesSent,
+  _In_  DWORD                              dwFlags,
+  _In_  LPOVERLAPPED                       lpOverlapped,
+  _In_  LPWSAOVERLAPPED_COMPLETION_ROUTINE lpCompletionRoutine
+);
+
+// https://msdn.microsoft.com/en-us/ms741621
+int WSAIoctl(
+  _In_  SOCKET                             s,
+  _In_  DWORD                              dwIoControlCode,
+  _In_  LPVOID                             lpvInBuffer,
+  _In_  DWORD                              cbInBuffer,
+  _Out_ LPVOID                             lpvOutBuffer,
+  _In_  DWORD                              cbOutBuffer,
+  _Out_ LPDWORD                            lpcbBytesReturned,
+  _In_  LPOVERLAPPED                       lpOverlapped,
+  _In_  LPWSAOVERLAPPED_COMPLETION_ROUTINE lpCompletionRoutine
+);
+
+// https://msdn.microsoft.com/en-us/ms741568
+BOOL WSAGetOverlappedResult(
+  _In_  SOCKET       s,
+  _In_  LPOVERLAPPED lpOverlapped,
+  _Out_ LPDWORD      lpcbTransfer,
+  _In_  BOOL         fWait,
+  _Out_ LPDWORD      lpdwFlags
+);
+
+// https://msdn.microsoft.com/en-us/ms742219
+DWORD WSAWaitForMultipleEvents(
+  _In_       DWORD    cEvents,
+  _In_ const WSAEVENT *lphEvents,
+  _In_       BOOL     fWaitAll,
+  _In_       DWORD    dwTimeout,
+  _In_       BOOL     fAlertable
+);
+
 ///////////////////////
 // Utility Functions
 ///////////////////////
 HANDLE handle_from_fd(int);
 BOOL wsa_invalid_event(WSAEVENT);
+LONGLONG interlocked_compare_exchange64(LONGLONG *, LONGLONG, LONGLONG);
+LONGLONG interlocked_exchange64(LONGLONG *, LONGLONG);
+LONGLONG interlocked_exchange_add64(LONGLONG *, LONGLONG);
+void get_system_time_precise(PFILETIME);
+void filetimes_to_epoch_ns(const FILETIME *, size_t, LONGLONG *);
+BOOL wait_on_address_available(void);
+BOOL wait_on_address(volatile void *, PVOID, SIZE_T, DWORD);
+void wake_by_address_single(PVOID);
+void wake_by_address_all(PVOID);
 
 ///////////////////////
 // Processes
@@ -294,6 +769,12 @@ BOOL WINAPI GetOverlappedResult(
   _In_  BOOL         bWait
 );
 
+// https://msdn.microsoft.com/en-us/aa363792
+BOOL WINAPI CancelIoEx(
+  _In_     HANDLE       hFile,
+  _In_opt_ LPOVERLAPPED lpOverlapped
+);
+
 
 ///////////////////////
 // Console
@@ -320,6 +801,55 @@ HANDLE WINAPI CreateConsoleScreenBuffer(
   _Reserved_       LPVOID              lpScreenBufferData
 );
 
+// https://docs.microsoft.com/en-us/windows/console/readconsoleinput
+BOOL WINAPI ReadConsoleInputW(
+  _In_  HANDLE        hConsoleInput,
+  _Out_ PINPUT_RECORD lpBuffer,
+  _In_  DWORD         nLength,
+  _Out_ LPDWORD       lpNumberOfEventsRead
+);
+
+// https://docs.microsoft.com/en-us/windows/console/peekconsoleinput
+BOOL WINAPI PeekConsoleInputW(
+  _In_  HANDLE        hConsoleInput,
+  _Out_ PINPUT_RECORD lpBuffer,
+  _In_  DWORD         nLength,
+  _Out_ LPDWORD       lpNumberOfEventsRead
+);
+
+// https://docs.microsoft.com/en-us/windows/console/getnumberofconsoleinputevents
+BOOL WINAPI GetNumberOfConsoleInputEvents(
+  _In_  HANDLE  hConsoleInput,
+  _Out_ LPDWORD lpcNumberOfEvents
+);
+
+// https://docs.microsoft.com/en-us/windows/console/writeconsole
+BOOL WINAPI WriteConsoleW(
+  _In_             HANDLE  hConsoleOutput,
+  _In_       const VOID    *lpBuffer,
+  _In_             DWORD   nNumberOfCharsToWrite,
+  _Out_opt_        LPDWORD lpNumberOfCharsWritten,
+  _Reserved_       LPVOID  lpReserved
+);
+
+// https://docs.microsoft.com/en-us/windows/console/writeconsoleoutput
+BOOL WINAPI WriteConsoleOutputW(
+  _In_          HANDLE     hConsoleOutput,
+  _In_    const CHAR_INFO  *lpBuffer,
+  _In_          COORD      dwBufferSize,
+  _In_          COORD      dwBufferCoord,
+  _Inout_       SMALL_RECT *lpWriteRegion
+);
+
+// https://docs.microsoft.com/en-us/windows/console/readconsoleoutput
+BOOL WINAPI ReadConsoleOutputW(
+  _In_    HANDLE     hConsoleOutput,
+  _Out_   PCHAR_INFO lpBuffer,
+  _In_    COORD      dwBufferSize,
+  _In_    COORD      dwBufferCoord,
+  _Inout_ SMALL_RECT *lpReadRegion
+);
+
 // Used internally to reset the last error to 0
 // in cases where pywincffi is the cause of the
 // error and we choose to ignore the error.
@@ -26,12 +26,100 @@ typedef struct _OVERLAPPED {
   HANDLE    hEvent;
 } OVERLAPPED, *LPOVERLAPPED;
 
+// https://msdn.microsoft.com/en-us/library/aa364742
+typedef union _FILE_SEGMENT_ELEMENT {
+  ...;
+  ULONGLONG Alignment;
+} FILE_SEGMENT_ELEMENT, *PFILE_SEGMENT_ELEMENT;
+
 // https://msdn.microsoft.com/en-us/library/ms724284
 typedef struct _FILETIME {
   DWORD dwLowDateTime;
   DWORD dwHighDateTime;
 } FILETIME, *PFILETIME;
 
+// https://msdn.microsoft.com/en-us/library/aa365740
+typedef struct _WIN32_FIND_DATA {
+  DWORD    dwFileAttributes;
+  FILETIME ftCreationTime;
+  FILETIME ftLastAccessTime;
+  FILETIME ftLastWriteTime;
+  DWORD    nFileSizeHigh;
+  DWORD    nFileSizeLow;
+  DWORD    dwReserved0;
+  DWORD    dwReserved1;
+  TCHAR    cFileName[260];  // MAX_PATH
+  TCHAR    cAlternateFileName[14];
+} WIN32_FIND_DATA, *PWIN32_FIND_DATA, *LPWIN32_FIND_DATA;
+
+// https://msdn.microsoft.com/en-us/library/aa364226
+typedef struct _FILE_ID_BOTH_DIR_INFO {
+  DWORD         NextEntryOffset;
+  DWORD         FileIndex;
+  LARGE_INTEGER CreationTime;
+  LARGE_INTEGER LastAccessTime;
+  LARGE_INTEGER LastWriteTime;
+  LARGE_INTEGER ChangeTime;
+  LARGE_INTEGER EndOfFile;
+  LARGE_INTEGER AllocationSize;
+  DWORD         FileAttributes;
+  DWORD         FileNameLength;
+  DWORD         EaSize;
+  CCHAR         ShortNameLength;
+  WCHAR         ShortName[12];
+  LARGE_INTEGER FileId;
+  WCHAR         FileName[1];
+} FILE_ID_BOTH_DIR_INFO, *PFILE_ID_BOTH_DIR_INFO;
+
+// https://msdn.microsoft.com/en-us/library/aa364391
+typedef struct _FILE_NOTIFY_INFORMATION {
+  DWORD NextEntryOffset;
+  DWORD Action;
+  DWORD FileNameLength;
+  WCHAR FileName[1];
+} FILE_NOTIFY_INFORMATION, *PFILE_NOTIFY_INFORMATION;
+
+// https://msdn.microsoft.com/en-us/library/aa364214
+typedef struct _FILE_ALLOCATION_INFO {
+  LARGE_INTEGER AllocationSize;
+} FILE_ALLOCATION_INFO, *PFILE_ALLOCATION_INFO;
+
+// https://msdn.microsoft.com/en-us/library/aa364220
+typedef struct _FILE_END_OF_FILE_INFO {
+  LARGE_INTEGER EndOfFile;
+} FILE_END_OF_FILE_INFO, *PFILE_END_OF_FILE_INFO;
+
+// https://msdn.microsoft.com/en-us/library/cc232070
+typedef struct _FILE_SET_SPARSE_BUFFER {
+  BOOLEAN SetSparse;
+} FILE_SET_SPARSE_BUFFER, *PFILE_SET_SPARSE_BUFFER;
+
+// https://msdn.microsoft.com/en-us/library/aa364598
+typedef struct _FILE_ZERO_DATA_INFORMATION {
+  LARGE_INTEGER FileOffset;
+  LARGE_INTEGER BeyondFinalZero;
+} FILE_ZERO_DATA_INFORMATION, *PFILE_ZERO_DATA_INFORMATION;
+
+// https://msdn.microsoft.com/en-us/library/ms724958
+typedef struct _SYSTEM_INFO {
+  union {
+    DWORD dwOemId;
+    struct {
+      WORD wProcessorArchitecture;
+      WORD wReserved;
+    };
+  };
+  DWORD     dwPageSize;
+  LPVOID    lpMinimumApplicationAddress;
+  LPVOID    lpMaximumApplicationAddress;
+  DWORD_PTR dwActiveProcessorMask;
+  DWORD     dwNumberOfProcessors;
+  DWORD     dwProcessorType;
+  DWORD     dwAllocationGranularity;
+  WORD      wProcessorLevel;
+  WORD      wProcessorRevision;
+} SYSTEM_INFO, *LPSYSTEM_INFO;
+
 // https://msdn.microsoft.com/en-us/library/ms686331
 typedef struct _STARTUPINFO {
   DWORD  cb;
@@ -68,12 +156,126 @@ typedef struct _COMSTAT {
   DWORD cbOutQue;
 } COMSTAT, *LPCOMSTAT;
 
+// https://msdn.microsoft.com/en-us/library/aa363214
+typedef struct _DCB {
+  DWORD DCBlength;
+  DWORD BaudRate;
+  DWORD fBinary  :1;
+  DWORD fParity  :1;
+  DWORD fOutxCtsFlow  :1;
+  DWORD fOutxDsrFlow  :1;
+  DWORD fDtrControl  :2;
+  DWORD fDsrSensitivity  :1;
+  DWORD fTXContinueOnXoff  :1;
+  DWORD fOutX  :1;
+  DWORD fInX  :1;
+  DWORD fErrorChar  :1;
+  DWORD fNull  :1;
+  DWORD fRtsControl  :2;
+  DWORD fAbortOnError  :1;
+  DWORD fDummy2  :17;
+  WORD  wReserved;
+  WORD  XonLim;
+  WORD  XoffLim;
+  BYTE  ByteSize;
+  BYTE  Parity;
+  BYTE  StopBits;
+  char  XonChar;
+  char  XoffChar;
+  char  ErrorChar;
+  char  EofChar;
+  char  EvtChar;
+  WORD  wReserved1;
+} DCB, *LPDCB;
+
+// https://msdn.microsoft.com/en-us/library/aa363190
+typedef struct _COMMTIMEOUTS {
+  DWORD ReadIntervalTimeout;
+  DWORD ReadTotalTimeoutMultiplier;
+  DWORD ReadTotalTimeoutConstant;
+  DWORD WriteTotalTimeoutMultiplier;
+  DWORD WriteTotalTimeoutConstant;
+} COMMTIMEOUTS, *LPCOMMTIMEOUTS;
+
 // https://msdn.microsoft.com/en-us/ms741653
 typedef struct _WSANETWORKEVENTS {
   long lNetworkEvents;
   int  iErrorCode[...];
 } WSANETWORKEVENTS, *LPWSANETWORKEVENTS;
 
+// https://msdn.microsoft.com/en-us/library/ms740094
+typedef struct pollfd {
+  SOCKET fd;
+  SHORT  events;
+  SHORT  revents;
+} WSAPOLLFD, *PWSAPOLLFD, *LPWSAPOLLFD;
+
+// https://msdn.microsoft.com/en-us/library/ms741542
+typedef struct _WSABUF {
+  ULONG len;
+  CHAR  *buf;
+} WSABUF, *LPWSABUF;
+
+// https://msdn.microsoft.com/en-us/library/ms740496
+typedef struct sockaddr {
+  USHORT sa_family;
+  CHAR   sa_data[14];
+} SOCKADDR, *PSOCKADDR, *LPSOCKADDR;
+
+// https://msdn.microsoft.com/en-us/library/aa373931
+typedef struct _GUID {
+  DWORD Data1;
+  WORD  Data2;
+  WORD  Data3;
+  BYTE  Data4[8];
+} GUID;
+
+// https://msdn.microsoft.com/en-us/library/hh437236
+typedef struct _RIO_BUF {
+  RIO_BUFFERID BufferId;
+  ULONG        Offset;
+  ULONG        Length;
+} RIO_BUF, *PRIO_BUF;
+
+// https://msdn.microsoft.com/en-us/library/hh437230
+typedef struct _RIORESULT {
+  LONG      Status;
+  ULONG     BytesTransferred;
+  ULONGLONG SocketContext;
+  ULONGLONG RequestContext;
+} RIORESULT, *PRIORESULT;
+
+// https://msdn.microsoft.com/en-us/library/hh437227
+typedef struct _RIO_NOTIFICATION_COMPLETION {
+  RIO_NOTIFICATION_COMPLETION_TYPE Type;
+  union {
+    struct {
+      HANDLE EventHandle;
+      BOOL   NotifyReset;
+    } Event;
+    struct {
+      HANDLE IocpHandle;
+      PVOID  CompletionKey;
+      PVOID  Overlapped;
+    } Iocp;
+  };
+} RIO_NOTIFICATION_COMPLETION, *PRIO_NOTIFICATION_COMPLETION;
+
+// https://msdn.microsoft.com/en-us/library/hh437194
+typedef struct _RIO_EXTENSION_FUNCTION_TABLE {
+  DWORD                         cbSize;
+  LPFN_RIORECEIVE               RIOReceive;
+  LPFN_RIOSEND                  RIOSend;
+  LPFN_RIOCLOSECOMPLETIONQUEUE  RIOCloseCompletionQueue;
+  LPFN_RIOCREATECOMPLETIONQUEUE RIOCreateCompletionQueue;
+  LPFN_RIOCREATEREQUESTQUEUE    RIOCreateRequestQueue;
+  LPFN_RIODEQUEUECOMPLETION     RIODequeueCompletion;
+  LPFN_RIODEREGISTERBUFFER      RIODeregisterBuffer;
+  LPFN_RIONOTIFY                RIONotify;
+  LPFN_RIOREGISTERBUFFER        RIORegisterBuffer;
+  ...;
+} RIO_EXTENSION_FUNCTION_TABLE, *PRIO_EXTENSION_FUNCTION_TABLE;
+
 // https://msdn.microsoft.com/en-us/library/ms684873
 typedef struct _PROCESS_INFORMATION {
   HANDLE hProcess;
@@ -90,3 +292,61 @@ typedef struct _CONSOLE_SCREEN_BUFFER_INFO {
   SMALL_RECT srWindow;
   COORD      dwMaximumWindowSize;
 } CONSOLE_SCREEN_BUFFER_INFO, *PCONSOLE_SCREEN_BUFFER_INFO;
+
+// https://docs.microsoft.com/en-us/windows/console/key-event-record-str
+typedef struct _KEY_EVENT_RECORD {
+  BOOL  bKeyDown;
+  WORD  wRepeatCount;
+  WORD  wVirtualKeyCode;
+  WORD  wVirtualScanCode;
+  union {
+    WCHAR UnicodeChar;
+    CHAR  AsciiChar;
+  } uChar;
+  DWORD dwControlKeyState;
+} KEY_EVENT_RECORD;
+
+// https://docs.microsoft.com/en-us/windows/console/mouse-event-record-str
+typedef struct _MOUSE_EVENT_RECORD {
+  COORD dwMousePosition;
+  DWORD dwButtonState;
+  DWORD dwControlKeyState;
+  DWORD dwEventFlags;
+} MOUSE_EVENT_RECORD;
+
+// https://docs.microsoft.com/en-us/windows/console/window-buffer-size-record-str
+typedef struct _WINDOW_BUFFER_SIZE_RECORD {
+  COORD dwSize;
+} WINDOW_BUFFER_SIZE_RECORD;
+
+// https://docs.microsoft.com/en-us/windows/console/menu-event-record-str
+typedef struct _MENU_EVENT_RECORD {
+  UINT dwCommandId;
+} MENU_EVENT_RECORD;
+
+// https://docs.microsoft.com/en-us/windows/console/focus-event-record-str
+typedef struct _FOCUS_EVENT_RECORD {
+  BOOL bSetFocus;
+} FOCUS_EVENT_RECORD;
+
+// https://docs.microsoft.com/en-us/windows/console/input-record-str
+typedef struct _INPUT_RECORD {
+  WORD EventType;
+  union {
+    KEY_EVENT_RECORD          KeyEvent;
+    MOUSE_EVENT_RECORD        MouseEvent;
+    WINDOW_BUFFER_SIZE_RECORD WindowBufferSizeEvent;
+    MENU_EVENT_RECORD         MenuEvent;
+    FOCUS_EVENT_RECORD        FocusEvent;
+  } Event;
+} INPUT_RECORD, *PINPUT_RECORD;
+
+// https://docs.microsoft.com/en-us/windows/win32/sync/slim-reader-writer--srw--locks
+typedef struct _RTL_SRWLOCK {
+  PVOID Ptr;
+} SRWLOCK, *PSRWLOCK;
+
+// https://docs.microsoft.com/en-us/windows/win32/sync/condition-variables
+typedef struct _RTL_CONDITION_VARIABLE {
+  PVOID Ptr;
+} CONDITION_VARIABLE, *PCONDITION_VARIABLE;
@@ -11,6 +11,150 @@
 
 typedef int... SOCKET;
 typedef HANDLE WSAEVENT;  // according to winsock2.h
+typedef int... FINDEX_INFO_LEVELS;
+typedef int... FINDEX_SEARCH_OPS;
+typedef int... FILE_INFO_BY_HANDLE_CLASS;
+
+// https://msdn.microsoft.com/en-us/library/aa383713
+typedef union _LARGE_INTEGER {
+  ...;
+  LONGLONG QuadPart;
+} LARGE_INTEGER, *PLARGE_INTEGER;
+
+// https://msdn.microsoft.com/en-us/library/ms687066
+typedef void (WINAPI *WAITORTIMERCALLBACK)(
+  PVOID   lpParameter,
+  BOOLEAN TimerOrWaitFired
+);
+
+// https://msdn.microsoft.com/en-us/library/ms686786
+typedef void (WINAPI *PTIMERAPCROUTINE)(
+  LPVOID lpArgToCompletionRoutine,
+  DWORD  dwTimerLowValue,
+  DWORD  dwTimerHighValue
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363854
+typedef DWORD (WINAPI *LPPROGRESS_ROUTINE)(
+  LARGE_INTEGER TotalFileSize,
+  LARGE_INTEGER TotalBytesTransferred,
+  LARGE_INTEGER StreamSize,
+  LARGE_INTEGER StreamBytesTransferred,
+  DWORD         dwStreamNumber,
+  DWORD         dwCallbackReason,
+  HANDLE        hSourceFile,
+  HANDLE        hDestinationFile,
+  LPVOID        lpData
+);
+
+// https://msdn.microsoft.com/en-us/library/aa363792
+typedef void (WINAPI *LPOVERLAPPED_COMPLETION_ROUTINE)(
+  DWORD              dwErrorCode,
+  DWORD              dwNumberOfBytesTransfered,
+  struct _OVERLAPPED *lpOverlapped
+);
+
+// https://msdn.microsoft.com/en-us/library/ms741688
+typedef void (WINAPI *LPWSAOVERLAPPED_COMPLETION_ROUTINE)(
+  DWORD              dwError,
+  DWORD              cbTransferred,
+  struct _OVERLAPPED *lpOverlapped,
+  DWORD              dwFlags
+);
+
+// https://msdn.microsoft.com/en-us/library/ms737524
+typedef BOOL (WINAPI *LPFN_ACCEPTEX)(
+  SOCKET             sListenSocket,
+  SOCKET             sAcceptSocket,
+  PVOID              lpOutputBuffer,
+  DWORD              dwReceiveDataLength,
+  DWORD              dwLocalAddressLength,
+  DWORD              dwRemoteAddressLength,
+  LPDWORD            lpdwBytesReceived,
+  struct _OVERLAPPED *lpOverlapped
+);
+
+// https://msdn.microsoft.com/en-us/library/ms737606
+typedef BOOL (WINAPI *LPFN_CONNECTEX)(
+  SOCKET                s,
+  const struct sockaddr *name,
+  int                   namelen,
+  PVOID                 lpSendBuffer,
+  DWORD                 dwSendDataLength,
+  LPDWORD               lpdwBytesSent,
+  struct _OVERLAPPED    *lpOverlapped
+);
+
+// Registered I/O
+// https://msdn.microsoft.com/en-us/library/hh437192
+typedef struct RIO_BUFFERID_t *RIO_BUFFERID;
+typedef struct RIO_CQ_t *RIO_CQ;
+typedef struct RIO_RQ_t *RIO_RQ;
+typedef int... RIO_NOTIFICATION_COMPLETION_TYPE;
+
+// https://msdn.microsoft.com/en-us/library/hh437216
+typedef BOOL (WINAPI *LPFN_RIORECEIVE)(
+  RIO_RQ          SocketQueue,
+  struct _RIO_BUF *pData,
+  ULONG           DataBufferCount,
+  DWORD           Flags,
+  PVOID           RequestContext
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437218
+typedef BOOL (WINAPI *LPFN_RIOSEND)(
+  RIO_RQ          SocketQueue,
+  struct _RIO_BUF *pData,
+  ULONG           DataBufferCount,
+  DWORD           Flags,
+  PVOID           RequestContext
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437199
+typedef RIO_BUFFERID (WINAPI *LPFN_RIOREGISTERBUFFER)(
+  CHAR  *DataBuffer,
+  DWORD DataLength
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437202
+typedef void (WINAPI *LPFN_RIODEREGISTERBUFFER)(
+  RIO_BUFFERID BufferId
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437184
+typedef RIO_CQ (WINAPI *LPFN_RIOCREATECOMPLETIONQUEUE)(
+  DWORD                                QueueSize,
+  struct _RIO_NOTIFICATION_COMPLETION *NotificationCompletion
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437180
+typedef void (WINAPI *LPFN_RIOCLOSECOMPLETIONQUEUE)(
+  RIO_CQ CQ
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437186
+typedef RIO_RQ (WINAPI *LPFN_RIOCREATEREQUESTQUEUE)(
+  SOCKET Socket,
+  ULONG  MaxOutstandingReceive,
+  ULONG  MaxReceiveDataBuffers,
+  ULONG  MaxOutstandingSend,
+  ULONG  MaxSendDataBuffers,
+  RIO_CQ ReceiveCQ,
+  RIO_CQ SendCQ,
+  PVOID  SocketContext
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437204
+typedef ULONG (WINAPI *LPFN_RIODEQUEUECOMPLETION)(
+  RIO_CQ             CQ,
+  struct _RIORESULT *Array,
+  ULONG              ArraySize
+);
+
+// https://msdn.microsoft.com/en-us/library/hh437209
+typedef INT (WINAPI *LPFN_RIONOTIFY)(
+  RIO_CQ CQ
+);
 
 // https://docs.microsoft.com/en-us/windows/console/coord-str
 typedef struct _COORD {
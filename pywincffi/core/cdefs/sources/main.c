@@ -1,5 +1,6 @@
 #include <io.h>
 #include <winsock2.h>
+#include <mswsock.h>
 #include <winerror.h>
 #include <TlHelp32.h>
 #include <windows.h>
@@ -39,6 +40,104 @@
     static const int INHERIT_PARENT_AFFINITY = 0x00010000;
 #endif
 
+#if !defined(COPY_FILE_NO_BUFFERING)
+    static const int COPY_FILE_NO_BUFFERING = 0x00001000;
+#endif
+
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+    static const int CREATE_WAITABLE_TIMER_HIGH_RESOLUTION = 0x00000002;
+#endif
+
+#if !defined(WSA_FLAG_REGISTERED_IO)
+    static const int WSA_FLAG_REGISTERED_IO = 0x100;
+#endif
+
+// Registered I/O was added to mswsock.h by the Windows 8 SDK.  Older SDKs,
+// such as the ones used to build for Python 2.7, 3.3 and 3.4, get the
+// declarations below so the module still compiles.  RIO itself requires
+// Windows 8 and WSAIoctl() fails when the function table is requested on
+// older versions of Windows.
+#if !defined(SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER)
+    static const DWORD SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER =
+        _WSAIORW(IOC_WS2, 36);
+    static const DWORD RIO_CORRUPT_CQ = 0xFFFFFFFF;
+    static const int RIO_MSG_DONT_NOTIFY = 0x00000001;
+    static const int RIO_MSG_DEFER = 0x00000002;
+    static const int RIO_MSG_WAITALL = 0x00000004;
+    static const int RIO_MSG_COMMIT_ONLY = 0x00000008;
+
+    typedef struct RIO_BUFFERID_t *RIO_BUFFERID;
+    typedef struct RIO_CQ_t *RIO_CQ;
+    typedef struct RIO_RQ_t *RIO_RQ;
+
+    typedef enum _RIO_NOTIFICATION_COMPLETION_TYPE {
+        RIO_EVENT_COMPLETION = 1,
+        RIO_IOCP_COMPLETION = 2
+    } RIO_NOTIFICATION_COMPLETION_TYPE;
+
+    typedef struct _RIO_BUF {
+        RIO_BUFFERID BufferId;
+        ULONG Offset;
+        ULONG Length;
+    } RIO_BUF, *PRIO_BUF;
+
+    typedef struct _RIORESULT {
+        LONG Status;
+        ULONG BytesTransferred;
+        ULONGLONG SocketContext;
+        ULONGLONG RequestContext;
+    } RIORESULT, *PRIORESULT;
+
+    typedef struct _RIO_NOTIFICATION_COMPLETION {
+        RIO_NOTIFICATION_COMPLETION_TYPE Type;
+        union {
+            struct {
+                HANDLE EventHandle;
+                BOOL NotifyReset;
+            } Event;
+            struct {
+                HANDLE IocpHandle;
+                PVOID CompletionKey;
+                PVOID Overlapped;
+            } Iocp;
+        };
+    } RIO_NOTIFICATION_COMPLETION, *PRIO_NOTIFICATION_COMPLETION;
+
+    typedef BOOL (PASCAL FAR *LPFN_RIORECEIVE)(
+        RIO_RQ, PRIO_BUF, ULONG, DWORD, PVOID);
+    typedef BOOL (PASCAL FAR *LPFN_RIOSEND)(
+        RIO_RQ, PRIO_BUF, ULONG, DWORD, PVOID);
+    typedef RIO_BUFFERID (PASCAL FAR *LPFN_RIOREGISTERBUFFER)(PCHAR, DWORD);
+    typedef VOID (PASCAL FAR *LPFN_RIODEREGISTERBUFFER)(RIO_BUFFERID);
+    typedef RIO_CQ (PASCAL FAR *LPFN_RIOCREATECOMPLETIONQUEUE)(
+        DWORD, PRIO_NOTIFICATION_COMPLETION);
+    typedef VOID (PASCAL FAR *LPFN_RIOCLOSECOMPLETIONQUEUE)(RIO_CQ);
+    typedef RIO_RQ (PASCAL FAR *LPFN_RIOCREATEREQUESTQUEUE)(
+        SOCKET, ULONG, ULONG, ULONG, ULONG, RIO_CQ, RIO_CQ, PVOID);
+    typedef ULONG (PASCAL FAR *LPFN_RIODEQUEUECOMPLETION)(
+        RIO_CQ, PRIORESULT, ULONG);
+    typedef INT (PASCAL FAR *LPFN_RIONOTIFY)(RIO_CQ);
+
+    // The order matches mswsock.h, the functions pywincffi does not use
+    // are declared as plain pointers.
+    typedef struct _RIO_EXTENSION_FUNCTION_TABLE {
+        DWORD cbSize;
+        LPFN_RIORECEIVE RIOReceive;
+        PVOID RIOReceiveEx;
+        LPFN_RIOSEND RIOSend;
+        PVOID RIOSendEx;
+        LPFN_RIOCLOSECOMPLETIONQUEUE RIOCloseCompletionQueue;
+        LPFN_RIOCREATECOMPLETIONQUEUE RIOCreateCompletionQueue;
+        LPFN_RIOCREATEREQUESTQUEUE RIOCreateRequestQueue;
+        LPFN_RIODEQUEUECOMPLETION RIODequeueCompletion;
+        LPFN_RIODEREGISTERBUFFER RIODeregisterBuffer;
+        LPFN_RIONOTIFY RIONotify;
+        LPFN_RIOREGISTERBUFFER RIORegisterBuffer;
+        PVOID RIOResizeCompletionQueue;
+        PVOID RIOResizeRequestQueue;
+    } RIO_EXTENSION_FUNCTION_TABLE, *PRIO_EXTENSION_FUNCTION_TABLE;
+#endif
+
 HANDLE handle_from_fd(int fd) {
     return (HANDLE)_get_osfhandle(fd);
 }
@@ -49,3 +148,121 @@ HANDLE handle_from_fd(int fd) {
 BOOL wsa_invalid_event(WSAEVENT event) {
     return event == WSA_INVALID_EVENT;
 }
+
+// The Interlocked functions are compiler intrinsics on most platforms so
+// cffi can't call them directly.  These are used by
+// pywincffi.kernel32.ringqueue for words shared between threads.
+LONGLONG interlocked_compare_exchange64(
+        LONGLONG volatile *destination, LONGLONG exchange,
+        LONGLONG comparand) {
+    return InterlockedCompareExchange64(destination, exchange, comparand);
+}
+
+LONGLONG interlocked_exchange64(LONGLONG volatile *target, LONGLONG value) {
+    return InterlockedExchange64(target, value);
+}
+
+LONGLONG interlocked_exchange_add64(
+        LONGLONG volatile *addend, LONGLONG value) {
+    return InterlockedExchangeAdd64(addend, value);
+}
+
+// GetSystemTimePreciseAsFileTime() was added in Windows 8 so it's looked
+// up at runtime rather than linked against.  On older versions of Windows
+// this falls back to GetSystemTimeAsFileTime(), which has the resolution
+// of the system timer.
+typedef VOID (WINAPI *GET_SYSTEM_TIME_AS_FILE_TIME)(LPFILETIME);
+
+void get_system_time_precise(PFILETIME lpSystemTimeAsFileTime) {
+    static GET_SYSTEM_TIME_AS_FILE_TIME precise = NULL;
+    static BOOL resolved = FALSE;
+
+    if (!resolved) {
+        precise = (GET_SYSTEM_TIME_AS_FILE_TIME)GetProcAddress(
+            GetModuleHandle(TEXT("kernel32")),
+            "GetSystemTimePreciseAsFileTime");
+        resolved = TRUE;
+    }
+
+    if (precise != NULL) {
+        precise(lpSystemTimeAsFileTime);
+    } else {
+        GetSystemTimeAsFileTime(lpSystemTimeAsFileTime);
+    }
+}
+
+// Converts `count` FILETIMEs to nanoseconds since the Unix epoch.  Used by
+// pywincffi.kernel32.clock.filetimes_to_epoch_ns() so large arrays don't
+// have to be converted one Python integer at a time.
+void filetimes_to_epoch_ns(
+        const FILETIME *filetimes, size_t count, LONGLONG *results) {
+    size_t i;
+    for (i = 0; i < count; i++) {
+        ULONGLONG value =
+            (ULONGLONG)filetimes[i].dwHighDateTime << 32 |
+            filetimes[i].dwLowDateTime;
+        results[i] = ((LONGLONG)value - 116444736000000000LL) * 100;
+    }
+}
+
+// WaitOnAddress() and WakeByAddress*() were added in Windows 8 and are
+// exported by kernelbase.dll.  They're looked up at runtime so the module
+// doesn't link against Synchronization.lib, which older SDKs don't ship,
+// and still loads on Windows 7.  wait_on_address() fails with
+// ERROR_NOT_SUPPORTED if they're missing.
+typedef BOOL (WINAPI *WAIT_ON_ADDRESS)(volatile VOID *, PVOID, SIZE_T, DWORD);
+typedef VOID (WINAPI *WAKE_BY_ADDRESS)(PVOID);
+
+static WAIT_ON_ADDRESS wait_on_address_function = NULL;
+static WAKE_BY_ADDRESS wake_by_address_single_function = NULL;
+static WAKE_BY_ADDRESS wake_by_address_all_function = NULL;
+static BOOL wait_on_address_resolved = FALSE;
+
+static void resolve_wait_on_address(void) {
+    HMODULE kernelbase;
+
+    if (wait_on_address_resolved) {
+        return;
+    }
+
+    kernelbase = GetModuleHandle(TEXT("kernelbase"));
+    if (kernelbase != NULL) {
+        wait_on_address_function = (WAIT_ON_ADDRESS)GetProcAddress(
+            kernelbase, "WaitOnAddress");
+        wake_by_address_single_function = (WAKE_BY_ADDRESS)GetProcAddress(
+            kernelbase, "WakeByAddressSingle");
+        wake_by_address_all_function = (WAKE_BY_ADDRESS)GetProcAddress(
+            kernelbase, "WakeByAddressAll");
+    }
+    wait_on_address_resolved = TRUE;
+}
+
+BOOL wait_on_address_available(void) {
+    resolve_wait_on_address();
+    return wait_on_address_function != NULL &&
+        wake_by_address_single_function != NULL &&
+        wake_by_address_all_function != NULL;
+}
+
+BOOL wait_on_address(
+        volatile void *Address, PVOID CompareAddress, SIZE_T AddressSize,
+        DWORD dwMilliseconds) {
+    if (!wait_on_address_available()) {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return FALSE;
+    }
+    return wait_on_address_function(
+        Address, CompareAddress, AddressSize, dwMilliseconds);
+}
+
+void wake_by_address_single(PVOID Address) {
+    if (wait_on_address_available()) {
+        wake_by_address_single_function(Address);
+    }
+}
+
+void wake_by_address_all(PVOID Address) {
+    if (wait_on_address_available()) {
+        wake_by_address_all_function(Address);
+    }
+}
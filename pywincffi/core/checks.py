@@ -49,6 +49,45 @@ def error_check(function, code=None, expected=None):
             expected_return_code=expected)
 
 
+def pending_check(function, code, overlapped=True):
+    """
+    Checks the result of a function which may complete asynchronously
+    when given an ``OVERLAPPED`` structure.  A zero ``code`` with the
+    last error set to ``ERROR_IO_PENDING`` means the operation was
+    started, in which case the last error is cleared.
+
+    :param str function:
+        The Windows API function which was called.
+
+    :param int code:
+        The value returned by ``function``.
+
+    :keyword bool overlapped:
+        False if ``function`` was called without an ``OVERLAPPED``
+        structure, in which case ``ERROR_IO_PENDING`` is an error too.
+
+    :rtype: bool
+    :returns:
+        Returns True if the operation is pending and False if it
+        completed immediately.
+
+    :raises pywincffi.exceptions.WindowsAPIError:
+        Raised if ``function`` failed.
+    """
+    if code != 0:
+        return False
+
+    ffi, library = dist.load()
+    errno, error_message = ffi.getwinerror()
+    if not overlapped or errno != library.ERROR_IO_PENDING:
+        raise WindowsAPIError(
+            function, error_message, errno, return_code=code,
+            expected_return_code=NON_ZERO)
+
+    library.SetLastError(0)
+    return True
+
+
 def input_check(name, value, allowed_types=None, allowed_values=None):
     """
     A small wrapper around :func:`isinstance`.  This is mainly meant
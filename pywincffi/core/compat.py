@@ -0,0 +1,12 @@
+"""
+Compatibility
+=============
+
+Small shims for differences between the versions of Python pywincffi
+supports.
+"""
+
+import time
+
+# Python 2 does not provide time.monotonic()
+monotonic = getattr(time, "monotonic", time.time)
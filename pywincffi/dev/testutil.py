@@ -6,9 +6,11 @@ This module is used by the unittests.
 """
 
 import os
+import re
 import socket
 import subprocess
 import sys
+from os.path import basename
 from random import choice
 from string import ascii_lowercase, ascii_uppercase
 from textwrap import dedent
@@ -70,6 +72,161 @@ def mock_library(**attributes):
         dist, "load", lambda: [ffi, LibraryWrapper(library, attributes)])
 
 
+# Windows types which cffi only provides when running on Windows.  These
+# are declared by :class:`StandInFFI` so our own typedefs.h and structs.h
+# can be parsed on any platform.
+STANDIN_TYPEDEFS = """
+typedef uint8_t BYTE, BOOLEAN, UCHAR;
+typedef BYTE *LPBYTE, *PBYTE;
+typedef char CHAR, CCHAR;
+typedef char16_t WCHAR, TCHAR;
+typedef WCHAR *LPWSTR, *PWSTR, *LPTSTR;
+typedef const WCHAR *LPCWSTR, *LPCTSTR;
+typedef int16_t SHORT;
+typedef uint16_t WORD, USHORT, ATOM;
+typedef WORD *LPWORD;
+typedef int32_t BOOL, INT, LONG;
+typedef BOOL *LPBOOL;
+typedef LONG *PLONG, *LPLONG;
+typedef uint32_t DWORD, UINT, ULONG;
+typedef DWORD *LPDWORD, *PDWORD;
+typedef ULONG *PULONG;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG, DWORD64;
+typedef LONGLONG *PLONGLONG;
+typedef ULONGLONG *PULONGLONG;
+typedef intptr_t LONG_PTR, INT_PTR, SSIZE_T;
+typedef uintptr_t ULONG_PTR, DWORD_PTR, UINT_PTR, SIZE_T;
+typedef ULONG_PTR *PULONG_PTR;
+typedef SIZE_T *PSIZE_T;
+typedef void *PVOID, *LPVOID, *HANDLE;
+typedef const void *LPCVOID;
+typedef HANDLE *PHANDLE, *LPHANDLE;
+"""
+
+# Header files which only contain types and can be loaded by
+# :class:`StandInFFI`.
+STANDIN_HEADERS = ("typedefs.h", "structs.h")
+
+# Constructs which only cffi's API mode understands and what they should
+# be replaced with when loading headers into :class:`StandInFFI`.
+STANDIN_REPLACEMENTS = (
+    (re.compile(r"typedef\s+int\.\.\.\s+SOCKET;"),
+     "typedef uintptr_t SOCKET;"),
+    # Enums, such as FINDEX_INFO_LEVELS, are the size of an int
+    (re.compile(r"typedef\s+int\.\.\.\s+(\w+);"), r"typedef int \1;"),
+    # FD_MAX_EVENTS, the only variable length array in structs.h
+    (re.compile(r"iErrorCode\[\.\.\.\]"), "iErrorCode[10]"),
+    (re.compile(r"^\s*\.\.\.;\s*$", re.MULTILINE), ""),
+)
+
+
+class StandInFFI(FFI):
+    """
+    An instance of :class:`FFI` which can be used on any platform in place
+    of the one :func:`dist.load` returns.  It declares the Windows types
+    cffi normally provides, the types from our own headers and emulates
+    :meth:`FFI.getwinerror` using the error set by a
+    :class:`StandInLibrary`.  Functions registered with
+    :meth:`def_extern` are made available as attributes of the stand-in
+    library just as they would be on the compiled library.
+    """
+    def __init__(self):
+        super(StandInFFI, self).__init__()
+        self.last_error = 0
+        self.externs = {}
+        self.cdef(STANDIN_TYPEDEFS)
+
+        headers = [
+            path for path in dist.HEADER_FILES
+            if basename(path) in STANDIN_HEADERS]
+        header = dist._read(*headers)  # pylint: disable=protected-access
+        for regex, replacement in STANDIN_REPLACEMENTS:
+            header = regex.sub(replacement, header)
+
+        self.cdef(dist.REGEX_SAL_ANNOTATION.sub(" ", header))
+
+    def getwinerror(self, code=-1):
+        """Returns the last error set by :meth:`StandInLibrary.SetLastError`"""
+        if code == -1:
+            code = self.last_error
+        return code, "Stand-in error %d" % code
+
+    def def_extern(  # pylint: disable=unused-argument
+            self, name=None, error=None, onerror=None):
+        """Records the decorated function in :attr:`externs`"""
+        def decorator(function):
+            self.externs[name or function.__name__] = function
+            return function
+        return decorator
+
+
+class StandInLibrary(object):
+    """
+    Base class for Python stand-ins of the library which :func:`dist.load`
+    returns.  Subclasses implement the Windows functions a test needs,
+    usually on top of the closest POSIX equivalent, so the wrappers and the
+    logic built on them can be tested on any platform.
+
+    Handles passed into or returned from a stand-in are plain integers cast
+    to ``HANDLE``.  Unless a stand-in says otherwise the integer is a POSIX
+    file descriptor.
+    """
+    CONSTANTS = dict(
+        INVALID_HANDLE_VALUE=-1,
+        INFINITE=0xFFFFFFFF,
+        WAIT_OBJECT_0=0x00000000,
+        WAIT_ABANDONED=0x00000080,
+        WAIT_ABANDONED_0=0x00000080,
+        WAIT_TIMEOUT=0x00000102,
+        WAIT_FAILED=0xFFFFFFFF,
+        GENERIC_READ=0x80000000,
+        GENERIC_WRITE=0x40000000,
+        ERROR_FILE_NOT_FOUND=2,
+        ERROR_ACCESS_DENIED=5,
+        ERROR_INVALID_HANDLE=6,
+        ERROR_NOT_ENOUGH_MEMORY=8,
+        ERROR_HANDLE_EOF=38,
+        ERROR_INVALID_PARAMETER=87,
+        ERROR_BROKEN_PIPE=109,
+        ERROR_ALREADY_EXISTS=183,
+        ERROR_IO_PENDING=997
+    )
+
+    def __init__(self, ffi):
+        self.ffi = ffi
+
+    def __getattr__(self, item):
+        try:
+            return self.CONSTANTS[item]
+        except KeyError:
+            pass
+
+        try:
+            return self.ffi.externs[item]
+        except KeyError:
+            raise AttributeError(
+                "Stand-in %s does not provide %r" % (
+                    self.__class__.__name__, item))
+
+    def SetLastError(self, dwErrCode):  # pylint: disable=invalid-name
+        """Stand-in for ``SetLastError``"""
+        self.ffi.last_error = int(dwErrCode)
+
+    def fail(self, errno, result=0):
+        """Sets the last error to ``errno`` and returns ``result``"""
+        self.SetLastError(errno)
+        return result
+
+    def handle(self, value):
+        """Converts an integer into a ``HANDLE``"""
+        return self.ffi.cast("HANDLE", value)
+
+    def fd(self, handle):  # pylint: disable=invalid-name
+        """Converts a ``HANDLE`` back into an integer"""
+        return int(self.ffi.cast("intptr_t", handle))
+
+
 class SharedState(object):  # pylint: disable=too-few-public-methods
     """
     Contains some state data which is shared across multiple
@@ -81,6 +238,7 @@ class SharedState(object):  # pylint: disable=too-few-public-methods
     ffi = None
     kernel32 = None
     ws2_32 = None
+    standin_ffi = None
 
 
 class TestCase(_TestCase):  # pylint: disable=too-many-public-methods
@@ -299,3 +457,24 @@ class TestCase(_TestCase):  # pylint: disable=too-many-public-methods
         last_error, _ = self.GetLastError()
         self.assertIn(last_error, (0, errno))
         self.SetLastError(0)
+
+    def standin_library(self, library_class):
+        """
+        Replaces :func:`dist.load` for the duration of the test so it
+        returns a :class:`StandInFFI` instance and an instance of
+        ``library_class``, which should be a subclass of
+        :class:`StandInLibrary`.
+
+        :returns:
+            Returns the instance of ``library_class`` that was created.
+        """
+        if SharedState.standin_ffi is None:
+            SharedState.standin_ffi = StandInFFI()
+
+        ffi = SharedState.standin_ffi
+        ffi.last_error = 0
+        library = library_class(ffi)
+        patcher = patch.object(dist, "load", lambda: (ffi, library))
+        patcher.start()
+        self.addCleanup(patcher.stop)
+        return library
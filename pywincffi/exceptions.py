@@ -169,6 +169,32 @@ class WindowsAPIError(PyWinCFFIError):
                 self.errno, self.return_code, self.expected_return_code))
 
 
+class HandleCloseError(PyWinCFFIError):
+    """
+    A subclass of :class:`PyWinCFFIError` that's raised when one or more
+    handles could not be closed by
+    :meth:`pywincffi.kernel32.HandleGroup.close`.  Every handle is closed,
+    or attempted, before this is raised.
+
+    :param list errors:
+        A list of ``(handle, error)`` tuples where ``error`` is the
+        :class:`WindowsAPIError` produced when closing ``handle``.
+
+    :param int total:
+        The number of handles which were closed or attempted.
+    """
+    def __init__(self, errors, total):
+        self.errors = errors
+        self.total = total
+        self.message = \
+            "Failed to close {0} of {1} handle(s): {2}".format(
+                len(errors), total,
+                "; ".join(
+                    "{0!r} (errno: {1})".format(handle, error.errno)
+                    for handle, error in errors))
+        super(HandleCloseError, self).__init__(self.message)
+
+
 class InternalError(PyWinCFFIError):
     """
     Raised if we encounter an internal error.  Most likely this is an
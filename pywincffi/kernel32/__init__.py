@@ -11,10 +11,12 @@ Provides functions, constants and utilities that wrap functions provided by
 # it's close to the way Windows would present them (as a single module)
 from pywincffi.kernel32.file import (
     ReadFile, WriteFile, FlushFileBuffers, MoveFileEx, CreateFile, LockFileEx,
-    UnlockFileEx, GetTempPath)
+    UnlockFileEx, GetTempPath, SetFilePointerEx, GetFileSizeEx, pread,
+    pread_into, pwrite, GetDiskFreeSpace, GetDiskFreeSpaceResult,
+    GetVolumePathName, sector_size, SetEndOfFile)
 from pywincffi.kernel32.handle import (
     CloseHandle, GetStdHandle, GetHandleInformation, SetHandleInformation,
-    DuplicateHandle)
+    DuplicateHandle, OwnedHandle, HandleGroup)
 from pywincffi.kernel32.pipe import (
     CreatePipe, PeekNamedPipe, PeekNamedPipeResult, SetNamedPipeHandleState)
 from pywincffi.kernel32.process import (
@@ -22,9 +24,57 @@ from pywincffi.kernel32.process import (
     TerminateProcess, CreateToolhelp32Snapshot, CreateProcess, pid_exists)
 from pywincffi.kernel32.events import (
     CreateEvent, OpenEvent, ResetEvent, SetEvent)
-from pywincffi.kernel32.comms import ClearCommError
+from pywincffi.kernel32.clock import (
+    QueryPerformanceCounter, QueryPerformanceFrequency,
+    GetSystemTimePreciseAsFileTime, GetTickCount64, perf_counter_ns, time_ns,
+    filetime_to_epoch_ns, filetimes_to_epoch_ns, epoch_ns_to_filetimes)
+from pywincffi.kernel32.comms import (
+    ClearCommError, GetCommState, SetCommState, SetCommTimeouts, SetCommMask,
+    WaitCommEvent, PurgeComm, RingBuffer, CommReader)
 from pywincffi.kernel32.console import (
     SetConsoleTextAttribute, GetConsoleScreenBufferInfo,
-    CreateConsoleScreenBuffer)
-from pywincffi.kernel32.synchronization import WaitForSingleObject
-from pywincffi.kernel32.overlapped import GetOverlappedResult
+    CreateConsoleScreenBuffer, WriteConsoleW, WriteConsoleOutputW,
+    ReadConsoleOutputW, ReadConsoleInputW, PeekConsoleInputW,
+    GetNumberOfConsoleInputEvents)
+from pywincffi.kernel32.consoleinput import (
+    ConsoleInputReader, decode_input_records)
+from pywincffi.kernel32.consolewriter import ConsoleWriter
+from pywincffi.kernel32.rendering import (
+    FrameBuffer, ConsoleRenderer, Rect, diff_frames)
+from pywincffi.kernel32.synchronization import (
+    WaitForSingleObject, WaitForMultipleObjects, CreateSemaphoreEx,
+    ReleaseSemaphore, CreateMutexEx, ReleaseMutex, Semaphore, Mutex,
+    wait_any, InitializeSRWLock, AcquireSRWLockExclusive,
+    AcquireSRWLockShared, TryAcquireSRWLockExclusive,
+    TryAcquireSRWLockShared, ReleaseSRWLockExclusive, ReleaseSRWLockShared,
+    InitializeConditionVariable, SleepConditionVariableSRW,
+    WakeConditionVariable, WakeAllConditionVariable, RWLock, Condition,
+    WaitOnAddress, WakeByAddressSingle, WakeByAddressAll)
+from pywincffi.kernel32.ringqueue import SPMCQueue
+from pywincffi.kernel32.timers import (
+    CreateWaitableTimerEx, SetWaitableTimer, CancelWaitableTimer,
+    CreateTimerQueue, DeleteTimerQueueEx, CreateTimerQueueTimer,
+    DeleteTimerQueueTimer, TimerScheduler)
+from pywincffi.kernel32.overlapped import (
+    GetOverlappedResult, CancelIoEx, OverlappedPool)
+from pywincffi.kernel32.memory import (
+    GetSystemInfo, VirtualAlloc, VirtualFree, AlignedBufferPool)
+from pywincffi.kernel32.mapping import (
+    CreateFileMapping, OpenFileMapping, MapViewOfFile, MapViewOfFileEx,
+    FlushViewOfFile, UnmapViewOfFile, MappedView, MappedFileWindow)
+from pywincffi.kernel32.scatter import (
+    ReadFileScatter, WriteFileGather, SegmentArray, read_scatter,
+    write_gather)
+from pywincffi.kernel32.filecopy import (
+    CopyFileEx, Cancellation, copy_file, copy_handle)
+from pywincffi.kernel32.directory import (
+    FindFirstFileEx, FindNextFile, FindClose, GetFileInformationByHandleEx,
+    DirectoryEntry, iter_directory, list_directory, find_files, walk)
+from pywincffi.kernel32.watcher import (
+    ReadDirectoryChanges, DirectoryWatcher, FileChange, coalesce,
+    parse_notify_information)
+from pywincffi.kernel32.allocation import (
+    SetFileInformationByHandle, DeviceIoControl, set_allocation_size,
+    set_end_of_file, preallocate, set_sparse, set_zero_data)
+from pywincffi.kernel32.locking import (
+    RangeLockManager, RangeLock, IntervalTree, LockStatistics)
@@ -0,0 +1,275 @@
+"""
+File Allocation
+---------------
+
+A module containing Windows functions for controlling how disk space is
+allocated to files.  :func:`preallocate` reserves space for a file ahead
+of time, so appending to it doesn't grow the file one extent at a time,
+while :func:`set_sparse` and :func:`set_zero_data` release space which
+is no longer needed.
+"""
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import (
+    NON_ZERO, NoneType, input_check, error_check, pending_check)
+from pywincffi.exceptions import InputError
+from pywincffi.kernel32.file import GetFileSizeEx
+from pywincffi.wintypes import HANDLE, OVERLAPPED, wintype_to_cdata
+
+
+def _sizeof(ffi, cdata):
+    # ffi.sizeof() on a pointer, such as ffi.new("PFILE_ALLOCATION_INFO")
+    # produces, is the size of the pointer rather than the structure.
+    ctype = ffi.typeof(cdata)
+    if ctype.kind == "pointer":
+        return ffi.sizeof(ctype.item)
+    return ffi.sizeof(cdata)
+
+
+def SetFileInformationByHandle(
+        hFile, FileInformationClass, lpFileInformation, dwBufferSize=None):
+    """
+    Sets information for ``hFile``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa365539
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file.
+
+    :param int FileInformationClass:
+        The type of information in ``lpFileInformation``, such as
+        ``FileAllocationInfo`` or ``FileEndOfFileInfo``.
+
+    :param lpFileInformation:
+        The structure containing the information, such as one created
+        with ``ffi.new("PFILE_ALLOCATION_INFO")``.
+
+    :keyword int dwBufferSize:
+        The size of ``lpFileInformation``.  Defaults to the size of the
+        structure ``lpFileInformation`` points to.
+    """
+    ffi, library = dist.load()
+
+    if dwBufferSize is None:
+        dwBufferSize = _sizeof(ffi, lpFileInformation)
+
+    input_check("hFile", hFile, HANDLE)
+    input_check("FileInformationClass", FileInformationClass, integer_types)
+    input_check("dwBufferSize", dwBufferSize, integer_types)
+
+    code = library.SetFileInformationByHandle(
+        wintype_to_cdata(hFile), FileInformationClass, lpFileInformation,
+        dwBufferSize
+    )
+    error_check("SetFileInformationByHandle", code=code, expected=NON_ZERO)
+
+
+def DeviceIoControl(  # pylint: disable=too-many-arguments
+        hDevice, dwIoControlCode, lpInBuffer=None, lpOutBuffer=None,
+        lpOverlapped=None, nInBufferSize=None, nOutBufferSize=None):
+    """
+    Sends the control code ``dwIoControlCode`` to ``hDevice``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363216
+
+    :param pywincffi.wintypes.HANDLE hDevice:
+        The handle to the device, volume or file.
+
+    :param int dwIoControlCode:
+        The control code, such as ``FSCTL_SET_SPARSE``.
+
+    :keyword lpInBuffer:
+        The structure or buffer containing the input for the operation.
+
+    :keyword lpOutBuffer:
+        The structure or buffer to receive the output of the operation.
+
+    :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        If provided, and ``hDevice`` was opened with
+        ``FILE_FLAG_OVERLAPPED``, the operation may complete
+        asynchronously.  Use :func:`pywincffi.kernel32.GetOverlappedResult`
+        to wait for it.
+
+    :keyword int nInBufferSize:
+        The size of ``lpInBuffer``.  Defaults to the size of the structure
+        or buffer provided.
+
+    :keyword int nOutBufferSize:
+        The size of ``lpOutBuffer``.  Defaults to the size of the structure
+        or buffer provided.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes stored in ``lpOutBuffer`` or ``None`` if
+        the operation is pending.
+    """
+    ffi, library = dist.load()
+
+    input_check("hDevice", hDevice, HANDLE)
+    input_check("dwIoControlCode", dwIoControlCode, integer_types)
+    input_check("lpOverlapped", lpOverlapped, (NoneType, OVERLAPPED))
+
+    buffers = []
+    for buffer_, size in ((lpInBuffer, nInBufferSize),
+                          (lpOutBuffer, nOutBufferSize)):
+        if buffer_ is None:
+            buffers.extend((ffi.NULL, 0))
+            continue
+
+        if not isinstance(buffer_, ffi.CData):
+            buffer_ = ffi.from_buffer(buffer_)
+        buffers.extend(
+            (buffer_, _sizeof(ffi, buffer_) if size is None else size))
+
+    lpBytesReturned = ffi.new("LPDWORD")
+    code = library.DeviceIoControl(
+        wintype_to_cdata(hDevice), ffi.cast("DWORD", dwIoControlCode),
+        buffers[0], buffers[1], buffers[2], buffers[3], lpBytesReturned,
+        wintype_to_cdata(lpOverlapped)
+    )
+
+    if pending_check(
+            "DeviceIoControl", code, overlapped=lpOverlapped is not None):
+        return None
+
+    return int(lpBytesReturned[0])
+
+
+def set_allocation_size(hFile, size):
+    """
+    Sets the amount of disk space allocated to ``hFile`` to ``size``
+    bytes, rounded up to the cluster size, using
+    ``FileAllocationInfo``.  The size of the file does not change unless
+    ``size`` is smaller than it, in which case the file is truncated.
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, which must have been opened with
+        ``GENERIC_WRITE`` access.
+
+    :param int size:
+        The number of bytes to allocate.
+    """
+    input_check("size", size, integer_types)
+    ffi, library = dist.load()
+    info = ffi.new("PFILE_ALLOCATION_INFO")
+    info.AllocationSize.QuadPart = size
+    SetFileInformationByHandle(hFile, library.FileAllocationInfo, info)
+
+
+def set_end_of_file(hFile, size):
+    """
+    Sets the size of ``hFile`` to ``size`` bytes using
+    ``FileEndOfFileInfo``.  Unlike :func:`pywincffi.kernel32.SetEndOfFile`
+    the file pointer is not used or moved.
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, which must have been opened with
+        ``GENERIC_WRITE`` access.
+
+    :param int size:
+        The new size of the file.
+    """
+    input_check("size", size, integer_types)
+    ffi, library = dist.load()
+    info = ffi.new("PFILE_END_OF_FILE_INFO")
+    info.EndOfFile.QuadPart = size
+    SetFileInformationByHandle(hFile, library.FileEndOfFileInfo, info)
+
+
+def preallocate(hFile, size, extend=False):
+    """
+    Reserves disk space for ``hFile`` so that writing up to ``size`` bytes
+    does not need to allocate more.  Nothing is done if the file is
+    already ``size`` bytes or larger.
+
+    >>> from pywincffi.kernel32 import CreateFile, preallocate
+    >>> hFile = CreateFile(u"C:\\logs\\app.log", GENERIC_WRITE)
+    >>> preallocate(hFile, 256 * 1024 * 1024)
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, which must have been opened with
+        ``GENERIC_WRITE`` access.
+
+    :param int size:
+        The number of bytes to reserve space for.
+
+    :keyword bool extend:
+        If True the size of the file is also set to ``size``.  By default
+        only the allocation changes so appending to the file is still
+        possible and the space beyond the end of the file is released once
+        the last handle to it is closed.
+
+    :raises WindowsAPIError:
+        Raised with an ``errno`` of ``ERROR_DISK_FULL`` if there isn't
+        enough space on the volume.
+    """
+    input_check("size", size, integer_types)
+    input_check("extend", extend, allowed_values=(True, False))
+
+    if size < 0:
+        raise InputError("size", size, message="Expected `size` to be >= 0")
+
+    if size <= GetFileSizeEx(hFile):
+        return
+
+    set_allocation_size(hFile, size)
+    if extend:
+        set_end_of_file(hFile, size)
+
+
+def set_sparse(hFile, sparse=True):
+    """
+    Marks ``hFile`` as a sparse file using ``FSCTL_SET_SPARSE``.  Ranges
+    of a sparse file which are zeroed by :func:`set_zero_data` no longer
+    occupy disk space.
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, which must have been opened with
+        ``GENERIC_WRITE`` access.
+
+    :keyword bool sparse:
+        If False the file is no longer sparse.  Only supported by Windows
+        Server 2003 and later.
+    """
+    input_check("sparse", sparse, allowed_values=(True, False))
+    ffi, library = dist.load()
+    info = ffi.new("PFILE_SET_SPARSE_BUFFER")
+    info.SetSparse = sparse
+    DeviceIoControl(hFile, library.FSCTL_SET_SPARSE, lpInBuffer=info)
+
+
+def set_zero_data(hFile, offset, length):
+    """
+    Zeroes ``length`` bytes of ``hFile`` starting at ``offset`` using
+    ``FSCTL_SET_ZERO_DATA``.  If the file is sparse, see
+    :func:`set_sparse`, the disk space used by the range is released.
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, which must have been opened with
+        ``GENERIC_WRITE`` access.
+
+    :param int offset:
+        The first byte to zero.
+
+    :param int length:
+        The number of bytes to zero.
+    """
+    input_check("offset", offset, integer_types)
+    input_check("length", length, integer_types)
+
+    if offset < 0 or length < 0:
+        raise InputError(
+            "offset", offset,
+            message="Expected `offset` and `length` to be >= 0")
+
+    ffi, library = dist.load()
+    info = ffi.new("PFILE_ZERO_DATA_INFORMATION")
+    info.FileOffset.QuadPart = offset
+    info.BeyondFinalZero.QuadPart = offset + length
+    DeviceIoControl(hFile, library.FSCTL_SET_ZERO_DATA, lpInBuffer=info)
@@ -0,0 +1,280 @@
+"""
+Clock
+-----
+
+A module containing Windows functions for reading the system's clocks
+and helpers for converting ``FILETIME`` values to nanoseconds since the
+Unix epoch, either one at a time or a whole ``FILETIME[]`` array at once.
+"""
+
+import struct
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, NoneType, input_check, error_check
+from pywincffi.exceptions import InputError
+from pywincffi.wintypes import FILETIME, wintype_to_cdata
+
+# The number of 100ns intervals between the FILETIME epoch,
+# 1601-01-01, and the Unix epoch, 1970-01-01.
+EPOCH_AS_FILETIME = 116444736000000000
+
+# The size of a FILETIME in bytes.  The two DWORDs are stored low first,
+# the same layout as a little endian 64-bit integer.
+FILETIME_SIZE = 8
+
+# Values which never change while the process is running.  Populated on
+# first use by the functions below.
+_CLOCK_CACHE = {}
+
+
+def QueryPerformanceCounter():
+    """
+    Retrieves the current value of the performance counter, a high
+    resolution (<1us) time stamp for measuring time intervals.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms644904
+
+    :rtype: int
+    :returns:
+        Returns the counter in ticks.  See
+        :func:`QueryPerformanceFrequency`.
+    """
+    ffi, library = dist.load()
+    lpPerformanceCount = ffi.new("PLARGE_INTEGER")
+    code = library.QueryPerformanceCounter(lpPerformanceCount)
+    error_check("QueryPerformanceCounter", code=code, expected=NON_ZERO)
+    return lpPerformanceCount.QuadPart
+
+
+def QueryPerformanceFrequency():
+    """
+    Retrieves the frequency of the performance counter in ticks per
+    second.  The frequency is fixed at system boot so
+    :func:`performance_frequency` should usually be used instead.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms644905
+
+    :rtype: int
+    """
+    ffi, library = dist.load()
+    lpFrequency = ffi.new("PLARGE_INTEGER")
+    code = library.QueryPerformanceFrequency(lpFrequency)
+    error_check("QueryPerformanceFrequency", code=code, expected=NON_ZERO)
+    return lpFrequency.QuadPart
+
+
+def GetSystemTimePreciseAsFileTime():
+    """
+    Retrieves the current system date and time, in UTC, with the highest
+    possible precision (<1us).  The function was added in Windows 8 so on
+    older versions of Windows this falls back to
+    ``GetSystemTimeAsFileTime``, which only has the resolution of the
+    system timer.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh706895
+
+    :rtype: :class:`pywincffi.wintypes.FILETIME`
+    :returns:
+        Returns the current time.  Use :func:`filetime_to_epoch_ns` to
+        convert it.
+    """
+    _, library = dist.load()
+    lpSystemTimeAsFileTime = FILETIME()
+    library.get_system_time_precise(wintype_to_cdata(lpSystemTimeAsFileTime))
+    return lpSystemTimeAsFileTime
+
+
+def GetTickCount64():
+    """
+    Retrieves the number of milliseconds that have elapsed since the
+    system was started.  The resolution is that of the system timer,
+    typically 10-16ms.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms724411
+
+    :rtype: int
+    """
+    _, library = dist.load()
+    return int(library.GetTickCount64())
+
+
+def performance_frequency():
+    """
+    Returns :func:`QueryPerformanceFrequency`, which is retrieved once and
+    then cached.
+
+    :rtype: int
+    """
+    try:
+        return _CLOCK_CACHE["frequency"]
+    except KeyError:
+        frequency = _CLOCK_CACHE["frequency"] = QueryPerformanceFrequency()
+        return frequency
+
+
+def perf_counter_ns():
+    """
+    Returns :func:`QueryPerformanceCounter` converted to nanoseconds.  Only
+    the difference between two values is meaningful.
+
+    :rtype: int
+    """
+    return QueryPerformanceCounter() * 1000000000 // performance_frequency()
+
+
+def time_ns():
+    """
+    Returns :func:`GetSystemTimePreciseAsFileTime` as nanoseconds since
+    the Unix epoch, a drop in replacement for ``time.time()`` where
+    precision matters.
+
+    :rtype: int
+    """
+    return filetime_to_epoch_ns(GetSystemTimePreciseAsFileTime())
+
+
+def filetime_to_epoch_ns(lpFileTime):
+    """
+    Converts a single ``FILETIME`` to nanoseconds since the Unix epoch.
+
+    :type lpFileTime: :class:`pywincffi.wintypes.FILETIME` or cdata
+    :param lpFileTime:
+        The ``FILETIME`` to convert.
+
+    :rtype: int
+    """
+    value = lpFileTime.dwHighDateTime << 32 | lpFileTime.dwLowDateTime
+    return (value - EPOCH_AS_FILETIME) * 100
+
+
+def _filetime_array(ffi, lpFileTimes):
+    # Returns ``lpFileTimes`` as FILETIME cdata and the number of
+    # structures it holds.
+    if isinstance(lpFileTimes, FILETIME):
+        lpFileTimes = wintype_to_cdata(lpFileTimes)
+    if isinstance(lpFileTimes, ffi.CData):
+        if ffi.typeof(lpFileTimes).kind == "array":
+            return lpFileTimes, len(lpFileTimes)
+        return lpFileTimes, 1
+
+    data = ffi.from_buffer(lpFileTimes)
+    if len(data) % FILETIME_SIZE:
+        raise InputError(
+            "lpFileTimes", lpFileTimes,
+            message="Expected a multiple of %d bytes" % FILETIME_SIZE)
+    array = ffi.from_buffer("FILETIME[]", lpFileTimes)
+    return array, len(array)
+
+
+def _int64_array(ffi, results, count):
+    # Returns ``results`` as LONGLONG cdata with room for ``count`` values,
+    # allocating a new array if ``results`` is None.
+    if results is None:
+        return ffi.new("LONGLONG[]", count)
+    if isinstance(results, ffi.CData):
+        array = results
+    else:
+        try:
+            array = ffi.from_buffer(
+                "LONGLONG[]", results, require_writable=True)
+        except (BufferError, TypeError):
+            raise InputError(
+                "results", results,
+                message="Expected `results` to be a writable buffer")
+    if len(array) < count:
+        raise InputError(
+            "results", results,
+            message="Expected room for at least %d values" % count)
+    return array
+
+
+def filetimes_to_epoch_ns(lpFileTimes, count=None, results=None):
+    """
+    Converts an array of ``FILETIME`` structures to nanoseconds since the
+    Unix epoch.  The conversion is a single C loop writing 64-bit
+    integers into ``results`` so no Python integer is created per
+    structure, which matters for large arrays.
+
+    >>> from array import array
+    >>> epoch_ns = filetimes_to_epoch_ns(filetimes)
+    >>> epoch_ns = list(epoch_ns)  # if a list is more convenient
+    >>> epoch_ns = array("q", [0]) * len(filetimes)
+    >>> filetimes_to_epoch_ns(filetimes, results=epoch_ns)
+
+    :param lpFileTimes:
+        A ``FILETIME[]`` array or any object supporting the buffer
+        protocol, such as :class:`bytes` read from a file, holding
+        consecutive ``FILETIME`` structures.
+
+    :keyword int count:
+        The number of structures to convert.  Defaults to all of them.
+
+    :keyword results:
+        A ``LONGLONG[]`` array or writable buffer of signed 64-bit
+        integers, such as ``array("q")``, to store the results in.  A new
+        ``LONGLONG[]`` array is allocated if not provided.
+
+    :raises InputError:
+        Raised if ``lpFileTimes`` is not a whole number of ``FILETIME``
+        structures or holds fewer than ``count``, or if ``results`` is
+        too small.
+
+    :returns:
+        Returns ``results``.
+    """
+    input_check("count", count, (NoneType, ) + integer_types)
+    ffi, library = dist.load()
+    filetimes, available = _filetime_array(ffi, lpFileTimes)
+    if count is None:
+        count = available
+    elif count > available:
+        raise InputError(
+            "count", count,
+            message="Expected `count` <= %d" % available)
+
+    array = _int64_array(ffi, results, count)
+    library.filetimes_to_epoch_ns(filetimes, count, array)
+    return array if results is None else results
+
+
+def epoch_ns_to_filetimes(values, lpFileTimes=None):
+    """
+    The reverse of :func:`filetimes_to_epoch_ns`.  Converts nanoseconds
+    since the Unix epoch to ``FILETIME`` structures, truncating to
+    ``FILETIME``'s 100ns resolution, with a single :func:`struct.pack_into`
+    call.
+
+    :param values:
+        A sequence of integer nanoseconds since the Unix epoch.
+
+    :keyword lpFileTimes:
+        A ``FILETIME[]`` array to store the results in.  A new one is
+        allocated if not provided.
+
+    :returns:
+        Returns ``lpFileTimes``.
+    """
+    ffi, _ = dist.load()
+    count = len(values)
+    if lpFileTimes is None:
+        lpFileTimes = ffi.new("FILETIME[]", count)
+    elif len(lpFileTimes) < count:
+        raise InputError(
+            "lpFileTimes", lpFileTimes,
+            message="Expected room for at least %d FILETIMEs" % count)
+
+    epoch = EPOCH_AS_FILETIME
+    struct.pack_into(
+        "<%dQ" % count, ffi.buffer(lpFileTimes), 0,
+        *[value // 100 + epoch for value in values])
+    return lpFileTimes
@@ -2,12 +2,23 @@
 Communications
 --------------
 
-A module containing Windows functions related to communications.
+A module containing Windows functions related to communications and
+:class:`CommReader` which streams data from a serial port into a
+:class:`RingBuffer`.
 """
 
+from six import integer_types
+
 from pywincffi.core import dist
-from pywincffi.core.checks import NON_ZERO, input_check, error_check
-from pywincffi.wintypes import HANDLE, wintype_to_cdata
+from pywincffi.core.checks import (
+    NON_ZERO, NoneType, input_check, error_check, pending_check)
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.events import CreateEvent, ResetEvent
+from pywincffi.kernel32.file import _finish_io, _start_io
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.kernel32.overlapped import CancelIoEx, GetOverlappedResult
+from pywincffi.kernel32.synchronization import WaitForSingleObject
+from pywincffi.wintypes import HANDLE, OVERLAPPED, wintype_to_cdata
 
 
 def ClearCommError(hFile):
@@ -43,3 +54,456 @@ def ClearCommError(hFile):
 
     # TODO: Build Python instance of COMSTAT here!
     return lpErrors, lpStat
+
+
+def GetCommState(hFile):
+    """
+    Retrieves the control settings of a communications device.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363260
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device.
+
+    :returns:
+        Returns a ``DCB`` structure which can be modified and passed to
+        :func:`SetCommState`.
+    """
+    input_check("hFile", hFile, HANDLE)
+
+    ffi, library = dist.load()
+
+    lpDCB = ffi.new("LPDCB")
+    lpDCB.DCBlength = ffi.sizeof("DCB")
+    code = library.GetCommState(wintype_to_cdata(hFile), lpDCB)
+    error_check("GetCommState", code=code, expected=NON_ZERO)
+    return lpDCB
+
+
+def SetCommState(hFile, lpDCB):
+    """
+    Configures a communications device using a ``DCB`` structure, usually
+    one returned by :func:`GetCommState`:
+
+    >>> from pywincffi.kernel32 import GetCommState, SetCommState
+    >>> lpDCB = GetCommState(hFile)
+    >>> lpDCB.BaudRate = 115200
+    >>> lpDCB.ByteSize = 8
+    >>> lpDCB.Parity = library.NOPARITY
+    >>> lpDCB.StopBits = library.ONESTOPBIT
+    >>> SetCommState(hFile, lpDCB)
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363436
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device.
+
+    :param lpDCB:
+        The ``DCB`` structure holding the new settings.
+    """
+    input_check("hFile", hFile, HANDLE)
+
+    ffi, library = dist.load()
+
+    if not isinstance(lpDCB, ffi.CData) or \
+            ffi.typeof(lpDCB) is not ffi.typeof("LPDCB"):
+        raise InputError(
+            "lpDCB", lpDCB, message="Expected a DCB structure")
+
+    lpDCB.DCBlength = ffi.sizeof("DCB")
+    code = library.SetCommState(wintype_to_cdata(hFile), lpDCB)
+    error_check("SetCommState", code=code, expected=NON_ZERO)
+
+
+def SetCommTimeouts(hFile, lpCommTimeouts):
+    """
+    Sets the time-out parameters for read and write operations on a
+    communications device.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363437
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device.
+
+    :param tuple lpCommTimeouts:
+        The ``(ReadIntervalTimeout, ReadTotalTimeoutMultiplier,
+        ReadTotalTimeoutConstant, WriteTotalTimeoutMultiplier,
+        WriteTotalTimeoutConstant)`` in milliseconds.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("lpCommTimeouts", lpCommTimeouts, tuple)
+
+    if len(lpCommTimeouts) != 5:
+        raise InputError(
+            "lpCommTimeouts", lpCommTimeouts,
+            message="Expected a tuple of five time-outs")
+
+    ffi, library = dist.load()
+    code = library.SetCommTimeouts(
+        wintype_to_cdata(hFile), ffi.new("LPCOMMTIMEOUTS", lpCommTimeouts))
+    error_check("SetCommTimeouts", code=code, expected=NON_ZERO)
+
+
+def SetCommMask(hFile, dwEvtMask):
+    """
+    Specifies the events :func:`WaitCommEvent` waits for.  A pending
+    :func:`WaitCommEvent` completes when the mask is changed.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363257
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device.
+
+    :param int dwEvtMask:
+        The ``EV_*`` events to enable, or 0 to disable all of them.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("dwEvtMask", dwEvtMask, integer_types)
+
+    ffi, library = dist.load()
+    code = library.SetCommMask(
+        wintype_to_cdata(hFile), ffi.cast("DWORD", dwEvtMask))
+    error_check("SetCommMask", code=code, expected=NON_ZERO)
+
+
+def WaitCommEvent(hFile, lpEvtMask=None, lpOverlapped=None):
+    """
+    Waits for one of the events selected with :func:`SetCommMask` to
+    occur on a communications device.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363479
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device.
+
+    :keyword lpEvtMask:
+        A ``DWORD *`` the events which occurred are stored in.  Required
+        when ``lpOverlapped`` is provided because the events are stored
+        after this function has returned.
+
+    :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        If provided and the device was opened with
+        ``FILE_FLAG_OVERLAPPED`` the wait happens in the background.  The
+        event in ``lpOverlapped`` is signaled once ``lpEvtMask`` is set.
+
+    :rtype: int
+    :returns:
+        Returns the ``EV_*`` events which occurred or ``None`` if the
+        wait is pending.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("lpOverlapped", lpOverlapped, (NoneType, OVERLAPPED))
+
+    ffi, library = dist.load()
+
+    if lpEvtMask is None:
+        if lpOverlapped is not None:
+            raise InputError(
+                "lpEvtMask", lpEvtMask,
+                message="`lpEvtMask` is required with `lpOverlapped`")
+        lpEvtMask = ffi.new("LPDWORD")
+
+    code = library.WaitCommEvent(
+        wintype_to_cdata(hFile), lpEvtMask, wintype_to_cdata(lpOverlapped))
+
+    if pending_check(
+            "WaitCommEvent", code, overlapped=lpOverlapped is not None):
+        return None
+
+    return lpEvtMask[0]
+
+
+def PurgeComm(hFile, dwFlags):
+    """
+    Discards the input or output buffer of a communications device and
+    optionally aborts pending reads or writes.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363428
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device.
+
+    :param int dwFlags:
+        A combination of ``PURGE_RXABORT``, ``PURGE_RXCLEAR``,
+        ``PURGE_TXABORT`` and ``PURGE_TXCLEAR``.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("dwFlags", dwFlags, integer_types)
+
+    ffi, library = dist.load()
+    code = library.PurgeComm(
+        wintype_to_cdata(hFile), ffi.cast("DWORD", dwFlags))
+    error_check("PurgeComm", code=code, expected=NON_ZERO)
+
+
+class RingBuffer(object):
+    """
+    A fixed size byte buffer in cffi memory which data can be read into
+    directly.  When more space is needed than is free the oldest data is
+    discarded and counted in :attr:`dropped`.
+
+    :param int capacity:
+        The size of the buffer in bytes.
+    """
+    def __init__(self, capacity):
+        input_check("capacity", capacity, integer_types)
+        if capacity < 1:
+            raise InputError(
+                "capacity", capacity, message="Expected `capacity` >= 1")
+
+        ffi, _ = dist.load()
+        self._ffi = ffi
+        self.capacity = capacity
+        self.buffer = ffi.new("char[]", capacity)
+        self._start = 0
+        self._length = 0
+
+        # The number of bytes discarded to make room for newer data
+        self.dropped = 0
+
+    def __len__(self):
+        return self._length
+
+    @property
+    def free(self):
+        """The number of bytes which can be stored without dropping any"""
+        return self.capacity - self._length
+
+    def reserve(self, size):
+        """
+        Returns a ``(pointer, length)`` tuple describing up to ``size``
+        contiguous bytes of free space, discarding the oldest data if
+        needed.  ``length`` may be less than ``size`` when the free space
+        wraps around the end of the buffer.  Call :meth:`commit` with the
+        number of bytes stored.
+        """
+        size = min(size, self.capacity)
+        if size > self.free:
+            self.dropped += size - self.free
+            self.discard(size - self.free)
+
+        end = (self._start + self._length) % self.capacity
+        return self.buffer + end, min(size, self.capacity - end)
+
+    def commit(self, count):
+        """Marks ``count`` bytes returned by :meth:`reserve` as used"""
+        if count > self.free:
+            raise InputError(
+                "count", count,
+                message="Expected `count` <= %d" % self.free)
+        self._length += count
+
+    def discard(self, count):
+        """Discards up to ``count`` of the oldest bytes"""
+        count = min(count, self._length)
+        self._length -= count
+        if self._length:
+            self._start = (self._start + count) % self.capacity
+        else:
+            self._start = 0
+
+    def read(self, size=None):
+        """
+        Removes and returns up to ``size`` of the oldest bytes, all of
+        them by default.
+
+        :rtype: bytes
+        """
+        if size is None or size > self._length:
+            size = self._length
+
+        ffi = self._ffi
+        first = min(size, self.capacity - self._start)
+        data = ffi.buffer(self.buffer + self._start, first)[:]
+        if first < size:
+            data += ffi.buffer(self.buffer, size - first)[:]
+        self.discard(size)
+        return data
+
+
+class CommReader(object):
+    """
+    Streams data from a communications device into a :class:`RingBuffer`.
+    An overlapped :func:`WaitCommEvent` for ``EV_RXCHAR`` is kept
+    outstanding and, once it completes, :func:`ClearCommError` reports how
+    many bytes are queued so exactly that many are read without waiting.
+
+    >>> from pywincffi.kernel32 import CommReader, CreateFile
+    >>> hFile = CreateFile(
+    ...     u"\\\\.\\COM3", library.GENERIC_READ | library.GENERIC_WRITE,
+    ...     dwCreationDisposition=library.OPEN_EXISTING,
+    ...     dwFlagsAndAttributes=library.FILE_FLAG_OVERLAPPED)
+    >>> with CommReader(hFile) as reader:
+    ...     while True:
+    ...         if reader.poll(100):
+    ...             handle_samples(reader.read())
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        A handle to the communications device opened with
+        ``FILE_FLAG_OVERLAPPED``.  The handle is not closed by
+        :meth:`close`.
+
+    :keyword int capacity:
+        The size of the :class:`RingBuffer` in bytes.
+
+    :keyword int dwEvtMask:
+        The events to wait for.  Defaults to ``EV_RXCHAR | EV_ERR``.
+    """
+    def __init__(self, hFile, capacity=64 * 1024, dwEvtMask=None):
+        input_check("hFile", hFile, HANDLE)
+
+        ffi, library = dist.load()
+
+        if dwEvtMask is None:
+            dwEvtMask = library.EV_RXCHAR | library.EV_ERR
+
+        self.hFile = hFile
+        self.ring = RingBuffer(capacity)
+        self.closed = False
+        self._pending = False
+        self._mask = ffi.new("LPDWORD")
+        self._transferred = ffi.new("LPDWORD")
+        self._overrun_errors = library.CE_OVERRUN | library.CE_RXOVER
+
+        # The COMSTAT from the most recent ClearCommError call, which
+        # includes the hold flags and output queue size.
+        self.status = None
+
+        # Counters for the events handled, bytes read and the number of
+        # times ClearCommError reported that data was lost by the device
+        # or driver because it was not read quickly enough.
+        self.events = 0
+        self.bytes_read = 0
+        self.overruns = 0
+        self.errors = 0
+
+        SetCommMask(hFile, dwEvtMask)
+        self.hEvent = CreateEvent()
+        try:
+            self.hReadEvent = CreateEvent()
+        except WindowsAPIError:
+            CloseHandle(self.hEvent)
+            raise
+
+        self._overlapped = OVERLAPPED()
+        self._overlapped.hEvent = self.hEvent
+        self._read_overlapped = OVERLAPPED()
+        self._read_overlapped.hEvent = self.hReadEvent
+
+    def poll(self, dwMilliseconds=0):
+        """
+        Waits up to ``dwMilliseconds`` for an event and, if one occurs,
+        calls :meth:`drain`.
+
+        :rtype: int
+        :returns:
+            Returns the number of bytes added to :attr:`ring`.
+        """
+        if self._wait(dwMilliseconds) is None:
+            return 0
+        self.events += 1
+        return self.drain()
+
+    def _wait(self, dwMilliseconds):
+        _, library = dist.load()
+
+        if not self._pending:
+            ResetEvent(self.hEvent)
+            mask = WaitCommEvent(self.hFile, self._mask, self._overlapped)
+            if mask is not None:
+                return mask
+            self._pending = True
+
+        if WaitForSingleObject(self.hEvent, dwMilliseconds) == \
+                library.WAIT_TIMEOUT:
+            return None
+
+        self._pending = False
+        GetOverlappedResult(self.hFile, self._overlapped, True)
+        return self._mask[0]
+
+    def drain(self):
+        """
+        Reads every byte queued by the device into :attr:`ring` and
+        records any overrun reported by :func:`ClearCommError`.
+
+        :rtype: int
+        :returns:
+            Returns the number of bytes read.
+        """
+        lpErrors, lpStat = ClearCommError(self.hFile)
+        self.status = lpStat
+        if lpErrors[0]:
+            self.errors |= lpErrors[0]
+            if lpErrors[0] & self._overrun_errors:
+                self.overruns += 1
+
+        total = 0
+        remaining = lpStat.cbInQue
+        while remaining:
+            pointer, length = self.ring.reserve(remaining)
+            count = self._read_into(pointer, length)
+            self.ring.commit(count)
+            total += count
+            remaining -= count
+            if count < length:
+                break
+
+        self.bytes_read += total
+        return total
+
+    def _read_into(self, pointer, length):
+        # ReadFile() allocates a new buffer for each call so the read
+        # goes straight into the ring buffer instead.
+        count = _start_io(
+            "ReadFile", self.hFile, pointer, length, self._read_overlapped,
+            lpNumberOfBytes=self._transferred)
+        if count is None:
+            count = _finish_io("ReadFile", self.hFile, self._read_overlapped)
+        return count
+
+    def read(self, size=None):
+        """Removes and returns up to ``size`` bytes from :attr:`ring`"""
+        return self.ring.read(size)
+
+    def close(self):
+        """
+        Cancels the outstanding wait and closes the events.  Calling this
+        more than once has no effect.
+        """
+        if self.closed:
+            return
+
+        _, library = dist.load()
+        self.closed = True
+        try:
+            if self._pending:
+                CancelIoEx(self.hFile, self._overlapped)
+                try:
+                    GetOverlappedResult(self.hFile, self._overlapped, True)
+                except WindowsAPIError as error:
+                    if error.errno != library.ERROR_OPERATION_ABORTED:
+                        raise
+                    library.SetLastError(0)
+                self._pending = False
+        finally:
+            CloseHandle(self.hEvent)
+            CloseHandle(self.hReadEvent)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
@@ -6,11 +6,11 @@ A module containing functions for interacting with a Windows
 console.
 """
 
-from six import integer_types
+from six import integer_types, text_type
 
 from pywincffi.core import dist
 from pywincffi.core.checks import NON_ZERO, NoneType, input_check, error_check
-from pywincffi.exceptions import WindowsAPIError
+from pywincffi.exceptions import InputError, WindowsAPIError
 from pywincffi.wintypes import HANDLE, SECURITY_ATTRIBUTES, wintype_to_cdata
 
 
@@ -32,8 +32,6 @@ def SetConsoleTextAttribute(hConsoleOutput, wAttributes):
     input_check("hConsoleOutput", hConsoleOutput, HANDLE)
     input_check("wAttributes", wAttributes, integer_types)
     ffi, library = dist.load()
-    # raise Exception(type(wAttributes))
-    # info = ffi.new("PCHAR_INFO")
     code = library.SetConsoleTextAttribute(
         wintype_to_cdata(hConsoleOutput),
         ffi.cast("ATOM", wAttributes)
@@ -154,3 +152,261 @@ def CreateConsoleScreenBuffer(
             expected_return_code="not INVALID_HANDLE_VALUE")
 
     return HANDLE(handle)
+
+
+def _input_records(ffi, lpBuffer, nLength):
+    if lpBuffer is None:
+        return ffi.new("INPUT_RECORD[]", nLength or 128)
+    if nLength is not None and nLength > len(lpBuffer):
+        raise InputError(
+            "nLength", nLength,
+            message="Expected `nLength` <= %d, the length of lpBuffer" %
+                    len(lpBuffer))
+    return lpBuffer
+
+
+def _console_input(function, hConsoleInput, lpBuffer, nLength):
+    input_check("hConsoleInput", hConsoleInput, HANDLE)
+    input_check("nLength", nLength, (NoneType, ) + integer_types)
+    ffi, library = dist.load()
+    lpBuffer = _input_records(ffi, lpBuffer, nLength)
+    count = ffi.new("DWORD *")
+    code = getattr(library, function)(
+        wintype_to_cdata(hConsoleInput), lpBuffer,
+        len(lpBuffer) if nLength is None else nLength, count)
+    error_check(function, code, expected=NON_ZERO)
+    return lpBuffer, count[0]
+
+
+def ReadConsoleInputW(hConsoleInput, lpBuffer=None, nLength=None):
+    """
+    Reads and removes as many input records as are available, up to
+    ``nLength``, from a console input buffer.  The call blocks until at
+    least one record is available.
+
+    .. seealso::
+
+        https://docs.microsoft.com/en-us/windows/console/readconsoleinput
+
+    :param pywincffi.wintypes.HANDLE hConsoleInput:
+        A handle to the console input buffer. The handle must have the
+        ``GENERIC_READ`` access right.
+
+    :keyword lpBuffer:
+        An ``INPUT_RECORD[]`` array to read into.  Passing the same array
+        to every call avoids allocating one each time.  A new array is
+        allocated if not provided.
+
+    :keyword int nLength:
+        The maximum number of records to read.  Defaults to the length of
+        ``lpBuffer``, or 128 if a new array is allocated.
+
+    :rtype: tuple
+    :returns:
+        Returns a tuple of ``(lpBuffer, count)`` where ``count`` is the
+        number of records read into ``lpBuffer``.  Use
+        :func:`pywincffi.kernel32.consoleinput.decode_input_records` to
+        convert them.
+    """
+    return _console_input(
+        "ReadConsoleInputW", hConsoleInput, lpBuffer, nLength)
+
+
+def PeekConsoleInputW(hConsoleInput, lpBuffer=None, nLength=None):
+    """
+    Same as :func:`ReadConsoleInputW` except the records are left in the
+    input buffer and the call returns immediately, with a ``count`` of 0,
+    if there are no records.
+
+    .. seealso::
+
+        https://docs.microsoft.com/en-us/windows/console/peekconsoleinput
+    """
+    return _console_input(
+        "PeekConsoleInputW", hConsoleInput, lpBuffer, nLength)
+
+
+def GetNumberOfConsoleInputEvents(hConsoleInput):
+    """
+    Returns the number of unread input records in a console input
+    buffer.
+
+    .. seealso::
+
+        https://docs.microsoft.com/en-us/windows/console/getnumberofconsoleinputevents
+
+    :param pywincffi.wintypes.HANDLE hConsoleInput:
+        A handle to the console input buffer. The handle must have the
+        ``GENERIC_READ`` access right.
+
+    :rtype: int
+    """
+    input_check("hConsoleInput", hConsoleInput, HANDLE)
+    ffi, library = dist.load()
+    count = ffi.new("DWORD *")
+    code = library.GetNumberOfConsoleInputEvents(
+        wintype_to_cdata(hConsoleInput), count)
+    error_check("GetNumberOfConsoleInputEvents", code, expected=NON_ZERO)
+    return count[0]
+
+
+def WriteConsoleW(hConsoleOutput, lpBuffer):
+    """
+    Writes a string to a console screen buffer at the current cursor
+    position using the current text attributes.
+
+    .. seealso::
+
+        https://docs.microsoft.com/en-us/windows/console/writeconsole
+
+    :param pywincffi.wintypes.HANDLE hConsoleOutput:
+        A handle to the console screen buffer. The handle must have the
+        ``GENERIC_WRITE`` access right.
+
+    :param str lpBuffer:
+        The text to write.
+
+    :rtype: int
+    :returns:
+        Returns the number of UTF-16 code units written which may be less
+        than the length of ``lpBuffer`` encoded as UTF-16.
+    """
+    input_check("hConsoleOutput", hConsoleOutput, HANDLE)
+    input_check("lpBuffer", lpBuffer, text_type)
+    ffi, library = dist.load()
+    buffer_ = ffi.new("WCHAR[]", lpBuffer)
+    written = ffi.new("DWORD *")
+    code = library.WriteConsoleW(
+        wintype_to_cdata(hConsoleOutput), buffer_, len(buffer_) - 1,
+        written, ffi.NULL)
+    error_check("WriteConsoleW", code, expected=NON_ZERO)
+    return written[0]
+
+
+def _coord(name, value):
+    input_check(name, value, tuple)
+    if len(value) != 2:
+        raise InputError(name, value, message="Expected an (x, y) tuple")
+    return value
+
+
+def _region(ffi, name, value):
+    input_check(name, value, tuple)
+    if len(value) != 4:
+        raise InputError(
+            name, value,
+            message="Expected a (left, top, right, bottom) tuple")
+    return ffi.new("SMALL_RECT *", value)
+
+
+def WriteConsoleOutputW(
+        hConsoleOutput, lpBuffer, dwBufferSize, dwBufferCoord=(0, 0),
+        lpWriteRegion=None):
+    """
+    Writes a rectangle of character cells from ``lpBuffer`` to a console
+    screen buffer in a single call.
+
+    .. seealso::
+
+        https://docs.microsoft.com/en-us/windows/console/writeconsoleoutput
+
+    :param pywincffi.wintypes.HANDLE hConsoleOutput:
+        A handle to the console screen buffer. The handle must have the
+        ``GENERIC_WRITE`` access right.
+
+    :param lpBuffer:
+        A ``CHAR_INFO[]`` array holding ``columns * rows`` cells in row
+        major order.
+
+    :param tuple dwBufferSize:
+        The ``(columns, rows)`` of ``lpBuffer``.
+
+    :keyword tuple dwBufferCoord:
+        The ``(x, y)`` cell of ``lpBuffer`` copied to the top left corner
+        of ``lpWriteRegion``.
+
+    :keyword tuple lpWriteRegion:
+        The ``(left, top, right, bottom)`` cells of the screen buffer to
+        write, inclusive.  Defaults to the size of ``lpBuffer`` starting
+        at the top left corner of the screen buffer.
+
+    :rtype: tuple
+    :returns:
+        Returns the ``(left, top, right, bottom)`` cells which were
+        actually written, which may be smaller than ``lpWriteRegion`` if
+        it extended past the edge of the screen buffer.
+    """
+    input_check("hConsoleOutput", hConsoleOutput, HANDLE)
+    columns, rows = _coord("dwBufferSize", dwBufferSize)
+    dwBufferCoord = _coord("dwBufferCoord", dwBufferCoord)
+    ffi, library = dist.load()
+    if len(lpBuffer) < columns * rows:
+        raise InputError(
+            "lpBuffer", lpBuffer,
+            message="Expected at least %d cells" % (columns * rows))
+
+    if lpWriteRegion is None:
+        lpWriteRegion = (0, 0, columns - 1, rows - 1)
+    region = _region(ffi, "lpWriteRegion", lpWriteRegion)
+
+    code = library.WriteConsoleOutputW(
+        wintype_to_cdata(hConsoleOutput), lpBuffer, dwBufferSize,
+        dwBufferCoord, region)
+    error_check("WriteConsoleOutputW", code, expected=NON_ZERO)
+    return region.Left, region.Top, region.Right, region.Bottom
+
+
+def ReadConsoleOutputW(
+        hConsoleOutput, dwBufferSize, dwBufferCoord=(0, 0),
+        lpReadRegion=None, lpBuffer=None):
+    """
+    Reads a rectangle of character cells from a console screen buffer.
+
+    .. seealso::
+
+        https://docs.microsoft.com/en-us/windows/console/readconsoleoutput
+
+    :param pywincffi.wintypes.HANDLE hConsoleOutput:
+        A handle to the console screen buffer. The handle must have the
+        ``GENERIC_READ`` access right.
+
+    :param tuple dwBufferSize:
+        The ``(columns, rows)`` of ``lpBuffer``.
+
+    :keyword tuple dwBufferCoord:
+        The ``(x, y)`` cell of ``lpBuffer`` the top left corner of
+        ``lpReadRegion`` is copied to.
+
+    :keyword tuple lpReadRegion:
+        The ``(left, top, right, bottom)`` cells of the screen buffer to
+        read, inclusive.  Defaults to the size of ``lpBuffer``.
+
+    :keyword lpBuffer:
+        A ``CHAR_INFO[]`` array of at least ``columns * rows`` cells to
+        read into.  A new array is allocated if not provided.
+
+    :rtype: tuple
+    :returns:
+        Returns a tuple of ``(lpBuffer, region)`` where ``region`` is the
+        ``(left, top, right, bottom)`` cells which were actually read.
+    """
+    input_check("hConsoleOutput", hConsoleOutput, HANDLE)
+    columns, rows = _coord("dwBufferSize", dwBufferSize)
+    dwBufferCoord = _coord("dwBufferCoord", dwBufferCoord)
+    ffi, library = dist.load()
+    if lpBuffer is None:
+        lpBuffer = ffi.new("CHAR_INFO[]", columns * rows)
+    elif len(lpBuffer) < columns * rows:
+        raise InputError(
+            "lpBuffer", lpBuffer,
+            message="Expected at least %d cells" % (columns * rows))
+
+    if lpReadRegion is None:
+        lpReadRegion = (0, 0, columns - 1, rows - 1)
+    region = _region(ffi, "lpReadRegion", lpReadRegion)
+
+    code = library.ReadConsoleOutputW(
+        wintype_to_cdata(hConsoleOutput), lpBuffer, dwBufferSize,
+        dwBufferCoord, region)
+    error_check("ReadConsoleOutputW", code, expected=NON_ZERO)
+    return lpBuffer, (region.Left, region.Top, region.Right, region.Bottom)
@@ -0,0 +1,175 @@
+"""
+Console Input
+-------------
+
+Decodes the ``INPUT_RECORD`` arrays filled by
+:func:`pywincffi.kernel32.console.ReadConsoleInputW` and
+:func:`pywincffi.kernel32.console.PeekConsoleInputW` into named tuples
+and provides :class:`ConsoleInputReader` which reads many records per
+call into a single reusable array.
+"""
+
+from collections import namedtuple
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check
+from pywincffi.exceptions import InputError
+from pywincffi.kernel32.console import (
+    GetNumberOfConsoleInputEvents, PeekConsoleInputW, ReadConsoleInputW)
+from pywincffi.wintypes import HANDLE
+
+KeyEvent = namedtuple(
+    "KeyEvent",
+    ("key_down", "repeat_count", "virtual_key_code", "virtual_scan_code",
+     "char", "control_key_state"))
+
+MouseEvent = namedtuple(
+    "MouseEvent",
+    ("x", "y", "button_state", "control_key_state", "event_flags"))
+
+WindowBufferSizeEvent = namedtuple(
+    "WindowBufferSizeEvent", ("columns", "rows"))
+
+MenuEvent = namedtuple("MenuEvent", ("command_id", ))
+
+FocusEvent = namedtuple("FocusEvent", ("set_focus", ))
+
+
+def _key_event(record):
+    event = record.Event.KeyEvent
+    return KeyEvent(
+        bool(event.bKeyDown), event.wRepeatCount, event.wVirtualKeyCode,
+        event.wVirtualScanCode, event.uChar.UnicodeChar,
+        event.dwControlKeyState)
+
+
+def _mouse_event(record):
+    event = record.Event.MouseEvent
+    position = event.dwMousePosition
+    return MouseEvent(
+        position.X, position.Y, event.dwButtonState,
+        event.dwControlKeyState, event.dwEventFlags)
+
+
+def _window_buffer_size_event(record):
+    size = record.Event.WindowBufferSizeEvent.dwSize
+    return WindowBufferSizeEvent(size.X, size.Y)
+
+
+def _menu_event(record):
+    return MenuEvent(record.Event.MenuEvent.dwCommandId)
+
+
+def _focus_event(record):
+    return FocusEvent(bool(record.Event.FocusEvent.bSetFocus))
+
+
+def _decoders():
+    _, library = dist.load()
+    return {
+        library.KEY_EVENT: _key_event,
+        library.MOUSE_EVENT: _mouse_event,
+        library.WINDOW_BUFFER_SIZE_EVENT: _window_buffer_size_event,
+        library.MENU_EVENT: _menu_event,
+        library.FOCUS_EVENT: _focus_event
+    }
+
+
+def decode_input_records(lpBuffer, count, decoders=None):
+    """
+    Decodes the first ``count`` records of an ``INPUT_RECORD[]`` array.
+
+    :param lpBuffer:
+        The ``INPUT_RECORD[]`` array to decode.
+
+    :param int count:
+        The number of records in ``lpBuffer`` to decode.
+
+    :keyword dict decoders:
+        Used internally by :class:`ConsoleInputReader` to avoid building
+        the mapping of event types to decoders on every call.
+
+    :rtype: list
+    :returns:
+        Returns a list containing a :class:`KeyEvent`,
+        :class:`MouseEvent`, :class:`WindowBufferSizeEvent`,
+        :class:`MenuEvent` or :class:`FocusEvent` for each record.
+        Records with an unknown event type are skipped.
+    """
+    if decoders is None:
+        decoders = _decoders()
+
+    events = []
+    for index in range(count):
+        record = lpBuffer[index]
+        decoder = decoders.get(record.EventType)
+        if decoder is not None:
+            events.append(decoder(record))
+    return events
+
+
+class ConsoleInputReader(object):
+    """
+    Reads input events from a console input buffer, draining up to
+    ``size`` records per call into the same ``INPUT_RECORD[]`` array.
+
+    >>> from pywincffi.kernel32 import ConsoleInputReader, GetStdHandle
+    >>> reader = ConsoleInputReader(GetStdHandle(library.STD_INPUT_HANDLE))
+    >>> for event in reader.read():
+    ...     print(event)
+
+    :param pywincffi.wintypes.HANDLE hConsoleInput:
+        A handle to the console input buffer. The handle must have the
+        ``GENERIC_READ`` access right.
+
+    :keyword int size:
+        The number of records read by each call.
+    """
+    def __init__(self, hConsoleInput, size=128):
+        input_check("hConsoleInput", hConsoleInput, HANDLE)
+        input_check("size", size, integer_types)
+        if size < 1:
+            raise InputError("size", size, message="Expected `size` >= 1")
+
+        ffi, _ = dist.load()
+        self.hConsoleInput = hConsoleInput
+        self.records = ffi.new("INPUT_RECORD[]", size)
+        self._decoders = _decoders()
+        self.calls = 0
+        self.events = 0
+
+    def pending(self):
+        """Returns the number of unread records in the input buffer"""
+        return GetNumberOfConsoleInputEvents(self.hConsoleInput)
+
+    def read(self):
+        """
+        Reads and decodes the available records, blocking until there is
+        at least one.
+        """
+        _, count = ReadConsoleInputW(self.hConsoleInput, self.records)
+        return self._decode(count)
+
+    def read_available(self):
+        """
+        Same as :meth:`read` but returns an empty list rather than
+        blocking when there are no records.
+        """
+        if not self.pending():
+            return []
+        return self.read()
+
+    def peek(self):
+        """
+        Decodes the available records without removing them from the
+        input buffer.  Does not block.
+        """
+        _, count = PeekConsoleInputW(self.hConsoleInput, self.records)
+        return self._decode(count)
+
+    def _decode(self, count):
+        self.calls += 1
+        self.events += count
+        return decode_input_records(self.records, count, self._decoders)
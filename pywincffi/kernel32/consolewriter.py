@@ -0,0 +1,201 @@
+"""
+Console Writer
+--------------
+
+Buffered output for colored console text.  Calling
+:func:`pywincffi.kernel32.console.SetConsoleTextAttribute` and writing
+before every colored segment costs two calls per segment, most of which
+only set the attributes the console already has.
+:class:`ConsoleWriter` instead collects text into runs of equal
+attributes and writes each run with one ``WriteConsoleW`` call, only
+changing the attributes when they differ from the last ones it set.
+"""
+
+from collections import namedtuple
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, input_check, error_check
+from pywincffi.core.compat import monotonic
+from pywincffi.exceptions import WindowsAPIError
+from pywincffi.kernel32.console import GetConsoleScreenBufferInfo
+from pywincffi.wintypes import HANDLE, wintype_to_cdata
+
+WriterStatistics = namedtuple(
+    "WriterStatistics",
+    ("lines", "writes", "switches", "seconds", "lines_per_second"))
+
+
+class ConsoleWriter(object):
+    """
+    Buffers text written to a console screen buffer and flushes it with
+    as few calls as possible.  Consecutive writes with the same
+    attributes are coalesced into a single run, each run is written with
+    one ``WriteConsoleW`` call and ``SetConsoleTextAttribute`` is only
+    called when a run's attributes differ from the cached attributes of
+    the console.
+
+    >>> from pywincffi.kernel32 import ConsoleWriter, GetStdHandle
+    >>> with ConsoleWriter(GetStdHandle(library.STD_OUTPUT_HANDLE)) as out:
+    ...     out.write(u"[ ")
+    ...     out.write(u"OK", library.FOREGROUND_GREEN)
+    ...     out.writeline(u" ] started")
+
+    :param pywincffi.wintypes.HANDLE hConsoleOutput:
+        A handle to the console screen buffer.  The handle must have the
+        ``GENERIC_WRITE`` access right and also ``GENERIC_READ`` if
+        ``attributes`` is not provided.
+
+    :keyword int attributes:
+        The attributes used by :meth:`write` when none are given.  If not
+        provided the screen buffer's current attributes are used.
+
+    :keyword int buffer_size:
+        The number of characters which may be buffered before
+        :meth:`write` flushes automatically.
+    """
+    def __init__(self, hConsoleOutput, attributes=None, buffer_size=4096):
+        input_check("hConsoleOutput", hConsoleOutput, HANDLE)
+        input_check("buffer_size", buffer_size, integer_types)
+        ffi, library = dist.load()
+        self._ffi = ffi
+        self._library = library
+        self._handle = wintype_to_cdata(hConsoleOutput)
+        self._written = ffi.new("DWORD *")
+        self.hConsoleOutput = hConsoleOutput
+        self.buffer_size = buffer_size
+
+        if attributes is None:
+            info = GetConsoleScreenBufferInfo(hConsoleOutput)
+            attributes = info.wAttributes
+
+            # The attributes the console is known to have, None if unknown
+            self.current = attributes
+        else:
+            input_check("attributes", attributes, integer_types)
+            self.current = None
+
+        self.attributes = attributes
+        self._runs = []
+        self._pending = 0
+        self.lines = 0
+        self.writes = 0
+        self.switches = 0
+        self.seconds = 0.0
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.flush()
+
+    def write(self, text, attributes=None):
+        """
+        Buffers ``text`` to be written with ``attributes``, or the
+        writer's default attributes if not provided.
+        """
+        input_check("text", text, text_type)
+        if attributes is None:
+            attributes = self.attributes
+        else:
+            input_check("attributes", attributes, integer_types)
+        if not text:
+            return
+
+        runs = self._runs
+        if runs and runs[-1][0] == attributes:
+            runs[-1][1].append(text)
+        else:
+            runs.append((attributes, [text]))
+
+        self._pending += len(text)
+        if self._pending >= self.buffer_size:
+            self.flush()
+
+    def writeline(self, text=u"", attributes=None):
+        """Same as :meth:`write` but also ends the line"""
+        self.write(text + u"\n", attributes)
+
+    def invalidate(self):
+        """
+        Forgets the cached attributes so the next run always sets them.
+        Use this when something else may have changed the attributes of
+        the screen buffer.
+        """
+        self.current = None
+
+    def flush(self):
+        """
+        Writes all of the buffered text, switching attributes only between
+        runs whose attributes differ.  If a call fails, the text which was
+        not written yet stays buffered for the next flush.
+        """
+        runs = self._runs
+        if not runs:
+            return
+
+        flushed = 0
+        start = monotonic()
+        try:
+            for attributes, parts in runs:
+                if attributes != self.current:
+                    self._set_attributes(attributes)
+                text = u"".join(parts)
+                self._write(text, parts)
+                self.lines += text.count(u"\n")
+                flushed += 1
+        finally:
+            del runs[:flushed]
+            self._pending = sum(
+                len(part) for _, parts in runs for part in parts)
+            self.seconds += monotonic() - start
+
+    def statistics(self):
+        """
+        Returns a :class:`WriterStatistics` tuple with the number of lines
+        flushed, the number of ``WriteConsoleW`` and
+        ``SetConsoleTextAttribute`` calls made, the seconds spent flushing
+        and the resulting throughput in lines per second.
+        """
+        seconds = self.seconds
+        return WriterStatistics(
+            self.lines, self.writes, self.switches, seconds,
+            self.lines / seconds if seconds else 0.0)
+
+    def _set_attributes(self, attributes):
+        # The handle and attributes were checked on the way in so the
+        # library is called directly rather than through
+        # SetConsoleTextAttribute().
+        self.current = None
+        code = self._library.SetConsoleTextAttribute(self._handle, attributes)
+        error_check("SetConsoleTextAttribute", code=code, expected=NON_ZERO)
+        self.current = attributes
+        self.switches += 1
+
+    def _write(self, text, parts):
+        # Writes ``text``, the joined ``parts`` of a run.  On failure
+        # ``parts`` is replaced with whatever was not written so the run
+        # can be retried.
+        ffi = self._ffi
+        buffer_ = ffi.new("WCHAR[]", text)
+        offset = 0
+        remaining = len(buffer_) - 1
+        try:
+            while remaining:
+                code = self._library.WriteConsoleW(
+                    self._handle, buffer_ + offset, remaining, self._written,
+                    ffi.NULL)
+                error_check("WriteConsoleW", code=code, expected=NON_ZERO)
+                self.writes += 1
+                written = self._written[0]
+                if not written:
+                    # Looping would never finish and dropping the text
+                    # would lose it, so treat this like any other error.
+                    raise WindowsAPIError(
+                        "WriteConsoleW", "No characters were written", 0)
+                offset += written
+                remaining -= written
+        except Exception:
+            parts[:] = [ffi.string(buffer_ + offset, remaining)]
+            raise
@@ -0,0 +1,470 @@
+"""
+Directories
+-----------
+
+A module containing Windows functions for enumerating the contents of
+directories.  :func:`iter_directory` reads many entries with each call to
+:func:`GetFileInformationByHandleEx`, parsing them directly out of a single
+reused buffer, and :func:`walk` builds a recursive walk on top of it.
+:func:`find_files` does the same for wildcard patterns using
+:func:`FindFirstFileEx`.
+"""
+
+import os
+from collections import namedtuple
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, input_check, error_check
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.file import CreateFile
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.wintypes import HANDLE, wintype_to_cdata
+
+# The size of the buffer used by iter_directory() and walk() by default.
+# Larger buffers mean fewer calls for directories with many entries.
+DEFAULT_BUFFER_SIZE = 64 * 1024
+
+
+class DirectoryEntry(namedtuple(
+        "DirectoryEntry",
+        ("name", "attributes", "size", "creation_time", "last_access_time",
+         "last_write_time", "file_id"))):
+    """
+    A single entry produced by :func:`iter_directory` or :func:`find_files`.
+    Times are ``FILETIME`` values, the number of 100 nanosecond intervals
+    since January 1, 1601 (UTC).  ``file_id`` is ``None`` for entries from
+    :func:`find_files`.
+    """
+    __slots__ = ()
+
+    @property
+    def is_directory(self):
+        """True if the entry is a directory"""
+        _, library = dist.load()
+        return bool(self.attributes & library.FILE_ATTRIBUTE_DIRECTORY)
+
+    @property
+    def is_reparse_point(self):
+        """True if the entry is a reparse point such as a symlink"""
+        _, library = dist.load()
+        return bool(self.attributes & library.FILE_ATTRIBUTE_REPARSE_POINT)
+
+
+def _filetime(filetime):
+    return filetime.dwHighDateTime << 32 | filetime.dwLowDateTime
+
+
+def FindFirstFileEx(
+        lpFileName, fInfoLevelId=None, fSearchOp=None,
+        dwAdditionalFlags=None):
+    """
+    Searches a directory for a file or subdirectory with a name that
+    matches ``lpFileName``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa364419
+
+    :param str lpFileName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The directory and file name to search for, which may include
+        wildcards such as ``C:\\data\\*``.
+
+    :keyword int fInfoLevelId:
+        The information level of the returned data.  Defaults to
+        ``FindExInfoBasic`` which skips looking up short names.
+
+    :keyword int fSearchOp:
+        The type of filtering to perform.  Defaults to
+        ``FindExSearchNameMatch``.
+
+    :keyword int dwAdditionalFlags:
+        Defaults to ``FIND_FIRST_EX_LARGE_FETCH`` which uses a larger
+        buffer for directory queries.
+
+    :rtype: tuple
+    :returns:
+        Returns a tuple containing the search :class:`HANDLE` and the
+        ``WIN32_FIND_DATA`` structure holding the first match.  Pass both
+        to :func:`FindNextFile` for the next match and close the handle
+        with :func:`FindClose`.
+
+    :raises WindowsAPIError:
+        Raised if nothing matches, with an ``errno`` of
+        ``ERROR_FILE_NOT_FOUND``, or if the search fails.
+    """
+    ffi, library = dist.load()
+
+    if fInfoLevelId is None:
+        fInfoLevelId = library.FindExInfoBasic
+
+    if fSearchOp is None:
+        fSearchOp = library.FindExSearchNameMatch
+
+    if dwAdditionalFlags is None:
+        dwAdditionalFlags = library.FIND_FIRST_EX_LARGE_FETCH
+
+    input_check("lpFileName", lpFileName, text_type)
+    input_check(
+        "fInfoLevelId", fInfoLevelId,
+        allowed_values=(library.FindExInfoStandard, library.FindExInfoBasic))
+    input_check("fSearchOp", fSearchOp, integer_types)
+    input_check("dwAdditionalFlags", dwAdditionalFlags, integer_types)
+
+    lpFindFileData = ffi.new("LPWIN32_FIND_DATA")
+    handle = library.FindFirstFileEx(
+        lpFileName, fInfoLevelId, lpFindFileData, fSearchOp, ffi.NULL,
+        dwAdditionalFlags
+    )
+    if int(ffi.cast("intptr_t", handle)) == library.INVALID_HANDLE_VALUE:
+        errno, message = ffi.getwinerror()
+        raise WindowsAPIError("FindFirstFileEx", message, errno)
+
+    return HANDLE(handle), lpFindFileData
+
+
+def FindNextFile(hFindFile, lpFindFileData):
+    """
+    Continues a search started by :func:`FindFirstFileEx`, storing the
+    next match in ``lpFindFileData``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa364428
+
+    :param pywincffi.wintypes.HANDLE hFindFile:
+        The search handle returned by :func:`FindFirstFileEx`.
+
+    :param lpFindFileData:
+        The ``WIN32_FIND_DATA`` structure returned by
+        :func:`FindFirstFileEx`.
+
+    :rtype: bool
+    :returns:
+        Returns False once there are no more matches.
+    """
+    input_check("hFindFile", hFindFile, HANDLE)
+
+    ffi, library = dist.load()
+    code = library.FindNextFile(wintype_to_cdata(hFindFile), lpFindFileData)
+    if code == 0:
+        errno, message = ffi.getwinerror()
+        if errno != library.ERROR_NO_MORE_FILES:
+            raise WindowsAPIError(
+                "FindNextFile", message, errno, return_code=code,
+                expected_return_code=NON_ZERO)
+        library.SetLastError(0)
+        return False
+    return True
+
+
+def FindClose(hFindFile):
+    """
+    Closes a search handle opened by :func:`FindFirstFileEx`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa364413
+
+    :param pywincffi.wintypes.HANDLE hFindFile:
+        The search handle to close.
+    """
+    input_check("hFindFile", hFindFile, HANDLE)
+
+    _, library = dist.load()
+    code = library.FindClose(wintype_to_cdata(hFindFile))
+    error_check("FindClose", code=code, expected=NON_ZERO)
+
+
+def GetFileInformationByHandleEx(
+        hFile, FileInformationClass, lpFileInformation, dwBufferSize):
+    """
+    Retrieves information about ``hFile`` into ``lpFileInformation``.  With
+    a ``FileInformationClass`` of ``FileIdBothDirectoryInfo`` and a
+    directory handle this retrieves as many directory entries as will fit
+    into the buffer.  See :func:`parse_directory_info`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa364953
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The file or directory to retrieve information for.
+
+    :param int FileInformationClass:
+        The type of information to retrieve.
+
+    :param lpFileInformation:
+        The buffer, such as one created with ``ffi.new("char[]", size)``,
+        to store the information in.
+
+    :param int dwBufferSize:
+        The size of ``lpFileInformation`` in bytes.
+
+    :raises WindowsAPIError:
+        Raised if the call fails.  Once every directory entry has been
+        returned this fails with ``ERROR_NO_MORE_FILES``.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("FileInformationClass", FileInformationClass, integer_types)
+    input_check("dwBufferSize", dwBufferSize, integer_types)
+
+    _, library = dist.load()
+    code = library.GetFileInformationByHandleEx(
+        wintype_to_cdata(hFile), FileInformationClass, lpFileInformation,
+        dwBufferSize
+    )
+    error_check("GetFileInformationByHandleEx", code=code, expected=NON_ZERO)
+
+
+def parse_directory_info(lpFileInformation, dwBufferSize):
+    """
+    Parses the chain of variable length ``FILE_ID_BOTH_DIR_INFO`` records
+    in ``lpFileInformation``.  Each record is read in place, no structures
+    are allocated to hold them.
+
+    :param lpFileInformation:
+        The buffer filled by :func:`GetFileInformationByHandleEx`.  May be
+        cdata or any object supporting the buffer protocol.
+
+    :param int dwBufferSize:
+        The size of ``lpFileInformation``.  Records are not allowed to
+        extend beyond it.
+
+    :raises InputError:
+        Raised if a record extends beyond the end of the buffer.
+
+    :returns:
+        Yields a :class:`DirectoryEntry` for each record.
+    """
+    ffi, _ = dist.load()
+
+    if not isinstance(lpFileInformation, ffi.CData):
+        lpFileInformation = ffi.from_buffer(lpFileInformation)
+
+    address = ffi.cast("char *", lpFileInformation)
+    name_offset = ffi.offsetof("FILE_ID_BOTH_DIR_INFO", "FileName")
+    offset = 0
+
+    while True:
+        if offset + name_offset > dwBufferSize:
+            raise InputError(
+                "lpFileInformation", None,
+                message="Record at offset %d extends beyond the end of "
+                        "the buffer" % offset)
+
+        info = ffi.cast("PFILE_ID_BOTH_DIR_INFO", address + offset)
+        if offset + name_offset + info.FileNameLength > dwBufferSize:
+            raise InputError(
+                "lpFileInformation", None,
+                message="File name at offset %d extends beyond the end "
+                        "of the buffer" % offset)
+
+        yield DirectoryEntry(
+            name=ffi.unpack(
+                ffi.cast("WCHAR *", address + offset + name_offset),
+                info.FileNameLength // ffi.sizeof("WCHAR")),
+            attributes=info.FileAttributes,
+            size=info.EndOfFile.QuadPart,
+            creation_time=info.CreationTime.QuadPart,
+            last_access_time=info.LastAccessTime.QuadPart,
+            last_write_time=info.LastWriteTime.QuadPart,
+            file_id=info.FileId.QuadPart
+        )
+
+        if info.NextEntryOffset == 0:
+            break
+        offset += info.NextEntryOffset
+
+
+def iter_directory(hDirectory, lpFileInformation=None,
+                   dwBufferSize=DEFAULT_BUFFER_SIZE):
+    """
+    Yields a :class:`DirectoryEntry` for everything in the directory
+    ``hDirectory``, except for ``.`` and ``..``, using
+    :func:`GetFileInformationByHandleEx`.
+
+    :param pywincffi.wintypes.HANDLE hDirectory:
+        A handle to a directory opened with ``FILE_LIST_DIRECTORY`` access
+        and ``FILE_FLAG_BACKUP_SEMANTICS``.  See :func:`list_directory`.
+
+    :keyword lpFileInformation:
+        The buffer to read entries into.  By default a buffer of
+        ``dwBufferSize`` bytes is allocated.
+
+    :keyword int dwBufferSize:
+        The size of ``lpFileInformation``.
+    """
+    ffi, library = dist.load()
+
+    if lpFileInformation is None:
+        lpFileInformation = ffi.new("char[]", dwBufferSize)
+
+    while True:
+        try:
+            GetFileInformationByHandleEx(
+                hDirectory, library.FileIdBothDirectoryInfo,
+                lpFileInformation, dwBufferSize)
+        except WindowsAPIError as error:
+            if error.errno != library.ERROR_NO_MORE_FILES:
+                raise
+            library.SetLastError(0)
+            return
+
+        for entry in parse_directory_info(lpFileInformation, dwBufferSize):
+            if entry.name not in (u".", u".."):
+                yield entry
+
+
+def list_directory(path, lpFileInformation=None,
+                   dwBufferSize=DEFAULT_BUFFER_SIZE):
+    """
+    Opens the directory ``path`` and returns a list of the
+    :class:`DirectoryEntry` objects :func:`iter_directory` produces.
+
+    :param str path:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The directory to list.
+
+    :rtype: list
+    """
+    _, library = dist.load()
+    hDirectory = CreateFile(
+        path, library.FILE_LIST_DIRECTORY,
+        dwShareMode=library.FILE_SHARE_READ | library.FILE_SHARE_WRITE |
+        library.FILE_SHARE_DELETE,
+        dwCreationDisposition=library.OPEN_EXISTING,
+        dwFlagsAndAttributes=library.FILE_FLAG_BACKUP_SEMANTICS)
+    try:
+        return list(iter_directory(
+            hDirectory, lpFileInformation=lpFileInformation,
+            dwBufferSize=dwBufferSize))
+    finally:
+        CloseHandle(hDirectory)
+
+
+def find_files(lpFileName, large_fetch=True):
+    """
+    Yields a :class:`DirectoryEntry` for each file or directory matching
+    ``lpFileName``, except for ``.`` and ``..``.  A single
+    ``WIN32_FIND_DATA`` structure is used for the whole search.
+
+    >>> from pywincffi.kernel32 import find_files
+    >>> logs = [entry.name for entry in find_files(u"C:\\logs\\*.log")]
+
+    :param str lpFileName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The pattern to search for, see :func:`FindFirstFileEx`.
+
+    :keyword bool large_fetch:
+        If True, the default, ``FIND_FIRST_EX_LARGE_FETCH`` is used.
+    """
+    ffi, library = dist.load()
+
+    try:
+        hFindFile, lpFindFileData = FindFirstFileEx(
+            lpFileName,
+            dwAdditionalFlags=library.FIND_FIRST_EX_LARGE_FETCH
+            if large_fetch else 0)
+    except WindowsAPIError as error:
+        if error.errno != library.ERROR_FILE_NOT_FOUND:
+            raise
+        library.SetLastError(0)
+        return
+
+    try:
+        while True:
+            name = ffi.string(lpFindFileData.cFileName)
+            if name not in (u".", u".."):
+                yield DirectoryEntry(
+                    name=name,
+                    attributes=lpFindFileData.dwFileAttributes,
+                    size=lpFindFileData.nFileSizeHigh << 32 |
+                    lpFindFileData.nFileSizeLow,
+                    creation_time=_filetime(lpFindFileData.ftCreationTime),
+                    last_access_time=_filetime(
+                        lpFindFileData.ftLastAccessTime),
+                    last_write_time=_filetime(
+                        lpFindFileData.ftLastWriteTime),
+                    file_id=None
+                )
+
+            if not FindNextFile(hFindFile, lpFindFileData):
+                break
+    finally:
+        FindClose(hFindFile)
+
+
+def walk(top, topdown=True, onerror=None, followlinks=False,
+         dwBufferSize=DEFAULT_BUFFER_SIZE):
+    """
+    Walks the directory tree rooted at ``top`` in the same manner as
+    :func:`os.walk` except the directories and files are lists of
+    :class:`DirectoryEntry` objects rather than names, so their size,
+    attributes and times are available without any additional calls.
+    One buffer is used to list every directory in the tree.
+
+    >>> from pywincffi.kernel32 import walk
+    >>> total = 0
+    >>> for path, directories, files in walk(u"C:\\build"):
+    ...     total += sum(entry.size for entry in files)
+
+    :param str top:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The directory to start from.
+
+    :keyword bool topdown:
+        If True, the default, each directory is produced before its
+        subdirectories and removing entries from ``directories`` prevents
+        them from being walked.
+
+    :keyword callable onerror:
+        Called with the :class:`WindowsAPIError` raised when a directory
+        can't be listed.  By default such errors are ignored.
+
+    :keyword bool followlinks:
+        If True directories which are reparse points, such as symlinks and
+        junctions, are walked too.
+
+    :keyword int dwBufferSize:
+        The size of the buffer used to list each directory.
+
+    :returns:
+        Yields a ``(path, directories, files)`` tuple for each directory.
+    """
+    input_check("top", top, text_type)
+
+    ffi, _ = dist.load()
+    lpFileInformation = ffi.new("char[]", dwBufferSize)
+
+    # Each item is a directory to list or, when walking bottom up, a
+    # result to produce once all of its subdirectories have been produced.
+    stack = [(top, None)]
+    while stack:
+        path, result = stack.pop()
+        if result is not None:
+            yield result
+            continue
+
+        try:
+            entries = list_directory(
+                path, lpFileInformation=lpFileInformation,
+                dwBufferSize=dwBufferSize)
+        except WindowsAPIError as error:
+            if onerror is not None:
+                onerror(error)
+            continue
+
+        directories = [entry for entry in entries if entry.is_directory]
+        files = [entry for entry in entries if not entry.is_directory]
+
+        if topdown:
+            yield path, directories, files
+        else:
+            stack.append((path, (path, directories, files)))
+
+        for entry in reversed(directories):
+            if followlinks or not entry.is_reparse_point:
+                stack.append((os.path.join(path, entry.name), None))
@@ -10,6 +10,7 @@ from six import integer_types, text_type
 from pywincffi.core import dist
 from pywincffi.core.checks import NON_ZERO, input_check, error_check, NoneType
 from pywincffi.exceptions import WindowsAPIError
+from pywincffi.kernel32.tracking import tracked
 from pywincffi.wintypes import HANDLE, SECURITY_ATTRIBUTES, wintype_to_cdata
 
 
@@ -77,7 +78,7 @@ def CreateEvent(
         if error.errno != library.ERROR_ALREADY_EXISTS:
             raise
 
-    return HANDLE(handle)
+    return tracked(HANDLE(handle), "CreateEvent")
 
 
 def OpenEvent(dwDesiredAccess, bInheritHandle, lpName):
@@ -110,7 +111,7 @@ def OpenEvent(dwDesiredAccess, bInheritHandle, lpName):
         lpName
     )
     error_check("OpenEvent")
-    return HANDLE(handle)
+    return tracked(HANDLE(handle), "OpenEvent")
 
 
 def ResetEvent(hEvent):
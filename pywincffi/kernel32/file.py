@@ -5,15 +5,37 @@ Files
 A module containing common Windows file functions for working with files.
 """
 
+from collections import namedtuple
+
 from six import integer_types, text_type, binary_type
 
 from pywincffi.core import dist
-from pywincffi.core.checks import NON_ZERO, input_check, error_check, NoneType
+from pywincffi.core.checks import (
+    NON_ZERO, input_check, error_check, NoneType, pending_check)
 from pywincffi.exceptions import WindowsAPIError
+from pywincffi.kernel32.events import CreateEvent
+from pywincffi.kernel32.overlapped import GetOverlappedResult, OverlappedPool
+from pywincffi.kernel32.tracking import tracked
 from pywincffi.wintypes import (
     SECURITY_ATTRIBUTES, OVERLAPPED, HANDLE, wintype_to_cdata
 )
 
+# The pool used by pread(), pwrite() and pread_into() when the caller
+# does not provide one.  Each structure has its own manual reset event so
+# GetOverlappedResult() waits for its own operation rather than the file
+# handle, which any concurrent operation on an overlapped handle signals.
+DEFAULT_OVERLAPPED_POOL = OverlappedPool(
+    event_factory=lambda: CreateEvent(bManualReset=True, bInitialState=False))
+
+# Sector sizes keyed by volume path, populated by sector_size().
+_SECTOR_SIZE_CACHE = {}
+
+GetDiskFreeSpaceResult = namedtuple(
+    "GetDiskFreeSpaceResult",
+    ("lpSectorsPerCluster", "lpBytesPerSector", "lpNumberOfFreeClusters",
+     "lpTotalNumberOfClusters")
+)
+
 
 def CreateFile(  # pylint: disable=too-many-arguments
         lpFileName, dwDesiredAccess, dwShareMode=None,
@@ -107,10 +129,10 @@ def CreateFile(  # pylint: disable=too-many-arguments
         # on the creation disposition.
         if (dwCreationDisposition == library.CREATE_ALWAYS and
                 error.errno == library.ERROR_ALREADY_EXISTS):
-            return HANDLE(handle)
+            return tracked(HANDLE(handle), "CreateFile")
         raise
 
-    return HANDLE(handle)
+    return tracked(HANDLE(handle), "CreateFile")
 
 
 def WriteFile(hFile, lpBuffer, nNumberOfBytesToWrite=None, lpOverlapped=None):
@@ -124,10 +146,13 @@ def WriteFile(hFile, lpBuffer, nNumberOfBytesToWrite=None, lpOverlapped=None):
     :param pywincffi.wintypes.HANDLE hFile:
         The handle to write to.
 
-    :type lpBuffer: str/bytes
+    :type lpBuffer: str/bytes, bytearray or memoryview
     :param lpBuffer:
         Type is ``str`` on Python 2, ``bytes`` on Python 3.
-        The data to be written to the file or device.
+        The data to be written to the file or device.  A
+        :class:`bytearray` or :class:`memoryview`, such as a buffer from
+        :class:`pywincffi.kernel32.AlignedBufferPool`, is written from
+        in place.
 
     :keyword int nNumberOfBytesToWrite:
         The number of bytes to be written.  Defaults to len(lpBuffer).
@@ -151,12 +176,15 @@ def WriteFile(hFile, lpBuffer, nNumberOfBytesToWrite=None, lpOverlapped=None):
     ffi, library = dist.load()
 
     input_check("hFile", hFile, HANDLE)
-    input_check("lpBuffer", lpBuffer, binary_type)
+    input_check("lpBuffer", lpBuffer, (binary_type, bytearray, memoryview))
     input_check(
         "lpOverlapped", lpOverlapped,
         allowed_types=(NoneType, OVERLAPPED)
     )
 
+    if not isinstance(lpBuffer, binary_type):
+        lpBuffer = ffi.from_buffer(lpBuffer)
+
     if nNumberOfBytesToWrite is None:
         nNumberOfBytesToWrite = len(lpBuffer)
     else:
@@ -243,6 +271,273 @@ def ReadFile(hFile, nNumberOfBytesToRead, lpOverlapped=None):
     return ffi.unpack(lpBuffer, bytes_read[0])
 
 
+def SetFilePointerEx(hFile, liDistanceToMove, dwMoveMethod=None):
+    """
+    Moves the file pointer of ``hFile``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa365542
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to move the file pointer of.
+
+    :param int liDistanceToMove:
+        A signed 64-bit number of bytes to move the file pointer by.
+
+    :keyword int dwMoveMethod:
+        The starting point for the move, one of ``FILE_BEGIN``,
+        ``FILE_CURRENT`` or ``FILE_END``.  By default ``FILE_BEGIN``
+        is used.
+
+    :rtype: int
+    :returns:
+        Returns the new position of the file pointer.
+    """
+    ffi, library = dist.load()
+
+    if dwMoveMethod is None:
+        dwMoveMethod = library.FILE_BEGIN
+
+    input_check("hFile", hFile, HANDLE)
+    input_check("liDistanceToMove", liDistanceToMove, integer_types)
+    input_check(
+        "dwMoveMethod", dwMoveMethod,
+        allowed_values=(
+            library.FILE_BEGIN,
+            library.FILE_CURRENT,
+            library.FILE_END
+        ))
+
+    distance = ffi.new("PLARGE_INTEGER")
+    distance.QuadPart = liDistanceToMove
+    lpNewFilePointer = ffi.new("PLARGE_INTEGER")
+    code = library.SetFilePointerEx(
+        wintype_to_cdata(hFile), distance[0], lpNewFilePointer,
+        ffi.cast("DWORD", dwMoveMethod)
+    )
+    error_check("SetFilePointerEx", code=code, expected=NON_ZERO)
+    return lpNewFilePointer.QuadPart
+
+
+def GetFileSizeEx(hFile):
+    """
+    Retrieves the size of ``hFile``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa364957
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file.
+
+    :rtype: int
+    :returns:
+        Returns the size of the file in bytes.
+    """
+    input_check("hFile", hFile, HANDLE)
+    ffi, library = dist.load()
+
+    lpFileSize = ffi.new("PLARGE_INTEGER")
+    code = library.GetFileSizeEx(wintype_to_cdata(hFile), lpFileSize)
+    error_check("GetFileSizeEx", code=code, expected=NON_ZERO)
+    return lpFileSize.QuadPart
+
+
+def SetEndOfFile(hFile):
+    """
+    Sets the size of ``hFile`` to the current position of its file
+    pointer, truncating or extending the file.  See
+    :func:`SetFilePointerEx`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa365531
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, which must have been opened with
+        ``GENERIC_WRITE`` access.
+    """
+    input_check("hFile", hFile, HANDLE)
+    _, library = dist.load()
+    code = library.SetEndOfFile(wintype_to_cdata(hFile))
+    error_check("SetEndOfFile", code=code, expected=NON_ZERO)
+
+
+def _start_io(function, hFile, lpBuffer, nNumberOfBytes, lpOverlapped,
+              lpNumberOfBytes=None):
+    """
+    Calls ``function``, ``ReadFile`` or ``WriteFile``, using
+    ``lpOverlapped``.  A read which reaches the end of the file, or a
+    pipe closed by the other end, is not treated as an error.  The same
+    errors from a write are raised since the data was not written.
+    Callers which start I/O repeatedly may pass their own ``LPDWORD`` in
+    ``lpNumberOfBytes``.
+
+    :returns:
+        The number of bytes transferred if the operation completed
+        immediately or ``None`` if it's pending, see :func:`_finish_io`.
+    """
+    ffi, library = dist.load()
+
+    if lpNumberOfBytes is None:
+        lpNumberOfBytes = ffi.new("LPDWORD")
+    code = getattr(library, function)(
+        wintype_to_cdata(hFile), lpBuffer, nNumberOfBytes,
+        lpNumberOfBytes, wintype_to_cdata(lpOverlapped)
+    )
+    if code != 0:
+        return lpNumberOfBytes[0]
+
+    errno, _ = ffi.getwinerror()
+    if function == "ReadFile" and _end_of_data(errno):
+        library.SetLastError(0)
+        return 0
+
+    pending_check(function, code)
+    return None
+
+
+def _end_of_data(errno):
+    """
+    Returns True if ``errno`` means a read reached the end of the file
+    or the other end of a pipe was closed.
+    """
+    _, library = dist.load()
+    return errno in (library.ERROR_HANDLE_EOF, library.ERROR_BROKEN_PIPE)
+
+
+def _finish_io(function, hFile, lpOverlapped):
+    """
+    Waits for an operation which :func:`_start_io` reported as pending.
+    ``function`` is the function which started it and errors are handled
+    as they are by :func:`_start_io`.
+
+    :returns:
+        The number of bytes transferred.
+    """
+    _, library = dist.load()
+
+    try:
+        return GetOverlappedResult(hFile, lpOverlapped, True)
+    except WindowsAPIError as error:
+        if function != "ReadFile" or not _end_of_data(error.errno):
+            raise
+        library.SetLastError(0)
+        return 0
+
+
+def _positioned_io(  # pylint: disable=too-many-arguments
+        function, hFile, lpBuffer, nNumberOfBytes, offset, pool):
+    """
+    Calls ``function``, ``ReadFile`` or ``WriteFile``, with an
+    ``OVERLAPPED`` structure from ``pool`` positioned at ``offset``.  If
+    ``hFile`` was opened with ``FILE_FLAG_OVERLAPPED`` this waits for the
+    operation to complete.
+
+    :returns:
+        The number of bytes transferred.
+    """
+    if pool is None:
+        pool = DEFAULT_OVERLAPPED_POOL
+
+    with pool.overlapped(offset) as lpOverlapped:
+        count = _start_io(
+            function, hFile, lpBuffer, nNumberOfBytes, lpOverlapped)
+        if count is None:
+            count = _finish_io(function, hFile, lpOverlapped)
+        return count
+
+
+def pread(hFile, nNumberOfBytesToRead, offset, pool=None):
+    """
+    Reads up to ``nNumberOfBytesToRead`` bytes from ``hFile`` starting
+    at ``offset`` without using or moving the file pointer of ``hFile``
+    first.  Unlike :func:`ReadFile` with :func:`SetFilePointerEx` multiple
+    threads may call this on the same handle at once.
+
+    >>> from pywincffi.kernel32 import pread
+    >>> header = pread(hFile, 512, 5 * 1024 ** 3)
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to read from.  If the handle was opened with
+        ``FILE_FLAG_OVERLAPPED`` this function waits for the read
+        to complete.
+
+    :param int nNumberOfBytesToRead:
+        The maximum number of bytes to read.
+
+    :param int offset:
+        The 64-bit offset, from the start of the file, to read from.
+
+    :keyword pywincffi.kernel32.overlapped.OverlappedPool pool:
+        The pool to acquire the ``OVERLAPPED`` structure from.  By default
+        :data:`DEFAULT_OVERLAPPED_POOL` is used.
+
+    :rtype: bytes
+    :returns:
+        Returns the data read which will be empty if ``offset`` is at or
+        past the end of the file.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("nNumberOfBytesToRead", nNumberOfBytesToRead, integer_types)
+
+    ffi, _ = dist.load()
+    lpBuffer = ffi.new("char []", nNumberOfBytesToRead)
+    bytes_read = _positioned_io(
+        "ReadFile", hFile, lpBuffer, nNumberOfBytesToRead, offset, pool)
+    return ffi.unpack(lpBuffer, bytes_read)
+
+
+def pread_into(hFile, buffer_, offset, pool=None):
+    """
+    The same as :func:`pread` except data is read directly into
+    ``buffer_``, such as a :class:`bytearray` or a writable
+    :class:`memoryview`, rather than a newly allocated buffer.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes read into ``buffer_``.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("buffer_", buffer_, (bytearray, memoryview))
+
+    ffi, _ = dist.load()
+    lpBuffer = ffi.from_buffer(buffer_)
+    return _positioned_io(
+        "ReadFile", hFile, lpBuffer, len(lpBuffer), offset, pool)
+
+
+def pwrite(hFile, lpBuffer, offset, pool=None):
+    """
+    Writes ``lpBuffer`` to ``hFile`` starting at ``offset`` without using
+    the file pointer of ``hFile`` first.  See :func:`pread`.
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to write to.
+
+    :type lpBuffer: bytes, bytearray or memoryview
+    :param lpBuffer:
+        The data to write.
+
+    :param int offset:
+        The 64-bit offset, from the start of the file, to write to.
+
+    :keyword pywincffi.kernel32.overlapped.OverlappedPool pool:
+        The pool to acquire the ``OVERLAPPED`` structure from.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes written.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("lpBuffer", lpBuffer, (binary_type, bytearray, memoryview))
+
+    ffi, _ = dist.load()
+    data = ffi.from_buffer(lpBuffer)
+    return _positioned_io("WriteFile", hFile, data, len(data), offset, pool)
+
+
 def MoveFileEx(lpExistingFileName, lpNewFileName, dwFlags=None):
     """
     Moves an existing file or directory, including its children,
@@ -311,16 +606,21 @@ def LockFileEx(
               could not be acquired.  Otherwise :func:`LockFileEx` will wait.
 
     :param int nNumberOfBytesToLockLow:
-        The start of the byte range to lock.
+        The low order 32 bits of the length of the byte range to lock.
 
     :param int nNumberOfBytesToLockHigh:
-        The end of the byte range to lock.
+        The high order 32 bits of the length of the byte range to lock.
+        Use :func:`pywincffi.wintypes.split_dwords` to split a 64-bit
+        length into the two values.
 
     :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
-        The underlying Windows API requires lpOverlapped, which acts both
-        an input argument and may contain results after calling. If None is
-        provided, a throw-away zero-filled instance will be created to
-        support such call. See Microsoft's documentation for intended usage.
+        The underlying Windows API requires lpOverlapped, whose ``Offset``
+        and ``OffsetHigh`` fields hold the start of the byte range.  If None
+        is provided, a throw-away zero-filled instance will be created so
+        the range starts at the beginning of the file.  Code which locks
+        many ranges should acquire structures from a
+        :class:`pywincffi.kernel32.OverlappedPool` or use
+        :class:`pywincffi.kernel32.RangeLockManager` instead.
     """
     input_check("hFile", hFile, HANDLE)
     input_check("dwFlags", dwFlags, integer_types)
@@ -364,16 +664,15 @@ def UnlockFileEx(
         right.
 
     :param int nNumberOfBytesToUnlockLow:
-        The start of the byte range to unlock.
+        The low order 32 bits of the length of the byte range to unlock.
 
     :param int nNumberOfBytesToUnlockHigh:
-        The end of the byte range to unlock.
+        The high order 32 bits of the length of the byte range to unlock.
 
     :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
-        The underlying Windows API requires lpOverlapped, which acts both
-        an input argument and may contain results after calling. If None is
-        provided, a throw-away zero-filled instance will be created to
-        support such call. See Microsoft's documentation for intended usage.
+        The structure whose ``Offset`` and ``OffsetHigh`` fields hold the
+        start of the byte range, which must exactly match a range
+        previously locked with :func:`LockFileEx`.  See :func:`LockFileEx`.
     """
     input_check("hFile", hFile, HANDLE)
     input_check(
@@ -418,3 +717,89 @@ def GetTempPath():
     code = library.GetTempPath(library.MAX_PATH + 1, lpBuffer)
     error_check("GetTempPath", code=code, expected=NON_ZERO)
     return ffi.string(lpBuffer)
+
+
+def GetDiskFreeSpace(lpRootPathName=None):
+    """
+    Retrieves information about the specified disk, including the sector
+    size which is required for unbuffered I/O.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/aa364935
+
+    :keyword str lpRootPathName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The root directory of the disk, such as ``C:\\``.  Defaults to the
+        root of the current directory.  See :func:`GetVolumePathName`.
+
+    :rtype: GetDiskFreeSpaceResult
+    """
+    ffi, library = dist.load()
+    input_check("lpRootPathName", lpRootPathName, (NoneType, text_type))
+
+    lpSectorsPerCluster = ffi.new("LPDWORD")
+    lpBytesPerSector = ffi.new("LPDWORD")
+    lpNumberOfFreeClusters = ffi.new("LPDWORD")
+    lpTotalNumberOfClusters = ffi.new("LPDWORD")
+    code = library.GetDiskFreeSpace(
+        ffi.NULL if lpRootPathName is None else lpRootPathName,
+        lpSectorsPerCluster, lpBytesPerSector, lpNumberOfFreeClusters,
+        lpTotalNumberOfClusters
+    )
+    error_check("GetDiskFreeSpace", code=code, expected=NON_ZERO)
+    return GetDiskFreeSpaceResult(
+        lpSectorsPerCluster=lpSectorsPerCluster[0],
+        lpBytesPerSector=lpBytesPerSector[0],
+        lpNumberOfFreeClusters=lpNumberOfFreeClusters[0],
+        lpTotalNumberOfClusters=lpTotalNumberOfClusters[0]
+    )
+
+
+def GetVolumePathName(lpszFileName):
+    """
+    Retrieves the mount point of the volume ``lpszFileName`` is on.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/aa364996
+
+    :param str lpszFileName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The path to a file or directory, which does not need to exist.
+
+    :rtype: str
+    :returns:
+        Returns the volume path, such as ``C:\\``, including the trailing
+        backslash.
+    """
+    ffi, library = dist.load()
+    input_check("lpszFileName", lpszFileName, text_type)
+
+    lpszVolumePathName = ffi.new("TCHAR[{}]".format(library.MAX_PATH + 1))
+    code = library.GetVolumePathName(
+        lpszFileName, lpszVolumePathName, library.MAX_PATH + 1)
+    error_check("GetVolumePathName", code=code, expected=NON_ZERO)
+    return ffi.string(lpszVolumePathName)
+
+
+def sector_size(path):
+    """
+    Returns the sector size, in bytes, of the volume ``path`` is on.  Offsets,
+    lengths and buffer addresses used with a handle opened with
+    ``FILE_FLAG_NO_BUFFERING`` must be a multiple of this value.  The
+    size is retrieved once per volume then cached.
+
+    :param str path:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        A path on the volume.
+
+    :rtype: int
+    """
+    volume = GetVolumePathName(path)
+    try:
+        return _SECTOR_SIZE_CACHE[volume]
+    except KeyError:
+        size = GetDiskFreeSpace(volume).lpBytesPerSector
+        _SECTOR_SIZE_CACHE[volume] = size
+        return size
@@ -0,0 +1,438 @@
+"""
+File Copy
+---------
+
+A module for copying files.  :func:`copy_file` copies one path to another
+using :func:`CopyFileEx` while :func:`copy_handle` copies between two open
+handles, such as pipes or devices which ``CopyFileEx`` can't take, using
+a double buffered pipeline of overlapped reads and writes.
+"""
+
+import os
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, input_check, error_check, NoneType
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.file import (
+    DEFAULT_OVERLAPPED_POOL, SetEndOfFile, SetFilePointerEx, _start_io,
+    _finish_io)
+from pywincffi.kernel32.memory import AlignedBufferPool, round_up
+from pywincffi.kernel32.overlapped import OverlappedPool
+from pywincffi.wintypes import HANDLE
+
+# Files at least this large are copied by copy_file() with
+# COPY_FILE_NO_BUFFERING unless the caller says otherwise.
+NO_BUFFERING_THRESHOLD = 256 * 1024 ** 2
+
+# The size of each of the two buffers copy_handle() uses by default.
+DEFAULT_CHUNK_SIZE = 1024 ** 2
+
+# The ffi instance _copy_progress_routine() was last registered with.
+_PROGRESS_ROUTINE_FFI = []
+
+
+class Cancellation(object):
+    """
+    A flag which cancels :func:`CopyFileEx`, :func:`copy_file` or
+    :func:`copy_handle` when set.  :meth:`cancel` may be called from any
+    thread, including from inside of a progress callback.
+    """
+    def __init__(self):
+        ffi, _ = dist.load()
+        self.pbCancel = ffi.new("LPBOOL")
+
+    def cancel(self):
+        """Requests that the copy be cancelled"""
+        self.pbCancel[0] = 1
+
+    @property
+    def cancelled(self):
+        """True if :meth:`cancel` has been called"""
+        return bool(self.pbCancel[0])
+
+
+class _ProgressContext(object):  # pylint: disable=too-few-public-methods
+    """The ``lpData`` passed to :func:`_copy_progress_routine`"""
+    def __init__(self, routine, data):
+        self.routine = routine
+        self.data = data
+        self.error = None
+
+
+def _copy_progress_routine(  # pylint: disable=too-many-arguments
+        TotalFileSize, TotalBytesTransferred, StreamSize,
+        StreamBytesTransferred, dwStreamNumber, dwCallbackReason,
+        hSourceFile, hDestinationFile, lpData):
+    """
+    The ``LPPROGRESS_ROUTINE`` given to ``CopyFileEx``.  Calls the Python
+    function from the :class:`_ProgressContext` in ``lpData``.  If that
+    function raises an exception the copy is cancelled and the exception
+    is raised again by :func:`CopyFileEx`.
+    """
+    ffi, library = dist.load()
+    context = ffi.from_handle(lpData)
+
+    try:
+        result = context.routine(
+            TotalFileSize.QuadPart, TotalBytesTransferred.QuadPart,
+            StreamSize.QuadPart, StreamBytesTransferred.QuadPart,
+            dwStreamNumber, dwCallbackReason, HANDLE(hSourceFile),
+            HANDLE(hDestinationFile), context.data)
+    except Exception as error:  # pylint: disable=broad-except
+        context.error = error
+        return library.PROGRESS_CANCEL
+
+    return library.PROGRESS_CONTINUE if result is None else result
+
+
+def _register_progress_routine(ffi):
+    """
+    Registers :func:`_copy_progress_routine` as the implementation of the
+    ``extern "Python"`` function declared in functions.h.
+    """
+    if not _PROGRESS_ROUTINE_FFI or _PROGRESS_ROUTINE_FFI[0] is not ffi:
+        ffi.def_extern(name="_copy_progress_routine")(_copy_progress_routine)
+        _PROGRESS_ROUTINE_FFI[:] = [ffi]
+
+
+def CopyFileEx(  # pylint: disable=too-many-arguments
+        lpExistingFileName, lpNewFileName, lpProgressRoutine=None,
+        lpData=None, pbCancel=None, dwCopyFlags=0):
+    """
+    Copies an existing file to a new file, notifying the application of
+    its progress through a callback function.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363852
+
+    :param str lpExistingFileName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The name of the file to copy.
+
+    :param str lpNewFileName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The name of the new file.
+
+    :keyword callable lpProgressRoutine:
+        A function called each time a chunk of the file has been copied.
+        It receives the same arguments as an ``LPPROGRESS_ROUTINE`` with
+        the ``LARGE_INTEGER`` values converted to integers and ``lpData``
+        being the Python object passed to this function.  Return one of
+        the ``PROGRESS_*`` constants or ``None`` to continue the copy.
+        Raising an exception cancels the copy and the exception is raised
+        again by this function.
+
+    :keyword lpData:
+        Any Python object, passed on to ``lpProgressRoutine``.
+
+    :keyword Cancellation pbCancel:
+        If provided the copy is cancelled when
+        :meth:`Cancellation.cancel` is called.
+
+    :keyword int dwCopyFlags:
+        Flags which specify how the file is to be copied, such as
+        ``COPY_FILE_FAIL_IF_EXISTS`` or ``COPY_FILE_NO_BUFFERING``.
+
+    :raises WindowsAPIError:
+        Raised if the copy fails.  A cancelled copy fails with
+        ``ERROR_REQUEST_ABORTED``.
+    """
+    input_check("lpExistingFileName", lpExistingFileName, text_type)
+    input_check("lpNewFileName", lpNewFileName, text_type)
+    input_check("pbCancel", pbCancel, (NoneType, Cancellation))
+    input_check("dwCopyFlags", dwCopyFlags, integer_types)
+
+    if lpProgressRoutine is not None and not callable(lpProgressRoutine):
+        raise InputError(
+            "lpProgressRoutine", lpProgressRoutine,
+            message="Expected `lpProgressRoutine` to be callable")
+
+    ffi, library = dist.load()
+
+    context = None
+    routine = lpContext = ffi.NULL
+    if lpProgressRoutine is not None:
+        _register_progress_routine(ffi)
+        context = _ProgressContext(lpProgressRoutine, lpData)
+        lpContext = ffi.new_handle(context)
+        routine = library._copy_progress_routine  # pylint: disable=W0212
+
+    code = library.CopyFileEx(
+        lpExistingFileName, lpNewFileName, routine, lpContext,
+        ffi.NULL if pbCancel is None else pbCancel.pbCancel,
+        dwCopyFlags
+    )
+
+    if context is not None and context.error is not None:
+        library.SetLastError(0)
+        raise context.error
+
+    error_check("CopyFileEx", code=code, expected=NON_ZERO)
+
+
+def _progress_adapter(TotalFileSize, TotalBytesTransferred, *args):
+    """
+    The progress routine :func:`copy_file` gives to :func:`CopyFileEx`.
+    The last argument, ``lpData``, is the caller's progress function.
+    """
+    args[-1](TotalBytesTransferred, TotalFileSize)
+
+
+def copy_file(source, destination, progress=None, cancel=None,
+              overwrite=True, no_buffering=None):
+    """
+    Copies ``source`` to ``destination`` using :func:`CopyFileEx`.
+
+    >>> from pywincffi.kernel32 import Cancellation, copy_file
+    >>> cancel = Cancellation()
+    >>> def progress(transferred, total):
+    ...     print("%d of %d bytes copied" % (transferred, total))
+    >>> copy_file(u"C:\\build.iso", u"D:\\build.iso", progress, cancel)
+
+    :param str source:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The file to copy.
+
+    :param str destination:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The path to copy to.
+
+    :keyword callable progress:
+        Called with the number of bytes copied so far and the total
+        size of the file.
+
+    :keyword Cancellation cancel:
+        Used to cancel the copy.
+
+    :keyword bool overwrite:
+        If False the copy fails if ``destination`` exists.
+
+    :keyword bool no_buffering:
+        If True the copy bypasses the system cache, which is faster for
+        very large files.  By default this is only done for files at
+        least :data:`NO_BUFFERING_THRESHOLD` bytes in size.
+
+    :raises WindowsAPIError:
+        Raised if the copy fails.  A cancelled copy fails with
+        ``ERROR_REQUEST_ABORTED``.
+    """
+    _, library = dist.load()
+
+    dwCopyFlags = 0
+    if not overwrite:
+        dwCopyFlags |= library.COPY_FILE_FAIL_IF_EXISTS
+
+    if no_buffering is None:
+        try:
+            no_buffering = \
+                os.path.getsize(source) >= NO_BUFFERING_THRESHOLD
+        except (OSError, IOError):
+            # Let CopyFileEx() report the problem with `source`
+            no_buffering = False
+
+    if no_buffering:
+        dwCopyFlags |= library.COPY_FILE_NO_BUFFERING
+
+    lpProgressRoutine = None
+    if progress is not None:
+        lpProgressRoutine = _progress_adapter
+
+    CopyFileEx(
+        source, destination, lpProgressRoutine=lpProgressRoutine,
+        lpData=progress, pbCancel=cancel, dwCopyFlags=dwCopyFlags)
+
+
+def copy_handle(  # pylint: disable=too-many-arguments,too-many-locals
+        hSource, hDestination, size=None, chunk_size=DEFAULT_CHUNK_SIZE,
+        progress=None, cancel=None, buffer_pool=None, pool=None):
+    """
+    Copies data from ``hSource`` to ``hDestination`` until the end of
+    ``hSource`` is reached or ``size`` bytes have been copied.  Two buffers
+    are used so the next chunk is being read while the previous one is
+    being written.  Both buffers are allocated once, before the copy
+    starts.
+
+    The reads and writes only overlap if the handles were opened with
+    ``FILE_FLAG_OVERLAPPED``.  If the handles were also opened with
+    ``FILE_FLAG_NO_BUFFERING`` provide a ``buffer_pool`` whose alignment
+    is the sector size of both volumes.  Every read and write is then a
+    whole number of sectors: a final partial chunk is padded with zeros
+    and the destination, which must be a file, is truncated back to the
+    number of bytes copied with :func:`SetEndOfFile`.
+
+    :param pywincffi.wintypes.HANDLE hSource:
+        The handle to read from, starting at offset 0.
+
+    :param pywincffi.wintypes.HANDLE hDestination:
+        The handle to write to, starting at offset 0.
+
+    :keyword int size:
+        The number of bytes to copy.  By default everything is copied.
+
+    :keyword int chunk_size:
+        The size of each read.  Ignored if ``buffer_pool`` is provided.
+
+    :keyword callable progress:
+        Called with the number of bytes copied so far and ``size`` after
+        each chunk is written.  The second argument is None if ``size``
+        was not provided.
+
+    :keyword Cancellation cancel:
+        Used to cancel the copy.  Checked after each chunk is read.
+
+    :keyword pywincffi.kernel32.AlignedBufferPool buffer_pool:
+        The pool to take the two buffers from.  They are returned to the
+        pool once the copy finishes.
+
+    :keyword pywincffi.kernel32.overlapped.OverlappedPool pool:
+        The pool to acquire the ``OVERLAPPED`` structures from.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes copied.
+
+    :raises WindowsAPIError:
+        Raised if a read or write fails.  A cancelled copy fails with
+        ``ERROR_REQUEST_ABORTED``.
+    """
+    input_check("hSource", hSource, HANDLE)
+    input_check("hDestination", hDestination, HANDLE)
+    input_check("size", size, (NoneType, ) + integer_types)
+    input_check("chunk_size", chunk_size, integer_types)
+    input_check("cancel", cancel, (NoneType, Cancellation))
+    input_check("buffer_pool", buffer_pool, (NoneType, AlignedBufferPool))
+    input_check("pool", pool, (NoneType, OverlappedPool))
+
+    ffi, library = dist.load()
+
+    if pool is None:
+        pool = DEFAULT_OVERLAPPED_POOL
+
+    if buffer_pool is None:
+        views = alignment = None
+        buffers = [ffi.new("char[]", chunk_size) for _ in range(2)]
+    else:
+        views = [buffer_pool.acquire(), buffer_pool.acquire()]
+        buffers = [ffi.from_buffer(view) for view in views]
+        chunk_size = buffer_pool.buffer_size
+        alignment = buffer_pool.alignment
+
+    def start(function, hFile, lpBuffer, count, offset):
+        lpOverlapped = pool.acquire(offset)
+        try:
+            return function, lpOverlapped, _start_io(
+                function, hFile, lpBuffer, count, lpOverlapped)
+        except Exception:
+            pool.release(lpOverlapped)
+            raise
+
+    def finish(hFile, operation):
+        function, lpOverlapped, count = operation
+        try:
+            if count is None:
+                count = _finish_io(function, hFile, lpOverlapped)
+            return count
+        finally:
+            pool.release(lpOverlapped)
+
+    def read_size(offset):
+        if size is None:
+            return chunk_size
+        count = min(chunk_size, size - offset)
+        if alignment is not None and count > 0:
+            # Unbuffered reads must be whole sectors, anything read past
+            # `size` is not written.
+            count = round_up(count, alignment)
+        return count
+
+    offset = 0
+    current = 0
+    read = write = None
+    padded = False
+    try:
+        if read_size(offset) > 0:
+            read = start(
+                "ReadFile", hSource, buffers[current], read_size(offset),
+                offset)
+
+        while read is not None:
+            operation, read = read, None
+            count = finish(hSource, operation)
+            if size is not None:
+                count = min(count, size - offset)
+            if count == 0:
+                break
+
+            if cancel is not None and cancel.cancelled:
+                raise WindowsAPIError(
+                    "copy_handle", "The copy was cancelled",
+                    library.ERROR_REQUEST_ABORTED)
+
+            lpBuffer, write_offset = buffers[current], offset
+            length = count
+            if alignment is not None and count % alignment:
+                # A partial sector is the end of the file, so this is the
+                # last chunk.
+                length = round_up(count, alignment)
+                lpBuffer[count:length] = b"\x00" * (length - count)
+                padded = True
+
+            write = start(
+                "WriteFile", hDestination, lpBuffer, length, write_offset)
+            offset += count
+            current = 1 - current
+
+            if not padded and read_size(offset) > 0:
+                read = start(
+                    "ReadFile", hSource, buffers[current],
+                    read_size(offset), offset)
+
+            # A write may complete having written less than was asked,
+            # to a pipe for example, so the rest is written before the
+            # buffer is reused.
+            written = 0
+            while True:
+                operation, write = write, None
+                transferred = finish(hDestination, operation)
+                written += transferred
+                if written >= length:
+                    break
+
+                if transferred == 0:
+                    raise WindowsAPIError(
+                        "WriteFile",
+                        "Wrote %d of %d bytes at offset %d" % (
+                            written, length, write_offset),
+                        library.ERROR_WRITE_FAULT)
+
+                write = start(
+                    "WriteFile", hDestination, lpBuffer + written,
+                    length - written, write_offset + written)
+
+            if progress is not None:
+                progress(offset, size)
+
+    except Exception:
+        # Neither buffer can be reused, or freed, while an operation
+        # using it is still in progress.
+        for hFile, operation in ((hSource, read), (hDestination, write)):
+            if operation is not None:
+                try:
+                    finish(hFile, operation)
+                except WindowsAPIError:
+                    pass
+        raise
+
+    finally:
+        if views is not None:
+            for view in views:
+                buffer_pool.release(view)
+
+    if padded:
+        SetFilePointerEx(hDestination, offset)
+        SetEndOfFile(hDestination)
+
+    return offset
@@ -6,13 +6,21 @@ A module containing general functions for working with handle
 objects.  The functions provided here are part of the ``kernel32`` library.
 """
 
+import warnings
+
 from six import integer_types
+from six.moves import builtins
 
 from pywincffi.core import dist
 from pywincffi.core.checks import NON_ZERO, input_check, error_check
-from pywincffi.exceptions import WindowsAPIError
+from pywincffi.exceptions import HandleCloseError, WindowsAPIError
+from pywincffi.kernel32 import tracking
+from pywincffi.kernel32.tracking import tracked, untracked
 from pywincffi.wintypes import HANDLE, SOCKET, wintype_to_cdata
 
+# Python 2 does not provide ResourceWarning
+LeakWarning = getattr(builtins, "ResourceWarning", RuntimeWarning)
+
 
 def GetStdHandle(nStdHandle):
     """
@@ -63,6 +71,8 @@ def CloseHandle(hObject):
 
     code = library.CloseHandle(wintype_to_cdata(hObject))
     error_check("CloseHandle", code=code, expected=NON_ZERO)
+    _disarm_safety_net(hObject)
+    untracked(hObject)
 
 
 def GetHandleInformation(hObject):
@@ -181,4 +191,189 @@ def DuplicateHandle(  # pylint: disable=too-many-arguments
         ffi.cast("DWORD", dwOptions)
     )
     error_check("DuplicateHandle", code, expected=NON_ZERO)
-    return HANDLE(lpTargetHandle[0])
+    return tracked(HANDLE(lpTargetHandle[0]), "DuplicateHandle")
+
+
+def _close_leaked(cdata):
+    # Finalizer used by OwnedHandle's safety net.  Exceptions can't be
+    # raised from a finalizer so failures are only reported by the warning.
+    ffi, library = dist.load()
+    OwnedHandle.leaked += 1
+    warnings.warn(
+        "Handle 0x%x was never closed and has been closed by the garbage "
+        "collector" % int(ffi.cast("intptr_t", cdata)), LeakWarning)
+    library.CloseHandle(cdata)
+    untracked(cdata)
+
+
+def _arm_safety_net(handle):
+    # The guard is stored on the handle object itself, rather than on the
+    # OwnedHandle, so it can't fire while the handle is still referenced.
+    # It goes straight into the instance dictionary since setting an
+    # attribute on a HANDLE sets it on the underlying cdata.
+    ffi, _ = dist.load()
+    armed = [True]
+
+    def finalizer(cdata):
+        if armed[0]:
+            armed[0] = False
+            _close_leaked(cdata)
+
+    vars(handle)["_safety_net"] = (armed, ffi.gc(
+        ffi.cast("HANDLE", wintype_to_cdata(handle)), finalizer))
+
+
+def _disarm_safety_net(handle):
+    net = vars(handle).pop("_safety_net", None)
+    if net is not None:
+        net[0][0] = False
+
+
+class OwnedHandle(object):
+    """
+    Owns ``handle``, closing it with :func:`CloseHandle` when the ``with``
+    block exits or :meth:`close` is called, even if an exception is raised.
+
+    >>> from pywincffi.kernel32 import CreateEvent, OwnedHandle
+    >>> with OwnedHandle(CreateEvent()) as hEvent:
+    ...     SetEvent(hEvent)
+
+    :type handle: pywincffi.wintypes.HANDLE or pywincffi.wintypes.SOCKET
+    :param handle:
+        The handle to take ownership of.
+
+    :keyword bool safety_net:
+        If True and the handle is garbage collected without being closed,
+        it's closed by a finalizer registered with ``ffi.gc``, a
+        ``ResourceWarning`` is emitted and :attr:`OwnedHandle.leaked` is
+        incremented.  The finalizer is attached to the ``handle`` object,
+        not to the :class:`OwnedHandle`, so it only runs once nothing
+        references ``handle``; closing it with :func:`CloseHandle` or
+        calling :meth:`detach` disarms it.  This is a last resort for
+        finding leaks, the time at which the finalizer runs is not
+        predictable.
+    """
+    # The number of handles closed by the safety net.
+    leaked = 0
+
+    def __init__(self, handle, safety_net=False):
+        input_check("handle", handle, (HANDLE, SOCKET))
+        self.handle = handle
+        if safety_net:
+            _arm_safety_net(handle)
+
+    @property
+    def closed(self):
+        """True once the handle has been closed or detached"""
+        return self.handle is None
+
+    def detach(self):
+        """
+        Gives up ownership of the handle, without closing it, and returns
+        it.  The caller becomes responsible for closing the handle.
+        """
+        handle, self.handle = self.handle, None
+        if handle is not None:
+            _disarm_safety_net(handle)
+        return handle
+
+    def close(self):
+        """
+        Closes the handle.  Calling this more than once has no effect.
+        """
+        if self.handle is not None:
+            CloseHandle(self.detach())
+
+    def __enter__(self):
+        return self.handle
+
+    def __exit__(self, *_):
+        self.close()
+
+    def __repr__(self):
+        return "<OwnedHandle %r>" % (self.handle, )
+
+
+class HandleGroup(object):
+    """
+    A group of handles which are closed together.  Each handle is checked
+    and converted once, when it's added, so :meth:`close` can close all of
+    them in a tight loop.  A failure to close one handle does not prevent
+    the others from being closed.
+
+    >>> from pywincffi.kernel32 import CreateEvent, HandleGroup
+    >>> with HandleGroup() as handles:
+    ...     events = [handles.add(CreateEvent()) for _ in range(64)]
+
+    :keyword handles:
+        An optional iterable of handles to add to the group.
+    """
+    def __init__(self, handles=None):
+        self._handles = []
+        for handle in handles or ():
+            self.add(handle)
+
+    def __len__(self):
+        return len(self._handles)
+
+    def add(self, handle):
+        """
+        Adds ``handle`` to the group and returns it.
+
+        :type handle: pywincffi.wintypes.HANDLE or pywincffi.wintypes.SOCKET
+        :param handle:
+            The handle the group should close.
+        """
+        input_check("handle", handle, (HANDLE, SOCKET))
+        self._handles.append((handle, wintype_to_cdata(handle)))
+        return handle
+
+    def detach(self, handle):
+        """
+        Removes ``handle`` from the group without closing it.
+
+        :raises ValueError:
+            Raised if ``handle`` is not in the group.
+        """
+        for i, (owned, _) in enumerate(self._handles):
+            if owned is handle:
+                del self._handles[i]
+                return handle
+        raise ValueError("%r is not in the group" % (handle, ))
+
+    def close(self):
+        """
+        Closes every handle in the group and empties it.
+
+        :raises pywincffi.exceptions.HandleCloseError:
+            Raised once every handle has been closed, or attempted, if any
+            of them could not be closed.
+        """
+        ffi, library = dist.load()
+        handles, self._handles = self._handles, []
+        close = library.CloseHandle
+        tracker = tracking.tracker
+        errors = []
+
+        for handle, cdata in handles:
+            code = close(cdata)
+            if code == 0:
+                errno, message = ffi.getwinerror()
+                errors.append((handle, WindowsAPIError(
+                    "CloseHandle", message, errno, return_code=code,
+                    expected_return_code=NON_ZERO)))
+                continue
+
+            _disarm_safety_net(handle)
+            if tracker is not None:
+                tracker.untrack(cdata)
+
+        if errors:
+            library.SetLastError(0)
+            raise HandleCloseError(errors, len(handles))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
@@ -0,0 +1,433 @@
+"""
+Range Locks
+-----------
+
+A module for coordinating access to byte ranges of a shared file.
+:class:`RangeLockManager` wraps :func:`pywincffi.kernel32.LockFileEx` and
+:func:`pywincffi.kernel32.UnlockFileEx`, tracking the ranges held through
+one handle in an :class:`IntervalTree` so conflicts between threads are
+resolved without calling Windows at all.
+"""
+
+import random
+import threading
+import time
+from collections import namedtuple
+from itertools import count
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check
+from pywincffi.core.compat import monotonic
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.file import LockFileEx, UnlockFileEx
+from pywincffi.kernel32.overlapped import OverlappedPool
+from pywincffi.wintypes import HANDLE, split_dwords
+
+LockStatistics = namedtuple(
+    "LockStatistics",
+    ("acquired", "released", "contended", "retries", "timeouts",
+     "wait_time", "held"))
+
+
+class _Node(object):  # pylint: disable=too-few-public-methods
+    """A node of :class:`IntervalTree`"""
+    __slots__ = (
+        "key", "start", "end", "value", "priority", "max_end", "left",
+        "right")
+
+    def __init__(self, key, start, end, value):
+        self.key = key
+        self.start = start
+        self.end = end
+        self.value = value
+        self.priority = random.random()
+        self.max_end = end
+        self.left = None
+        self.right = None
+
+    def update(self):
+        self.max_end = self.end
+        for child in (self.left, self.right):
+            if child is not None and child.max_end > self.max_end:
+                self.max_end = child.max_end
+
+
+def _split(node, key):
+    # Splits the tree rooted at `node` into nodes with keys less than `key`
+    # and nodes with keys greater than or equal to `key`.
+    if node is None:
+        return None, None
+
+    if node.key < key:
+        node.right, right = _split(node.right, key)
+        node.update()
+        return node, right
+
+    left, node.left = _split(node.left, key)
+    node.update()
+    return left, node
+
+
+def _merge(left, right):
+    # Merges two trees where every key in `left` is less than every key
+    # in `right`.
+    if left is None:
+        return right
+    if right is None:
+        return left
+
+    if left.priority > right.priority:
+        left.right = _merge(left.right, right)
+        left.update()
+        return left
+
+    right.left = _merge(left, right.left)
+    right.update()
+    return right
+
+
+class IntervalTree(object):
+    """
+    A set of half open ``[start, end)`` intervals, each with an associated
+    value, supporting insertion, removal and overlap queries in
+    ``O(log n)`` time plus the number of overlapping intervals.  Intervals
+    are ordered by ``start`` and every node records the largest ``end``
+    beneath it so subtrees which can't overlap a query are skipped.
+    Identical and overlapping intervals may be stored more than once.
+    """
+    def __init__(self):
+        self._root = None
+        self._serial = count()
+        self._length = 0
+
+    def __len__(self):
+        return self._length
+
+    def add(self, start, end, value=None):
+        """
+        Adds the interval ``[start, end)``.
+
+        :rtype: tuple
+        :returns:
+            Returns a key which can be passed to :meth:`remove`.
+        """
+        if end <= start:
+            raise InputError(
+                "end", end, message="Expected `end` to be greater than "
+                                    "`start`")
+
+        key = (start, next(self._serial))
+        left, right = _split(self._root, key)
+        self._root = _merge(_merge(left, _Node(key, start, end, value)), right)
+        self._length += 1
+        return key
+
+    def remove(self, key):
+        """
+        Removes the interval returned by :meth:`add` as ``key``.
+
+        :raises KeyError:
+            Raised if ``key`` is not in the tree.
+        """
+        start, serial = key
+        left, right = _split(self._root, key)
+        middle, right = _split(right, (start, serial + 1))
+        if middle is None:
+            self._root = _merge(left, right)
+            raise KeyError(key)
+
+        self._root = _merge(left, right)
+        self._length -= 1
+
+    def overlapping(self, start, end):
+        """
+        Returns a list of ``(start, end, value)`` tuples, ordered by
+        ``start``, for each interval overlapping ``[start, end)``.
+        """
+        results = []
+        stack = []
+        node = self._root
+
+        while True:
+            # Subtrees where nothing ends after `start` are skipped
+            while node is not None and node.max_end > start:
+                stack.append(node)
+                node = node.left
+
+            if not stack:
+                break
+
+            node = stack.pop()
+            if node.start >= end:
+                # Neither this node nor anything to its right can overlap
+                break
+
+            if node.end > start:
+                results.append((node.start, node.end, node.value))
+            node = node.right
+
+        return results
+
+
+class RangeLock(object):
+    """
+    A byte range held by :class:`RangeLockManager`.  Calling
+    :meth:`release`, or leaving the ``with`` block, unlocks the range.
+    """
+    def __init__(self, manager, offset, length, exclusive):
+        self.manager = manager
+        self.offset = offset
+        self.length = length
+        self.exclusive = exclusive
+        self.key = None
+
+    @property
+    def released(self):
+        """True once the range has been released"""
+        return self.key is None
+
+    def release(self):
+        """Unlocks the range.  Has no effect if it's already released."""
+        self.manager.release(self)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.release()
+
+    def __repr__(self):
+        return "<RangeLock %s [%d, %d)>" % (
+            "exclusive" if self.exclusive else "shared",
+            self.offset, self.offset + self.length)
+
+
+class RangeLockManager(object):
+    """
+    Locks byte ranges of ``hFile`` on behalf of any number of threads.
+    Ranges held through this manager are kept in an :class:`IntervalTree`
+    so that a thread asking for a range another thread holds waits
+    without calling Windows.  Ranges held by other processes are detected
+    by calling :func:`pywincffi.kernel32.LockFileEx` with
+    ``LOCKFILE_FAIL_IMMEDIATELY`` and retrying with exponential backoff,
+    so waiting never blocks inside Windows and can be given a timeout.
+
+    >>> from pywincffi.kernel32 import RangeLockManager
+    >>> locks = RangeLockManager(hFile)
+    >>> with locks.acquire(4096, 512):
+    ...     update_index_page(hFile, 4096)
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to the file, created with ``GENERIC_READ`` or
+        ``GENERIC_WRITE`` access.  Only one manager should be used for
+        each handle.
+
+    :keyword pywincffi.kernel32.overlapped.OverlappedPool pool:
+        The pool ``OVERLAPPED`` structures, which hold the offset of each
+        range, are acquired from.
+
+    :keyword float initial_backoff:
+        The number of seconds to wait after the first failed attempt to
+        lock a range held by another process.  The wait doubles, with some
+        jitter, after each further attempt.
+
+    :keyword float max_backoff:
+        The maximum number of seconds to wait between attempts.
+    """
+    def __init__(self, hFile, pool=None, initial_backoff=0.001,
+                 max_backoff=0.1):
+        input_check("hFile", hFile, HANDLE)
+        self.hFile = hFile
+        self.pool = OverlappedPool() if pool is None else pool
+        self.initial_backoff = initial_backoff
+        self.max_backoff = max_backoff
+        self._ranges = IntervalTree()
+        self._condition = threading.Condition(threading.Lock())
+        self._acquired = 0
+        self._released = 0
+        self._contended = 0
+        self._retries = 0
+        self._timeouts = 0
+        self._wait_time = 0.0
+
+    def __len__(self):
+        """The number of ranges currently held"""
+        return len(self._ranges)
+
+    def statistics(self):
+        """
+        Returns a :class:`LockStatistics` tuple containing:
+
+            * ``acquired`` - The number of ranges acquired.
+            * ``released`` - The number of ranges released.
+            * ``contended`` - The number of acquisitions which had to wait
+              for a thread or process to release a conflicting range.
+            * ``retries`` - The number of calls to ``LockFileEx`` which
+              failed because another process held a conflicting range.
+            * ``timeouts`` - The number of acquisitions which gave up.
+            * ``wait_time`` - The total number of seconds spent waiting.
+            * ``held`` - The number of ranges currently held.
+        """
+        with self._condition:
+            return LockStatistics(
+                acquired=self._acquired, released=self._released,
+                contended=self._contended, retries=self._retries,
+                timeouts=self._timeouts, wait_time=self._wait_time,
+                held=len(self._ranges))
+
+    def _conflicts(self, offset, length, exclusive):
+        for _, _, held in self._ranges.overlapping(offset, offset + length):
+            if exclusive or held.exclusive:
+                return True
+        return False
+
+    def _lock(self, offset, length, exclusive):
+        # Attempts to lock the range in Windows without waiting.  Returns
+        # False if another process holds a conflicting range.
+        _, library = dist.load()
+        flags = library.LOCKFILE_FAIL_IMMEDIATELY
+        if exclusive:
+            flags |= library.LOCKFILE_EXCLUSIVE_LOCK
+
+        high, low = split_dwords(length)
+        with self.pool.overlapped(offset) as lpOverlapped:
+            try:
+                LockFileEx(self.hFile, flags, low, high, lpOverlapped)
+            except WindowsAPIError as error:
+                if error.errno != library.ERROR_LOCK_VIOLATION:
+                    raise
+                library.SetLastError(0)
+                return False
+        return True
+
+    def acquire(self, offset, length, exclusive=True, blocking=True,
+                timeout=None):
+        """
+        Locks ``length`` bytes of the file starting at ``offset``.
+
+        :param int offset:
+            The first byte of the range.
+
+        :param int length:
+            The number of bytes in the range.
+
+        :keyword bool exclusive:
+            If True, the default, no other thread or process may lock an
+            overlapping range.  Otherwise other shared locks may overlap
+            the range.
+
+        :keyword bool blocking:
+            If False return immediately if the range can't be locked.
+
+        :keyword float timeout:
+            The maximum number of seconds to wait.  Waits forever by
+            default.
+
+        :rtype: RangeLock
+        :returns:
+            Returns the :class:`RangeLock` or ``None`` if the range could
+            not be locked without waiting longer than allowed.
+        """
+        input_check("offset", offset, integer_types)
+        input_check("length", length, integer_types)
+        input_check("exclusive", exclusive, allowed_values=(True, False))
+
+        if offset < 0 or length <= 0:
+            raise InputError(
+                "length", length,
+                message="Expected `offset` >= 0 and `length` > 0")
+
+        if not blocking:
+            timeout = 0
+        deadline = None if timeout is None else monotonic() + timeout
+        started = None
+        backoff = self.initial_backoff
+
+        with self._condition:
+            while True:
+                if not self._conflicts(offset, length, exclusive):
+                    if self._lock(offset, length, exclusive):
+                        break
+                    self._retries += 1
+                    held_elsewhere = True
+                else:
+                    held_elsewhere = False
+
+                now = monotonic()
+                if started is None:
+                    started = now
+                    self._contended += 1
+
+                if deadline is not None and now >= deadline:
+                    self._timeouts += 1
+                    self._wait_time += now - started
+                    return None
+
+                remaining = None if deadline is None else deadline - now
+                if held_elsewhere:
+                    # Another process holds the range.  Sleep without
+                    # holding the condition so other threads may release
+                    # or acquire ranges meanwhile.
+                    delay = backoff * random.uniform(0.5, 1.0)
+                    if remaining is not None:
+                        delay = min(delay, remaining)
+                    backoff = min(backoff * 2, self.max_backoff)
+                    self._condition.release()
+                    try:
+                        time.sleep(delay)
+                    finally:
+                        self._condition.acquire()
+                else:
+                    self._condition.wait(remaining)
+
+            lock = RangeLock(self, offset, length, exclusive)
+            lock.key = self._ranges.add(offset, offset + length, lock)
+            self._acquired += 1
+            if started is not None:
+                self._wait_time += monotonic() - started
+            return lock
+
+    def try_acquire(self, offset, length, exclusive=True):
+        """
+        Same as :meth:`acquire` with ``blocking=False``.
+        """
+        return self.acquire(offset, length, exclusive=exclusive,
+                            blocking=False)
+
+    def release(self, lock):
+        """
+        Unlocks the range held by ``lock``.  Has no effect if the range
+        has already been released.
+
+        :param RangeLock lock:
+            A lock returned by :meth:`acquire`.
+        """
+        input_check("lock", lock, RangeLock)
+        if lock.manager is not self:
+            raise InputError(
+                "lock", lock,
+                message="Expected a lock acquired from this manager")
+
+        with self._condition:
+            if lock.key is None:
+                return
+
+            high, low = split_dwords(lock.length)
+            with self.pool.overlapped(lock.offset) as lpOverlapped:
+                UnlockFileEx(self.hFile, low, high, lpOverlapped)
+
+            self._ranges.remove(lock.key)
+            lock.key = None
+            self._released += 1
+            self._condition.notify_all()
+
+    def release_all(self):
+        """Releases every range held through this manager"""
+        with self._condition:
+            locks = [
+                value for _, _, value in self._ranges.overlapping(
+                    0, 0xFFFFFFFFFFFFFFFF)]
+        for lock in locks:
+            self.release(lock)
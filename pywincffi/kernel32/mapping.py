@@ -0,0 +1,588 @@
+"""
+Memory Mapped Files
+-------------------
+
+A module containing Windows functions for mapping files, or the paging
+file, into memory.  Besides the function wrappers this module provides
+:class:`MappedView`, which exposes a view as a :class:`memoryview` with a
+managed lifetime, and :class:`MappedFileWindow` which slides a view across
+mappings too large to map at once.
+"""
+
+import weakref
+from itertools import count
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, input_check, error_check, NoneType
+from pywincffi.exceptions import InputError
+from pywincffi.kernel32.memory import allocation_granularity, _null_check
+from pywincffi.kernel32.tracking import tracked
+from pywincffi.wintypes import (
+    SECURITY_ATTRIBUTES, HANDLE, wintype_to_cdata, split_dwords)
+
+
+def CreateFileMapping(  # pylint: disable=too-many-arguments
+        hFile, lpAttributes=None, flProtect=None, dwMaximumSizeHigh=0,
+        dwMaximumSizeLow=0, lpName=None):
+    """
+    Creates or opens a named or unnamed file mapping object for
+    the specified file.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366537
+
+    :type hFile: pywincffi.wintypes.HANDLE or None
+    :param hFile:
+        A handle to the file to create the mapping from.  If ``None`` is
+        provided then the mapping will be backed by the paging file which
+        is how memory is usually shared between processes.
+
+    :keyword pywincffi.wintypes.SECURITY_ATTRIBUTES lpAttributes:
+        If not provided then, by default, the handle cannot be inherited
+        by a subprocess.
+
+    :keyword int flProtect:
+        The page protection of the file mapping object.  By default
+        ``PAGE_READWRITE`` will be used.
+
+    :keyword int dwMaximumSizeHigh:
+        The high-order ``DWORD`` of the maximum size of the mapping.
+
+    :keyword int dwMaximumSizeLow:
+        The low-order ``DWORD`` of the maximum size of the mapping.  If
+        this and ``dwMaximumSizeHigh`` are 0, which is the default, the
+        maximum size will be the current size of ``hFile``.
+
+    :keyword str lpName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The optional name of the mapping.  If a mapping by this name already
+        exists then it will be opened instead.
+
+    :rtype: pywincffi.wintypes.HANDLE
+    :returns:
+        Returns a handle to the mapping.
+        :func:`pywincffi.kernel32.CloseHandle` should be called on the handle
+        when you are done with it.
+    """
+    ffi, library = dist.load()
+
+    if flProtect is None:
+        flProtect = library.PAGE_READWRITE
+
+    input_check("hFile", hFile, (NoneType, HANDLE))
+    input_check(
+        "lpAttributes", lpAttributes,
+        allowed_types=(NoneType, SECURITY_ATTRIBUTES))
+    input_check("flProtect", flProtect, integer_types)
+    input_check("dwMaximumSizeHigh", dwMaximumSizeHigh, integer_types)
+    input_check("dwMaximumSizeLow", dwMaximumSizeLow, integer_types)
+    input_check("lpName", lpName, (NoneType, text_type))
+
+    if hFile is None:
+        hFile = ffi.cast("HANDLE", library.INVALID_HANDLE_VALUE)
+    else:
+        hFile = wintype_to_cdata(hFile)
+
+    handle = library.CreateFileMapping(
+        hFile,
+        wintype_to_cdata(lpAttributes),
+        ffi.cast("DWORD", flProtect),
+        ffi.cast("DWORD", dwMaximumSizeHigh),
+        ffi.cast("DWORD", dwMaximumSizeLow),
+        ffi.NULL if lpName is None else lpName
+    )
+    _null_check("CreateFileMapping", handle)
+    return tracked(HANDLE(handle), "CreateFileMapping")
+
+
+def OpenFileMapping(dwDesiredAccess, bInheritHandle, lpName):
+    """
+    Opens a named file mapping object.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366791
+
+    :param int dwDesiredAccess:
+        The access to the mapping, such as ``FILE_MAP_READ``.
+
+    :param bool bInheritHandle:
+        True if the handle should be inheritable by new processes.
+
+    :param str lpName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The name of the file mapping object to open.
+
+    :rtype: pywincffi.wintypes.HANDLE
+    :returns:
+        Returns a handle to the mapping.
+    """
+    input_check("dwDesiredAccess", dwDesiredAccess, integer_types)
+    input_check("bInheritHandle", bInheritHandle, bool)
+    input_check("lpName", lpName, text_type)
+
+    ffi, library = dist.load()
+    handle = library.OpenFileMapping(
+        ffi.cast("DWORD", dwDesiredAccess),
+        ffi.cast("BOOL", bInheritHandle),
+        lpName
+    )
+    _null_check("OpenFileMapping", handle)
+    return tracked(HANDLE(handle), "OpenFileMapping")
+
+
+def MapViewOfFile(
+        hFileMappingObject, dwDesiredAccess, dwFileOffsetHigh=0,
+        dwFileOffsetLow=0, dwNumberOfBytesToMap=0):
+    """
+    Maps a view of a file mapping into the address space of the
+    calling process.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366761
+
+    :param pywincffi.wintypes.HANDLE hFileMappingObject:
+        A handle to the file mapping, such as one returned
+        by :func:`CreateFileMapping`.
+
+    :param int dwDesiredAccess:
+        The access to the view, such as ``FILE_MAP_READ``.
+
+    :keyword int dwFileOffsetHigh:
+        The high-order ``DWORD`` of the offset where the view begins.
+
+    :keyword int dwFileOffsetLow:
+        The low-order ``DWORD`` of the offset where the view begins.  The
+        offset must be a multiple of the allocation granularity.
+
+    :keyword int dwNumberOfBytesToMap:
+        The number of bytes to map.  If 0, which is the default, the view
+        will extend to the end of the mapping.
+
+    :returns:
+        Returns the ``LPVOID`` address of the view.
+        :func:`UnmapViewOfFile` should be called on the address when you
+        are done with it.
+    """
+    input_check("hFileMappingObject", hFileMappingObject, HANDLE)
+    input_check("dwDesiredAccess", dwDesiredAccess, integer_types)
+    input_check("dwFileOffsetHigh", dwFileOffsetHigh, integer_types)
+    input_check("dwFileOffsetLow", dwFileOffsetLow, integer_types)
+    input_check("dwNumberOfBytesToMap", dwNumberOfBytesToMap, integer_types)
+
+    ffi, library = dist.load()
+    address = library.MapViewOfFile(
+        wintype_to_cdata(hFileMappingObject),
+        ffi.cast("DWORD", dwDesiredAccess),
+        ffi.cast("DWORD", dwFileOffsetHigh),
+        ffi.cast("DWORD", dwFileOffsetLow),
+        ffi.cast("SIZE_T", dwNumberOfBytesToMap)
+    )
+    _null_check("MapViewOfFile", address)
+    return address
+
+
+def MapViewOfFileEx(  # pylint: disable=too-many-arguments
+        hFileMappingObject, dwDesiredAccess, dwFileOffsetHigh=0,
+        dwFileOffsetLow=0, dwNumberOfBytesToMap=0, lpBaseAddress=None):
+    """
+    Maps a view of a file mapping into the address space of the calling
+    process at an optional base address.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366763
+
+    See :func:`MapViewOfFile` for documentation on the common arguments.
+
+    :keyword lpBaseAddress:
+        The ``LPVOID`` address where the view should begin.  If ``None``,
+        which is the default, the system chooses the address.
+
+    :returns:
+        Returns the ``LPVOID`` address of the view.
+    """
+    input_check("hFileMappingObject", hFileMappingObject, HANDLE)
+    input_check("dwDesiredAccess", dwDesiredAccess, integer_types)
+    input_check("dwFileOffsetHigh", dwFileOffsetHigh, integer_types)
+    input_check("dwFileOffsetLow", dwFileOffsetLow, integer_types)
+    input_check("dwNumberOfBytesToMap", dwNumberOfBytesToMap, integer_types)
+
+    ffi, library = dist.load()
+
+    if lpBaseAddress is None:
+        lpBaseAddress = ffi.NULL
+    else:
+        input_check("lpBaseAddress", lpBaseAddress, ffi.CData)
+
+    address = library.MapViewOfFileEx(
+        wintype_to_cdata(hFileMappingObject),
+        ffi.cast("DWORD", dwDesiredAccess),
+        ffi.cast("DWORD", dwFileOffsetHigh),
+        ffi.cast("DWORD", dwFileOffsetLow),
+        ffi.cast("SIZE_T", dwNumberOfBytesToMap),
+        lpBaseAddress
+    )
+    _null_check("MapViewOfFileEx", address)
+    return address
+
+
+def FlushViewOfFile(lpBaseAddress, dwNumberOfBytesToFlush=0):
+    """
+    Writes a byte range within a mapped view to disk.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366563
+
+    :param lpBaseAddress:
+        The ``LPVOID`` address of the first byte to flush.
+
+    :keyword int dwNumberOfBytesToFlush:
+        The number of bytes to flush.  If 0, which is the default, the
+        rest of the view will be flushed.
+    """
+    ffi, library = dist.load()
+    input_check("lpBaseAddress", lpBaseAddress, ffi.CData)
+    input_check(
+        "dwNumberOfBytesToFlush", dwNumberOfBytesToFlush, integer_types)
+
+    code = library.FlushViewOfFile(
+        lpBaseAddress, ffi.cast("SIZE_T", dwNumberOfBytesToFlush))
+    error_check("FlushViewOfFile", code=code, expected=NON_ZERO)
+
+
+def UnmapViewOfFile(lpBaseAddress):
+    """
+    Unmaps a view of a file from the address space of the calling process.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366882
+
+    :param lpBaseAddress:
+        The ``LPVOID`` address returned by :func:`MapViewOfFile`.
+    """
+    ffi, library = dist.load()
+    input_check("lpBaseAddress", lpBaseAddress, ffi.CData)
+    code = library.UnmapViewOfFile(lpBaseAddress)
+    error_check("UnmapViewOfFile", code=code, expected=NON_ZERO)
+
+
+def _release(view):
+    """
+    Releases ``view`` so any further access raises :class:`ValueError`
+    rather than touching unmapped memory.  Python 2 has no
+    ``memoryview.release()`` in which case this does nothing.
+    """
+    release = getattr(view, "release", None)
+    if release is not None:
+        release()
+
+
+class MappedView(object):
+    """
+    Maps ``size`` bytes of ``hFileMappingObject``, starting at ``offset``,
+    and exposes them as a :class:`memoryview`.  Unlike
+    :func:`MapViewOfFile`, ``offset`` does not have to be a multiple of the
+    allocation granularity.  The view is unmapped by :meth:`close` or when
+    used as a context manager:
+
+    >>> from pywincffi.kernel32 import CreateFileMapping, MappedView
+    >>> hMap = CreateFileMapping(None, dwMaximumSizeLow=4096, lpName=u"ipc")
+    >>> with MappedView(hMap, 0, 4096) as view:
+    ...     view.buffer[0:5] = b"hello"
+
+    Every :class:`memoryview` handed out by :attr:`buffer` or :meth:`slice`
+    which is still alive is released when the view is closed, so using one
+    afterwards raises :class:`ValueError` instead of reading unmapped
+    memory.  The view only holds weak references to them so slicing many
+    times does not accumulate memory views.  Python 2 can't release, or
+    weakly reference, a :class:`memoryview` so there nothing is tracked and
+    it is up to the caller not to keep one past :meth:`close`.
+
+    :param pywincffi.wintypes.HANDLE hFileMappingObject:
+        The handle to the file mapping.
+
+    :param int offset:
+        The offset, in bytes, of the first byte of the view.
+
+    :param int size:
+        The number of bytes to map.
+
+    :keyword int dwDesiredAccess:
+        The access to the view.  By default ``FILE_MAP_WRITE`` will be used.
+        Views without ``FILE_MAP_WRITE`` or ``FILE_MAP_COPY`` access produce
+        read-only memory views where Python supports it.
+    """
+    def __init__(self, hFileMappingObject, offset, size, dwDesiredAccess=None):
+        ffi, library = dist.load()
+
+        if dwDesiredAccess is None:
+            dwDesiredAccess = library.FILE_MAP_WRITE
+
+        input_check("offset", offset, integer_types)
+        input_check("size", size, integer_types)
+
+        if offset < 0 or size <= 0:
+            raise InputError(
+                "size", size,
+                message="Expected `offset` >= 0 and `size` > 0")
+
+        start = offset - (offset % allocation_granularity())
+        self._skew = offset - start
+        self.offset = offset
+        self.size = size
+        self.readonly = not dwDesiredAccess & (
+            library.FILE_MAP_WRITE | library.FILE_MAP_COPY)
+
+        dwFileOffsetHigh, dwFileOffsetLow = split_dwords(start)
+        self.address = MapViewOfFile(
+            hFileMappingObject, dwDesiredAccess, dwFileOffsetHigh,
+            dwFileOffsetLow, size + self._skew)
+        self._data = ffi.cast("char *", self.address) + self._skew
+        self._exports = {}
+        self._export_ids = count()
+        self._buffer = self._export(memoryview(ffi.buffer(self._data, size)))
+
+    def _export(self, view):
+        if self.readonly and hasattr(view, "toreadonly"):
+            view = view.toreadonly()
+
+        # Python 2 can neither release nor weakly reference a memoryview
+        if hasattr(view, "release"):
+            exports = self._exports
+            key = next(self._export_ids)
+            exports[key] = weakref.ref(
+                view, lambda _, key=key: exports.pop(key, None))
+        return view
+
+    @property
+    def closed(self):
+        """True once the view has been unmapped"""
+        return self.address is None
+
+    @property
+    def buffer(self):
+        """A :class:`memoryview` covering the whole view"""
+        if self.closed:
+            raise ValueError("I/O operation on a closed view")
+        return self._buffer
+
+    def slice(self, start, stop):
+        """
+        Returns a :class:`memoryview` of bytes ``start`` through ``stop``
+        relative to the start of the view.
+        """
+        if self.closed:
+            raise ValueError("I/O operation on a closed view")
+        return self._export(self._buffer[start:stop])
+
+    def flush(self, start=0, size=None):
+        """
+        Flushes ``size`` bytes of the view to disk starting at ``start``.
+        By default the whole view is flushed.
+        """
+        if self.closed:
+            raise ValueError("I/O operation on a closed view")
+
+        if size is None:
+            size = self.size - start
+
+        FlushViewOfFile(self._data + start, size)
+
+    def close(self):
+        """
+        Releases outstanding memory views then unmaps the view.
+
+        :raises BufferError:
+            Raised, without unmapping the view, if a memory view could not
+            be released because something still holds a buffer exported
+            from it, such as a ``bytearray`` resized over it or a
+            ``numpy`` array.  Memory views which could be released stay
+            released; :meth:`close` can be called again once the consumer
+            has let go.
+        """
+        if self.closed:
+            return
+
+        # Exports are released newest first so slices go before the
+        # buffer they were created from.
+        busy = 0
+        for key in sorted(self._exports, reverse=True):
+            view = self._exports[key]()
+            try:
+                if view is not None:
+                    _release(view)
+            except BufferError:
+                busy += 1
+            else:
+                self._exports.pop(key, None)
+
+        if busy:
+            raise BufferError(
+                "%d memory view(s) of %r are still exported; the view was "
+                "not unmapped" % (busy, self))
+
+        address, self.address = self.address, None
+        self._data = None
+        UnmapViewOfFile(address)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
+
+    def __repr__(self):
+        return "<%s offset=%d size=%d%s>" % (
+            self.__class__.__name__, self.offset, self.size,
+            " closed" if self.closed else "")
+
+
+def window_bounds(offset, size, window_size, granularity, total_size):
+    """
+    Returns the ``(start, size)`` of the window which should be mapped
+    so the bytes ``offset`` through ``offset + size`` can be accessed.
+    ``start`` is aligned to ``granularity`` and the window is at least
+    ``window_size`` bytes unless it reaches ``total_size`` first.
+    """
+    start = offset - (offset % granularity)
+    end = min(total_size, max(start + window_size, offset + size))
+    return start, end - start
+
+
+class MappedFileWindow(object):
+    """
+    Slides a single :class:`MappedView` across a file mapping so mappings
+    larger than the available address space can be read or written.  Only
+    one window is mapped at a time, moving the window releases every
+    :class:`memoryview` which was handed out for the previous window.
+
+    >>> from pywincffi.kernel32 import CreateFileMapping, MappedFileWindow
+    >>> hMap = CreateFileMapping(hFile, flProtect=library.PAGE_READONLY)
+    >>> with MappedFileWindow(
+    ...         hMap, file_size,
+    ...         dwDesiredAccess=library.FILE_MAP_READ) as window:
+    ...     for offset, data in window.windows():
+    ...         digest.update(data)
+
+    :param pywincffi.wintypes.HANDLE hFileMappingObject:
+        The handle to the file mapping.
+
+    :param int size:
+        The total size, in bytes, of the mapping.
+
+    :keyword int window_size:
+        The minimum size of each window, rounded up to the allocation
+        granularity.  By default 64 times the allocation granularity
+        is used, 4MiB on most systems.
+
+    :keyword int dwDesiredAccess:
+        The access for each view, see :class:`MappedView`.
+    """
+    def __init__(
+            self, hFileMappingObject, size, window_size=None,
+            dwDesiredAccess=None):
+        input_check("hFileMappingObject", hFileMappingObject, HANDLE)
+        input_check("size", size, integer_types)
+
+        granularity = allocation_granularity()
+        if window_size is None:
+            window_size = granularity * 64
+
+        input_check("window_size", window_size, integer_types)
+        if window_size <= 0:
+            raise InputError(
+                "window_size", window_size,
+                message="Expected `window_size` to be greater than 0")
+
+        self.hFileMappingObject = hFileMappingObject
+        self.size = size
+        self.window_size = -(-window_size // granularity) * granularity
+        self.granularity = granularity
+        self.dwDesiredAccess = dwDesiredAccess
+        self.remaps = 0
+        self._view = None
+
+    def _contains(self, offset, size):
+        view = self._view
+        return (
+            view is not None and view.offset <= offset and
+            offset + size <= view.offset + view.size)
+
+    def view(self, offset, size):
+        """
+        Returns a :class:`memoryview` of ``size`` bytes starting at
+        ``offset``, sliding the window first if the current window does not
+        contain the requested range.
+
+        :raises InputError:
+            Raised if the range extends past the end of the mapping or
+            ``size`` is larger than the window.
+        """
+        input_check("offset", offset, integer_types)
+        input_check("size", size, integer_types)
+
+        if offset < 0 or size < 0 or offset + size > self.size:
+            raise InputError(
+                "size", size,
+                message="Range %d-%d is outside of the mapping (%d bytes)" % (
+                    offset, offset + size, self.size))
+
+        if size > self.window_size:
+            raise InputError(
+                "size", size,
+                message="Expected `size` to be no larger than the window "
+                        "(%d bytes)" % self.window_size)
+
+        if not self._contains(offset, size):
+            self.slide(offset, size)
+
+        start = offset - self._view.offset
+        return self._view.slice(start, start + size)
+
+    def slide(self, offset, size=0):
+        """
+        Unmaps the current window, if any, and maps the window containing
+        ``offset``.
+
+        :rtype: MappedView
+        :returns:
+            Returns the newly mapped window.
+        """
+        self.close()
+        start, length = window_bounds(
+            offset, size, self.window_size, self.granularity, self.size)
+        self._view = MappedView(
+            self.hFileMappingObject, start, length,
+            dwDesiredAccess=self.dwDesiredAccess)
+        self.remaps += 1
+        return self._view
+
+    def windows(self):
+        """
+        A generator which maps each window of the mapping in turn
+        yielding a tuple of ``(offset, memoryview)``.
+        """
+        offset = 0
+        while offset < self.size:
+            size = min(self.window_size, self.size - offset)
+            yield offset, self.view(offset, size)
+            offset += size
+
+    def close(self):
+        """Unmaps the current window if there is one"""
+        if self._view is not None:
+            self._view.close()
+            self._view = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
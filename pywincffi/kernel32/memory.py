@@ -0,0 +1,376 @@
+"""
+Memory
+------
+
+A module containing Windows functions for querying and managing
+virtual memory.  :class:`AlignedBufferPool` uses these to hand out the
+aligned buffers required by handles opened with ``FILE_FLAG_NO_BUFFERING``.
+"""
+
+import threading
+from collections import deque
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, input_check, error_check, NoneType
+from pywincffi.exceptions import InputError, WindowsAPIError
+
+
+def _null_check(function, result):
+    """
+    Raises :class:`WindowsAPIError` if ``result``, the return value
+    of ``function``, is ``NULL``.
+    """
+    ffi, _ = dist.load()
+    if result == ffi.NULL:
+        errno, message = ffi.getwinerror()
+        raise WindowsAPIError(function, message, errno)
+
+
+def GetSystemInfo():
+    """
+    Retrieves information about the current system such as the page size
+    and the allocation granularity.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms724381
+
+    :returns:
+        Returns a ffi data structure with attributes corresponding to
+        the fields on the ``SYSTEM_INFO`` struct.
+    """
+    ffi, library = dist.load()
+    lpSystemInfo = ffi.new("LPSYSTEM_INFO")
+    library.GetSystemInfo(lpSystemInfo)
+    return lpSystemInfo
+
+
+# Values from GetSystemInfo() which never change while the process
+# is running.  Populated on first use by the functions below.
+_SYSTEM_INFO_CACHE = {}
+
+
+def _system_info(field):
+    try:
+        return _SYSTEM_INFO_CACHE[field]
+    except KeyError:
+        info = GetSystemInfo()
+        _SYSTEM_INFO_CACHE.update(
+            dwPageSize=int(info.dwPageSize),
+            dwAllocationGranularity=int(info.dwAllocationGranularity))
+        return _SYSTEM_INFO_CACHE[field]
+
+
+def allocation_granularity():
+    """
+    Returns the granularity, in bytes, at which views of a file mapping
+    may start.  The value is retrieved once using :func:`GetSystemInfo`
+    then cached.
+
+    :rtype: int
+    """
+    return _system_info("dwAllocationGranularity")
+
+
+def page_size():
+    """
+    Returns the size, in bytes, of a page of memory.  The value is
+    retrieved once using :func:`GetSystemInfo` then cached.
+
+    :rtype: int
+    """
+    return _system_info("dwPageSize")
+
+
+def VirtualAlloc(lpAddress, dwSize, flAllocationType=None, flProtect=None):
+    """
+    Reserves, commits, or changes the state of a region of pages in the
+    virtual address space of the calling process.  Memory allocated
+    by this function is automatically initialized to zero and starts on
+    an :func:`allocation_granularity` boundary.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366887
+
+    :param lpAddress:
+        The starting address of the region to allocate or ``None`` to let
+        the system determine where to allocate the region.
+
+    :param int dwSize:
+        The size of the region in bytes.
+
+    :keyword int flAllocationType:
+        The type of allocation.  Defaults to
+        ``MEM_COMMIT | MEM_RESERVE``.
+
+    :keyword int flProtect:
+        The memory protection for the region.  Defaults to
+        ``PAGE_READWRITE``.
+
+    :returns:
+        Returns the base address of the allocated region.  Use
+        :func:`VirtualFree` to release it.
+    """
+    ffi, library = dist.load()
+
+    if flAllocationType is None:
+        flAllocationType = library.MEM_COMMIT | library.MEM_RESERVE
+
+    if flProtect is None:
+        flProtect = library.PAGE_READWRITE
+
+    input_check("dwSize", dwSize, integer_types)
+    input_check("flAllocationType", flAllocationType, integer_types)
+    input_check("flProtect", flProtect, integer_types)
+
+    address = library.VirtualAlloc(
+        ffi.NULL if lpAddress is None else lpAddress,
+        ffi.cast("SIZE_T", dwSize), flAllocationType, flProtect
+    )
+    _null_check("VirtualAlloc", address)
+    return address
+
+
+def VirtualFree(lpAddress, dwSize=0, dwFreeType=None):
+    """
+    Releases or decommits a region of pages allocated by
+    :func:`VirtualAlloc`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa366892
+
+    :param lpAddress:
+        The address returned by :func:`VirtualAlloc`.
+
+    :keyword int dwSize:
+        The size of the region to free.  Must be 0, the default, when
+        ``dwFreeType`` is ``MEM_RELEASE``.
+
+    :keyword int dwFreeType:
+        The type of free operation.  Defaults to ``MEM_RELEASE``.
+    """
+    ffi, library = dist.load()
+
+    if dwFreeType is None:
+        dwFreeType = library.MEM_RELEASE
+
+    input_check("dwSize", dwSize, integer_types)
+    input_check("dwFreeType", dwFreeType, integer_types)
+
+    code = library.VirtualFree(
+        lpAddress, ffi.cast("SIZE_T", dwSize), dwFreeType)
+    error_check("VirtualFree", code=code, expected=NON_ZERO)
+
+
+def round_up(value, multiple):
+    """
+    Returns ``value`` rounded up to the nearest multiple of ``multiple``.
+
+    :rtype: int
+    """
+    return -(-value // multiple) * multiple
+
+
+class AlignedBufferPool(object):
+    """
+    A pool of writable :class:`memoryview` buffers which start on an
+    ``alignment`` boundary and are a multiple of ``alignment`` in size.
+    This satisfies the requirements of a handle opened with
+    ``FILE_FLAG_NO_BUFFERING`` when ``alignment`` is the sector size of the
+    volume, see :func:`pywincffi.kernel32.sector_size`:
+
+    >>> from pywincffi.kernel32 import (
+    ...     AlignedBufferPool, pread_into, sector_size)
+    >>> pool = AlignedBufferPool(sector_size(u"D:\\data.bin"), 65536)
+    >>> with pool.buffer() as buffer_:
+    ...     count = pread_into(hFile, buffer_, 0)
+
+    Buffers are carved out of slabs allocated with :func:`VirtualAlloc`,
+    which are only released by :meth:`close`.  Released buffers are reused
+    rather than freed so the same :class:`memoryview` objects are handed
+    out again.  The pool may be shared between threads.
+
+    :param int alignment:
+        The alignment, in bytes, of each buffer.  Must be a power of two no
+        larger than :func:`allocation_granularity`.
+
+    :param int buffer_size:
+        The minimum size of each buffer.  This is rounded up to a multiple
+        of ``alignment``.
+
+    :keyword int slab_size:
+        The minimum number of bytes allocated by each call to
+        :func:`VirtualAlloc`.  Defaults to :func:`allocation_granularity`
+        which is the least ``VirtualAlloc`` will reserve.
+    """
+    def __init__(self, alignment, buffer_size, slab_size=None):
+        input_check("alignment", alignment, integer_types)
+        input_check("buffer_size", buffer_size, integer_types)
+        input_check("slab_size", slab_size, (NoneType, ) + integer_types)
+
+        granularity = allocation_granularity()
+        if alignment <= 0 or alignment & (alignment - 1) \
+                or alignment > granularity:
+            raise InputError(
+                "alignment", alignment,
+                message="Expected `alignment` to be a power of two no "
+                        "larger than %d" % granularity)
+
+        if buffer_size <= 0:
+            raise InputError(
+                "buffer_size", buffer_size,
+                message="Expected `buffer_size` to be greater than 0")
+
+        self.alignment = alignment
+        self.buffer_size = round_up(buffer_size, alignment)
+        self.slab_size = round_up(
+            max(slab_size or granularity, self.buffer_size), page_size())
+        self.created = 0
+        self.closed = False
+        self._slabs = []
+        self._owned = {}
+        self._in_use = set()
+        self._idle = deque()
+        self._lock = threading.Lock()
+
+    def __len__(self):
+        return len(self._idle)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
+
+    def _allocate_slab(self):
+        ffi, _ = dist.load()
+        slab = VirtualAlloc(None, self.slab_size)
+        buffers = []
+        self._slabs.append((slab, buffers))
+        address = ffi.cast("char *", slab)
+        for offset in range(
+                0, self.slab_size - self.buffer_size + 1, self.buffer_size):
+            buffer_ = memoryview(
+                ffi.buffer(address + offset, self.buffer_size))
+            buffers.append(buffer_)
+            self._owned[id(buffer_)] = buffer_
+            self._idle.append(buffer_)
+            self.created += 1
+
+    def acquire(self):
+        """
+        Returns an aligned buffer from the pool allocating a new slab
+        if no idle buffers are available.  Reused buffers are not zeroed.
+
+        :rtype: memoryview
+        """
+        if self.closed:
+            raise ValueError("The pool has been closed")
+
+        while True:
+            try:
+                buffer_ = self._idle.pop()
+                self._in_use.add(id(buffer_))
+                return buffer_
+            except IndexError:
+                with self._lock:
+                    if not self._idle:
+                        self._allocate_slab()
+
+    def release(self, buffer_):
+        """
+        Returns ``buffer_``, which must have come from :meth:`acquire`, to
+        the pool.  Any I/O using the buffer must have completed.  Once the
+        pool has been closed this is a no-op, so a buffer may be released
+        after :meth:`close`, for example by :meth:`buffer` on exit.
+
+        :raises InputError:
+            Raised if ``buffer_`` does not belong to this pool or has
+            already been released.
+        """
+        if self.closed:
+            return
+
+        if self._owned.get(id(buffer_)) is not buffer_:
+            raise InputError(
+                "buffer_", buffer_,
+                message="Expected `buffer_` to have come from this pool")
+
+        try:
+            self._in_use.remove(id(buffer_))
+        except KeyError:
+            raise InputError(
+                "buffer_", buffer_,
+                message="`buffer_` has already been released")
+
+        self._idle.append(buffer_)
+
+    def buffer(self):
+        """
+        A context manager which acquires a buffer and releases it on exit.
+        """
+        return _PooledBuffer(self)
+
+    def close(self):
+        """
+        Releases every buffer and frees the slabs allocated by the pool.
+        Buffers from the pool, including those which have not been
+        released, must not be used afterwards.  Closing the pool more than
+        once is a no-op.
+
+        :raises BufferError:
+            Raised if a buffer could not be released because something
+            still holds a buffer exported from it, such as a ``numpy``
+            array.  The slabs holding such buffers are not freed, so the
+            consumer never sees freed memory, and calling :meth:`close`
+            again once the consumer has let go frees them.  Python 2 can't
+            release a :class:`memoryview` so there it is up to the caller
+            not to use one past :meth:`close`.
+        """
+        with self._lock:
+            if self.closed and not self._slabs:
+                return
+
+            self.closed = True
+            self._idle.clear()
+            busy = []
+            for slab, buffers in self._slabs:
+                exported = 0
+                for buffer_ in buffers:
+                    release = getattr(buffer_, "release", None)
+                    try:
+                        if release is not None:
+                            release()
+                    except BufferError:
+                        exported += 1
+
+                if exported:
+                    busy.append((slab, buffers))
+                else:
+                    VirtualFree(slab)
+
+            self._slabs = busy
+            if busy:
+                raise BufferError(
+                    "Buffers in %d slab(s) are still exported; those slabs "
+                    "were not freed" % len(busy))
+
+            self._owned.clear()
+            self._in_use.clear()
+
+
+class _PooledBuffer(object):  # pylint: disable=too-few-public-methods
+    """Context manager returned by :meth:`AlignedBufferPool.buffer`"""
+    def __init__(self, pool):
+        self.pool = pool
+        self.buffer_ = pool.acquire()
+
+    def __enter__(self):
+        return self.buffer_
+
+    def __exit__(self, *_):
+        self.pool.release(self.buffer_)
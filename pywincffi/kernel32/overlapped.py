@@ -2,12 +2,21 @@
 Overlapped
 ----------
 
-A module containing Windows functions for working with OVERLAPPED objects.
+A module containing Windows functions for working with OVERLAPPED objects
+and :class:`OverlappedPool` which recycles them.
 """
 
+from collections import deque
+
+from six import integer_types
+
 from pywincffi.core import dist
-from pywincffi.core.checks import NON_ZERO, input_check, error_check
-from pywincffi.wintypes import HANDLE, OVERLAPPED, wintype_to_cdata
+from pywincffi.core.checks import (
+    NON_ZERO, NoneType, input_check, error_check)
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.wintypes import (
+    HANDLE, OVERLAPPED, wintype_to_cdata, split_dwords)
 
 
 def GetOverlappedResult(hFile, lpOverlapped, bWait):
@@ -64,3 +73,138 @@ def GetOverlappedResult(hFile, lpOverlapped, bWait):
     error_check("GetOverlappedResult", result, NON_ZERO)
 
     return int(lpNumberOfBytesTransferred[0])
+
+
+def CancelIoEx(hFile, lpOverlapped=None):
+    """
+    Cancels outstanding overlapped operations on ``hFile`` issued by any
+    thread in the current process.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa363792
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to cancel operations on.
+
+    :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        The operation to cancel.  By default every operation on ``hFile``
+        is cancelled.
+
+    :rtype: bool
+    :returns:
+        Returns False if there was nothing to cancel.  Use
+        :func:`GetOverlappedResult` to wait for cancelled operations to
+        complete before releasing their buffers.
+    """
+    input_check("hFile", hFile, HANDLE)
+    input_check("lpOverlapped", lpOverlapped, (NoneType, OVERLAPPED))
+
+    ffi, library = dist.load()
+    code = library.CancelIoEx(
+        wintype_to_cdata(hFile), wintype_to_cdata(lpOverlapped))
+    if code == 0:
+        errno, message = ffi.getwinerror()
+        if errno != library.ERROR_NOT_FOUND:
+            raise WindowsAPIError(
+                "CancelIoEx", message, errno, return_code=code,
+                expected_return_code=NON_ZERO)
+        library.SetLastError(0)
+        return False
+    return True
+
+
+class OverlappedPool(object):
+    """
+    A pool of :class:`pywincffi.wintypes.OVERLAPPED` structures.  Creating
+    an ``OVERLAPPED`` allocates new cdata each time so code which performs
+    many positioned or asynchronous operations should acquire them from a
+    pool instead:
+
+    >>> from pywincffi.kernel32 import OverlappedPool, ReadFile
+    >>> pool = OverlappedPool()
+    >>> with pool.overlapped(offset=1 << 32) as lpOverlapped:
+    ...     data = ReadFile(hFile, 4096, lpOverlapped=lpOverlapped)
+
+    The pool may be shared between threads.  Each structure is only handed
+    out to one caller at a time.
+
+    :keyword int maximum:
+        The maximum number of idle structures kept by the pool.  Structures
+        released while the pool is full are discarded.
+
+    :keyword callable event_factory:
+        An optional callable returning a :class:`pywincffi.wintypes.HANDLE`
+        to an event, such as :func:`pywincffi.kernel32.CreateEvent`.  When
+        provided each new structure receives its own event in ``hEvent``
+        which is required when several overlapped operations are
+        outstanding on one handle at the same time.  Events are owned by
+        the structure, reused along with it and closed if the structure
+        is discarded.
+    """
+    def __init__(self, maximum=64, event_factory=None):
+        input_check("maximum", maximum, integer_types)
+        self.maximum = maximum
+        self.event_factory = event_factory
+        self.created = 0
+        self._idle = deque()
+
+    def __len__(self):
+        return len(self._idle)
+
+    def acquire(self, offset=0):
+        """
+        Returns an ``OVERLAPPED`` structure whose ``Offset`` and
+        ``OffsetHigh`` fields have been set to ``offset``.  The other
+        fields, except for ``hEvent``, are zeroed.
+
+        :param int offset:
+            A 64-bit offset from the start of the file.
+        """
+        input_check("offset", offset, integer_types)
+        if offset < 0:
+            raise InputError(
+                "offset", offset, message="Expected `offset` to be >= 0")
+
+        try:
+            lpOverlapped = self._idle.pop()
+        except IndexError:
+            lpOverlapped = OVERLAPPED()
+            self.created += 1
+            if self.event_factory is not None:
+                lpOverlapped.hEvent = self.event_factory()
+
+        lpOverlapped.OffsetHigh, lpOverlapped.Offset = split_dwords(offset)
+        lpOverlapped.Internal = 0
+        lpOverlapped.InternalHigh = 0
+        return lpOverlapped
+
+    def release(self, lpOverlapped):
+        """
+        Returns ``lpOverlapped`` to the pool.  The operation using the
+        structure must have completed before it's released.
+        """
+        if len(self._idle) < self.maximum:
+            self._idle.append(lpOverlapped)
+        elif self.event_factory is not None:
+            CloseHandle(lpOverlapped.hEvent)
+
+    def overlapped(self, offset=0):
+        """
+        A context manager which acquires a structure for ``offset`` and
+        releases it on exit.
+        """
+        return _PooledOverlapped(self, offset)
+
+
+class _PooledOverlapped(object):  # pylint: disable=too-few-public-methods
+    """Context manager returned by :meth:`OverlappedPool.overlapped`"""
+    def __init__(self, pool, offset):
+        self.pool = pool
+        self.lpOverlapped = pool.acquire(offset)
+
+    def __enter__(self):
+        return self.lpOverlapped
+
+    def __exit__(self, *_):
+        self.pool.release(self.lpOverlapped)
@@ -11,6 +11,7 @@ from six import integer_types
 
 from pywincffi.core import dist
 from pywincffi.core.checks import NON_ZERO, input_check, error_check, NoneType
+from pywincffi.kernel32.tracking import tracked
 from pywincffi.wintypes import SECURITY_ATTRIBUTES, HANDLE, wintype_to_cdata
 
 PeekNamedPipeResult = namedtuple(
@@ -66,7 +67,8 @@ def CreatePipe(lpPipeAttributes=None, nSize=0):
     code = library.CreatePipe(hReadPipe, hWritePipe, lpPipeAttributes, nSize)
     error_check("CreatePipe", code=code, expected=NON_ZERO)
 
-    return HANDLE(hReadPipe[0]), HANDLE(hWritePipe[0])
+    return (tracked(HANDLE(hReadPipe[0]), "CreatePipe"),
+            tracked(HANDLE(hWritePipe[0]), "CreatePipe"))
 
 
 def SetNamedPipeHandleState(
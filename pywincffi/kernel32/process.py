@@ -28,6 +28,7 @@ from pywincffi.exceptions import (
     WindowsAPIError, PyWinCFFINotImplementedError, InputError)
 from pywincffi.kernel32.handle import CloseHandle
 from pywincffi.kernel32.synchronization import WaitForSingleObject
+from pywincffi.kernel32.tracking import tracked
 from pywincffi.wintypes import (
     HANDLE, SECURITY_ATTRIBUTES, STARTUPINFO, PROCESS_INFORMATION,
     wintype_to_cdata)
@@ -306,7 +307,7 @@ def OpenProcess(dwDesiredAccess, bInheritHandle, dwProcessId):
         ffi.cast("DWORD", dwProcessId)
     )
     error_check("OpenProcess")
-    return HANDLE(handle)
+    return tracked(HANDLE(handle), "OpenProcess")
 
 
 def GetCurrentProcess():
@@ -414,7 +415,7 @@ def CreateToolhelp32Snapshot(dwFlags, th32ProcessID):
 
     error_check("CreateToolhelp32Snapshot")
 
-    return HANDLE(process_list)
+    return tracked(HANDLE(process_list), "CreateToolhelp32Snapshot")
 
 
 CreateProcessResult = namedtuple(
@@ -0,0 +1,270 @@
+"""
+Console Rendering
+-----------------
+
+A double buffered renderer for full screen console applications.  Each
+frame is drawn into a :class:`FrameBuffer`, a ``CHAR_INFO[]`` array the
+size of the screen, and :meth:`ConsoleRenderer.flush` compares it with
+the previous frame so only the rectangles which changed are written,
+each with a single call to
+:func:`pywincffi.kernel32.console.WriteConsoleOutputW`.
+"""
+
+from collections import namedtuple
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check
+from pywincffi.exceptions import InputError
+from pywincffi.kernel32.console import WriteConsoleOutputW
+from pywincffi.wintypes import HANDLE
+
+# An inclusive rectangle of cells, the same as SMALL_RECT
+Rect = namedtuple("Rect", ("left", "top", "right", "bottom"))
+
+RenderStatistics = namedtuple(
+    "RenderStatistics", ("frames", "writes", "cells"))
+
+# Stored in the front buffer to force a cell to be redrawn.  No real
+# cell uses all of the attribute bits.
+_INVALID_ATTRIBUTES = 0xFFFF
+
+
+class FrameBuffer(object):
+    """
+    A ``columns`` by ``rows`` array of ``CHAR_INFO`` cells in row major
+    order, the layout ``WriteConsoleOutputW`` expects.
+
+    :param int columns:
+        The width of the frame in cells.
+
+    :param int rows:
+        The height of the frame in cells.
+
+    :keyword int attributes:
+        The attributes blank cells are filled with.
+    """
+    def __init__(self, columns, rows, attributes=0):
+        input_check("columns", columns, integer_types)
+        input_check("rows", rows, integer_types)
+        if columns < 1 or rows < 1:
+            raise InputError(
+                "columns", columns,
+                message="Expected `columns` >= 1 and `rows` >= 1")
+
+        ffi, _ = dist.load()
+        self._ffi = ffi
+        self.columns = columns
+        self.rows = rows
+        self.cells = ffi.new("CHAR_INFO[]", columns * rows)
+        self.row_size = columns * ffi.sizeof("CHAR_INFO")
+        self.fill(attributes=attributes)
+
+    @property
+    def size(self):
+        """The ``(columns, rows)`` of the frame"""
+        return self.columns, self.rows
+
+    def fill(self, char=u" ", attributes=0, rect=None):
+        """
+        Sets every cell in ``rect``, the whole frame by default, to
+        ``char`` with ``attributes``.
+        """
+        left, top, right, bottom = rect or (
+            0, 0, self.columns - 1, self.rows - 1)
+        cells = self.cells
+        for y in range(max(top, 0), min(bottom, self.rows - 1) + 1):
+            start = y * self.columns
+            for x in range(max(left, 0), min(right, self.columns - 1) + 1):
+                cell = cells[start + x]
+                cell.Char.UnicodeChar = char
+                cell.Attributes = attributes
+
+    def put(self, x, y, text, attributes=0):
+        """
+        Writes ``text`` starting at cell ``(x, y)``.  Text running past
+        the right edge of the frame is clipped and characters outside the
+        basic multilingual plane are replaced with U+FFFD.
+
+        :rtype: int
+        :returns:
+            Returns the number of cells written.
+        """
+        input_check("text", text, text_type)
+        if not 0 <= y < self.rows or x >= self.columns:
+            return 0
+
+        if x < 0:
+            text = text[-x:]
+            x = 0
+        text = text[:self.columns - x]
+        cells = self.cells
+        start = y * self.columns + x
+        for i, char in enumerate(text):
+            cell = cells[start + i]
+            cell.Char.UnicodeChar = char if ord(char) <= 0xFFFF else u"\ufffd"
+            cell.Attributes = attributes
+        return len(text)
+
+    def cell(self, x, y):
+        """Returns the ``(char, attributes)`` of cell ``(x, y)``"""
+        cell = self.cells[y * self.columns + x]
+        return cell.Char.UnicodeChar, cell.Attributes
+
+    def row(self, y):
+        """Returns the raw bytes of row ``y``, for comparisons"""
+        return self._ffi.buffer(
+            self.cells + y * self.columns, self.row_size)[:]
+
+    def copy_from(self, other):
+        """Copies every cell of ``other``, a frame of the same size"""
+        if other.size != self.size:
+            raise InputError(
+                "other", other, message="Expected a frame of the same size")
+        self._ffi.memmove(
+            self.cells, other.cells, self.row_size * self.rows)
+
+
+def _span(before, after, cell_size):
+    # Returns the first and last cells which differ between two rows
+    length = len(before)
+    first = 0
+    while before[first] == after[first]:
+        first += 1
+    last = length - 1
+    while before[last] == after[last]:
+        last -= 1
+    return first // cell_size, last // cell_size
+
+
+def diff_frames(front, back, merge_rows=1):
+    """
+    Compares two frames of the same size and returns the rectangles of
+    ``back`` which differ from ``front``.
+
+    Rows are compared as a whole first so unchanged rows cost a single
+    comparison.  Each changed row contributes the span from its first to
+    its last changed cell and the spans of consecutive changed rows are
+    merged into one rectangle covering all of them.
+
+    :param FrameBuffer front:
+        The frame currently on the screen.
+
+    :param FrameBuffer back:
+        The frame which should be on the screen.
+
+    :keyword int merge_rows:
+        The number of unchanged rows which may separate two changed rows
+        and still have their spans merged.  Merging trades rewriting a
+        few unchanged cells for fewer calls.
+
+    :rtype: list
+    :returns:
+        Returns a list of :class:`Rect` ordered from top to bottom.
+    """
+    if front.size != back.size:
+        raise InputError(
+            "back", back, message="Expected frames of the same size")
+
+    ffi, _ = dist.load()
+    cell_size = ffi.sizeof("CHAR_INFO")
+    rects = []
+    current = None
+    for y in range(back.rows):
+        before, after = front.row(y), back.row(y)
+        if before == after:
+            continue
+
+        left, right = _span(before, after, cell_size)
+        if current is not None and y - current[3] - 1 <= merge_rows:
+            current = [
+                min(current[0], left), current[1], max(current[2], right), y]
+        else:
+            if current is not None:
+                rects.append(Rect(*current))
+            current = [left, y, right, y]
+
+    if current is not None:
+        rects.append(Rect(*current))
+    return rects
+
+
+class ConsoleRenderer(object):
+    """
+    Draws frames to a console screen buffer, writing only what changed.
+    Callers draw into :attr:`back` and call :meth:`flush`, which writes
+    each dirty rectangle of :attr:`back` with a single
+    ``WriteConsoleOutputW`` call and then copies :attr:`back` to
+    :attr:`front`, the frame the screen now shows.
+
+    >>> from pywincffi.kernel32 import ConsoleRenderer, GetStdHandle
+    >>> renderer = ConsoleRenderer(
+    ...     GetStdHandle(library.STD_OUTPUT_HANDLE), 80, 25)
+    >>> renderer.back.put(0, 0, u"CPU  42%", library.FOREGROUND_GREEN)
+    >>> renderer.flush()
+
+    :param pywincffi.wintypes.HANDLE hConsoleOutput:
+        A handle to the console screen buffer with ``GENERIC_WRITE``
+        access.
+
+    :param int columns:
+        The width of the frames.
+
+    :param int rows:
+        The height of the frames.
+
+    :keyword int merge_rows:
+        See :func:`diff_frames`.
+    """
+    def __init__(self, hConsoleOutput, columns, rows, merge_rows=1):
+        input_check("hConsoleOutput", hConsoleOutput, HANDLE)
+        input_check("merge_rows", merge_rows, integer_types)
+        self.hConsoleOutput = hConsoleOutput
+        self.merge_rows = merge_rows
+        self.back = FrameBuffer(columns, rows)
+        self.front = FrameBuffer(columns, rows)
+        self.frames = 0
+        self.writes = 0
+        self.cells = 0
+        self.invalidate()
+
+    def statistics(self):
+        """
+        Returns a :class:`RenderStatistics` tuple with the number of
+        frames flushed, ``WriteConsoleOutputW`` calls made and cells
+        written.
+        """
+        return RenderStatistics(self.frames, self.writes, self.cells)
+
+    def invalidate(self, rect=None):
+        """
+        Forces the cells in ``rect``, the whole screen by default, to be
+        written by the next :meth:`flush`.  Use this when something else
+        may have written to the screen buffer.
+        """
+        self.front.fill(
+            char=u"\x00", attributes=_INVALID_ATTRIBUTES, rect=rect)
+
+    def flush(self):
+        """
+        Writes the parts of :attr:`back` which differ from :attr:`front`.
+
+        :rtype: list
+        :returns:
+            Returns the list of :class:`Rect` which were written.
+        """
+        rects = diff_frames(self.front, self.back, self.merge_rows)
+        back = self.back
+        for rect in rects:
+            WriteConsoleOutputW(
+                self.hConsoleOutput, back.cells, back.size,
+                (rect.left, rect.top), tuple(rect))
+            self.writes += 1
+            self.cells += \
+                (rect.right - rect.left + 1) * (rect.bottom - rect.top + 1)
+
+        if rects:
+            self.front.copy_from(back)
+        self.frames += 1
+        return rects
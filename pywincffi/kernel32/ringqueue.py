@@ -0,0 +1,266 @@
+"""
+Ring Queue
+----------
+
+A bounded single producer, multiple consumer queue of byte strings in
+cffi allocated memory.  Threads which find the queue empty, or full,
+spin briefly and then sleep on the queue's own index words with
+``WaitOnAddress`` so no kernel event is needed per waiter and an
+uncontended put or get makes no system calls.
+"""
+
+from collections import namedtuple
+
+from six import binary_type, integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check
+from pywincffi.core.compat import monotonic
+from pywincffi.exceptions import InputError
+from pywincffi.kernel32.synchronization import (
+    WaitOnAddress, _check_wait_on_address)
+
+QueueStatistics = namedtuple(
+    "QueueStatistics", ("puts", "gets", "retries", "parks", "full"))
+
+# Offsets, in 64 bit words, of the header fields.  The fields written by
+# the producer and by the consumers are on separate cache lines.
+_HEAD = 0
+_TAIL = 8
+_SLEEPERS = 16
+_PRODUCER_WAITING = 24
+_HEADER_WORDS = 32
+_WORD = 8
+
+# Set in the tail by close() so consumers sleeping on the tail wake up
+_CLOSED = 1 << 62
+
+
+class SPMCQueue(object):
+    """
+    A ring of ``capacity`` slots, each holding up to ``slot_size`` bytes,
+    with one producing thread and any number of consuming threads.
+
+    The producer is the only writer of the tail so publishing an item is
+    a single interlocked store.  Consumers read the item at the head and
+    then claim it with an interlocked compare exchange, reading again if
+    another consumer claimed it first.  Consumers which find the queue
+    empty spin ``spin`` times and then sleep on the tail with
+    ``WaitOnAddress``.  The producer only calls ``WakeByAddressSingle``
+    when the count of sleeping consumers is non-zero.
+
+    ``WaitOnAddress`` only wakes threads of the calling process, so the
+    queue is shared between threads rather than processes.  It also
+    requires Windows 8 or later.
+
+    >>> from pywincffi.kernel32 import SPMCQueue
+    >>> queue = SPMCQueue(1024, 256)
+    >>> queue.put(b"frame")  # in the producer
+    >>> queue.get()          # in any consumer
+    b'frame'
+
+    :param int capacity:
+        The number of slots, a power of two.
+
+    :param int slot_size:
+        The largest item in bytes.
+
+    :keyword int spin:
+        How many times to check the queue again before sleeping.
+
+    :raises pywincffi.exceptions.WindowsAPIError:
+        Raised with ``ERROR_NOT_SUPPORTED`` before Windows 8.
+    """
+    def __init__(self, capacity, slot_size, spin=100):
+        input_check("capacity", capacity, integer_types)
+        input_check("slot_size", slot_size, integer_types)
+        input_check("spin", spin, integer_types)
+        if capacity < 1 or capacity & (capacity - 1):
+            raise InputError(
+                "capacity", capacity,
+                message="Expected `capacity` to be a power of two")
+        if slot_size < 1:
+            raise InputError(
+                "slot_size", slot_size, message="Expected `slot_size` >= 1")
+        _check_wait_on_address("SPMCQueue")
+
+        ffi, library = dist.load()
+        self._ffi = ffi
+        self._library = library
+        self.capacity = capacity
+        self.slot_size = slot_size
+        self.spin = spin
+
+        # Each slot is a length word followed by the data, padded to a
+        # whole number of words.
+        self._slot_words = 1 + (slot_size + _WORD - 1) // _WORD
+        self._words = ffi.new(
+            "LONGLONG[]", _HEADER_WORDS + capacity * self._slot_words)
+        self._bytes = ffi.cast("char *", self._words)
+        self._head = self._words + _HEAD
+        self._tail = self._words + _TAIL
+        self._sleepers = self._words + _SLEEPERS
+        self._producer_waiting = self._words + _PRODUCER_WAITING
+        self._compare = ffi.new("LONGLONG *")
+
+        self.puts = 0
+        self.gets = 0
+        self.retries = 0
+        self.parks = 0
+        self.full = 0
+
+    def __len__(self):
+        return (self._tail[0] & ~_CLOSED) - self._head[0]
+
+    @property
+    def closed(self):
+        """True once :meth:`close` has been called"""
+        return bool(self._tail[0] & _CLOSED)
+
+    def statistics(self):
+        """
+        Returns a :class:`QueueStatistics` tuple with the number of items
+        put and got, claims lost to another consumer, times a thread went
+        to sleep and puts which found the queue full.
+        """
+        return QueueStatistics(
+            self.puts, self.gets, self.retries, self.parks, self.full)
+
+    def _slot(self, index):
+        # Returns the word offset of the slot for `index`
+        return _HEADER_WORDS + (index & (self.capacity - 1)) * \
+            self._slot_words
+
+    def _sleep(self, address, value, deadline):
+        # Sleeps while the word at `address` holds `value`.  Returns False
+        # if `deadline` passed.
+        dwMilliseconds = self._library.INFINITE
+        if deadline is not None:
+            remaining = deadline - monotonic()
+            if remaining <= 0:
+                return False
+            dwMilliseconds = int(remaining * 1000) + 1
+
+        self._compare[0] = value
+        self.parks += 1
+        if WaitOnAddress(address, self._compare, _WORD, dwMilliseconds):
+            return True
+        return deadline is None or monotonic() < deadline
+
+    def put(self, data, timeout=None):
+        """
+        Adds ``data`` to the queue, waiting up to ``timeout`` seconds,
+        forever by default, for a free slot.  Must only be called from
+        the producing thread.
+
+        :rtype: bool
+        :returns:
+            Returns False if the queue stayed full until the timeout.
+        """
+        input_check("data", data, binary_type)
+        if len(data) > self.slot_size:
+            raise InputError(
+                "data", data,
+                message="Expected at most %d bytes" % self.slot_size)
+
+        tail = self._tail[0]
+        if tail & _CLOSED:
+            raise InputError("data", data, message="The queue is closed")
+
+        if tail - self._head[0] >= self.capacity:
+            self.full += 1
+            if not self._wait_for_space(tail, timeout):
+                return False
+
+        slot = self._slot(tail)
+        self._words[slot] = len(data)
+        self._ffi.memmove(self._bytes + (slot + 1) * _WORD, data, len(data))
+
+        library = self._library
+        library.interlocked_exchange64(self._tail, tail + 1)
+        if self._sleepers[0]:
+            library.wake_by_address_single(self._tail)
+        self.puts += 1
+        return True
+
+    def _wait_for_space(self, tail, timeout):
+        # Called by the producer when the queue is full
+        deadline = None if timeout is None else monotonic() + timeout
+        head = self._head
+        for _ in range(self.spin):
+            if tail - head[0] < self.capacity:
+                return True
+
+        library = self._library
+        while True:
+            library.interlocked_exchange64(self._producer_waiting, 1)
+            current = head[0]
+            if tail - current < self.capacity:
+                break
+            if not self._sleep(head, current, deadline):
+                library.interlocked_exchange64(self._producer_waiting, 0)
+                return False
+
+        library.interlocked_exchange64(self._producer_waiting, 0)
+        return True
+
+    def get(self, timeout=None):
+        """
+        Removes and returns the oldest item, waiting up to ``timeout``
+        seconds, forever by default, for one to be put.
+
+        :rtype: bytes
+        :returns:
+            Returns None if the timeout passed, or the queue was closed,
+            before an item was available.
+        """
+        deadline = None if timeout is None else monotonic() + timeout
+        ffi, library = self._ffi, self._library
+        words, head, tail = self._words, self._head, self._tail
+        spins = 0
+        while True:
+            index = head[0]
+            published = tail[0]
+            if index != published & ~_CLOSED:
+                slot = self._slot(index)
+                data = ffi.buffer(
+                    self._bytes + (slot + 1) * _WORD, words[slot])[:]
+                if library.interlocked_compare_exchange64(
+                        head, index + 1, index) == index:
+                    if self._producer_waiting[0]:
+                        library.wake_by_address_single(head)
+                    self.gets += 1
+                    return data
+                self.retries += 1
+                continue
+
+            if published & _CLOSED:
+                return None
+
+            if spins < self.spin:
+                spins += 1
+                continue
+
+            # Announce the sleep before checking the tail again so a put
+            # which lands in between either sees the sleeper and wakes it
+            # or changes the tail WaitOnAddress compares against.
+            library.interlocked_exchange_add64(self._sleepers, 1)
+            try:
+                if not self._sleep(tail, published, deadline):
+                    return None
+            finally:
+                library.interlocked_exchange_add64(self._sleepers, -1)
+            spins = 0
+
+    def close(self):
+        """
+        Marks the queue as closed and wakes every sleeping consumer.
+        Items already in the queue can still be got, after which
+        :meth:`get` returns None.  Must only be called from the producing
+        thread.
+        """
+        library = self._library
+        tail = self._tail[0]
+        if not tail & _CLOSED:
+            library.interlocked_exchange64(self._tail, tail | _CLOSED)
+            library.wake_by_address_all(self._tail)
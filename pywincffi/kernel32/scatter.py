@@ -0,0 +1,313 @@
+"""
+Scatter/Gather
+--------------
+
+A module containing Windows functions which read into, or write from,
+many page sized buffers with a single call.  :class:`SegmentArray` builds
+the ``FILE_SEGMENT_ELEMENT`` array those functions require while
+:func:`read_scatter` and :func:`write_gather` wrap a complete
+positioned operation.
+
+The handle passed to any function in this module must have been created by
+:func:`pywincffi.kernel32.CreateFile` with both ``FILE_FLAG_NO_BUFFERING``
+and ``FILE_FLAG_OVERLAPPED`` set in ``dwFlagsAndAttributes``.  Windows
+fails the call with ``ERROR_INVALID_PARAMETER`` otherwise.
+"""
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check, pending_check
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.file import DEFAULT_OVERLAPPED_POOL
+from pywincffi.kernel32.memory import page_size
+from pywincffi.kernel32.overlapped import GetOverlappedResult
+from pywincffi.wintypes import HANDLE, OVERLAPPED, wintype_to_cdata
+
+# The smallest sector size of any volume.  Offsets and lengths are checked
+# against this when the caller does not provide the volume's sector size.
+MINIMUM_SECTOR_SIZE = 512
+
+
+def check_alignment(name, address, size, alignment):
+    """
+    Raises :class:`InputError` unless both ``address`` and ``size`` are
+    non-zero multiples of ``alignment``.
+
+    :param str name:
+        The name of the buffer being checked, used in the error message.
+    """
+    if address % alignment:
+        raise InputError(
+            name, address,
+            message="Expected %s to start on a %d byte boundary, address "
+                    "is 0x%x" % (name, alignment, address))
+
+    if size <= 0 or size % alignment:
+        raise InputError(
+            name, size,
+            message="Expected the size of %s to be a multiple of %d, size "
+                    "is %d" % (name, alignment, size))
+
+
+class SegmentArray(object):
+    """
+    Builds the ``FILE_SEGMENT_ELEMENT`` array, one element per page plus
+    a terminating ``NULL`` element, describing ``buffers``.  The array is
+    built and validated once so it can be reused for many calls to
+    :func:`ReadFileScatter` or :func:`WriteFileGather`.
+
+    >>> import mmap
+    >>> from pywincffi.kernel32 import SegmentArray, read_scatter
+    >>> pages = [mmap.mmap(-1, 4096) for _ in range(8)]
+    >>> segments = SegmentArray(pages)
+    >>> read_scatter(hFile, segments, 0)
+
+    The buffers are referenced by the array for as long as it exists so
+    they must not be resized or released before it is.
+
+    :param list buffers:
+        A list of objects supporting the buffer protocol, such as
+        :class:`mmap.mmap` or buffers from an
+        :class:`pywincffi.kernel32.AlignedBufferPool` aligned to the page
+        size.  Each buffer must start on a page boundary and be a multiple
+        of the page size.
+
+    :keyword bool writable:
+        If True, the default, the buffers must be writable so they can
+        receive data from :func:`ReadFileScatter`.
+
+    :raises InputError:
+        Raised if a buffer is not page aligned or, when ``writable`` is
+        True, is read-only.
+    """
+    def __init__(self, buffers, writable=True):
+        input_check("buffers", buffers, (list, tuple))
+
+        if not buffers:
+            raise InputError(
+                "buffers", buffers,
+                message="Expected at least one buffer in `buffers`")
+
+        ffi, _ = dist.load()
+        self.page_size = page_size()
+        self.buffers = buffers
+        self._cdata = []
+        addresses = []
+
+        for i, buffer_ in enumerate(buffers):
+            try:
+                data = ffi.from_buffer(buffer_, require_writable=writable)
+            except BufferError:
+                raise InputError(
+                    "buffers[%d]" % i, buffer_,
+                    message="Expected buffers[%d] to be writable" % i)
+
+            address = int(ffi.cast("uintptr_t", data))
+            check_alignment(
+                "buffers[%d]" % i, address, len(data), self.page_size)
+            self._cdata.append(data)
+            addresses.extend(
+                range(address, address + len(data), self.page_size))
+
+        self.nbytes = len(addresses) * self.page_size
+        self.aSegmentArray = ffi.new(
+            "FILE_SEGMENT_ELEMENT[]", len(addresses) + 1)
+        for i, address in enumerate(addresses):
+            self.aSegmentArray[i].Alignment = address
+
+    def __len__(self):
+        """The number of pages described by the array"""
+        return len(self.aSegmentArray) - 1
+
+
+def _scatter_gather(  # pylint: disable=too-many-arguments
+        function, hFile, aSegmentArray, nNumberOfBytes, lpOverlapped,
+        sector_size):
+    input_check("hFile", hFile, HANDLE)
+    input_check("aSegmentArray", aSegmentArray, SegmentArray)
+    input_check("nNumberOfBytes", nNumberOfBytes, integer_types)
+    input_check("lpOverlapped", lpOverlapped, OVERLAPPED)
+    if sector_size is None:
+        sector_size = MINIMUM_SECTOR_SIZE
+    input_check("sector_size", sector_size, integer_types)
+
+    if nNumberOfBytes > aSegmentArray.nbytes:
+        raise InputError(
+            "nNumberOfBytes", nNumberOfBytes,
+            message="Expected no more than %d bytes for the segments "
+                    "provided" % aSegmentArray.nbytes)
+
+    if nNumberOfBytes % sector_size:
+        raise InputError(
+            "nNumberOfBytes", nNumberOfBytes,
+            message="Expected a multiple of the sector size, %d"
+                    % sector_size)
+
+    cdata = wintype_to_cdata(lpOverlapped)
+    offset = cdata.OffsetHigh << 32 | cdata.Offset
+    if offset % sector_size:
+        raise InputError(
+            "lpOverlapped", offset,
+            message="Expected the offset to be a multiple of the sector "
+                    "size, %d" % sector_size)
+
+    ffi, library = dist.load()
+    code = getattr(library, function)(
+        wintype_to_cdata(hFile),
+        aSegmentArray.aSegmentArray,
+        ffi.cast("DWORD", nNumberOfBytes),
+        ffi.NULL,  # _Reserved_
+        cdata
+    )
+
+    pending_check(function, code)
+
+
+def ReadFileScatter(
+        hFile, aSegmentArray, nNumberOfBytesToRead, lpOverlapped,
+        sector_size=None):
+    """
+    Reads data from ``hFile`` and stores it in the page sized buffers
+    described by ``aSegmentArray``.  The read is always asynchronous,
+    use :func:`pywincffi.kernel32.GetOverlappedResult` to wait for it.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa365469
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to read from.
+
+    :param SegmentArray aSegmentArray:
+        The buffers to read into.
+
+    :param int nNumberOfBytesToRead:
+        The number of bytes to read, which must be a multiple of the
+        sector size of the volume ``hFile`` is on.
+
+    :param pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        The structure containing the offset to read from, which must be a
+        multiple of the sector size.
+
+    :keyword int sector_size:
+        The sector size, see :func:`pywincffi.kernel32.sector_size`.
+        Defaults to :data:`MINIMUM_SECTOR_SIZE`, which catches most
+        mistakes without looking up the volume.
+
+    :raises InputError:
+        Raised if the number of bytes or the offset is not a multiple of
+        ``sector_size``.
+
+    :raises WindowsAPIError:
+        Raised if the read fails, a pending read is not treated as a
+        failure.
+    """
+    _scatter_gather(
+        "ReadFileScatter", hFile, aSegmentArray, nNumberOfBytesToRead,
+        lpOverlapped, sector_size)
+
+
+def WriteFileGather(
+        hFile, aSegmentArray, nNumberOfBytesToWrite, lpOverlapped,
+        sector_size=None):
+    """
+    Writes data to ``hFile`` from the page sized buffers described by
+    ``aSegmentArray``.  The write is always asynchronous,
+    use :func:`pywincffi.kernel32.GetOverlappedResult` to wait for it.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa365749
+
+    See :func:`ReadFileScatter` for documentation on the arguments.
+    """
+    _scatter_gather(
+        "WriteFileGather", hFile, aSegmentArray, nNumberOfBytesToWrite,
+        lpOverlapped, sector_size)
+
+
+def _positioned(  # pylint: disable=too-many-arguments
+        function, hFile, segments, offset, nNumberOfBytes, pool,
+        sector_size):
+    if pool is None:
+        pool = DEFAULT_OVERLAPPED_POOL
+
+    if not isinstance(segments, SegmentArray):
+        segments = SegmentArray(
+            segments, writable=function is ReadFileScatter)
+
+    if nNumberOfBytes is None:
+        nNumberOfBytes = segments.nbytes
+
+    _, library = dist.load()
+    with pool.overlapped(offset) as lpOverlapped:
+        try:
+            function(
+                hFile, segments, nNumberOfBytes, lpOverlapped, sector_size)
+            return GetOverlappedResult(hFile, lpOverlapped, True)
+        except WindowsAPIError as error:
+            # As with pread(), reading at or past the end of the file
+            # reads nothing rather than failing.
+            if function is not ReadFileScatter or \
+                    error.errno != library.ERROR_HANDLE_EOF:
+                raise
+            library.SetLastError(0)
+            return 0
+
+
+def read_scatter(  # pylint: disable=too-many-arguments
+        hFile, segments, offset, nNumberOfBytes=None, pool=None,
+        sector_size=None):
+    """
+    Reads from ``hFile``, starting at ``offset``, into ``segments`` with
+    a single call to :func:`ReadFileScatter` and waits for the result.
+
+    :param pywincffi.wintypes.HANDLE hFile:
+        The handle to read from.
+
+    :type segments: SegmentArray or list
+    :param segments:
+        A :class:`SegmentArray` or a list of buffers to build one from.
+        Reuse a :class:`SegmentArray` when reading into the same buffers
+        repeatedly.
+
+    :param int offset:
+        The 64-bit offset to read from.  Must be a multiple of the sector
+        size.
+
+    :keyword int nNumberOfBytes:
+        The number of bytes to read.  Defaults to the size of ``segments``.
+
+    :keyword pywincffi.kernel32.overlapped.OverlappedPool pool:
+        The pool to acquire the ``OVERLAPPED`` structure from.
+
+    :keyword int sector_size:
+        The sector size ``offset`` and ``nNumberOfBytes`` are checked
+        against, see :func:`ReadFileScatter`.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes read which will be zero if ``offset``
+        is at or past the end of the file.
+    """
+    return _positioned(
+        ReadFileScatter, hFile, segments, offset, nNumberOfBytes, pool,
+        sector_size)
+
+
+def write_gather(  # pylint: disable=too-many-arguments
+        hFile, segments, offset, nNumberOfBytes=None, pool=None,
+        sector_size=None):
+    """
+    Writes ``segments`` to ``hFile``, starting at ``offset``, with a single
+    call to :func:`WriteFileGather` and waits for the result.  See
+    :func:`read_scatter` for documentation on the arguments.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes written.
+    """
+    return _positioned(
+        WriteFileGather, hFile, segments, offset, nNumberOfBytes, pool,
+        sector_size)
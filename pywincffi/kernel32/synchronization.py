@@ -3,20 +3,36 @@ Synchronization
 ---------------
 
 This module contains general functions for synchronizing objects and
-events.  The functions provided in this module are parts of the ``kernel32``
-library.
+events along with the :class:`Semaphore` and :class:`Mutex` classes for
+kernel objects and the :class:`RWLock` and :class:`Condition` classes for
+slim reader/writer locks and condition variables.  The functions provided
+in this module are parts of the ``kernel32`` library, apart from
+``WaitOnAddress`` and ``WakeByAddress*`` which require Windows 8 or later
+and are looked up at runtime.
 
 .. seealso::
 
     :mod:`pywincffi.user32.synchronization`
 """
 
-from six import integer_types
+from collections import namedtuple
+
+from six import integer_types, text_type
 
 from pywincffi.core import dist
-from pywincffi.core.checks import input_check, error_check
-from pywincffi.exceptions import WindowsAPIError
-from pywincffi.wintypes import HANDLE, wintype_to_cdata
+from pywincffi.core.checks import NON_ZERO, NoneType, input_check, error_check
+from pywincffi.core.compat import monotonic
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.kernel32.tracking import tracked
+from pywincffi.wintypes import HANDLE, SECURITY_ATTRIBUTES, wintype_to_cdata
+
+WaitStatistics = namedtuple(
+    "WaitStatistics",
+    ("acquisitions", "contentions", "timeouts", "abandoned"))
+
+LockStatistics = namedtuple(
+    "LockStatistics", ("shared", "exclusive", "contentions"))
 
 
 def WaitForSingleObject(hHandle, dwMilliseconds):
@@ -50,3 +66,941 @@ def WaitForSingleObject(hHandle, dwMilliseconds):
     error_check("WaitForSingleObject")
 
     return result
+
+
+def WaitForMultipleObjects(lpHandles, bWaitAll, dwMilliseconds):
+    """
+    Waits for one or all of the specified objects to be in a signaled
+    state or for ``dwMilliseconds`` to elapse.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms687025
+
+    :param list lpHandles:
+        A list of :class:`pywincffi.wintypes.HANDLE` objects to wait on, no
+        more than ``MAXIMUM_WAIT_OBJECTS``.
+
+    :param bool bWaitAll:
+        If True wait for every object to be signaled, otherwise wait for
+        any one of them.
+
+    :param int dwMilliseconds:
+        The time-out interval.
+
+    :returns:
+        Returns ``WAIT_OBJECT_0`` or ``WAIT_ABANDONED_0`` plus the index
+        of the object which satisfied the wait, or ``WAIT_TIMEOUT``.
+    """
+    input_check("lpHandles", lpHandles, (list, tuple))
+    input_check("bWaitAll", bWaitAll, allowed_values=(True, False))
+    input_check("dwMilliseconds", dwMilliseconds, integer_types)
+    for hHandle in lpHandles:
+        input_check("hHandle", hHandle, HANDLE)
+
+    ffi, library = dist.load()
+    if not lpHandles:
+        raise InputError(
+            "lpHandles", lpHandles, message="Expected at least one handle")
+
+    handles = ffi.new(
+        "HANDLE[]", [wintype_to_cdata(hHandle) for hHandle in lpHandles])
+    result = library.WaitForMultipleObjects(
+        len(lpHandles), handles, ffi.cast("BOOL", bWaitAll),
+        ffi.cast("DWORD", dwMilliseconds))
+
+    if result == library.WAIT_FAILED:
+        raise WindowsAPIError(
+            "WaitForMultipleObjects", "Wait Failed", ffi.getwinerror()[-1],
+            return_code=result, expected_return_code="not %s" % result)
+
+    error_check("WaitForMultipleObjects")
+
+    return result
+
+
+def _create_handle(function, handle):
+    # Shared by CreateSemaphoreEx() and CreateMutexEx().  Opening an
+    # existing named object succeeds but sets ERROR_ALREADY_EXISTS.
+    ffi, library = dist.load()
+    errno, message = ffi.getwinerror()
+    if handle == ffi.NULL:
+        raise WindowsAPIError(
+            function, message, errno,
+            return_code=handle, expected_return_code="not NULL")
+
+    if errno == library.ERROR_ALREADY_EXISTS:
+        library.SetLastError(0)
+
+    return tracked(HANDLE(handle), function)
+
+
+def CreateSemaphoreEx(
+        lpSemaphoreAttributes=None, lInitialCount=0, lMaximumCount=1,
+        lpName=None, dwDesiredAccess=None):
+    """
+    Creates or opens a named or unnamed semaphore.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682438
+
+    :keyword pywincffi.wintypes.SECURITY_ATTRIBUTES lpSemaphoreAttributes:
+        If not provided the handle cannot be inherited by a subprocess.
+
+    :keyword int lInitialCount:
+        The initial count, between 0 and ``lMaximumCount``.
+
+    :keyword int lMaximumCount:
+        The maximum count, greater than zero.
+
+    :keyword str lpName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The optional name of the semaphore.  If a semaphore by this name
+        already exists it is opened and the counts are ignored.
+
+    :keyword int dwDesiredAccess:
+        Defaults to ``SEMAPHORE_ALL_ACCESS``.
+
+    :rtype: :class:`pywincffi.wintypes.HANDLE`
+    """
+    ffi, library = dist.load()
+
+    if dwDesiredAccess is None:
+        dwDesiredAccess = library.SEMAPHORE_ALL_ACCESS
+
+    input_check(
+        "lpSemaphoreAttributes", lpSemaphoreAttributes,
+        allowed_types=(NoneType, SECURITY_ATTRIBUTES))
+    input_check("lInitialCount", lInitialCount, integer_types)
+    input_check("lMaximumCount", lMaximumCount, integer_types)
+    input_check("lpName", lpName, (NoneType, text_type))
+    input_check("dwDesiredAccess", dwDesiredAccess, integer_types)
+
+    handle = library.CreateSemaphoreEx(
+        wintype_to_cdata(lpSemaphoreAttributes), lInitialCount,
+        lMaximumCount, ffi.NULL if lpName is None else lpName, 0,
+        ffi.cast("DWORD", dwDesiredAccess))
+    return _create_handle("CreateSemaphoreEx", handle)
+
+
+def ReleaseSemaphore(hSemaphore, lReleaseCount=1):
+    """
+    Increases the count of a semaphore.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms685071
+
+    :param pywincffi.wintypes.HANDLE hSemaphore:
+        The semaphore to release.
+
+    :keyword int lReleaseCount:
+        The amount to increase the count by.  Raising the count above
+        the maximum fails with ``ERROR_TOO_MANY_POSTS``.
+
+    :rtype: int
+    :returns:
+        Returns the count before it was increased.
+    """
+    input_check("hSemaphore", hSemaphore, HANDLE)
+    input_check("lReleaseCount", lReleaseCount, integer_types)
+
+    ffi, library = dist.load()
+    lpPreviousCount = ffi.new("LPLONG")
+    code = library.ReleaseSemaphore(
+        wintype_to_cdata(hSemaphore), lReleaseCount, lpPreviousCount)
+    error_check("ReleaseSemaphore", code=code, expected=NON_ZERO)
+    return lpPreviousCount[0]
+
+
+def CreateMutexEx(
+        lpMutexAttributes=None, lpName=None, dwFlags=0,
+        dwDesiredAccess=None):
+    """
+    Creates or opens a named or unnamed mutex.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682418
+
+    :keyword pywincffi.wintypes.SECURITY_ATTRIBUTES lpMutexAttributes:
+        If not provided the handle cannot be inherited by a subprocess.
+
+    :keyword str lpName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The optional name of the mutex.
+
+    :keyword int dwFlags:
+        ``CREATE_MUTEX_INITIAL_OWNER`` to own the mutex once it is
+        created.  Has no effect when an existing mutex is opened.
+
+    :keyword int dwDesiredAccess:
+        Defaults to ``MUTEX_ALL_ACCESS``.
+
+    :rtype: :class:`pywincffi.wintypes.HANDLE`
+    """
+    ffi, library = dist.load()
+
+    if dwDesiredAccess is None:
+        dwDesiredAccess = library.MUTEX_ALL_ACCESS
+
+    input_check(
+        "lpMutexAttributes", lpMutexAttributes,
+        allowed_types=(NoneType, SECURITY_ATTRIBUTES))
+    input_check("lpName", lpName, (NoneType, text_type))
+    input_check("dwFlags", dwFlags, integer_types)
+    input_check("dwDesiredAccess", dwDesiredAccess, integer_types)
+
+    handle = library.CreateMutexEx(
+        wintype_to_cdata(lpMutexAttributes),
+        ffi.NULL if lpName is None else lpName,
+        ffi.cast("DWORD", dwFlags), ffi.cast("DWORD", dwDesiredAccess))
+    return _create_handle("CreateMutexEx", handle)
+
+
+def ReleaseMutex(hMutex):
+    """
+    Releases ownership of a mutex.  Fails with ``ERROR_NOT_OWNER`` if the
+    calling thread does not own the mutex.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms685066
+
+    :param pywincffi.wintypes.HANDLE hMutex:
+        The mutex to release.
+    """
+    input_check("hMutex", hMutex, HANDLE)
+    _, library = dist.load()
+    code = library.ReleaseMutex(wintype_to_cdata(hMutex))
+    error_check("ReleaseMutex", code=code, expected=NON_ZERO)
+
+
+def _milliseconds(timeout):
+    # Converts a timeout in seconds, or None, to a dwMilliseconds value
+    _, library = dist.load()
+    if timeout is None:
+        return library.INFINITE
+    if timeout < 0:
+        raise InputError("timeout", timeout, message="Expected `timeout` >= 0")
+    return min(int(timeout * 1000), library.INFINITE - 1)
+
+
+class _WaitableObject(object):
+    """
+    The base of :class:`Semaphore` and :class:`Mutex`.  Acquiring first
+    polls the object without waiting, so the uncontended case costs one
+    call and only acquisitions which had to wait are counted as
+    contentions.
+    """
+    def __init__(self, handle):
+        self.handle = handle
+        self.closed = False
+        self.acquisitions = 0
+        self.contentions = 0
+        self.timeouts = 0
+        self.abandoned = 0
+
+    def statistics(self):
+        """Returns a :class:`WaitStatistics` tuple of the counters"""
+        return WaitStatistics(
+            self.acquisitions, self.contentions, self.timeouts,
+            self.abandoned)
+
+    def acquire(self, timeout=None):
+        """
+        Waits up to ``timeout`` seconds, forever by default, to acquire
+        the object.
+
+        :rtype: bool
+        :returns:
+            Returns True if the object was acquired.
+        """
+        _, library = dist.load()
+        dwMilliseconds = _milliseconds(timeout)
+        result = WaitForSingleObject(self.handle, 0)
+        if result == library.WAIT_TIMEOUT and dwMilliseconds:
+            self.contentions += 1
+            result = WaitForSingleObject(self.handle, dwMilliseconds)
+        return self._acquired(result)
+
+    def _acquired(self, result):
+        # Updates the counters from the result of a wait on this object
+        _, library = dist.load()
+        if result == library.WAIT_TIMEOUT:
+            self.timeouts += 1
+            return False
+
+        self.acquisitions += 1
+        if result == library.WAIT_ABANDONED:
+            self.abandoned += 1
+            self._recover()
+        return True
+
+    def _recover(self):
+        pass
+
+    def release(self):
+        """Releases the object"""
+        raise NotImplementedError
+
+    def close(self):
+        """
+        Closes the handle.  Calling this more than once has no effect.
+        """
+        if not self.closed:
+            self.closed = True
+            CloseHandle(self.handle)
+
+    def __enter__(self):
+        self.acquire()
+        return self
+
+    def __exit__(self, *_):
+        self.release()
+
+
+class Semaphore(_WaitableObject):
+    """
+    A counting semaphore which can be shared with other processes by
+    name.  Use it as a context manager to acquire and release one count.
+
+    >>> from pywincffi.kernel32 import Semaphore
+    >>> workers = Semaphore(4, 4, name=u"Local\\encoder-slots")
+    >>> with workers:
+    ...     encode()
+
+    :keyword int initial:
+        The initial count.
+
+    :keyword int maximum:
+        The maximum count.
+
+    :keyword str name:
+        The optional name of the semaphore.  If it already exists it is
+        opened and ``initial`` and ``maximum`` are ignored.
+    """
+    def __init__(self, initial=0, maximum=1, name=None):
+        if not 0 <= initial <= maximum or maximum < 1:
+            raise InputError(
+                "initial", initial,
+                message="Expected 0 <= `initial` <= `maximum` and "
+                        "`maximum` >= 1")
+        super(Semaphore, self).__init__(CreateSemaphoreEx(
+            lInitialCount=initial, lMaximumCount=maximum, lpName=name))
+        self.maximum = maximum
+
+    def release(self, count=1):  # pylint: disable=arguments-differ
+        """
+        Increases the count by ``count``.
+
+        :rtype: int
+        :returns:
+            Returns the count before it was increased.
+        """
+        return ReleaseSemaphore(self.handle, count)
+
+
+class Mutex(_WaitableObject):
+    """
+    A mutex which can be shared with other processes by name.  Use it as
+    a context manager to acquire and release it.
+
+    A mutex is abandoned when the thread which owns it exits without
+    releasing it, usually because its process crashed.  The next
+    :meth:`acquire` still succeeds but the data the mutex protects may
+    have been left half updated, so ``on_abandoned`` is called, while the
+    mutex is held, to repair it.  If ``on_abandoned`` raises the mutex is
+    released before the exception propagates.
+
+    >>> from pywincffi.kernel32 import Mutex
+    >>> lock = Mutex(name=u"Local\\job-table", on_abandoned=rebuild_index)
+    >>> with lock:
+    ...     update_job_table()
+
+    :keyword str name:
+        The optional name of the mutex.
+
+    :keyword bool initial_owner:
+        If True the calling thread owns a newly created mutex.
+
+    :keyword callable on_abandoned:
+        Called with no arguments when an acquisition finds the mutex
+        abandoned.
+    """
+    def __init__(self, name=None, initial_owner=False, on_abandoned=None):
+        if on_abandoned is not None and not callable(on_abandoned):
+            raise InputError(
+                "on_abandoned", on_abandoned,
+                message="Expected `on_abandoned` to be callable")
+
+        _, library = dist.load()
+        super(Mutex, self).__init__(CreateMutexEx(
+            lpName=name,
+            dwFlags=library.CREATE_MUTEX_INITIAL_OWNER if initial_owner
+            else 0))
+        self.on_abandoned = on_abandoned
+
+    def _recover(self):
+        if self.on_abandoned is None:
+            return
+        try:
+            self.on_abandoned()
+        except Exception:
+            self.release()
+            raise
+
+    def release(self):
+        """Releases ownership of the mutex"""
+        ReleaseMutex(self.handle)
+
+
+def wait_any(objects, timeout=None):
+    """
+    Waits up to ``timeout`` seconds, forever by default, to acquire any
+    one of ``objects`` and returns it, or None if the wait timed out.
+    Counters and abandoned mutex recovery are handled the same way as
+    :meth:`Semaphore.acquire` and :meth:`Mutex.acquire`.
+
+    :param list objects:
+        A list of :class:`Semaphore` and :class:`Mutex` objects.  When
+        more than one can be acquired the first in the list is.
+    """
+    _, library = dist.load()
+    dwMilliseconds = _milliseconds(timeout)
+    handles = [obj.handle for obj in objects]
+    result = WaitForMultipleObjects(handles, False, 0)
+    if result == library.WAIT_TIMEOUT and dwMilliseconds:
+        for obj in objects:
+            obj.contentions += 1
+        result = WaitForMultipleObjects(handles, False, dwMilliseconds)
+
+    if result == library.WAIT_TIMEOUT:
+        for obj in objects:
+            obj.timeouts += 1
+        return None
+
+    if result >= library.WAIT_ABANDONED_0:
+        obj = objects[result - library.WAIT_ABANDONED_0]
+        result = library.WAIT_ABANDONED
+    else:
+        obj = objects[result - library.WAIT_OBJECT_0]
+        result = library.WAIT_OBJECT_0
+
+    obj._acquired(result)  # pylint: disable=protected-access
+    return obj
+
+
+def _check_pointer(name, value, cdecl):
+    # Raises InputError unless `value` is a pointer of type `cdecl`
+    ffi, _ = dist.load()
+    if not isinstance(value, ffi.CData) or \
+            ffi.typeof(value) is not ffi.typeof(cdecl):
+        raise InputError(
+            name, value, message="Expected a %s pointer" % cdecl)
+
+
+def InitializeSRWLock(SRWLock):
+    """
+    Initializes a slim reader/writer lock.  Memory from ``ffi.new`` is
+    zeroed, which is already a valid unlocked ``SRWLOCK``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms683483
+
+    :param SRWLock:
+        A ``PSRWLOCK`` from ``ffi.new("PSRWLOCK")``.
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    library.InitializeSRWLock(SRWLock)
+
+
+def AcquireSRWLockExclusive(SRWLock):
+    """
+    Acquires a slim reader/writer lock in exclusive mode, blocking until
+    it is available.  SRW locks are not recursive.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms681930
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    library.AcquireSRWLockExclusive(SRWLock)
+
+
+def AcquireSRWLockShared(SRWLock):
+    """
+    Acquires a slim reader/writer lock in shared mode, blocking until it
+    is available.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms681934
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    library.AcquireSRWLockShared(SRWLock)
+
+
+def TryAcquireSRWLockExclusive(SRWLock):
+    """
+    Attempts to acquire a slim reader/writer lock in exclusive mode
+    without blocking.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/dd405523
+
+    :rtype: bool
+    :returns:
+        Returns True if the lock was acquired.
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    return bool(library.TryAcquireSRWLockExclusive(SRWLock))
+
+
+def TryAcquireSRWLockShared(SRWLock):
+    """
+    Attempts to acquire a slim reader/writer lock in shared mode without
+    blocking.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/dd405524
+
+    :rtype: bool
+    :returns:
+        Returns True if the lock was acquired.
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    return bool(library.TryAcquireSRWLockShared(SRWLock))
+
+
+def ReleaseSRWLockExclusive(SRWLock):
+    """
+    Releases a slim reader/writer lock acquired in exclusive mode.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms685076
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    library.ReleaseSRWLockExclusive(SRWLock)
+
+
+def ReleaseSRWLockShared(SRWLock):
+    """
+    Releases a slim reader/writer lock acquired in shared mode.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms685080
+    """
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    _, library = dist.load()
+    library.ReleaseSRWLockShared(SRWLock)
+
+
+def InitializeConditionVariable(ConditionVariable):
+    """
+    Initializes a condition variable.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms683469
+
+    :param ConditionVariable:
+        A ``PCONDITION_VARIABLE`` from ``ffi.new("PCONDITION_VARIABLE")``.
+    """
+    _check_pointer(
+        "ConditionVariable", ConditionVariable, "PCONDITION_VARIABLE")
+    _, library = dist.load()
+    library.InitializeConditionVariable(ConditionVariable)
+
+
+def SleepConditionVariableSRW(
+        ConditionVariable, SRWLock, dwMilliseconds, Flags=0):
+    """
+    Releases ``SRWLock`` and sleeps on ``ConditionVariable`` until it is
+    woken or ``dwMilliseconds`` elapse.  The lock is held again when this
+    function returns, whether or not the wait timed out.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms686304
+
+    :param ConditionVariable:
+        The ``PCONDITION_VARIABLE`` to sleep on.
+
+    :param SRWLock:
+        The ``PSRWLOCK`` held by the caller.
+
+    :param int dwMilliseconds:
+        The time-out interval.
+
+    :keyword int Flags:
+        ``CONDITION_VARIABLE_LOCKMODE_SHARED`` if the lock is held in
+        shared mode, 0 if it is held in exclusive mode.
+
+    :rtype: bool
+    :returns:
+        Returns False if the wait timed out.
+    """
+    _check_pointer(
+        "ConditionVariable", ConditionVariable, "PCONDITION_VARIABLE")
+    _check_pointer("SRWLock", SRWLock, "PSRWLOCK")
+    input_check("dwMilliseconds", dwMilliseconds, integer_types)
+    input_check("Flags", Flags, integer_types)
+
+    ffi, library = dist.load()
+    code = library.SleepConditionVariableSRW(
+        ConditionVariable, SRWLock, ffi.cast("DWORD", dwMilliseconds),
+        ffi.cast("ULONG", Flags))
+    return _woken("SleepConditionVariableSRW", code)
+
+
+def WakeConditionVariable(ConditionVariable):
+    """
+    Wakes one thread sleeping on a condition variable.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms687080
+    """
+    _check_pointer(
+        "ConditionVariable", ConditionVariable, "PCONDITION_VARIABLE")
+    _, library = dist.load()
+    library.WakeConditionVariable(ConditionVariable)
+
+
+def WakeAllConditionVariable(ConditionVariable):
+    """
+    Wakes every thread sleeping on a condition variable.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms687076
+    """
+    _check_pointer(
+        "ConditionVariable", ConditionVariable, "PCONDITION_VARIABLE")
+    _, library = dist.load()
+    library.WakeAllConditionVariable(ConditionVariable)
+
+
+def _check_address(name, value):
+    # Raises InputError unless `value` is a cdata pointer or array
+    ffi, _ = dist.load()
+    if not isinstance(value, ffi.CData) or \
+            ffi.typeof(value).kind not in ("pointer", "array"):
+        raise InputError(name, value, message="Expected a cdata pointer")
+
+
+def _check_wait_on_address(function):
+    # Raises WindowsAPIError if WaitOnAddress and WakeByAddress* are not
+    # available, which is the case before Windows 8.
+    _, library = dist.load()
+    if not library.wait_on_address_available():
+        raise WindowsAPIError(
+            function, "%s requires Windows 8 or later" % function,
+            library.ERROR_NOT_SUPPORTED)
+
+
+def WaitOnAddress(Address, CompareAddress, AddressSize, dwMilliseconds):
+    """
+    Sleeps while the value at ``Address`` equals the value at
+    ``CompareAddress``, until woken by :func:`WakeByAddressSingle` or
+    :func:`WakeByAddressAll` or ``dwMilliseconds`` elapse.  No kernel
+    object is allocated.  The comparison is made atomically with going to
+    sleep, so a wake which follows a change to the value is never missed.
+    Only threads of the same process can wake each other.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh706898
+
+    :param Address:
+        A cdata pointer to the value to wait on.
+
+    :param CompareAddress:
+        A cdata pointer to the value ``Address`` is expected to hold.
+
+    :param int AddressSize:
+        The size of the value in bytes; 1, 2, 4 or 8.
+
+    :param int dwMilliseconds:
+        The time-out interval.
+
+    :raises pywincffi.exceptions.WindowsAPIError:
+        Raised with ``ERROR_NOT_SUPPORTED`` before Windows 8.
+
+    :rtype: bool
+    :returns:
+        Returns False if the wait timed out.  Returning True does not
+        mean the value changed, callers should check it again.
+    """
+    _check_address("Address", Address)
+    _check_address("CompareAddress", CompareAddress)
+    input_check("AddressSize", AddressSize, allowed_values=(1, 2, 4, 8))
+    input_check("dwMilliseconds", dwMilliseconds, integer_types)
+    _check_wait_on_address("WaitOnAddress")
+
+    ffi, library = dist.load()
+    code = library.wait_on_address(
+        Address, CompareAddress, AddressSize,
+        ffi.cast("DWORD", dwMilliseconds))
+    return _woken("WaitOnAddress", code)
+
+
+def _woken(function, code):
+    # Checks the result of WaitOnAddress or SleepConditionVariableSRW,
+    # which fail with ERROR_TIMEOUT when the wait times out.
+    ffi, library = dist.load()
+    if code:
+        return True
+
+    errno, message = ffi.getwinerror()
+    if errno != library.ERROR_TIMEOUT:
+        raise WindowsAPIError(
+            function, message, errno,
+            return_code=code, expected_return_code=NON_ZERO)
+
+    library.SetLastError(0)
+    return False
+
+
+def WakeByAddressSingle(Address):
+    """
+    Wakes one thread waiting on ``Address`` with :func:`WaitOnAddress`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh706900
+
+    :raises pywincffi.exceptions.WindowsAPIError:
+        Raised with ``ERROR_NOT_SUPPORTED`` before Windows 8.
+    """
+    _check_address("Address", Address)
+    _check_wait_on_address("WakeByAddressSingle")
+    _, library = dist.load()
+    library.wake_by_address_single(Address)
+
+
+def WakeByAddressAll(Address):
+    """
+    Wakes every thread waiting on ``Address`` with :func:`WaitOnAddress`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh706899
+
+    :raises pywincffi.exceptions.WindowsAPIError:
+        Raised with ``ERROR_NOT_SUPPORTED`` before Windows 8.
+    """
+    _check_address("Address", Address)
+    _check_wait_on_address("WakeByAddressAll")
+    _, library = dist.load()
+    library.wake_by_address_all(Address)
+
+
+class _Guard(object):  # pylint: disable=too-few-public-methods
+    """
+    A context manager which calls ``acquire`` on entry and ``release`` on
+    exit.  Cheaper than one built with :func:`contextlib.contextmanager`.
+    """
+    def __init__(self, acquire, release):
+        self.acquire = acquire
+        self.release = release
+
+    def __enter__(self):
+        self.acquire()
+
+    def __exit__(self, *_):
+        self.release()
+
+
+class RWLock(object):
+    """
+    A slim reader/writer lock for threads in this process.  Unlike a
+    kernel object acquiring and releasing an uncontended SRW lock never
+    enters the kernel.  The ``SRWLOCK`` is allocated once, when the lock
+    is created, and the methods call the library directly rather than
+    through the validating wrappers.
+
+    cffi releases the GIL around every call so a thread blocked in
+    ``AcquireSRWLock*`` lets the thread which holds the lock run.  Each
+    acquisition first tries the non-blocking ``TryAcquireSRWLock*`` so
+    acquisitions which had to wait can be counted.
+
+    SRW locks are not recursive and must be released by the thread which
+    acquired them in exclusive mode.
+
+    >>> from pywincffi.kernel32 import RWLock
+    >>> lock = RWLock()
+    >>> with lock.shared:
+    ...     value = table[key]
+    >>> with lock.exclusive:
+    ...     table[key] = value
+    """
+    def __init__(self):
+        ffi, library = dist.load()
+        self.library = library
+        self.pointer = ffi.new("PSRWLOCK")
+        library.InitializeSRWLock(self.pointer)
+        self.shared = _Guard(self.acquire_shared, self.release_shared)
+        self.exclusive = _Guard(
+            self.acquire_exclusive, self.release_exclusive)
+        self.shared_acquisitions = 0
+        self.exclusive_acquisitions = 0
+        self.contentions = 0
+
+    def statistics(self):
+        """Returns a :class:`LockStatistics` tuple of the counters"""
+        return LockStatistics(
+            self.shared_acquisitions, self.exclusive_acquisitions,
+            self.contentions)
+
+    def acquire_shared(self, blocking=True):
+        """
+        Acquires the lock in shared mode.
+
+        :keyword bool blocking:
+            If False return immediately if the lock is held exclusively.
+
+        :rtype: bool
+        :returns:
+            Returns True if the lock was acquired.
+        """
+        if not self.library.TryAcquireSRWLockShared(self.pointer):
+            if not blocking:
+                return False
+            self.contentions += 1
+            self.library.AcquireSRWLockShared(self.pointer)
+        self.shared_acquisitions += 1
+        return True
+
+    def release_shared(self):
+        """Releases the lock acquired in shared mode"""
+        self.library.ReleaseSRWLockShared(self.pointer)
+
+    def acquire_exclusive(self, blocking=True):
+        """
+        Acquires the lock in exclusive mode.
+
+        :keyword bool blocking:
+            If False return immediately if the lock is held.
+
+        :rtype: bool
+        :returns:
+            Returns True if the lock was acquired.
+        """
+        if not self.library.TryAcquireSRWLockExclusive(self.pointer):
+            if not blocking:
+                return False
+            self.contentions += 1
+            self.library.AcquireSRWLockExclusive(self.pointer)
+        self.exclusive_acquisitions += 1
+        return True
+
+    def release_exclusive(self):
+        """Releases the lock acquired in exclusive mode"""
+        self.library.ReleaseSRWLockExclusive(self.pointer)
+
+    def __enter__(self):
+        self.acquire_exclusive()
+        return self
+
+    def __exit__(self, *_):
+        self.release_exclusive()
+
+
+class Condition(object):
+    """
+    A condition variable used with an :class:`RWLock`, similar to
+    :class:`threading.Condition`.  The lock must be held, in the mode
+    given to :meth:`wait`, when waiting.  Using the condition as a context
+    manager acquires the lock in exclusive mode.
+
+    >>> from pywincffi.kernel32 import Condition
+    >>> ready = Condition()
+    >>> with ready:
+    ...     ready.wait_for(lambda: queue, timeout=1.0)
+
+    :keyword RWLock lock:
+        The lock to use.  One is created if not provided.
+    """
+    def __init__(self, lock=None):
+        input_check("lock", lock, (NoneType, RWLock))
+        ffi, library = dist.load()
+        self.library = library
+        self.lock = RWLock() if lock is None else lock
+        self.pointer = ffi.new("PCONDITION_VARIABLE")
+        library.InitializeConditionVariable(self.pointer)
+        self.waits = 0
+        self.timeouts = 0
+
+    def wait(self, timeout=None, shared=False):
+        """
+        Releases the lock, sleeps until woken or ``timeout`` seconds
+        elapse and acquires the lock again.  Spurious wake ups are
+        possible so callers should check their condition in a loop, or
+        use :meth:`wait_for`.
+
+        :keyword bool shared:
+            True if the lock is held in shared mode.
+
+        :rtype: bool
+        :returns:
+            Returns False if the wait timed out.
+        """
+        ffi, library = dist.load()
+        self.waits += 1
+        code = library.SleepConditionVariableSRW(
+            self.pointer, self.lock.pointer,
+            ffi.cast("DWORD", _milliseconds(timeout)),
+            library.CONDITION_VARIABLE_LOCKMODE_SHARED if shared else 0)
+        if not _woken("SleepConditionVariableSRW", code):
+            self.timeouts += 1
+            return False
+        return True
+
+    def wait_for(self, predicate, timeout=None, shared=False):
+        """
+        Waits until ``predicate()`` returns a true value or ``timeout``
+        seconds elapse.
+
+        :returns:
+            Returns the last value ``predicate()`` returned.
+        """
+        deadline = None if timeout is None else monotonic() + timeout
+        result = predicate()
+        while not result:
+            remaining = None
+            if deadline is not None:
+                remaining = deadline - monotonic()
+                if remaining <= 0:
+                    break
+            self.wait(remaining, shared=shared)
+            result = predicate()
+        return result
+
+    def notify(self):
+        """Wakes one waiting thread"""
+        self.library.WakeConditionVariable(self.pointer)
+
+    def notify_all(self):
+        """Wakes every waiting thread"""
+        self.library.WakeAllConditionVariable(self.pointer)
+
+    def __enter__(self):
+        self.lock.acquire_exclusive()
+        return self
+
+    def __exit__(self, *_):
+        self.lock.release_exclusive()
@@ -0,0 +1,531 @@
+"""
+Timers
+------
+
+A module containing Windows functions for waitable timers and timer
+queues along with :class:`TimerScheduler`, which runs any number of
+one-shot and periodic callbacks from a single high resolution waitable
+timer.
+"""
+
+import heapq
+import itertools
+import threading
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NON_ZERO, NoneType, input_check, error_check
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.clock import perf_counter_ns
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.kernel32.synchronization import WaitForSingleObject
+from pywincffi.kernel32.tracking import tracked
+from pywincffi.wintypes import HANDLE, SECURITY_ATTRIBUTES, wintype_to_cdata
+
+# The ffi instance _timer_queue_callback() was last registered with.
+_TIMER_CALLBACK_FFI = []
+
+# Maps the address of each timer created by CreateTimerQueueTimer() to
+# the handle passed as its Parameter, keeping the handle alive until
+# DeleteTimerQueueTimer() is called.
+_TIMER_CONTEXTS = {}
+_TIMER_CONTEXTS_LOCK = threading.Lock()
+
+
+def CreateWaitableTimerEx(
+        lpTimerAttributes=None, lpTimerName=None, dwFlags=None,
+        dwDesiredAccess=None):
+    """
+    Creates or opens a waitable timer.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682494
+
+    :keyword pywincffi.wintypes.SECURITY_ATTRIBUTES lpTimerAttributes:
+        If not provided the handle cannot be inherited by a subprocess.
+
+    :keyword str lpTimerName:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The optional name of the timer.
+
+    :keyword int dwFlags:
+        Defaults to ``CREATE_WAITABLE_TIMER_HIGH_RESOLUTION`` which, on
+        Windows 10 1803 and later, fires with sub-millisecond precision
+        rather than at the ~15ms system timer interval.  Older versions
+        of Windows reject the flag with ``ERROR_INVALID_PARAMETER`` in
+        which case the default falls back to a regular timer.  Add
+        ``CREATE_WAITABLE_TIMER_MANUAL_RESET`` for a manual reset timer.
+
+    :keyword int dwDesiredAccess:
+        Defaults to ``TIMER_ALL_ACCESS``.
+
+    :rtype: :class:`pywincffi.wintypes.HANDLE`
+    """
+    ffi, library = dist.load()
+    high_resolution = dwFlags is None
+
+    if high_resolution:
+        dwFlags = library.CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+
+    if dwDesiredAccess is None:
+        dwDesiredAccess = library.TIMER_ALL_ACCESS
+
+    input_check(
+        "lpTimerAttributes", lpTimerAttributes,
+        allowed_types=(NoneType, SECURITY_ATTRIBUTES))
+    input_check("lpTimerName", lpTimerName, (NoneType, text_type))
+    input_check("dwFlags", dwFlags, integer_types)
+    input_check("dwDesiredAccess", dwDesiredAccess, integer_types)
+
+    handle = library.CreateWaitableTimerEx(
+        wintype_to_cdata(lpTimerAttributes),
+        ffi.NULL if lpTimerName is None else lpTimerName,
+        ffi.cast("DWORD", dwFlags), ffi.cast("DWORD", dwDesiredAccess))
+
+    if handle == ffi.NULL:
+        errno, message = ffi.getwinerror()
+
+        # The flag is only supported by Windows 10 1803 and later
+        if high_resolution and errno == library.ERROR_INVALID_PARAMETER:
+            return CreateWaitableTimerEx(
+                lpTimerAttributes=lpTimerAttributes, lpTimerName=lpTimerName,
+                dwFlags=0, dwDesiredAccess=dwDesiredAccess)
+
+        raise WindowsAPIError(
+            "CreateWaitableTimerEx", message, errno,
+            return_code=handle, expected_return_code="not NULL")
+
+    return tracked(HANDLE(handle), "CreateWaitableTimerEx")
+
+
+def SetWaitableTimer(hTimer, lpDueTime, lPeriod=0, fResume=False):
+    """
+    Activates a waitable timer.  The timer is signaled at ``lpDueTime``
+    and then every ``lPeriod`` milliseconds.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms686289
+
+    :param pywincffi.wintypes.HANDLE hTimer:
+        The timer to activate.
+
+    :param int lpDueTime:
+        The time the timer is first signaled in 100ns intervals.  Positive
+        values are absolute ``FILETIME`` values, negative values are
+        relative to now.
+
+    :keyword int lPeriod:
+        The period of the timer in milliseconds, 0 for a one-shot timer.
+
+    :keyword bool fResume:
+        If True the system is resumed from suspended power conservation
+        mode when the timer is signaled.
+    """
+    input_check("hTimer", hTimer, HANDLE)
+    input_check("lpDueTime", lpDueTime, integer_types)
+    input_check("lPeriod", lPeriod, integer_types)
+    input_check("fResume", fResume, allowed_values=(True, False))
+
+    ffi, library = dist.load()
+    pDueTime = ffi.new("PLARGE_INTEGER")
+    pDueTime.QuadPart = lpDueTime
+    code = library.SetWaitableTimer(
+        wintype_to_cdata(hTimer), pDueTime, lPeriod, ffi.NULL, ffi.NULL,
+        ffi.cast("BOOL", fResume))
+    error_check("SetWaitableTimer", code=code, expected=NON_ZERO)
+
+
+def CancelWaitableTimer(hTimer):
+    """
+    Deactivates a waitable timer without changing its signaled state.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms681985
+
+    :param pywincffi.wintypes.HANDLE hTimer:
+        The timer to deactivate.
+    """
+    input_check("hTimer", hTimer, HANDLE)
+    _, library = dist.load()
+    code = library.CancelWaitableTimer(wintype_to_cdata(hTimer))
+    error_check("CancelWaitableTimer", code=code, expected=NON_ZERO)
+
+
+def CreateTimerQueue():
+    """
+    Creates a queue for timers created by :func:`CreateTimerQueueTimer`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682483
+
+    :rtype: :class:`pywincffi.wintypes.HANDLE`
+    :returns:
+        Returns the queue which must be deleted with
+        :func:`DeleteTimerQueueEx`.
+    """
+    ffi, library = dist.load()
+    handle = library.CreateTimerQueue()
+    if handle == ffi.NULL:
+        errno, message = ffi.getwinerror()
+        raise WindowsAPIError(
+            "CreateTimerQueue", message, errno,
+            return_code=handle, expected_return_code="not NULL")
+    return HANDLE(handle)
+
+
+def DeleteTimerQueueEx(TimerQueue, wait=True):
+    """
+    Deletes a timer queue and every timer in it.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682568
+
+    :param pywincffi.wintypes.HANDLE TimerQueue:
+        The queue created by :func:`CreateTimerQueue`.
+
+    :keyword bool wait:
+        If True, the default, waits for running callbacks to finish.
+    """
+    input_check("TimerQueue", TimerQueue, HANDLE)
+    input_check("wait", wait, allowed_values=(True, False))
+
+    ffi, library = dist.load()
+    code = library.DeleteTimerQueueEx(
+        wintype_to_cdata(TimerQueue),
+        ffi.cast("HANDLE", library.INVALID_HANDLE_VALUE) if wait
+        else ffi.NULL)
+    error_check("DeleteTimerQueueEx", code=code, expected=NON_ZERO)
+
+
+def _timer_queue_callback(lpParameter, TimerOrWaitFired):
+    """
+    The ``WAITORTIMERCALLBACK`` given to ``CreateTimerQueueTimer``.  Runs
+    on a thread pool thread and calls the Python function in
+    ``lpParameter``.  Exceptions can't be raised into the thread pool so
+    they are stored on the context instead.
+    """
+    ffi, _ = dist.load()
+    context = ffi.from_handle(lpParameter)
+    try:
+        context.callback(context.parameter)
+    except Exception as error:  # pylint: disable=broad-except
+        context.error = error
+
+
+def _register_timer_callback(ffi):
+    """
+    Registers :func:`_timer_queue_callback` as the implementation of the
+    ``extern "Python"`` function declared in functions.h.
+    """
+    if not _TIMER_CALLBACK_FFI or _TIMER_CALLBACK_FFI[0] is not ffi:
+        ffi.def_extern(name="_timer_queue_callback")(_timer_queue_callback)
+        _TIMER_CALLBACK_FFI[:] = [ffi]
+
+
+class _TimerContext(object):  # pylint: disable=too-few-public-methods
+    """The ``Parameter`` passed to :func:`_timer_queue_callback`"""
+    def __init__(self, callback, parameter):
+        self.callback = callback
+        self.parameter = parameter
+        self.error = None
+
+
+def _timer_address(ffi, Timer):
+    return int(ffi.cast("uintptr_t", wintype_to_cdata(Timer)))
+
+
+def CreateTimerQueueTimer(
+        Callback, Parameter=None, DueTime=0, Period=0, Flags=None,
+        TimerQueue=None):
+    """
+    Creates a timer which calls ``Callback`` on a thread pool thread.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682485
+
+    :param callable Callback:
+        Called with ``Parameter`` each time the timer fires.  An exception
+        raised by ``Callback`` can't propagate into the thread pool so it
+        is raised by :func:`DeleteTimerQueueTimer` instead.
+
+    :keyword Parameter:
+        Any Python object, passed on to ``Callback``.
+
+    :keyword int DueTime:
+        The number of milliseconds until the timer first fires.
+
+    :keyword int Period:
+        The period of the timer in milliseconds, 0 for a one-shot timer.
+
+    :keyword int Flags:
+        The ``WT_*`` flags.  Defaults to ``WT_EXECUTEDEFAULT``.
+
+    :keyword pywincffi.wintypes.HANDLE TimerQueue:
+        The queue to add the timer to.  Defaults to the process' default
+        timer queue.
+
+    :rtype: :class:`pywincffi.wintypes.HANDLE`
+    :returns:
+        Returns the timer, which must be deleted with
+        :func:`DeleteTimerQueueTimer`.
+    """
+    if not callable(Callback):
+        raise InputError(
+            "Callback", Callback, message="Expected `Callback` to be callable")
+
+    input_check("DueTime", DueTime, integer_types)
+    input_check("Period", Period, integer_types)
+    input_check("Flags", Flags, (NoneType, ) + integer_types)
+    input_check("TimerQueue", TimerQueue, (NoneType, HANDLE))
+
+    ffi, library = dist.load()
+
+    if Flags is None:
+        Flags = library.WT_EXECUTEDEFAULT
+
+    _register_timer_callback(ffi)
+    context = _TimerContext(Callback, Parameter)
+    lpParameter = ffi.new_handle(context)
+    phNewTimer = ffi.new("PHANDLE")
+
+    # The callback finds its context through lpParameter, which this
+    # function references until it's stored in _TIMER_CONTEXTS, so a timer
+    # which fires immediately still has a live context.  The lock only
+    # guards _TIMER_CONTEXTS against DeleteTimerQueueTimer() on another
+    # thread.
+    with _TIMER_CONTEXTS_LOCK:
+        code = library.CreateTimerQueueTimer(
+            phNewTimer, wintype_to_cdata(TimerQueue),
+            library._timer_queue_callback,  # pylint: disable=W0212
+            lpParameter, ffi.cast("DWORD", DueTime),
+            ffi.cast("DWORD", Period), ffi.cast("ULONG", Flags))
+        error_check("CreateTimerQueueTimer", code=code, expected=NON_ZERO)
+        Timer = HANDLE(phNewTimer[0])
+        _TIMER_CONTEXTS[_timer_address(ffi, Timer)] = lpParameter
+
+    return Timer
+
+
+def DeleteTimerQueueTimer(Timer, TimerQueue=None):
+    """
+    Cancels a timer created by :func:`CreateTimerQueueTimer` and waits
+    for any running callback to finish.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms682569
+
+    :param pywincffi.wintypes.HANDLE Timer:
+        The timer to delete.
+
+    :keyword pywincffi.wintypes.HANDLE TimerQueue:
+        The queue the timer was created in, if any.
+
+    :raises Exception:
+        Raises the last exception the timer's callback raised, if any.
+    """
+    input_check("Timer", Timer, HANDLE)
+    input_check("TimerQueue", TimerQueue, (NoneType, HANDLE))
+
+    ffi, library = dist.load()
+    code = library.DeleteTimerQueueTimer(
+        wintype_to_cdata(TimerQueue), wintype_to_cdata(Timer),
+        ffi.cast("HANDLE", library.INVALID_HANDLE_VALUE))
+    error_check("DeleteTimerQueueTimer", code=code, expected=NON_ZERO)
+
+    with _TIMER_CONTEXTS_LOCK:
+        lpParameter = _TIMER_CONTEXTS.pop(_timer_address(ffi, Timer), None)
+
+    if lpParameter is not None:
+        context = ffi.from_handle(lpParameter)
+        if context.error is not None:
+            raise context.error
+
+
+class ScheduledTimer(object):
+    """
+    A callback scheduled by :meth:`TimerScheduler.schedule`.  Call
+    :meth:`cancel` to stop it.
+    """
+    def __init__(self, callback, deadline, period):
+        self.callback = callback
+        self.deadline = deadline
+        self.period = period
+        self.cancelled = False
+
+        # The number of times the callback ran, the number of periods
+        # skipped because the callback fell more than a whole period
+        # behind and the largest lateness seen, in nanoseconds.
+        self.runs = 0
+        self.skipped = 0
+        self.max_lateness = 0
+
+    def cancel(self):
+        """Prevents the callback from running again"""
+        self.cancelled = True
+
+
+class TimerScheduler(object):
+    """
+    Runs one-shot and periodic callbacks using a heap of deadlines and a
+    single waitable timer, which is always set for the earliest deadline.
+
+    Periodic timers are rescheduled relative to their previous deadline
+    rather than to when the callback ran, so lateness does not accumulate
+    into drift.  When a callback falls more than a whole period behind
+    the missed periods are skipped, and counted, rather than run back to
+    back.
+
+    >>> from pywincffi.kernel32 import TimerScheduler
+    >>> scheduler = TimerScheduler()
+    >>> scheduler.schedule(sample_sensors, 0.010, period=0.010)
+    >>> scheduler.schedule(flush_metrics, 1.0, period=1.0)
+    >>> while True:
+    ...     scheduler.wait()
+
+    :keyword pywincffi.wintypes.HANDLE hTimer:
+        The waitable timer to use.  One is created, with
+        :func:`CreateWaitableTimerEx`, if not provided and closed by
+        :meth:`close`.
+
+    :keyword callable clock:
+        Returns the current time in nanoseconds.  Defaults to
+        :func:`pywincffi.kernel32.clock.perf_counter_ns`.
+    """
+    def __init__(self, hTimer=None, clock=None):
+        input_check("hTimer", hTimer, (NoneType, HANDLE))
+        self.clock = perf_counter_ns if clock is None else clock
+        self._owns_timer = hTimer is None
+        self.hTimer = CreateWaitableTimerEx() if hTimer is None else hTimer
+        self._heap = []
+        self._sequence = itertools.count()
+
+        # The deadline the waitable timer is currently set for, so it is
+        # only set again when the earliest deadline changes.
+        self._armed = None
+        self.closed = False
+
+    def __len__(self):
+        return len(self._heap)
+
+    def schedule(self, callback, delay, period=None):
+        """
+        Schedules ``callback`` to run after ``delay`` seconds and then,
+        if ``period`` is given, every ``period`` seconds.
+
+        :rtype: :class:`ScheduledTimer`
+        """
+        if not callable(callback):
+            raise InputError(
+                "callback", callback,
+                message="Expected `callback` to be callable")
+        if period is not None and period <= 0:
+            raise InputError(
+                "period", period, message="Expected `period` > 0")
+
+        timer = ScheduledTimer(
+            callback, self.clock() + int(delay * 1e9),
+            None if period is None else int(period * 1e9))
+        self._push(timer)
+        self._arm()
+        return timer
+
+    def _push(self, timer):
+        heapq.heappush(
+            self._heap, (timer.deadline, next(self._sequence), timer))
+
+    def _arm(self):
+        while self._heap and self._heap[0][2].cancelled:
+            heapq.heappop(self._heap)
+
+        if not self._heap:
+            self._armed = None
+            return
+
+        deadline = self._heap[0][0]
+        if deadline != self._armed:
+            # Relative due times are negative.  At least one 100ns
+            # interval is used because 0 is an absolute time.
+            due = max(deadline - self.clock(), 100) // 100
+            SetWaitableTimer(self.hTimer, -due)
+            self._armed = deadline
+
+    def run_pending(self):
+        """
+        Runs every callback whose deadline has passed, without waiting.
+        If a callback raises, its timer is still rescheduled and the
+        waitable timer re-armed before the exception propagates.  Any
+        other callbacks which are due run on the next call.
+
+        :rtype: int
+        :returns:
+            Returns the number of callbacks run.
+        """
+        heap = self._heap
+        now = self.clock()
+        count = 0
+        try:
+            while heap and heap[0][0] <= now:
+                deadline, _, timer = heapq.heappop(heap)
+                if timer.cancelled:
+                    continue
+
+                timer.max_lateness = max(timer.max_lateness, now - deadline)
+                timer.runs += 1
+                count += 1
+                try:
+                    timer.callback()
+                finally:
+                    if timer.period is not None and not timer.cancelled:
+                        missed = (now - deadline) // timer.period
+                        timer.skipped += missed
+                        timer.deadline = \
+                            deadline + (missed + 1) * timer.period
+                        self._push(timer)
+        finally:
+            self._armed = None
+            self._arm()
+        return count
+
+    def wait(self, dwMilliseconds=None):
+        """
+        Waits for the earliest deadline, up to ``dwMilliseconds``, and
+        runs the callbacks which are due.
+
+        :rtype: int
+        :returns:
+            Returns the number of callbacks run.
+        """
+        _, library = dist.load()
+        if dwMilliseconds is None:
+            dwMilliseconds = library.INFINITE
+
+        if self._heap:
+            WaitForSingleObject(self.hTimer, dwMilliseconds)
+        return self.run_pending()
+
+    def close(self):
+        """
+        Cancels the waitable timer and closes it if it was created by the
+        scheduler.  Calling this more than once has no effect.
+        """
+        if self.closed:
+            return
+        self.closed = True
+        self._heap = []
+        CancelWaitableTimer(self.hTimer)
+        if self._owns_timer:
+            CloseHandle(self.hTimer)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
@@ -0,0 +1,228 @@
+"""
+Handle Tracking
+---------------
+
+An opt-in tracker for finding leaked handles.  Once :func:`enable` has
+been called each handle returned by a wrapper such as
+:func:`pywincffi.kernel32.CreateEvent`, :func:`pywincffi.kernel32.CreatePipe`
+or :func:`pywincffi.kernel32.OpenProcess` is recorded along with the name
+of the wrapper and a short summary of the stack which called it.  Closing
+the handle with :func:`pywincffi.kernel32.CloseHandle`, or any of the
+helpers built on it, removes the record so whatever remains are the
+handles which are still open.
+
+>>> from pywincffi.kernel32 import tracking
+>>> tracker = tracking.enable()
+>>> run_workload()
+>>> tracker.census()
+{'CreateEvent': 1200, 'OpenProcess': 3}
+>>> print(tracker.dump())
+
+While disabled, the default, the wrappers only check whether a tracker
+is active so the overhead is a single function call per handle.
+"""
+
+import sys
+import threading
+from collections import namedtuple
+from os.path import basename
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check
+from pywincffi.wintypes import wintype_to_cdata
+
+# The active HandleTracker, see enable() and disable()
+tracker = None
+
+HandleRecord = namedtuple("HandleRecord", ("handle", "function", "stack"))
+HandleLeak = namedtuple("HandleLeak", ("function", "stack", "count"))
+
+
+def _value(handle):
+    # Handles are tracked by their value, which is the same for a
+    # HANDLE and the cdata it wraps.
+    ffi, _ = dist.load()
+    if not isinstance(handle, ffi.CData):
+        handle = wintype_to_cdata(handle)
+    return int(ffi.cast("intptr_t", handle))
+
+
+def format_stack(stack):
+    """
+    Formats a stack summary, as stored in :class:`HandleRecord`, as a
+    single line starting with the innermost frame.
+    """
+    return " <- ".join(
+        "%s:%d(%s)" % (basename(filename), lineno, name)
+        for filename, lineno, name in stack)
+
+
+class HandleTracker(object):
+    """
+    Records the handles which are currently open.  Use :func:`enable`
+    rather than constructing this class directly so the wrappers in
+    :mod:`pywincffi.kernel32` report to it.
+
+    :keyword int depth:
+        The number of stack frames, starting with the caller of the
+        wrapper, to record for each handle.  Only the file name, line
+        number and function name of each frame are kept so recording the
+        stack does not read any source code.
+    """
+    def __init__(self, depth=4):
+        input_check("depth", depth, integer_types)
+        self.depth = depth
+        self.opened = 0
+        self.closed = 0
+        self.unmatched = 0
+        self._live = {}
+        self._lock = threading.Lock()
+
+    def __len__(self):
+        """The number of handles which are currently open"""
+        return len(self._live)
+
+    def track(self, handle, function, skip=1):
+        """
+        Records that ``function`` returned ``handle``.
+
+        :param handle:
+            The :class:`pywincffi.wintypes.HANDLE` or the cdata handle.
+
+        :param str function:
+            The name of the function which created the handle.
+
+        :keyword int skip:
+            The number of frames between the caller of this method and the
+            frame the stack summary should start with.
+        """
+        frame = sys._getframe(skip + 1)  # pylint: disable=protected-access
+        stack = []
+        while frame is not None and len(stack) < self.depth:
+            code = frame.f_code
+            stack.append((code.co_filename, frame.f_lineno, code.co_name))
+            frame = frame.f_back
+
+        value = _value(handle)
+        with self._lock:
+            # Windows reuses the values of closed handles so a handle
+            # which was closed without being untracked is replaced here.
+            self._live[value] = HandleRecord(value, function, tuple(stack))
+            self.opened += 1
+
+    def untrack(self, handle):
+        """
+        Records that ``handle`` has been closed.  Handles which were not
+        tracked, such as those created before the tracker was enabled, are
+        counted by :attr:`unmatched`.
+        """
+        value = _value(handle)
+        with self._lock:
+            if self._live.pop(value, None) is None:
+                self.unmatched += 1
+            else:
+                self.closed += 1
+
+    def live(self):
+        """Returns a list of :class:`HandleRecord` for every open handle"""
+        with self._lock:
+            return list(self._live.values())
+
+    def census(self):
+        """
+        Returns a dictionary mapping the name of each function to the
+        number of handles it created which are still open.
+        """
+        census = {}
+        for record in self.live():
+            census[record.function] = census.get(record.function, 0) + 1
+        return census
+
+    def top_leakers(self, count=10):
+        """
+        Groups the open handles by the function and stack which created
+        them.
+
+        :keyword int count:
+            The maximum number of groups to return.
+
+        :rtype: list
+        :returns:
+            Returns a list of :class:`HandleLeak` tuples, the groups with
+            the most open handles first.
+        """
+        input_check("count", count, integer_types)
+        groups = {}
+        for record in self.live():
+            key = (record.function, record.stack)
+            groups[key] = groups.get(key, 0) + 1
+
+        leaks = [
+            HandleLeak(function, stack, total)
+            for (function, stack), total in groups.items()]
+        leaks.sort(key=lambda leak: (-leak.count, leak.function))
+        return leaks[:count]
+
+    def dump(self, count=10):
+        """
+        Returns a report of the open handles and the ``count`` sites which
+        created the most of them, suitable for logging.
+        """
+        lines = ["%d open handle(s), %d opened, %d closed, %d unmatched" % (
+            len(self), self.opened, self.closed, self.unmatched)]
+        for leak in self.top_leakers(count):
+            lines.append("%6d %s %s" % (
+                leak.count, leak.function, format_stack(leak.stack)))
+        return "\n".join(lines)
+
+    def reset(self):
+        """Forgets every open handle and resets the counters"""
+        with self._lock:
+            self._live.clear()
+            self.opened = self.closed = self.unmatched = 0
+
+
+def enable(depth=4):
+    """
+    Starts tracking handles, if they're not being tracked already, and
+    returns the active :class:`HandleTracker`.
+
+    :keyword int depth:
+        See :class:`HandleTracker`.  Ignored if tracking is already
+        enabled.
+    """
+    global tracker  # pylint: disable=global-statement
+    if tracker is None:
+        tracker = HandleTracker(depth=depth)
+    return tracker
+
+
+def disable():
+    """
+    Stops tracking handles and returns the tracker which was active, or
+    ``None``, so its records can still be inspected.
+    """
+    global tracker  # pylint: disable=global-statement
+    active, tracker = tracker, None
+    return active
+
+
+def tracked(handle, function):
+    """
+    Called by the wrappers which create handles.  Records ``handle``, if
+    tracking is enabled, and returns it.
+    """
+    if tracker is not None:
+        tracker.track(handle, function, skip=2)
+    return handle
+
+
+def untracked(handle):
+    """
+    Called by the wrappers which close handles.  Removes the record of
+    ``handle`` if tracking is enabled.
+    """
+    if tracker is not None:
+        tracker.untrack(handle)
@@ -0,0 +1,382 @@
+"""
+Directory Changes
+-----------------
+
+A module containing Windows functions for watching directories for
+changes.  :class:`DirectoryWatcher` keeps a ``ReadDirectoryChangesW`` call
+outstanding at all times, alternating between two buffers, so changes are
+still being collected while Python parses the previous batch.
+"""
+
+from collections import OrderedDict, namedtuple
+
+from six import integer_types, text_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NoneType, input_check, pending_check
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.events import CreateEvent, ResetEvent
+from pywincffi.kernel32.file import CreateFile
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.kernel32.overlapped import CancelIoEx, GetOverlappedResult
+from pywincffi.kernel32.synchronization import WaitForSingleObject
+from pywincffi.wintypes import HANDLE, OVERLAPPED, wintype_to_cdata
+
+# The size of each of the two buffers used by DirectoryWatcher.  Windows
+# limits the buffer to 64KiB when watching a directory on a network share.
+DEFAULT_BUFFER_SIZE = 64 * 1024
+
+FileChange = namedtuple("FileChange", ("action", "name"))
+
+
+def ReadDirectoryChanges(  # pylint: disable=too-many-arguments
+        hDirectory, lpBuffer, nBufferLength, bWatchSubtree, dwNotifyFilter,
+        lpOverlapped=None):
+    """
+    Retrieves changes to the directory ``hDirectory`` into ``lpBuffer`` as
+    a chain of ``FILE_NOTIFY_INFORMATION`` records.  See
+    :func:`parse_notify_information`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/aa365465
+
+    :param pywincffi.wintypes.HANDLE hDirectory:
+        A handle to the directory opened with ``FILE_LIST_DIRECTORY``
+        access and ``FILE_FLAG_BACKUP_SEMANTICS``.  ``FILE_FLAG_OVERLAPPED``
+        is also required when ``lpOverlapped`` is provided.
+
+    :param lpBuffer:
+        The ``DWORD`` aligned buffer, such as one created with
+        ``ffi.new("char[]", size)``, to store changes in.
+
+    :param int nBufferLength:
+        The size of ``lpBuffer`` in bytes.
+
+    :param bool bWatchSubtree:
+        If True changes to subdirectories are reported too.
+
+    :param int dwNotifyFilter:
+        The ``FILE_NOTIFY_CHANGE_*`` flags selecting which changes to
+        report.
+
+    :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        If provided the call returns immediately and
+        :func:`pywincffi.kernel32.GetOverlappedResult` returns the number of
+        bytes stored once changes are available.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes stored in ``lpBuffer`` or ``None`` when
+        ``lpOverlapped`` is provided.  Zero bytes means too many changes
+        occurred to fit in the buffer and the directory should be rescanned.
+    """
+    input_check("hDirectory", hDirectory, HANDLE)
+    input_check("nBufferLength", nBufferLength, integer_types)
+    input_check("bWatchSubtree", bWatchSubtree, allowed_values=(True, False))
+    input_check("dwNotifyFilter", dwNotifyFilter, integer_types)
+    input_check("lpOverlapped", lpOverlapped, (NoneType, OVERLAPPED))
+
+    ffi, library = dist.load()
+    lpBytesReturned = ffi.new("LPDWORD")
+    code = library.ReadDirectoryChangesW(
+        wintype_to_cdata(hDirectory), lpBuffer, nBufferLength,
+        ffi.cast("BOOL", bWatchSubtree), dwNotifyFilter,
+        lpBytesReturned if lpOverlapped is None else ffi.NULL,
+        wintype_to_cdata(lpOverlapped), ffi.NULL
+    )
+
+    pending_check(
+        "ReadDirectoryChangesW", code, overlapped=lpOverlapped is not None)
+
+    if lpOverlapped is None:
+        return int(lpBytesReturned[0])
+    return None
+
+
+def parse_notify_information(lpBuffer, nBufferLength):
+    """
+    Parses the chain of variable length ``FILE_NOTIFY_INFORMATION``
+    records in ``lpBuffer``.  Each record is read in place, no structures
+    are allocated to hold them.
+
+    :param lpBuffer:
+        The buffer filled by :func:`ReadDirectoryChanges`.  May be cdata
+        or any object supporting the buffer protocol.
+
+    :param int nBufferLength:
+        The number of bytes stored in ``lpBuffer``.  Records are not
+        allowed to extend beyond it.
+
+    :raises InputError:
+        Raised if a record extends beyond ``nBufferLength``.
+
+    :returns:
+        Yields a :class:`FileChange` for each record.  ``name`` is
+        relative to the directory being watched.
+    """
+    ffi, _ = dist.load()
+
+    if not isinstance(lpBuffer, ffi.CData):
+        lpBuffer = ffi.from_buffer(lpBuffer)
+
+    address = ffi.cast("char *", lpBuffer)
+    name_offset = ffi.offsetof("FILE_NOTIFY_INFORMATION", "FileName")
+    offset = 0
+
+    while nBufferLength:
+        if offset + name_offset > nBufferLength:
+            raise InputError(
+                "lpBuffer", None,
+                message="Record at offset %d extends beyond the end of "
+                        "the buffer" % offset)
+
+        info = ffi.cast("PFILE_NOTIFY_INFORMATION", address + offset)
+        if offset + name_offset + info.FileNameLength > nBufferLength:
+            raise InputError(
+                "lpBuffer", None,
+                message="File name at offset %d extends beyond the end "
+                        "of the buffer" % offset)
+
+        yield FileChange(
+            action=info.Action,
+            name=ffi.unpack(
+                ffi.cast("WCHAR *", address + offset + name_offset),
+                info.FileNameLength // ffi.sizeof("WCHAR"))
+        )
+
+        if info.NextEntryOffset == 0:
+            break
+        offset += info.NextEntryOffset
+
+
+def coalesce(changes):
+    """
+    Reduces ``changes`` to at most one :class:`FileChange` per name, in
+    the order each name was first changed.  Renames are treated as the
+    old name being removed and the new name being added so that, for
+    example, a file written to a temporary name and renamed into place is
+    reported as a single ``FILE_ACTION_ADDED``.
+
+    * ``FILE_ACTION_ADDED`` then ``FILE_ACTION_MODIFIED`` is reported as
+      ``FILE_ACTION_ADDED``.
+    * ``FILE_ACTION_ADDED`` then ``FILE_ACTION_REMOVED`` is not reported.
+    * ``FILE_ACTION_REMOVED`` then ``FILE_ACTION_ADDED`` is reported as
+      ``FILE_ACTION_MODIFIED``.
+    * Otherwise the later action is reported.
+
+    :param changes:
+        An iterable of :class:`FileChange` objects, such as
+        :func:`parse_notify_information` produces.
+
+    :rtype: list
+    """
+    _, library = dist.load()
+    added = library.FILE_ACTION_ADDED
+    removed = library.FILE_ACTION_REMOVED
+    modified = library.FILE_ACTION_MODIFIED
+    renames = {
+        library.FILE_ACTION_RENAMED_OLD_NAME: removed,
+        library.FILE_ACTION_RENAMED_NEW_NAME: added
+    }
+
+    actions = OrderedDict()
+    for action, name in changes:
+        action = renames.get(action, action)
+        previous = actions.get(name)
+
+        if previous == added and action == modified:
+            continue
+        elif previous == added and action == removed:
+            del actions[name]
+        elif previous == removed and action == added:
+            actions[name] = modified
+        else:
+            actions[name] = action
+
+    return [FileChange(action, name) for name, action in actions.items()]
+
+
+class DirectoryWatcher(object):
+    """
+    Watches the directory ``path`` for changes.  A read is always
+    outstanding, alternating between two buffers, so Windows continues to
+    collect changes while :meth:`read` parses the previous batch.
+
+    >>> from pywincffi.kernel32 import DirectoryWatcher
+    >>> with DirectoryWatcher(u"C:\\ingest") as watcher:
+    ...     while True:
+    ...         for action, name in watcher.read():
+    ...             process(action, name)
+
+    :param str path:
+        Type is ``unicode`` on Python 2, ``str`` on Python 3.
+        The directory to watch.
+
+    :keyword bool recursive:
+        If True, the default, changes to subdirectories are reported too.
+
+    :keyword int dwNotifyFilter:
+        The ``FILE_NOTIFY_CHANGE_*`` flags selecting which changes to
+        report.  Defaults to file and directory names, size, last write
+        time and creation time.
+
+    :keyword int buffer_size:
+        The size of each buffer.  Changes which occur while a buffer is
+        full are lost so busy directories need larger buffers.
+
+    :keyword callable rescan:
+        Called with ``path`` when changes were lost, so the caller can
+        rescan the directory to find what changed.  See :attr:`overflows`.
+    """
+    def __init__(self, path, recursive=True, dwNotifyFilter=None,
+                 buffer_size=DEFAULT_BUFFER_SIZE, rescan=None):
+        input_check("path", path, text_type)
+        input_check("recursive", recursive, allowed_values=(True, False))
+        input_check("buffer_size", buffer_size, integer_types)
+
+        ffi, library = dist.load()
+
+        if dwNotifyFilter is None:
+            dwNotifyFilter = \
+                library.FILE_NOTIFY_CHANGE_FILE_NAME | \
+                library.FILE_NOTIFY_CHANGE_DIR_NAME | \
+                library.FILE_NOTIFY_CHANGE_SIZE | \
+                library.FILE_NOTIFY_CHANGE_LAST_WRITE | \
+                library.FILE_NOTIFY_CHANGE_CREATION
+
+        input_check("dwNotifyFilter", dwNotifyFilter, integer_types)
+
+        if buffer_size <= 0 or buffer_size % 4:
+            raise InputError(
+                "buffer_size", buffer_size,
+                message="Expected `buffer_size` to be a positive multiple "
+                        "of 4")
+
+        self.path = path
+        self.recursive = recursive
+        self.dwNotifyFilter = dwNotifyFilter
+        self.buffer_size = buffer_size
+        self.rescan = rescan
+
+        # The number of times changes were lost because they didn't fit
+        # in the buffer.
+        self.overflows = 0
+
+        self._buffers = (
+            ffi.new("char[]", buffer_size), ffi.new("char[]", buffer_size))
+        self._current = 0
+        self._pending = False
+        self.closed = False
+
+        self.hDirectory = CreateFile(
+            path, library.FILE_LIST_DIRECTORY,
+            dwShareMode=library.FILE_SHARE_READ | library.FILE_SHARE_WRITE |
+            library.FILE_SHARE_DELETE,
+            dwCreationDisposition=library.OPEN_EXISTING,
+            dwFlagsAndAttributes=library.FILE_FLAG_BACKUP_SEMANTICS |
+            library.FILE_FLAG_OVERLAPPED)
+
+        try:
+            self.hEvent = CreateEvent()
+        except WindowsAPIError:
+            CloseHandle(self.hDirectory)
+            raise
+
+        self._overlapped = OVERLAPPED()
+        self._overlapped.hEvent = self.hEvent
+
+        try:
+            self._read()
+        except WindowsAPIError:
+            self.close()
+            raise
+
+    def _read(self):
+        ResetEvent(self.hEvent)
+        ReadDirectoryChanges(
+            self.hDirectory, self._buffers[self._current], self.buffer_size,
+            self.recursive, self.dwNotifyFilter, self._overlapped)
+        self._pending = True
+
+    def read(self, dwMilliseconds=None):
+        """
+        Waits for changes and returns them, coalesced with
+        :func:`coalesce`.  The next read is started, using the other
+        buffer, before this batch is parsed.
+
+        :keyword int dwMilliseconds:
+            The maximum time to wait for changes.  Waits forever by
+            default.
+
+        :rtype: list
+        :returns:
+            Returns a list of :class:`FileChange` objects.  The list is
+            empty if ``dwMilliseconds`` elapsed or if changes were lost,
+            in which case :attr:`overflows` is incremented and ``rescan`` is
+            called.
+        """
+        if self.closed:
+            raise ValueError("The watcher has been closed")
+
+        _, library = dist.load()
+
+        if dwMilliseconds is None:
+            dwMilliseconds = library.INFINITE
+
+        if WaitForSingleObject(self.hEvent, dwMilliseconds) == \
+                library.WAIT_TIMEOUT:
+            return []
+
+        lpBuffer = self._buffers[self._current]
+        try:
+            nBufferLength = GetOverlappedResult(
+                self.hDirectory, self._overlapped, True)
+        except WindowsAPIError as error:
+            if error.errno != library.ERROR_NOTIFY_ENUM_DIR:
+                self._pending = False
+                raise
+            library.SetLastError(0)
+            nBufferLength = 0
+
+        self._current ^= 1
+        self._read()
+
+        if nBufferLength == 0:
+            self.overflows += 1
+            if self.rescan is not None:
+                self.rescan(self.path)
+            return []
+
+        return coalesce(parse_notify_information(lpBuffer, nBufferLength))
+
+    def close(self):
+        """
+        Cancels the outstanding read and closes the directory handle.
+        Calling this more than once has no effect.
+        """
+        if self.closed:
+            return
+
+        _, library = dist.load()
+        self.closed = True
+        try:
+            if self._pending:
+                CancelIoEx(self.hDirectory, self._overlapped)
+                try:
+                    GetOverlappedResult(
+                        self.hDirectory, self._overlapped, True)
+                except WindowsAPIError as error:
+                    if error.errno != library.ERROR_OPERATION_ABORTED:
+                        raise
+                    library.SetLastError(0)
+                self._pending = False
+        finally:
+            CloseHandle(self.hDirectory)
+            CloseHandle(self.hEvent)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
@@ -7,6 +7,7 @@ types.
 """
 
 import socket
+import weakref
 
 from pywincffi.core import dist
 from pywincffi.exceptions import InputError
@@ -79,9 +80,78 @@ def handle_from_file(file_):
         return HANDLE(library.handle_from_fd(fileno))
 
 
+class SocketCache(object):
+    """
+    Maps Python socket objects to the :class:`SOCKET` objects
+    :func:`socket_from_object` returns for them so converting the same
+    long lived socket repeatedly does not allocate.  Sockets are held
+    weakly, so caching one does not keep it alive, and each entry records
+    the file number it was created for.  An entry is replaced when the
+    socket's file number changes and dropped when the socket is closed.
+    """
+    def __init__(self):
+        self.hits = 0
+        self.misses = 0
+        self.invalidations = 0
+        self._entries = weakref.WeakKeyDictionary()
+
+    def __len__(self):
+        return len(self._entries)
+
+    def get(self, sock, fileno):
+        """
+        Returns the cached :class:`SOCKET` for ``sock`` if it was created
+        for ``fileno``, otherwise creates and caches a new one.
+        """
+        try:
+            cached_fileno, wrapped = self._entries[sock]
+        except (KeyError, TypeError):
+            pass
+        else:
+            if cached_fileno == fileno:
+                self.hits += 1
+                return wrapped
+            self.invalidations += 1
+
+        self.misses += 1
+        ffi, _ = dist.load()
+        wrapped = SOCKET()
+        wrapped._cdata[0] = ffi.cast("SOCKET", fileno)
+        try:
+            self._entries[sock] = (fileno, wrapped)
+        except TypeError:
+            # Objects which can't be weakly referenced are not cached
+            pass
+        return wrapped
+
+    def discard(self, sock):
+        """Drops the entry for ``sock``, if there is one"""
+        try:
+            del self._entries[sock]
+        except (KeyError, TypeError):
+            return
+        self.invalidations += 1
+
+    def hit_rate(self):
+        """The fraction of lookups which were answered from the cache"""
+        lookups = self.hits + self.misses
+        return float(self.hits) / lookups if lookups else 0.0
+
+    def clear(self):
+        """Drops every entry and resets the counters"""
+        self._entries.clear()
+        self.hits = self.misses = self.invalidations = 0
+
+
+# The cache used by socket_from_object()
+socket_cache = SocketCache()
+
+
 def socket_from_object(sock):
     """
-    Converts a Python socket to a Windows SOCKET object.
+    Converts a Python socket to a Windows SOCKET object.  The result is
+    cached in :data:`socket_cache` so converting the same socket again
+    returns the same object, as long as its file number has not changed.
 
     .. warning::
 
@@ -107,11 +177,37 @@ def socket_from_object(sock):
             "sock", sock,
             message="Expected a Python socket object for `sock`")
     except socket.error as error:
+        socket_cache.discard(sock)
         raise InputError(
             "sock", sock,
             message="Invalid socket object (error: %s)" % error)
     else:
-        ffi, _ = dist.load()
-        sock = SOCKET()
-        sock._cdata[0] = ffi.cast("SOCKET", fileno)
-        return sock
+        return socket_cache.get(sock, fileno)
+
+
+def split_dwords(value):
+    """
+    Splits a 64-bit unsigned integer into the pair of ``DWORD`` values
+    which many Windows functions accept in place of a single 64-bit input,
+    such as ``dwFileOffsetHigh`` and ``dwFileOffsetLow``.
+
+    >>> from pywincffi.wintypes import split_dwords
+    >>> split_dwords(0x100000002)
+    (1, 2)
+
+    :param int value:
+        The value to split.
+
+    :raises InputError:
+        Raised if ``value`` does not fit into 64 bits.
+
+    :rtype: tuple
+    :return:
+        Returns a tuple of ``(high, low)``.
+    """
+    if not 0 <= value <= 0xFFFFFFFFFFFFFFFF:
+        raise InputError(
+            "value", value,
+            message="Expected `value` to be an unsigned 64-bit integer")
+
+    return value >> 32, value & 0xFFFFFFFF
@@ -8,3 +8,12 @@ Provides functions, constants and utilities that wrap functions provided by
 
 from pywincffi.ws2_32.events import (
     WSAEventSelect, WSACreateEvent, WSAGetLastError, WSAEnumNetworkEvents)
+from pywincffi.ws2_32.poll import WSAPoll, WSAWaitForMultipleEvents, PollSet
+from pywincffi.ws2_32.reactor import SocketReactor, decode_network_events
+from pywincffi.ws2_32.overlapped import (
+    WSARecv, WSASend, WSAGetOverlappedResult, WSAIoctl, AcceptEx, ConnectEx,
+    WSABufArray, SocketBufferPool, get_extension_function)
+from pywincffi.ws2_32.rio import (
+    RIORegisterBuffer, RIODeregisterBuffer, RIOCreateCompletionQueue,
+    RIOCloseCompletionQueue, RIOCreateRequestQueue, RIOReceive, RIOSend,
+    RIODequeueCompletion, RIONotify, BufferSlab, RIOEngine, get_rio_functions)
@@ -5,13 +5,25 @@ Events
 A module containing Windows functions for working with events.
 """
 
+import socket as socket_module
+
 from six import integer_types
 
 from pywincffi.core import dist
-from pywincffi.core.checks import input_check, error_check
+from pywincffi.core.checks import NoneType, input_check
 from pywincffi.exceptions import WindowsAPIError
 from pywincffi.wintypes import (
-    HANDLE, SOCKET, WSAEVENT, LPWSANETWORKEVENTS, wintype_to_cdata)
+    HANDLE, SOCKET, WSAEVENT, LPWSANETWORKEVENTS, wintype_to_cdata,
+    socket_from_object)
+
+
+def _as_socket(name, value):
+    # Python sockets are converted with socket_from_object() which caches
+    # the result so repeated calls for one socket don't allocate.
+    if isinstance(value, socket_module.socket):
+        return socket_from_object(value)
+    input_check(name, value, allowed_types=(SOCKET, ))
+    return value
 
 
 def WSAEventSelect(socket, hEventObject, lNetworkEvents):
@@ -25,6 +37,7 @@ def WSAEventSelect(socket, hEventObject, lNetworkEvents):
 
     :param pywincffi.wintypes.objects.SOCKET socket:
         The socket object to associate the selected network events with.
+        A Python socket may be passed instead.
 
     :param pywincffi.wintypes.objects.WSAEVENT hEventObject:
         A handle which identifies the event object to be associated
@@ -34,7 +47,7 @@ def WSAEventSelect(socket, hEventObject, lNetworkEvents):
         A bitmask which specifies the combination of ``FD_XXX`` network
         events which the application has interest in.
     """
-    input_check("socket", socket, allowed_types=(SOCKET, ))
+    socket = _as_socket("socket", socket)
     input_check("hEventObject", hEventObject, allowed_types=(HANDLE, ))
     input_check("lNetworkEvents", lNetworkEvents, integer_types)
 
@@ -47,11 +60,7 @@ def WSAEventSelect(socket, hEventObject, lNetworkEvents):
     )
 
     if code == library.SOCKET_ERROR:
-        errno = WSAGetLastError()
-        raise WindowsAPIError(
-            "WSAEventSelect", "Socket error %d" % errno, errno)
-
-    error_check("WSAEventSelect", code, expected=0)
+        raise socket_error("WSAEventSelect")
 
 
 def WSACreateEvent():
@@ -70,9 +79,7 @@ def WSACreateEvent():
     event = library.WSACreateEvent()
 
     if library.wsa_invalid_event(event):
-        errno = WSAGetLastError()
-        raise WindowsAPIError(
-            "WSACreateEvent", "Socket error %d" % errno, errno)
+        raise socket_error("WSACreateEvent")
 
     return WSAEVENT(event)
 
@@ -89,7 +96,27 @@ def WSAGetLastError():
     return library.WSAGetLastError()
 
 
-def WSAEnumNetworkEvents(socket, hEventObject=None):
+def socket_error(function, errno=None):
+    """
+    Returns a :class:`pywincffi.exceptions.WindowsAPIError` for the
+    windows socket ``function`` which failed, described by the system's
+    message for the error.
+
+    :param str function:
+        The function which failed.
+
+    :keyword int errno:
+        The error code.  Defaults to :func:`WSAGetLastError` for functions
+        which don't return the error themselves.
+    """
+    ffi, _ = dist.load()
+    if errno is None:
+        errno = WSAGetLastError()
+    _, message = ffi.getwinerror(errno)
+    return WindowsAPIError(function, message, errno)
+
+
+def WSAEnumNetworkEvents(socket, hEventObject=None, lpNetworkEvents=None):
     """
     Discovers occurrences of network events on the indicated ``socket``, clears
     internal events and optionally resets event objects.
@@ -98,16 +125,27 @@ def WSAEnumNetworkEvents(socket, hEventObject=None):
         https://msdn.microsoft.com/en-us/ms741572
 
     :param pywincffi.wintypes.objects.SOCKET socket:
-        The socket object to enumerate events for.
+        The socket object to enumerate events for.  A Python socket may
+        be passed instead.
 
     :keyword pywincffi.wintypes.objects.WSAEVENT hEventObject:
         An optional handle identify an associated event object
         to be reset.
 
+    :keyword pywincffi.wintypes.structures.LPWSANETWORKEVENTS lpNetworkEvents:
+        An optional structure to store the events in.  Callers which
+        enumerate events for the same socket repeatedly can pass the same
+        structure each time rather than allocating a new one.
+
     :rtype: :class:`pywincffi.wintypes.structures.LPWSANETWORKEVENTS`
     :return:
+        Returns ``lpNetworkEvents``, or a new structure if it was not
+        provided, containing the network events which occurred.
     """
-    input_check("socket", socket, allowed_types=(SOCKET, ))
+    socket = _as_socket("socket", socket)
+    input_check(
+        "lpNetworkEvents", lpNetworkEvents,
+        allowed_types=(LPWSANETWORKEVENTS, NoneType))
 
     ffi, library = dist.load()
     if hEventObject is not None:
@@ -116,12 +154,16 @@ def WSAEnumNetworkEvents(socket, hEventObject=None):
     else:
         hEventObject = ffi.NULL
 
-    lpNetworkEvents = LPWSANETWORKEVENTS()
+    if lpNetworkEvents is None:
+        lpNetworkEvents = LPWSANETWORKEVENTS()
+
     code = library.WSAEnumNetworkEvents(
         wintype_to_cdata(socket),
         hEventObject,
         wintype_to_cdata(lpNetworkEvents)
     )
-    error_check("WSAEnumNetworkEvents", code=code, expected=0)
+
+    if code == library.SOCKET_ERROR:
+        raise socket_error("WSAEnumNetworkEvents")
 
     return lpNetworkEvents
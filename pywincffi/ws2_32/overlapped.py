@@ -0,0 +1,674 @@
+"""
+Overlapped Sockets
+------------------
+
+A module containing Windows functions for asynchronous socket I/O.
+:func:`WSARecv` and :func:`WSASend` scatter and gather through a
+:class:`WSABufArray` while :func:`AcceptEx` and :func:`ConnectEx` call the
+Winsock extension functions, which are looked up once with
+``WSAIoctl(SIO_GET_EXTENSION_FUNCTION_POINTER)`` and cached.
+:class:`SocketBufferPool` recycles the buffers and ``OVERLAPPED``
+structures these operations need.
+"""
+
+import socket as _socket
+import struct
+from collections import deque
+
+from six import integer_types, binary_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NoneType, input_check
+from pywincffi.exceptions import InputError
+from pywincffi.wintypes import SOCKET, OVERLAPPED, wintype_to_cdata
+from pywincffi.ws2_32.events import WSAGetLastError, socket_error
+
+# The GUID of each extension function and the type of its pointer
+EXTENSION_FUNCTIONS = {
+    "AcceptEx": (
+        "LPFN_ACCEPTEX",
+        (0xb5367df1, 0xcbac, 0x11cf,
+         (0x95, 0xca, 0x00, 0x80, 0x5f, 0x48, 0xa1, 0x92))),
+    "ConnectEx": (
+        "LPFN_CONNECTEX",
+        (0x25a207b9, 0xddf3, 0x4660,
+         (0x8e, 0xe9, 0x76, 0xe5, 0x8c, 0x74, 0x06, 0x3e))),
+}
+
+# Extension function pointers which have already been looked up.  The
+# pointers are the same for every socket of the default provider.
+_extensions = {}
+
+# The space AcceptEx needs for each address, sizeof(SOCKADDR_IN6) + 16
+ACCEPTEX_ADDRESS_LENGTH = 44
+
+
+def _socket_error(function, ignore_pending=False):
+    # Raises the error for a function which returned SOCKET_ERROR.  If
+    # `ignore_pending` is True and the operation is still in progress
+    # the error is cleared instead.
+    _, library = dist.load()
+    errno = WSAGetLastError()
+    if ignore_pending and errno == library.WSA_IO_PENDING:
+        library.SetLastError(0)
+        return
+    raise socket_error(function, errno)
+
+
+def new_guid(value):
+    """
+    Returns a ``GUID *`` for ``value``, a ``(Data1, Data2, Data3, Data4)``
+    tuple such as those in :data:`EXTENSION_FUNCTIONS`.
+    """
+    ffi, _ = dist.load()
+    data1, data2, data3, data4 = value
+    guid = ffi.new("GUID *")
+    guid.Data1, guid.Data2, guid.Data3 = data1, data2, data3
+    guid.Data4 = data4
+    return guid
+
+
+class WSABufArray(object):
+    """
+    A ``WSABUF[]`` array describing the buffers :func:`WSARecv` scatters
+    into or :func:`WSASend` gathers from.  The array is only reallocated
+    when more buffers are assigned than it has room for and the buffers
+    are referenced, not copied, so they must stay alive while an
+    operation is outstanding.
+
+    >>> from pywincffi.ws2_32 import WSABufArray, WSASend
+    >>> buffers = WSABufArray([header, payload])
+    >>> while buffers.nbytes:
+    ...     buffers.consume(WSASend(sock, buffers))
+
+    :keyword list buffers:
+        The buffers to assign, see :meth:`assign`.
+
+    :keyword int capacity:
+        The number of buffers the array has room for initially.
+
+    :keyword bool writable:
+        If True every buffer must be writable, see :meth:`assign`.
+    """
+    def __init__(self, buffers=None, capacity=4, writable=False):
+        input_check("capacity", capacity, integer_types)
+        if capacity < 1:
+            raise InputError(
+                "capacity", capacity, message="Expected `capacity` >= 1")
+
+        ffi, _ = dist.load()
+        self._ffi = ffi
+        self._array = ffi.new("WSABUF[]", capacity)
+        self._capacity = capacity
+        self._references = []
+        self.first = 0
+        self.count = 0
+        self.writable = True
+        if buffers is not None:
+            self.assign(buffers, writable=writable)
+
+    def __len__(self):
+        """The number of buffers which have not been fully consumed"""
+        return self.count - self.first
+
+    @property
+    def capacity(self):
+        """The number of buffers the array currently has room for"""
+        return self._capacity
+
+    @property
+    def lpBuffers(self):
+        """A ``WSABUF *`` to the first buffer not fully consumed"""
+        return self._array + self.first
+
+    @property
+    def nbytes(self):
+        """The number of bytes remaining in the buffers"""
+        array = self._array
+        return sum(array[i].len for i in range(self.first, self.count))
+
+    def assign(self, buffers, writable=False):
+        """
+        Replaces the buffers in the array.  :attr:`writable` is set to
+        False if any of them is read-only.
+
+        :param list buffers:
+            A list or tuple of buffers.  Each one may be ``bytes``, which
+            can only be sent, or a writable object such as a ``bytearray``
+            or ``char[]`` cdata.
+
+        :keyword bool writable:
+            If True, raise :class:`pywincffi.exceptions.InputError` for
+            buffers which are read-only, such as ``bytes``.  Used for
+            buffers which :func:`WSARecv` will write to.
+        """
+        input_check("buffers", buffers, (list, tuple))
+        ffi = self._ffi
+        if len(buffers) > self._capacity:
+            self._capacity = len(buffers)
+            self._array = ffi.new("WSABUF[]", self._capacity)
+
+        references = []
+        readonly = False
+        for i, buf in enumerate(buffers):
+            if isinstance(buf, ffi.CData):
+                pointer, length = buf, ffi.sizeof(buf)
+            else:
+                try:
+                    pointer = ffi.from_buffer(buf, require_writable=True)
+                except BufferError:
+                    if writable:
+                        raise InputError(
+                            "buffers[%d]" % i, buf,
+                            message="Expected buffers[%d] to be writable" % i)
+                    pointer = ffi.from_buffer(buf)
+                    readonly = True
+                length = len(buf)
+            references.append(pointer)
+            entry = self._array[i]
+            entry.buf = ffi.cast("CHAR *", pointer)
+            entry.len = length
+
+        self._references = references
+        self.writable = not readonly
+        self.first = 0
+        self.count = len(buffers)
+        return self
+
+    def consume(self, count):
+        """
+        Advances past ``count`` bytes, such as the number of bytes a
+        partial :func:`WSASend` transferred, so the array describes only
+        what's left.  A buffer which was partially consumed is adjusted
+        in place.
+        """
+        input_check("count", count, integer_types)
+        if count < 0 or count > self.nbytes:
+            raise InputError(
+                "count", count,
+                message="Expected 0 <= `count` <= %d" % self.nbytes)
+
+        array = self._array
+        while count:
+            entry = array[self.first]
+            if count < entry.len:
+                entry.buf += count
+                entry.len -= count
+                break
+            count -= entry.len
+            self.first += 1
+
+        while self.first < self.count and array[self.first].len == 0:
+            self.first += 1
+
+
+def _buffers(lpBuffers, writable=False):
+    if isinstance(lpBuffers, WSABufArray):
+        if writable and not lpBuffers.writable:
+            raise InputError(
+                "lpBuffers", lpBuffers,
+                message="Expected `lpBuffers` to only hold writable buffers")
+        return lpBuffers
+    return WSABufArray(
+        lpBuffers, capacity=max(1, len(lpBuffers)), writable=writable)
+
+
+def WSARecv(s, lpBuffers, lpOverlapped=None, dwFlags=0):
+    """
+    Receives data from a connected socket, scattering it across one or
+    more buffers.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms741688
+
+    :param pywincffi.wintypes.SOCKET s:
+        The socket to receive from.
+
+    :param lpBuffers:
+        A :class:`WSABufArray` or a list of writable buffers.
+
+    :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        If provided, and the socket was created for overlapped I/O, the
+        receive may complete asynchronously.  Use
+        :func:`WSAGetOverlappedResult` to wait for it.
+
+    :keyword int dwFlags:
+        ``MSG_*`` flags modifying the receive.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes received, 0 if the connection was
+        closed gracefully, or ``None`` if the operation is pending.
+    """
+    input_check("s", s, SOCKET)
+    input_check("lpBuffers", lpBuffers, (WSABufArray, list, tuple))
+    input_check("lpOverlapped", lpOverlapped, (NoneType, OVERLAPPED))
+    input_check("dwFlags", dwFlags, integer_types)
+
+    ffi, library = dist.load()
+    buffers = _buffers(lpBuffers, writable=True)
+    received = ffi.new("DWORD[1]")
+    flags = ffi.new("DWORD[1]", [dwFlags])
+    code = library.WSARecv(
+        wintype_to_cdata(s), buffers.lpBuffers, len(buffers), received,
+        flags, wintype_to_cdata(lpOverlapped), ffi.NULL)
+
+    if code == library.SOCKET_ERROR:
+        return _socket_error("WSARecv", lpOverlapped is not None)
+    return int(received[0])
+
+
+def WSASend(s, lpBuffers, lpOverlapped=None, dwFlags=0):
+    """
+    Sends data on a connected socket, gathering it from one or more
+    buffers.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms742203
+
+    :param pywincffi.wintypes.SOCKET s:
+        The socket to send on.
+
+    :param lpBuffers:
+        A :class:`WSABufArray` or a list of buffers.  Passing a
+        :class:`WSABufArray` allows a partial send to be resumed with
+        :meth:`WSABufArray.consume`.
+
+    :keyword pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        If provided, and the socket was created for overlapped I/O, the
+        send may complete asynchronously.
+
+    :keyword int dwFlags:
+        ``MSG_*`` flags modifying the send.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes sent or ``None`` if the operation is
+        pending.
+    """
+    input_check("s", s, SOCKET)
+    input_check("lpBuffers", lpBuffers, (WSABufArray, list, tuple))
+    input_check("lpOverlapped", lpOverlapped, (NoneType, OVERLAPPED))
+    input_check("dwFlags", dwFlags, integer_types)
+
+    ffi, library = dist.load()
+    buffers = _buffers(lpBuffers)
+    sent = ffi.new("DWORD[1]")
+    code = library.WSASend(
+        wintype_to_cdata(s), buffers.lpBuffers, len(buffers), sent,
+        dwFlags, wintype_to_cdata(lpOverlapped), ffi.NULL)
+
+    if code == library.SOCKET_ERROR:
+        return _socket_error("WSASend", lpOverlapped is not None)
+    return int(sent[0])
+
+
+def WSAGetOverlappedResult(s, lpOverlapped, fWait=True):
+    """
+    Retrieves the result of an overlapped operation on ``s``.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms741568
+
+    :param pywincffi.wintypes.SOCKET s:
+        The socket the operation was started on.
+
+    :param pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        The structure passed to the operation.
+
+    :keyword bool fWait:
+        If True, the default, wait for the operation to complete.
+        Otherwise a pending operation raises
+        :class:`pywincffi.exceptions.WindowsAPIError` with
+        ``WSA_IO_INCOMPLETE``.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes transferred.
+    """
+    input_check("s", s, SOCKET)
+    input_check("lpOverlapped", lpOverlapped, OVERLAPPED)
+    input_check("fWait", fWait, allowed_values=(True, False))
+
+    ffi, library = dist.load()
+    transferred = ffi.new("DWORD[1]")
+    flags = ffi.new("DWORD[1]")
+    code = library.WSAGetOverlappedResult(
+        wintype_to_cdata(s), wintype_to_cdata(lpOverlapped), transferred,
+        fWait, flags)
+
+    if not code:
+        raise socket_error("WSAGetOverlappedResult")
+    return int(transferred[0])
+
+
+def WSAIoctl(s, dwIoControlCode, lpvInBuffer, lpvOutBuffer):
+    """
+    Controls the mode of a socket synchronously.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms741621
+
+    :param pywincffi.wintypes.SOCKET s:
+        The socket to control.
+
+    :param int dwIoControlCode:
+        The ``SIO_*`` control code.
+
+    :param lpvInBuffer:
+        A cdata pointer to the input, or ``None``.
+
+    :param lpvOutBuffer:
+        A cdata pointer the output is written to, or ``None``.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes written to ``lpvOutBuffer``.
+    """
+    input_check("s", s, SOCKET)
+    input_check("dwIoControlCode", dwIoControlCode, integer_types)
+
+    ffi, library = dist.load()
+    returned = ffi.new("DWORD[1]")
+    if lpvInBuffer is None:
+        lpvInBuffer, cbInBuffer = ffi.NULL, 0
+    else:
+        cbInBuffer = ffi.sizeof(ffi.typeof(lpvInBuffer).item)
+    if lpvOutBuffer is None:
+        lpvOutBuffer, cbOutBuffer = ffi.NULL, 0
+    else:
+        cbOutBuffer = ffi.sizeof(ffi.typeof(lpvOutBuffer).item)
+
+    code = library.WSAIoctl(
+        wintype_to_cdata(s), dwIoControlCode, lpvInBuffer, cbInBuffer,
+        lpvOutBuffer, cbOutBuffer, returned, ffi.NULL, ffi.NULL)
+
+    if code == library.SOCKET_ERROR:
+        _socket_error("WSAIoctl")
+    return int(returned[0])
+
+
+def get_extension_function(s, name):
+    """
+    Returns the pointer to the Winsock extension function ``name``, such
+    as ``"AcceptEx"``, looking it up with ``WSAIoctl`` the first time it's
+    requested.
+
+    :param pywincffi.wintypes.SOCKET s:
+        Any socket of the provider the function is looked up for.
+
+    :param str name:
+        A key of :data:`EXTENSION_FUNCTIONS`.
+    """
+    try:
+        return _extensions[name]
+    except KeyError:
+        pass
+
+    input_check("name", name, allowed_values=tuple(EXTENSION_FUNCTIONS))
+    ffi, library = dist.load()
+    ctype, value = EXTENSION_FUNCTIONS[name]
+    pointer = ffi.new(ctype + " *")
+    WSAIoctl(
+        s, library.SIO_GET_EXTENSION_FUNCTION_POINTER, new_guid(value),
+        pointer)
+
+    function = _extensions[name] = pointer[0]
+    return function
+
+
+def sockaddr(family, address):
+    """
+    Packs ``address``, in the form the :mod:`socket` module uses, into
+    the ``SOCKADDR_IN`` or ``SOCKADDR_IN6`` structure Windows expects.
+
+    :param int family:
+        ``AF_INET`` or ``AF_INET6``.
+
+    :param tuple address:
+        ``(host, port)`` or, for ``AF_INET6``, ``(host, port, flowinfo,
+        scope_id)`` where the last two are optional.
+
+    :rtype: bytes
+    """
+    input_check("address", address, tuple)
+    if family == _socket.AF_INET:
+        host, port = address
+        return struct.pack("<H", family) + struct.pack(">H", port) + \
+            _socket.inet_aton(host) + b"\x00" * 8
+
+    if family == getattr(_socket, "AF_INET6", None):
+        host, port, flowinfo, scope_id = (tuple(address) + (0, 0))[:4]
+        return struct.pack("<H", family) + \
+            struct.pack(">HI", port, flowinfo) + \
+            _socket.inet_pton(family, host) + struct.pack("<I", scope_id)
+
+    raise InputError(
+        "family", family, message="Expected AF_INET or AF_INET6")
+
+
+def AcceptEx(sListenSocket, sAcceptSocket, lpOutputBuffer, lpOverlapped,
+             dwReceiveDataLength=0,
+             dwAddressLength=ACCEPTEX_ADDRESS_LENGTH):
+    """
+    Accepts a connection on ``sListenSocket`` into the unconnected
+    ``sAcceptSocket`` and, optionally, receives the first block of data.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms737524
+
+    :param pywincffi.wintypes.SOCKET sListenSocket:
+        The listening socket.
+
+    :param pywincffi.wintypes.SOCKET sAcceptSocket:
+        A socket which is not bound or connected.  Once the operation
+        completes it should be passed to ``setsockopt`` with
+        ``SO_UPDATE_ACCEPT_CONTEXT``.
+
+    :param lpOutputBuffer:
+        A ``char[]`` cdata buffer of at least ``dwReceiveDataLength`` plus
+        twice ``dwAddressLength`` bytes, such as
+        :attr:`SocketBuffer.buffer`.
+
+    :param pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        The structure the operation completes through.
+
+    :keyword int dwReceiveDataLength:
+        The number of bytes of ``lpOutputBuffer`` used for data.  0, the
+        default, completes as soon as a connection arrives.
+
+    :keyword int dwAddressLength:
+        The number of bytes reserved for each of the local and remote
+        addresses.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes received or ``None`` if the operation
+        is pending.
+    """
+    input_check("sListenSocket", sListenSocket, SOCKET)
+    input_check("sAcceptSocket", sAcceptSocket, SOCKET)
+    input_check("lpOverlapped", lpOverlapped, OVERLAPPED)
+    input_check("dwReceiveDataLength", dwReceiveDataLength, integer_types)
+    input_check("dwAddressLength", dwAddressLength, integer_types)
+
+    ffi, _ = dist.load()
+    if ffi.sizeof(lpOutputBuffer) < \
+            dwReceiveDataLength + 2 * dwAddressLength:
+        raise InputError(
+            "lpOutputBuffer", lpOutputBuffer,
+            message="Expected at least %d bytes" % (
+                dwReceiveDataLength + 2 * dwAddressLength))
+
+    function = get_extension_function(sListenSocket, "AcceptEx")
+    received = ffi.new("DWORD[1]")
+    if not function(
+            wintype_to_cdata(sListenSocket), wintype_to_cdata(sAcceptSocket),
+            lpOutputBuffer, dwReceiveDataLength, dwAddressLength,
+            dwAddressLength, received, wintype_to_cdata(lpOverlapped)):
+        return _socket_error("AcceptEx", ignore_pending=True)
+    return int(received[0])
+
+
+def ConnectEx(s, family, address, lpOverlapped, lpSendBuffer=None):
+    """
+    Connects the bound socket ``s`` to ``address`` and, optionally, sends
+    the first block of data.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms737606
+
+    :param pywincffi.wintypes.SOCKET s:
+        A socket which is bound, for example to ``("0.0.0.0", 0)``, but
+        not connected.  Once the operation completes it should be passed
+        to ``setsockopt`` with ``SO_UPDATE_CONNECT_CONTEXT``.
+
+    :param int family:
+        The address family of ``s``.
+
+    :param tuple address:
+        The address to connect to, see :func:`sockaddr`.
+
+    :param pywincffi.wintypes.OVERLAPPED lpOverlapped:
+        The structure the operation completes through.
+
+    :keyword lpSendBuffer:
+        Data to send once connected.
+
+    :rtype: int
+    :returns:
+        Returns the number of bytes sent or ``None`` if the operation is
+        pending.
+    """
+    input_check("s", s, SOCKET)
+    input_check("lpOverlapped", lpOverlapped, OVERLAPPED)
+    input_check(
+        "lpSendBuffer", lpSendBuffer, (NoneType, binary_type, bytearray))
+
+    ffi, _ = dist.load()
+    name = sockaddr(family, address)
+    if lpSendBuffer:
+        send_buffer, send_length = \
+            ffi.from_buffer(lpSendBuffer), len(lpSendBuffer)
+    else:
+        send_buffer, send_length = ffi.NULL, 0
+
+    function = get_extension_function(s, "ConnectEx")
+    sent = ffi.new("DWORD[1]")
+    if not function(
+            wintype_to_cdata(s), ffi.cast("struct sockaddr *",
+                                          ffi.from_buffer(name)),
+            len(name), send_buffer, send_length, sent,
+            wintype_to_cdata(lpOverlapped)):
+        return _socket_error("ConnectEx", ignore_pending=True)
+    return int(sent[0])
+
+
+class SocketBuffer(object):  # pylint: disable=too-few-public-methods
+    """
+    A buffer handed out by :class:`SocketBufferPool` along with a
+    :class:`WSABufArray` describing it and an ``OVERLAPPED`` structure for
+    the operation using it.
+    """
+    __slots__ = ("buffer", "buffers", "lpOverlapped")
+
+    def __init__(self, ffi, size):
+        self.buffer = ffi.new("char[]", size)
+        self.buffers = WSABufArray([self.buffer], capacity=1)
+        self.lpOverlapped = OVERLAPPED()
+
+    def data(self, count):
+        """Returns the first ``count`` bytes of the buffer"""
+        ffi, _ = dist.load()
+        return ffi.buffer(self.buffer, count)[:]
+
+
+class SocketBufferPool(object):
+    """
+    A pool of :class:`SocketBuffer` objects, so a server handling many
+    overlapped receives, sends and accepts does not allocate a buffer and
+    an ``OVERLAPPED`` for each one.
+
+    >>> from pywincffi.ws2_32 import SocketBufferPool, WSARecv
+    >>> pool = SocketBufferPool(buffer_size=16384)
+    >>> buf = pool.acquire()
+    >>> WSARecv(sock, buf.buffers, lpOverlapped=buf.lpOverlapped)
+    >>> ...
+    >>> pool.release(buf)
+
+    :keyword int buffer_size:
+        The size of each buffer in bytes.
+
+    :keyword int maximum:
+        The maximum number of idle buffers kept by the pool.  Buffers
+        released while the pool is full are discarded.
+    """
+    def __init__(self, buffer_size=65536, maximum=64):
+        input_check("buffer_size", buffer_size, integer_types)
+        input_check("maximum", maximum, integer_types)
+        if buffer_size < 1:
+            raise InputError(
+                "buffer_size", buffer_size,
+                message="Expected `buffer_size` >= 1")
+
+        self.buffer_size = buffer_size
+        self.maximum = maximum
+        self.created = 0
+        self._idle = deque()
+
+    def __len__(self):
+        return len(self._idle)
+
+    def acquire(self):
+        """
+        Returns a :class:`SocketBuffer` whose ``WSABUF`` spans the whole
+        buffer and whose ``OVERLAPPED`` has been zeroed, except for
+        ``hEvent``.
+        """
+        try:
+            buf = self._idle.pop()
+        except IndexError:
+            ffi, _ = dist.load()
+            self.created += 1
+            return SocketBuffer(ffi, self.buffer_size)
+
+        buf.buffers.assign([buf.buffer])
+        lpOverlapped = buf.lpOverlapped
+        lpOverlapped.Internal = lpOverlapped.InternalHigh = 0
+        lpOverlapped.Offset = lpOverlapped.OffsetHigh = 0
+        return buf
+
+    def release(self, buf):
+        """
+        Returns ``buf`` to the pool.  The operation using it must have
+        completed before it's released.
+        """
+        input_check("buf", buf, SocketBuffer)
+        if len(self._idle) < self.maximum:
+            self._idle.append(buf)
+
+    def buffer(self):
+        """
+        A context manager which acquires a buffer and releases it on
+        exit.
+        """
+        return _PooledBuffer(self)
+
+
+class _PooledBuffer(object):  # pylint: disable=too-few-public-methods
+    """Context manager returned by :meth:`SocketBufferPool.buffer`"""
+    def __init__(self, pool):
+        self.pool = pool
+        self.buf = pool.acquire()
+
+    def __enter__(self):
+        return self.buf
+
+    def __exit__(self, *_):
+        self.pool.release(self.buf)
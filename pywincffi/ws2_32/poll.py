@@ -0,0 +1,271 @@
+"""
+Polling
+-------
+
+A module containing Windows functions for waiting on sockets with
+``WSAPoll`` and on socket events with ``WSAWaitForMultipleEvents``.
+:class:`PollSet` keeps the ``WSAPOLLFD`` array ``WSAPoll`` reads between
+calls so sockets can be added, changed and removed in constant time.
+"""
+
+import time
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NoneType, input_check
+from pywincffi.exceptions import InputError
+from pywincffi.wintypes import HANDLE, SOCKET, wintype_to_cdata
+from pywincffi.ws2_32.events import socket_error
+
+
+def WSAPoll(fdArray, fds=None, timeout=-1):
+    """
+    Determines the status of one or more sockets.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms741669
+
+    :param fdArray:
+        A ``WSAPOLLFD[]`` array created with ``ffi.new()``.  The
+        ``revents`` member of each entry is set when this function
+        returns.
+
+    :keyword int fds:
+        The number of entries in ``fdArray`` to poll.  Defaults to the
+        length of ``fdArray``.
+
+    :keyword int timeout:
+        The number of milliseconds to wait.  A negative value, the
+        default, waits forever and 0 returns immediately.
+
+    :rtype: int
+    :returns:
+        Returns the number of entries in ``fdArray`` with a non-zero
+        ``revents``, 0 if the timeout elapsed.
+    """
+    ffi, library = dist.load()
+    if fds is None:
+        fds = len(fdArray)
+
+    input_check("fds", fds, integer_types)
+    input_check("timeout", timeout, integer_types)
+
+    code = library.WSAPoll(fdArray, fds, timeout)
+    if code == library.SOCKET_ERROR:
+        raise socket_error("WSAPoll")
+
+    return code
+
+
+def WSAWaitForMultipleEvents(
+        lphEvents, fWaitAll=False, dwTimeout=None, fAlertable=False):
+    """
+    Waits until one or all of the event objects in ``lphEvents`` are
+    signaled, the timeout elapses or, if ``fAlertable`` is True, an I/O
+    completion routine runs.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/ms742219
+
+    :param list lphEvents:
+        A list or tuple of up to ``WSA_MAXIMUM_WAIT_EVENTS``
+        :class:`pywincffi.wintypes.WSAEVENT` objects.
+
+    :keyword bool fWaitAll:
+        If True wait for all of the events to be signaled rather than
+        any one of them.
+
+    :keyword int dwTimeout:
+        The number of milliseconds to wait.  Defaults to
+        ``WSA_INFINITE``.
+
+    :keyword bool fAlertable:
+        If True return ``WSA_WAIT_IO_COMPLETION`` when an I/O completion
+        routine is run by this thread.
+
+    :raises WindowsAPIError:
+        Raised if the function returns ``WSA_WAIT_FAILED``.
+
+    :rtype: int
+    :returns:
+        Returns ``WSA_WAIT_EVENT_0`` plus the index of the event which was
+        signaled, ``WSA_WAIT_TIMEOUT`` or ``WSA_WAIT_IO_COMPLETION``.
+    """
+    ffi, library = dist.load()
+    input_check("lphEvents", lphEvents, (list, tuple))
+    input_check("fWaitAll", fWaitAll, bool)
+    input_check("fAlertable", fAlertable, bool)
+
+    if dwTimeout is None:
+        dwTimeout = library.WSA_INFINITE
+    input_check("dwTimeout", dwTimeout, integer_types)
+
+    events = ffi.new("WSAEVENT[]", len(lphEvents))
+    for i, event in enumerate(lphEvents):
+        input_check("lphEvents[%d]" % i, event, HANDLE)
+        events[i] = wintype_to_cdata(event)
+
+    code = library.WSAWaitForMultipleEvents(
+        len(lphEvents), events, fWaitAll, dwTimeout, fAlertable)
+
+    if code == library.WSA_WAIT_FAILED:
+        raise socket_error("WSAWaitForMultipleEvents")
+
+    return code
+
+
+class PollSet(object):
+    """
+    A set of sockets polled together with :func:`WSAPoll`.  The sockets
+    are stored in a ``WSAPOLLFD[]`` array which is only reallocated when
+    it needs to grow, doubling in size, so :meth:`register`,
+    :meth:`modify` and :meth:`unregister` take constant time and
+    :meth:`poll` does not allocate any cdata.
+
+    >>> from pywincffi.wintypes import socket_from_object
+    >>> from pywincffi.ws2_32 import PollSet
+    >>> sockets = PollSet()
+    >>> sockets.register(socket_from_object(client), library.POLLRDNORM)
+    >>> for sock, revents in sockets.poll(1000):
+    ...     handle_ready(sock, revents)
+
+    :keyword int capacity:
+        The number of sockets the array has room for initially.
+    """
+    def __init__(self, capacity=64):
+        input_check("capacity", capacity, integer_types)
+        if capacity < 1:
+            raise InputError(
+                "capacity", capacity, message="Expected `capacity` >= 1")
+
+        ffi, _ = dist.load()
+        self._ffi = ffi
+        self._fds = ffi.new("WSAPOLLFD[]", capacity)
+        self._capacity = capacity
+        self._sockets = []
+        self._indexes = {}
+
+    def __len__(self):
+        """The number of registered sockets"""
+        return len(self._sockets)
+
+    @property
+    def capacity(self):
+        """The number of sockets the array currently has room for"""
+        return self._capacity
+
+    @staticmethod
+    def _key(socket):
+        return int(wintype_to_cdata(socket))
+
+    def _index(self, socket):
+        input_check("socket", socket, SOCKET)
+        try:
+            return self._indexes[self._key(socket)]
+        except KeyError:
+            raise InputError(
+                "socket", socket, message="The socket is not registered")
+
+    def _grow(self):
+        capacity = self._capacity * 2
+        fds = self._ffi.new("WSAPOLLFD[]", capacity)
+        self._ffi.memmove(
+            fds, self._fds, self._ffi.sizeof("WSAPOLLFD") * len(self))
+        self._fds = fds
+        self._capacity = capacity
+
+    def register(self, socket, events):
+        """
+        Adds ``socket`` to the set.
+
+        :param pywincffi.wintypes.SOCKET socket:
+            The socket to poll.
+
+        :param int events:
+            The ``POLL*`` flags to poll for, such as ``POLLRDNORM``.
+        """
+        input_check("socket", socket, SOCKET)
+        input_check("events", events, integer_types)
+        key = self._key(socket)
+        if key in self._indexes:
+            raise InputError(
+                "socket", socket, message="The socket is already registered")
+
+        index = len(self._sockets)
+        if index == self._capacity:
+            self._grow()
+
+        entry = self._fds[index]
+        entry.fd = wintype_to_cdata(socket)
+        entry.events = events
+        entry.revents = 0
+        self._sockets.append(socket)
+        self._indexes[key] = index
+
+    def modify(self, socket, events):
+        """Changes the ``POLL*`` flags ``socket`` is polled for"""
+        input_check("events", events, integer_types)
+        self._fds[self._index(socket)].events = events
+
+    def unregister(self, socket):
+        """
+        Removes ``socket`` from the set.  The last socket in the array is
+        moved into its place.
+        """
+        index = self._index(socket)
+        del self._indexes[self._key(socket)]
+        last = len(self._sockets) - 1
+        moved = self._sockets.pop()
+
+        if index != last:
+            self._fds[index] = self._fds[last]
+            self._sockets[index] = moved
+            self._indexes[self._key(moved)] = index
+
+    def poll(self, timeout=-1):
+        """
+        Polls every registered socket.
+
+        :keyword int timeout:
+            The number of milliseconds to wait, see :func:`WSAPoll`.
+
+        :rtype: list
+        :returns:
+            Returns a list of ``(socket, revents)`` tuples for each socket
+            which is ready, in the order they're stored.  ``WSAPoll``
+            rejects an empty array so an empty set sleeps for ``timeout``
+            instead, which keeps a polling loop from spinning, and then
+            returns an empty list.
+
+        :raises InputError:
+            Raised if the set is empty and ``timeout`` is negative since
+            nothing could end the wait.
+        """
+        input_check("timeout", timeout, (NoneType, ) + integer_types)
+        if timeout is None:
+            timeout = -1
+
+        count = len(self._sockets)
+        if count:
+            ready = WSAPoll(self._fds, count, timeout)
+        elif timeout < 0:
+            raise InputError(
+                "timeout", timeout,
+                message="Polling an empty set without a timeout would "
+                        "wait forever")
+        else:
+            time.sleep(timeout / 1000.0)
+            ready = 0
+
+        results = []
+        fds = self._fds
+        for index in range(count):
+            if len(results) == ready:
+                break
+            revents = fds[index].revents
+            if revents:
+                results.append((self._sockets[index], revents))
+        return results
@@ -0,0 +1,360 @@
+"""
+Socket Reactor
+--------------
+
+A module which dispatches network events for many sockets to callbacks.
+:class:`SocketReactor` associates each socket with its own event using
+:func:`pywincffi.ws2_32.WSAEventSelect`, waits on the events with
+``MsgWaitForMultipleObjects`` and decodes the results of
+:func:`pywincffi.ws2_32.WSAEnumNetworkEvents` into one callback per
+network event.
+"""
+
+
+from six import integer_types
+
+from pywincffi.core import dist
+from pywincffi.core.checks import NoneType, input_check
+from pywincffi.core.compat import monotonic
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.handle import CloseHandle
+from pywincffi.wintypes import (
+    SOCKET, LPWSANETWORKEVENTS, wintype_to_cdata)
+from pywincffi.ws2_32.events import (
+    WSACreateEvent, WSAEnumNetworkEvents, WSAEventSelect)
+
+# The order network events are dispatched in.  FD_READ comes before
+# FD_CLOSE so any data which arrived before the connection closed can be
+# read first.
+DISPATCH_ORDER = (
+    ("FD_ACCEPT", "FD_ACCEPT_BIT"),
+    ("FD_CONNECT", "FD_CONNECT_BIT"),
+    ("FD_READ", "FD_READ_BIT"),
+    ("FD_OOB", "FD_OOB_BIT"),
+    ("FD_WRITE", "FD_WRITE_BIT"),
+    ("FD_CLOSE", "FD_CLOSE_BIT"),
+)
+
+
+def decode_network_events(lpNetworkEvents):
+    """
+    Decodes a ``WSANETWORKEVENTS`` structure into a list of
+    ``(event, error)`` tuples, one for each ``FD_*`` bit which is set, in
+    the order :class:`SocketReactor` dispatches them.  ``error`` is the
+    matching entry of ``iErrorCode``, zero if the event succeeded.
+
+    :param lpNetworkEvents:
+        A :class:`pywincffi.wintypes.LPWSANETWORKEVENTS` or the structure
+        it wraps.
+    """
+    _, library = dist.load()
+    if isinstance(lpNetworkEvents, LPWSANETWORKEVENTS):
+        lpNetworkEvents = wintype_to_cdata(lpNetworkEvents)
+
+    network_events = lpNetworkEvents.lNetworkEvents
+    decoded = []
+    for event, bit in DISPATCH_ORDER:
+        event = getattr(library, event)
+        if network_events & event:
+            decoded.append(
+                (event, lpNetworkEvents.iErrorCode[getattr(library, bit)]))
+    return decoded
+
+
+class _Registration(object):  # pylint: disable=too-few-public-methods
+    """A socket registered with :class:`SocketReactor`"""
+    __slots__ = (
+        "socket", "event", "events", "callback", "lpNetworkEvents", "group",
+        "index")
+
+    def __init__(self, socket, event, events, callback):
+        self.socket = socket
+        self.event = event
+        self.events = events
+        self.callback = callback
+        self.lpNetworkEvents = LPWSANETWORKEVENTS()
+        self.group = None
+        self.index = None
+
+
+class _WaitGroup(object):  # pylint: disable=too-few-public-methods
+    """
+    Up to ``MAXIMUM_WAIT_OBJECTS - 1`` events which are waited on with a
+    single call.  The handle array is kept between calls.
+    """
+    __slots__ = ("handles", "registrations")
+
+    def __init__(self, ffi, size):
+        self.handles = ffi.new("HANDLE[]", size)
+        self.registrations = []
+
+
+class SocketReactor(object):
+    """
+    Waits for network events on any number of sockets and dispatches each
+    one to a callback.  Every registered socket gets its own event so
+    sockets are waited on in groups of up to ``MAXIMUM_WAIT_OBJECTS - 1``,
+    the most ``MsgWaitForMultipleObjects`` accepts since it also waits on
+    the thread's message queue.
+    Each socket also keeps the ``WSANETWORKEVENTS`` structure its events
+    are enumerated into so dispatching does not allocate.
+
+    >>> from pywincffi.wintypes import socket_from_object
+    >>> from pywincffi.ws2_32 import SocketReactor
+    >>> reactor = SocketReactor()
+    >>> def on_event(sock, event, error):
+    ...     if event == library.FD_ACCEPT:
+    ...         accept_client(server)
+    >>> reactor.register(
+    ...     socket_from_object(server), library.FD_ACCEPT, on_event)
+    >>> while True:
+    ...     reactor.poll()
+
+    :keyword int dwWakeMask:
+        Passed to ``MsgWaitForMultipleObjects`` so :meth:`poll` also
+        returns when input of the given types, such as ``QS_ALLINPUT``,
+        arrives in the thread's message queue.  Defaults to 0 which only
+        waits for network events.
+
+    :keyword int slice_ms:
+        When more than ``MAXIMUM_WAIT_OBJECTS - 1`` sockets are registered
+        the groups are waited on in turn for at most this many milliseconds
+        each.
+    """
+    def __init__(self, dwWakeMask=0, slice_ms=10):
+        input_check("dwWakeMask", dwWakeMask, integer_types)
+        input_check("slice_ms", slice_ms, integer_types)
+        ffi, library = dist.load()
+        self.dwWakeMask = dwWakeMask
+        self.slice_ms = slice_ms
+        self.group_size = library.MAXIMUM_WAIT_OBJECTS - 1
+        self._ffi = ffi
+        self._registrations = {}
+        self._groups = []
+        self._next_group = 0
+
+    def __len__(self):
+        """The number of registered sockets"""
+        return len(self._registrations)
+
+    @staticmethod
+    def _key(socket):
+        return int(wintype_to_cdata(socket))
+
+    def register(self, socket, events, callback):
+        """
+        Starts dispatching ``events`` which occur on ``socket`` to
+        ``callback``.  Like ``WSAEventSelect`` this puts the socket into
+        non-blocking mode.
+
+        :param pywincffi.wintypes.SOCKET socket:
+            The socket to register.
+
+        :param int events:
+            A bitmask of the ``FD_*`` events to dispatch.
+
+        :param callback:
+            Called as ``callback(socket, event, error)`` for each event,
+            where ``event`` is a single ``FD_*`` value and ``error`` is the
+            matching entry of ``iErrorCode``.
+        """
+        input_check("socket", socket, SOCKET)
+        input_check("events", events, integer_types)
+        key = self._key(socket)
+        if key in self._registrations:
+            raise InputError(
+                "socket", socket, message="The socket is already registered")
+
+        event = WSACreateEvent()
+        try:
+            WSAEventSelect(socket, event, events)
+        except WindowsAPIError:
+            CloseHandle(event)
+            raise
+
+        registration = _Registration(socket, event, events, callback)
+        self._registrations[key] = registration
+        self._add(registration)
+
+    def modify(self, socket, events, callback=None):
+        """
+        Changes the ``events`` dispatched for ``socket`` and, if provided,
+        the ``callback`` they're dispatched to.
+        """
+        input_check("events", events, integer_types)
+        registration = self._get(socket)
+        WSAEventSelect(socket, registration.event, events)
+        registration.events = events
+        if callback is not None:
+            registration.callback = callback
+
+    def unregister(self, socket):
+        """
+        Stops dispatching events for ``socket`` and closes its event.  The
+        socket itself is left open, and in non-blocking mode.
+        """
+        registration = self._get(socket)
+        del self._registrations[self._key(socket)]
+        self._remove(registration)
+        try:
+            WSAEventSelect(socket, registration.event, 0)
+        finally:
+            CloseHandle(registration.event)
+
+    def close(self):
+        """Unregisters every socket"""
+        for registration in list(self._registrations.values()):
+            self.unregister(registration.socket)
+
+    def _get(self, socket):
+        input_check("socket", socket, SOCKET)
+        try:
+            return self._registrations[self._key(socket)]
+        except KeyError:
+            raise InputError(
+                "socket", socket, message="The socket is not registered")
+
+    def _add(self, registration):
+        if not self._groups or \
+                len(self._groups[-1].registrations) == self.group_size:
+            self._groups.append(_WaitGroup(self._ffi, self.group_size))
+
+        group = self._groups[-1]
+        registration.group = group
+        registration.index = len(group.registrations)
+        group.handles[registration.index] = wintype_to_cdata(
+            registration.event)
+        group.registrations.append(registration)
+
+    def _remove(self, registration):
+        # The last registration in the last group fills the hole so every
+        # group except the last one stays full.
+        group, index = registration.group, registration.index
+        last_group = self._groups[-1]
+        last = last_group.registrations.pop()
+        if last is not registration:
+            last.group, last.index = group, index
+            group.registrations[index] = last
+            group.handles[index] = last_group.handles[
+                len(last_group.registrations)]
+
+        if not last_group.registrations:
+            self._groups.pop()
+        registration.group = registration.index = None
+
+    def _wait(self, group, start, dwMilliseconds):
+        # Returns the index of the first signaled event in the group at or
+        # after `start`, None on timeout or -1 if input arrived.
+        _, library = dist.load()
+        count = len(group.registrations) - start
+        code = library.MsgWaitForMultipleObjects(
+            count, group.handles + start, False, dwMilliseconds,
+            self.dwWakeMask)
+
+        if code == library.WAIT_FAILED:
+            errno, message = self._ffi.getwinerror()
+            raise WindowsAPIError("MsgWaitForMultipleObjects", message, errno)
+        if code == library.WAIT_TIMEOUT:
+            return None
+
+        index = code - library.WAIT_OBJECT_0
+        if index == count:
+            return -1
+        return start + index
+
+    def _signaled(self, group, first=None):
+        # MsgWaitForMultipleObjects only reports the lowest signaled index
+        # so the rest of the group is checked again, starting after it, to
+        # avoid starving sockets with higher indexes.
+        signaled = []
+        start = 0
+        if first is not None:
+            signaled.append(group.registrations[first])
+            start = first + 1
+
+        while start < len(group.registrations):
+            index = self._wait(group, start, 0)
+            if index is None or index < 0:
+                break
+            signaled.append(group.registrations[index])
+            start = index + 1
+        return signaled
+
+    def _dispatch(self, signaled):
+        dispatched = 0
+        for registration in signaled:
+            # An earlier callback may have unregistered this socket
+            if registration.group is None:
+                continue
+
+            socket = registration.socket
+            WSAEnumNetworkEvents(
+                socket, registration.event,
+                lpNetworkEvents=registration.lpNetworkEvents)
+            for event, error in decode_network_events(
+                    registration.lpNetworkEvents):
+                registration.callback(socket, event, error)
+                dispatched += 1
+        return dispatched
+
+    def poll(self, dwMilliseconds=None):
+        """
+        Waits for network events and dispatches them to their callbacks.
+
+        :keyword int dwMilliseconds:
+            The maximum number of milliseconds to wait.  Waits forever by
+            default, 0 dispatches whatever events are ready without
+            waiting.
+
+        :raises pywincffi.exceptions.InputError:
+            Raised if ``dwMilliseconds`` is not provided while no sockets
+            are registered and ``dwWakeMask`` is 0, since nothing could
+            end the wait.
+
+        :rtype: int
+        :returns:
+            Returns the number of callbacks which were called.  This is 0
+            if the wait timed out or input matching ``dwWakeMask`` arrived.
+        """
+        _, library = dist.load()
+        input_check("dwMilliseconds", dwMilliseconds,
+                    (NoneType, ) + integer_types)
+        if dwMilliseconds is None and not self._groups and \
+                not self.dwWakeMask:
+            raise InputError(
+                "dwMilliseconds", dwMilliseconds,
+                message="Expected a timeout, no sockets are registered and "
+                        "`dwWakeMask` is 0 so the wait would never end")
+        deadline = None
+        if dwMilliseconds is not None:
+            deadline = monotonic() + dwMilliseconds / 1000.0
+
+        while True:
+            signaled = []
+            for group in self._groups:
+                signaled.extend(self._signaled(group))
+            if signaled:
+                return self._dispatch(signaled)
+
+            if deadline is None:
+                remaining = library.INFINITE
+            else:
+                remaining = int(max(0, deadline - monotonic()) * 1000)
+                if remaining == 0:
+                    return 0
+
+            if len(self._groups) > 1:
+                remaining = min(remaining, self.slice_ms)
+                group = self._groups[self._next_group % len(self._groups)]
+                self._next_group += 1
+            elif self._groups:
+                group = self._groups[0]
+            else:
+                # Nothing registered, wait for input or the timeout
+                group = _WaitGroup(self._ffi, 0)
+
+            index = self._wait(group, 0, remaining)
+            if index == -1:
+                return 0
+            if index is not None:
+                return self._dispatch(self._signaled(group, first=index))
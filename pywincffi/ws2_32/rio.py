@@ -0,0 +1,600 @@
+"""
+Registered I/O
+--------------
+
+A module containing the Registered I/O (RIO) extension functions, which
+send and receive through buffers registered with Windows ahead of time so
+each operation skips probing and locking the buffer.  The function table
+is looked up once with
+``WSAIoctl(SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER)`` and cached.
+
+:class:`RIOEngine` builds on the functions, keeping a
+:class:`BufferSlab` of registered slices and dequeuing completions in
+batches.
+"""
+
+from collections import deque, namedtuple
+
+from six import integer_types, binary_type
+
+from pywincffi.core import dist
+from pywincffi.core.checks import input_check
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.memory import VirtualAlloc, VirtualFree
+from pywincffi.wintypes import SOCKET, wintype_to_cdata
+from pywincffi.ws2_32.events import socket_error
+from pywincffi.ws2_32.overlapped import WSAIoctl, new_guid
+
+WSAID_MULTIPLE_RIO = (
+    0x8509e081, 0x96dd, 0x4005,
+    (0xb1, 0x65, 0x9e, 0x2e, 0xe8, 0xc7, 0x9e, 0x3f))
+
+# Returned by RIORegisterBuffer on failure, ((RIO_BUFFERID)0xFFFFFFFF)
+RIO_INVALID_BUFFERID = 0xFFFFFFFF
+
+RIOCompletion = namedtuple(
+    "RIOCompletion", ("operation", "status", "data"))
+
+# The RIO_EXTENSION_FUNCTION_TABLE, once it has been looked up
+_functions = None
+
+
+def _invalid(ffi, value, invalid=0):
+    return int(ffi.cast("uintptr_t", value)) == invalid
+
+
+def get_rio_functions(s=None):
+    """
+    Returns the ``RIO_EXTENSION_FUNCTION_TABLE``, looking it up with
+    ``WSAIoctl`` the first time it's requested.
+
+    :keyword pywincffi.wintypes.SOCKET s:
+        Any socket, required for the first call only.
+    """
+    global _functions  # pylint: disable=global-statement
+    if _functions is not None:
+        return _functions
+
+    input_check("s", s, SOCKET)
+    ffi, library = dist.load()
+    table = ffi.new("RIO_EXTENSION_FUNCTION_TABLE *")
+    table.cbSize = ffi.sizeof("RIO_EXTENSION_FUNCTION_TABLE")
+    WSAIoctl(
+        s, library.SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER,
+        new_guid(WSAID_MULTIPLE_RIO), table)
+    _functions = table
+    return table
+
+
+def RIORegisterBuffer(DataBuffer, DataLength=None):
+    """
+    Registers a buffer for use with :func:`RIOReceive` and
+    :func:`RIOSend`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437199
+
+    :param DataBuffer:
+        A ``char[]`` cdata buffer which must stay alive until it's
+        deregistered.
+
+    :keyword int DataLength:
+        The number of bytes to register.  Defaults to the size of
+        ``DataBuffer``.
+
+    :returns:
+        Returns the ``RIO_BUFFERID`` of the registered buffer.
+    """
+    ffi, _ = dist.load()
+    if DataLength is None:
+        DataLength = ffi.sizeof(DataBuffer)
+    input_check("DataLength", DataLength, integer_types)
+
+    BufferId = get_rio_functions().RIORegisterBuffer(DataBuffer, DataLength)
+    if _invalid(ffi, BufferId, RIO_INVALID_BUFFERID):
+        raise socket_error("RIORegisterBuffer")
+    return BufferId
+
+
+def RIODeregisterBuffer(BufferId):
+    """
+    Deregisters a buffer registered with :func:`RIORegisterBuffer`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437202
+    """
+    get_rio_functions().RIODeregisterBuffer(BufferId)
+
+
+def RIOCreateCompletionQueue(QueueSize, NotificationCompletion=None):
+    """
+    Creates a completion queue for registered I/O operations.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437184
+
+    :param int QueueSize:
+        The number of completions the queue can hold.
+
+    :keyword NotificationCompletion:
+        A ``RIO_NOTIFICATION_COMPLETION *`` describing how
+        :func:`RIONotify` signals the queue.  By default the queue can
+        only be polled with :func:`RIODequeueCompletion`.
+
+    :returns:
+        Returns the ``RIO_CQ``.
+    """
+    input_check("QueueSize", QueueSize, integer_types)
+    ffi, _ = dist.load()
+    if NotificationCompletion is None:
+        NotificationCompletion = ffi.NULL
+
+    CQ = get_rio_functions().RIOCreateCompletionQueue(
+        QueueSize, NotificationCompletion)
+    if _invalid(ffi, CQ):
+        raise socket_error("RIOCreateCompletionQueue")
+    return CQ
+
+
+def RIOCloseCompletionQueue(CQ):
+    """
+    Closes a completion queue created by :func:`RIOCreateCompletionQueue`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437180
+    """
+    get_rio_functions().RIOCloseCompletionQueue(CQ)
+
+
+def RIOCreateRequestQueue(  # pylint: disable=too-many-arguments
+        Socket, MaxOutstandingReceive, MaxReceiveDataBuffers,
+        MaxOutstandingSend, MaxSendDataBuffers, ReceiveCQ, SendCQ,
+        SocketContext=0):
+    """
+    Creates the request queue of ``Socket``, which must have been created
+    with ``WSA_FLAG_REGISTERED_IO``.  The queue is closed along with the
+    socket.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437186
+
+    :param pywincffi.wintypes.SOCKET Socket:
+        The socket to create the queue for.
+
+    :param int MaxOutstandingReceive:
+        The maximum number of receives which may be outstanding.
+
+    :param int MaxReceiveDataBuffers:
+        The maximum number of buffers in each receive, currently 1.
+
+    :param int MaxOutstandingSend:
+        The maximum number of sends which may be outstanding.
+
+    :param int MaxSendDataBuffers:
+        The maximum number of buffers in each send, currently 1.
+
+    :param ReceiveCQ:
+        The ``RIO_CQ`` receives complete to.
+
+    :param SendCQ:
+        The ``RIO_CQ`` sends complete to, which may be ``ReceiveCQ``.
+
+    :keyword int SocketContext:
+        Reported in the ``SocketContext`` of each ``RIORESULT``.
+
+    :returns:
+        Returns the ``RIO_RQ``.
+    """
+    input_check("Socket", Socket, SOCKET)
+    input_check("SocketContext", SocketContext, integer_types)
+    ffi, _ = dist.load()
+    RQ = get_rio_functions().RIOCreateRequestQueue(
+        wintype_to_cdata(Socket), MaxOutstandingReceive,
+        MaxReceiveDataBuffers, MaxOutstandingSend, MaxSendDataBuffers,
+        ReceiveCQ, SendCQ, ffi.cast("PVOID", SocketContext))
+    if _invalid(ffi, RQ):
+        raise socket_error("RIOCreateRequestQueue")
+    return RQ
+
+
+def _request(function, SocketQueue, pData, DataBufferCount, Flags,
+             RequestContext):
+    input_check("DataBufferCount", DataBufferCount, integer_types)
+    input_check("Flags", Flags, integer_types)
+    input_check("RequestContext", RequestContext, integer_types)
+    ffi, _ = dist.load()
+    if pData is None:
+        pData = ffi.NULL
+
+    if not getattr(get_rio_functions(), function)(
+            SocketQueue, pData, DataBufferCount, Flags,
+            ffi.cast("PVOID", RequestContext)):
+        raise socket_error(function)
+
+
+def RIOReceive(SocketQueue, pData, DataBufferCount=1, Flags=0,
+               RequestContext=0):
+    """
+    Queues a receive into a slice of a registered buffer.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437216
+
+    :param SocketQueue:
+        The ``RIO_RQ`` of the socket.
+
+    :param pData:
+        A ``RIO_BUF *`` describing the slice to receive into, or ``None``
+        with ``RIO_MSG_COMMIT_ONLY``.
+
+    :keyword int DataBufferCount:
+        The number of ``RIO_BUF`` structures at ``pData``.
+
+    :keyword int Flags:
+        ``RIO_MSG_*`` flags.  ``RIO_MSG_DEFER`` queues the request
+        without telling the network stack until a later request without
+        it, or with ``RIO_MSG_COMMIT_ONLY``, is made.
+
+    :keyword int RequestContext:
+        Reported in the ``RequestContext`` of the ``RIORESULT``.
+    """
+    _request("RIOReceive", SocketQueue, pData, DataBufferCount, Flags,
+             RequestContext)
+
+
+def RIOSend(SocketQueue, pData, DataBufferCount=1, Flags=0,
+            RequestContext=0):
+    """
+    Queues a send from a slice of a registered buffer.  The arguments are
+    the same as :func:`RIOReceive`.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437218
+    """
+    _request("RIOSend", SocketQueue, pData, DataBufferCount, Flags,
+             RequestContext)
+
+
+def RIODequeueCompletion(CQ, Array, ArraySize=None):
+    """
+    Removes up to ``ArraySize`` completions from a completion queue.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437204
+
+    :param CQ:
+        The ``RIO_CQ`` to dequeue from.
+
+    :param Array:
+        A ``RIORESULT[]`` array the completions are written to.
+
+    :keyword int ArraySize:
+        The maximum number of completions to dequeue.  Defaults to the
+        length of ``Array``.
+
+    :rtype: int
+    :returns:
+        Returns the number of completions written to ``Array``.
+    """
+    _, library = dist.load()
+    if ArraySize is None:
+        ArraySize = len(Array)
+    input_check("ArraySize", ArraySize, integer_types)
+
+    count = get_rio_functions().RIODequeueCompletion(CQ, Array, ArraySize)
+    if count == library.RIO_CORRUPT_CQ:
+        raise WindowsAPIError(
+            "RIODequeueCompletion", "The completion queue is corrupt",
+            library.RIO_CORRUPT_CQ)
+    return count
+
+
+def RIONotify(CQ):
+    """
+    Asks for the completion queue's notification to be signaled once it
+    holds a completion.
+
+    .. seealso::
+
+        https://msdn.microsoft.com/en-us/library/hh437209
+    """
+    code = get_rio_functions().RIONotify(CQ)
+    if code != 0:
+        raise socket_error("RIONotify", code)
+
+
+class BufferSlab(object):
+    """
+    A single buffer divided into ``count`` slices of ``slice_size`` bytes
+    and registered once with :func:`RIORegisterBuffer`.  Each slice has a
+    ``RIO_BUF`` describing it which is kept between operations, so
+    handing a slice to :func:`RIOReceive` or :func:`RIOSend` does not
+    allocate.  The buffer is allocated with
+    :func:`pywincffi.kernel32.VirtualAlloc` so the registration covers
+    whole pages; call :meth:`close` to free it.
+
+    :param int slice_size:
+        The size of each slice in bytes.
+
+    :param int count:
+        The number of slices.
+    """
+    def __init__(self, slice_size, count):
+        input_check("slice_size", slice_size, integer_types)
+        input_check("count", count, integer_types)
+        if slice_size < 1 or count < 1:
+            raise InputError(
+                "count", count,
+                message="Expected `slice_size` >= 1 and `count` >= 1")
+
+        ffi, _ = dist.load()
+        self._ffi = ffi
+        self.slice_size = slice_size
+        self.count = count
+        self.size = slice_size * count
+        self.buffer = ffi.cast("char *", VirtualAlloc(None, self.size))
+        self.slices = ffi.new("RIO_BUF[]", count)
+        self.BufferId = None
+        self._free = deque(range(count))
+        self._in_use = bytearray(count)
+
+        for index in range(count):
+            self.slices[index].Offset = index * slice_size
+            self.slices[index].Length = slice_size
+
+    def __len__(self):
+        """The number of slices which are free"""
+        return len(self._free)
+
+    def register(self):
+        """Registers the buffer and points every ``RIO_BUF`` at it"""
+        self.BufferId = RIORegisterBuffer(self.buffer, self.size)
+        for index in range(self.count):
+            self.slices[index].BufferId = self.BufferId
+
+    def deregister(self):
+        """Deregisters the buffer, if it's registered"""
+        if self.BufferId is not None:
+            RIODeregisterBuffer(self.BufferId)
+            self.BufferId = None
+
+    def close(self):
+        """
+        Deregisters and frees the buffer.  Calling this more than once has
+        no effect.
+        """
+        self.deregister()
+        if self.buffer is not None:
+            VirtualFree(self.buffer)
+            self.buffer = None
+
+    def acquire(self):
+        """
+        Returns the index of a free slice or ``None`` if every slice is
+        in use.  The slice's ``Length`` is reset to ``slice_size``.
+        """
+        try:
+            index = self._free.popleft()
+        except IndexError:
+            return None
+        self._in_use[index] = 1
+        self.slices[index].Length = self.slice_size
+        return index
+
+    def release(self, index):
+        """Returns the slice ``index`` to the free list"""
+        input_check("index", index, integer_types)
+        if not 0 <= index < self.count or not self._in_use[index]:
+            raise InputError(
+                "index", index, message="The slice is not in use")
+        self._in_use[index] = 0
+        self._free.append(index)
+
+    def rio_buf(self, index):
+        """Returns the ``RIO_BUF *`` describing slice ``index``"""
+        return self.slices + index
+
+    def write(self, index, data):
+        """
+        Copies ``data`` into slice ``index`` and sets its ``Length`` so it
+        describes exactly ``data``.
+        """
+        if len(data) > self.slice_size:
+            raise InputError(
+                "data", data,
+                message="Expected at most %d bytes" % self.slice_size)
+        offset = index * self.slice_size
+        self._ffi.memmove(self.buffer + offset, data, len(data))
+        self.slices[index].Length = len(data)
+
+    def read(self, index, count):
+        """Returns a copy of the first ``count`` bytes of slice ``index``"""
+        offset = index * self.slice_size
+        return self._ffi.buffer(self.buffer + offset, count)[:]
+
+
+class RIOEngine(object):
+    """
+    Sends and receives on one socket using registered I/O.  The engine
+    owns a :class:`BufferSlab` with a slice for every receive and send
+    which may be outstanding, keeps ``receives`` receives queued at all
+    times and dequeues the completions of both from a single completion
+    queue up to ``batch`` at a time.
+
+    >>> from pywincffi.ws2_32 import RIOEngine
+    >>> engine = RIOEngine(sock, slice_size=1500, receives=256)
+    >>> while True:
+    ...     for completion in engine.dequeue():
+    ...         if completion.operation == "receive":
+    ...             handle_datagram(completion.data)
+
+    :param pywincffi.wintypes.SOCKET s:
+        A socket created with ``WSA_FLAG_REGISTERED_IO``.
+
+    :keyword int slice_size:
+        The size of each slice, the largest datagram which can be sent or
+        received.
+
+    :keyword int receives:
+        The number of receives kept outstanding.
+
+    :keyword int sends:
+        The maximum number of outstanding sends.
+
+    :keyword int batch:
+        The maximum number of completions :meth:`dequeue` handles at once.
+    """
+    RECEIVE = "receive"
+    SEND = "send"
+
+    def __init__(self, s, slice_size=2048, receives=64, sends=64, batch=64):
+        input_check("s", s, SOCKET)
+        input_check("receives", receives, integer_types)
+        input_check("sends", sends, integer_types)
+        input_check("batch", batch, integer_types)
+        ffi, _ = dist.load()
+        get_rio_functions(s)
+
+        self.s = s
+        self.batch = batch
+        self.batches = 0
+        self.completions = 0
+        self.slab = BufferSlab(slice_size, receives + sends)
+        self._results = ffi.new("RIORESULT[]", batch)
+        self._sends = sends
+        self._sending = 0
+        self._deferred = 0
+        self.CQ = None
+
+        try:
+            self.slab.register()
+            self.CQ = RIOCreateCompletionQueue(receives + sends)
+            self.RQ = RIOCreateRequestQueue(
+                s, receives, 1, sends, 1, self.CQ, self.CQ)
+            self._post_receives(
+                [self.slab.acquire() for _ in range(receives)])
+        except WindowsAPIError:
+            self.close()
+            raise
+
+    def _post_receives(self, indexes):
+        # Every receive but the last is deferred so the network stack is
+        # only told about the batch once.
+        _, library = dist.load()
+        last = len(indexes) - 1
+        for i, index in enumerate(indexes):
+            try:
+                RIOReceive(
+                    self.RQ, self.slab.rio_buf(index),
+                    Flags=library.RIO_MSG_DEFER if i < last else 0,
+                    RequestContext=index << 1)
+            except Exception:
+                # The slices which were not queued would never complete
+                for unposted in indexes[i:]:
+                    self.slab.release(unposted)
+                raise
+
+    def send(self, data, defer=False):
+        """
+        Copies ``data`` into a slice and queues it to be sent.
+
+        :param bytes data:
+            The data to send, at most ``slice_size`` bytes.
+
+        :keyword bool defer:
+            If True the send is not started until :meth:`commit` or a
+            later send without ``defer`` is called, so a burst of sends
+            costs a single transition into the network stack.
+
+        :rtype: bool
+        :returns:
+            Returns False, without sending, if ``sends`` sends are already
+            outstanding.
+        """
+        input_check("data", data, (binary_type, bytearray))
+        if self._sending == self._sends:
+            return False
+
+        _, library = dist.load()
+        index = self.slab.acquire()
+        try:
+            self.slab.write(index, data)
+            RIOSend(
+                self.RQ, self.slab.rio_buf(index),
+                Flags=library.RIO_MSG_DEFER if defer else 0,
+                RequestContext=index << 1 | 1)
+        except Exception:
+            # Nothing was queued so no completion will free the slice
+            self.slab.release(index)
+            raise
+        self._sending += 1
+        self._deferred = self._deferred + 1 if defer else 0
+        return True
+
+    def commit(self):
+        """Starts any sends queued with ``defer=True``"""
+        if self._deferred:
+            _, library = dist.load()
+            RIOSend(self.RQ, None, DataBufferCount=0,
+                    Flags=library.RIO_MSG_COMMIT_ONLY)
+            self._deferred = 0
+
+    def dequeue(self):
+        """
+        Dequeues up to ``batch`` completions without waiting.  The slice
+        of each completed receive is queued again and the slice of each
+        completed send is freed.  If a receive can't be queued again the
+        error is raised and the slices which were not queued are freed.
+
+        :rtype: list
+        :returns:
+            Returns a list of :class:`RIOCompletion` tuples.  ``data`` is
+            the received bytes for receives and the number of bytes sent
+            for sends.  ``status`` is zero for successful operations.
+        """
+        count = RIODequeueCompletion(self.CQ, self._results, self.batch)
+        if not count:
+            return []
+
+        completions = []
+        reposts = []
+        results = self._results
+        for i in range(count):
+            result = results[i]
+            context = result.RequestContext
+            index = context >> 1
+            if context & 1:
+                self._sending -= 1
+                self.slab.release(index)
+                completions.append(RIOCompletion(
+                    self.SEND, result.Status, result.BytesTransferred))
+            else:
+                completions.append(RIOCompletion(
+                    self.RECEIVE, result.Status,
+                    self.slab.read(index, result.BytesTransferred)))
+                reposts.append(index)
+
+        if reposts:
+            self._post_receives(reposts)
+        self.batches += 1
+        self.completions += count
+        return completions
+
+    def close(self):
+        """
+        Closes the completion queue and closes the slab.  The request
+        queue is closed along with the socket, which should be closed
+        first so outstanding receives are cancelled.
+        """
+        if self.CQ is not None:
+            RIOCloseCompletionQueue(self.CQ)
+            self.CQ = None
+        self.slab.close()
@@ -1,6 +1,6 @@
-from pywincffi.core.checks import input_check
-from pywincffi.dev.testutil import TestCase
-from pywincffi.exceptions import InputError
+from pywincffi.core.checks import input_check, pending_check
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
 
 
 class TestInputCheck(TestCase):
@@ -26,3 +26,34 @@ class TestInputCheck(TestCase):
     def test_allowed_values_failure(self):
         with self.assertRaises(InputError):
             input_check("", 1, allowed_values=(2, ))
+
+
+class TestPendingCheck(TestCase):
+    """
+    Tests for :func:`pywincffi.core.checks.pending_check`
+    """
+    def setUp(self):
+        super(TestPendingCheck, self).setUp()
+        self.library = self.standin_library(StandInLibrary)
+
+    def test_completed(self):
+        self.assertFalse(pending_check("ReadFile", 1))
+
+    def test_pending(self):
+        self.library.SetLastError(self.library.ERROR_IO_PENDING)
+        self.assertTrue(pending_check("ReadFile", 0))
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_pending_without_overlapped(self):
+        self.library.SetLastError(self.library.ERROR_IO_PENDING)
+        with self.assertRaises(WindowsAPIError):
+            pending_check("ReadFile", 0, overlapped=False)
+        self.library.SetLastError(0)
+
+    def test_error(self):
+        self.library.SetLastError(self.library.ERROR_INVALID_HANDLE)
+        with self.assertRaises(WindowsAPIError) as error:
+            pending_check("ReadFile", 0)
+        self.assertEqual(error.exception.errno,
+                         self.library.ERROR_INVALID_HANDLE)
+        self.library.SetLastError(0)
@@ -0,0 +1,237 @@
+import ctypes
+import ctypes.util
+import errno
+import os
+import tempfile
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.allocation import (
+    DeviceIoControl, preallocate, set_allocation_size, set_end_of_file,
+    set_sparse, set_zero_data)
+from pywincffi.kernel32.file import SetEndOfFile, SetFilePointerEx
+from pywincffi.wintypes import HANDLE
+
+LIBC = ctypes.CDLL(ctypes.util.find_library("c"), use_errno=True)
+FALLOC_FL_KEEP_SIZE = 0x01
+FALLOC_FL_PUNCH_HOLE = 0x02
+
+
+class AllocationLibrary(StandInLibrary):
+    """
+    Implements SetFileInformationByHandle, SetEndOfFile and
+    DeviceIoControl on top of ``fallocate`` and :func:`os.ftruncate`.
+    Allocating space uses ``FALLOC_FL_KEEP_SIZE``, as ``FileAllocationInfo``
+    does, and ``FSCTL_SET_ZERO_DATA`` punches a hole.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_DISK_FULL=112,
+        ERROR_NOT_SUPPORTED=50,
+        FILE_BEGIN=0,
+        FILE_CURRENT=1,
+        FILE_END=2,
+        FileAllocationInfo=5,
+        FileEndOfFileInfo=6,
+        FSCTL_SET_SPARSE=0x000900C4,
+        FSCTL_SET_ZERO_DATA=0x000980C8
+    )
+    STRUCTURES = {
+        5: "PFILE_ALLOCATION_INFO",
+        6: "PFILE_END_OF_FILE_INFO",
+        0x000900C4: "PFILE_SET_SPARSE_BUFFER",
+        0x000980C8: "PFILE_ZERO_DATA_INFORMATION"
+    }
+
+    def __init__(self, ffi):
+        super(AllocationLibrary, self).__init__(ffi)
+        self.calls = []
+        self.sparse = False
+        self.disk_full = False
+
+    def structure(self, code, pointer, size):
+        ctype = self.STRUCTURES[int(code)]
+        assert int(size) == self.ffi.sizeof(self.ffi.typeof(ctype).item)
+        return self.ffi.cast(ctype, pointer)
+
+    def fallocate(self, fd, mode, offset, length):
+        if self.disk_full:
+            return self.fail(self.ERROR_DISK_FULL)
+
+        if LIBC.fallocate(
+                fd, mode, ctypes.c_int64(offset), ctypes.c_int64(length)):
+            if ctypes.get_errno() == errno.ENOSPC:
+                return self.fail(self.ERROR_DISK_FULL)
+            return self.fail(self.ERROR_NOT_SUPPORTED)
+        return 1
+
+    def SetFileInformationByHandle(
+            self, hFile, FileInformationClass, lpFileInformation,
+            dwBufferSize):
+        self.calls.append(int(FileInformationClass))
+        fd = self.fd(hFile)
+        info = self.structure(
+            FileInformationClass, lpFileInformation, dwBufferSize)
+
+        if FileInformationClass == self.FileEndOfFileInfo:
+            os.ftruncate(fd, info.EndOfFile.QuadPart)
+            return 1
+
+        size = info.AllocationSize.QuadPart
+        if size < os.fstat(fd).st_size:
+            os.ftruncate(fd, size)
+            return 1
+        return self.fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size)
+
+    def SetEndOfFile(self, hFile):
+        fd = self.fd(hFile)
+        os.ftruncate(fd, os.lseek(fd, 0, os.SEEK_CUR))
+        return 1
+
+    def SetFilePointerEx(self, hFile, liDistanceToMove, lpNewFilePointer,
+                         dwMoveMethod):
+        lpNewFilePointer.QuadPart = os.lseek(
+            self.fd(hFile), liDistanceToMove.QuadPart, int(dwMoveMethod))
+        return 1
+
+    def GetFileSizeEx(self, hFile, lpFileSize):
+        lpFileSize.QuadPart = os.fstat(self.fd(hFile)).st_size
+        return 1
+
+    def DeviceIoControl(  # pylint: disable=too-many-arguments
+            self, hDevice, dwIoControlCode, lpInBuffer, nInBufferSize,
+            lpOutBuffer, nOutBufferSize, lpBytesReturned, lpOverlapped):
+        assert lpOutBuffer == self.ffi.NULL and nOutBufferSize == 0
+        info = self.structure(dwIoControlCode, lpInBuffer, nInBufferSize)
+        lpBytesReturned[0] = 0
+
+        if dwIoControlCode == self.FSCTL_SET_SPARSE:
+            self.sparse = bool(info.SetSparse)
+            return 1
+
+        offset = info.FileOffset.QuadPart
+        return self.fallocate(
+            self.fd(hDevice), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+            offset, info.BeyondFinalZero.QuadPart - offset)
+
+
+class AllocationCase(TestCase):
+    """
+    Sets up :class:`AllocationLibrary` and an empty file.
+    """
+    def setUp(self):
+        super(AllocationCase, self).setUp()
+        self.library = self.standin_library(AllocationLibrary)
+        self.fd, self.path = tempfile.mkstemp()
+        self.addCleanup(os.remove, self.path)
+        self.addCleanup(os.close, self.fd)
+        self.hFile = HANDLE(self.library.handle(self.fd))
+
+    def allocated(self):
+        return os.fstat(self.fd).st_blocks * 512
+
+    def size(self):
+        return os.fstat(self.fd).st_size
+
+
+class TestSetEndOfFile(AllocationCase):
+    """
+    Tests for :func:`pywincffi.kernel32.SetEndOfFile` and
+    :func:`pywincffi.kernel32.set_end_of_file`
+    """
+    def test_set_end_of_file_at_file_pointer(self):
+        SetFilePointerEx(self.hFile, 1000)
+        SetEndOfFile(self.hFile)
+        self.assertEqual(self.size(), 1000)
+
+    def test_set_end_of_file(self):
+        set_end_of_file(self.hFile, 4096)
+        self.assertEqual(self.size(), 4096)
+        set_end_of_file(self.hFile, 10)
+        self.assertEqual(self.size(), 10)
+        self.assertEqual(os.lseek(self.fd, 0, os.SEEK_CUR), 0)
+
+
+class TestPreallocate(AllocationCase):
+    """
+    Tests for :func:`pywincffi.kernel32.preallocate` and
+    :func:`pywincffi.kernel32.set_allocation_size`
+    """
+    def test_set_allocation_size(self):
+        set_allocation_size(self.hFile, 1024 * 1024)
+        self.assertGreaterEqual(self.allocated(), 1024 * 1024)
+        self.assertEqual(self.size(), 0)
+
+    def test_preallocate(self):
+        preallocate(self.hFile, 1024 * 1024)
+        self.assertGreaterEqual(self.allocated(), 1024 * 1024)
+        self.assertEqual(self.size(), 0)
+        self.assertEqual(self.library.calls, [self.library.FileAllocationInfo])
+
+    def test_preallocate_and_extend(self):
+        preallocate(self.hFile, 1024 * 1024, extend=True)
+        self.assertEqual(self.size(), 1024 * 1024)
+        self.assertEqual(
+            self.library.calls,
+            [self.library.FileAllocationInfo, self.library.FileEndOfFileInfo])
+
+    def test_already_large_enough(self):
+        os.write(self.fd, b"x" * 4096)
+        preallocate(self.hFile, 4096)
+        preallocate(self.hFile, 100)
+        self.assertEqual(self.library.calls, [])
+        self.assertEqual(self.size(), 4096)
+
+    def test_disk_full(self):
+        self.library.disk_full = True
+        with self.assertRaises(WindowsAPIError) as error:
+            preallocate(self.hFile, 1024 * 1024)
+        self.assertEqual(error.exception.errno, self.library.ERROR_DISK_FULL)
+
+    def test_negative_size(self):
+        with self.assertRaises(InputError):
+            preallocate(self.hFile, -1)
+
+
+class TestSparse(AllocationCase):
+    """
+    Tests for :func:`pywincffi.kernel32.set_sparse`,
+    :func:`pywincffi.kernel32.set_zero_data` and
+    :func:`pywincffi.kernel32.DeviceIoControl`
+    """
+    def test_set_sparse(self):
+        set_sparse(self.hFile)
+        self.assertTrue(self.library.sparse)
+        set_sparse(self.hFile, False)
+        self.assertFalse(self.library.sparse)
+
+    def test_set_zero_data(self):
+        os.write(self.fd, b"x" * 256 * 1024)
+        os.fsync(self.fd)
+        before = self.allocated()
+
+        set_sparse(self.hFile)
+        try:
+            set_zero_data(self.hFile, 64 * 1024, 128 * 1024)
+        except WindowsAPIError as error:  # pragma: no cover
+            if error.errno != self.library.ERROR_NOT_SUPPORTED:
+                raise
+            self.skipTest("The file system does not support punching holes")
+
+        self.assertEqual(self.size(), 256 * 1024)
+        self.assertLess(self.allocated(), before)
+        self.assertEqual(
+            os.pread(self.fd, 256 * 1024, 0),
+            b"x" * 64 * 1024 + b"\0" * 128 * 1024 + b"x" * 64 * 1024)
+
+    def test_set_zero_data_invalid_range(self):
+        with self.assertRaises(InputError):
+            set_zero_data(self.hFile, -1, 10)
+
+    def test_device_io_control_returns_bytes(self):
+        info = self.library.ffi.new("PFILE_SET_SPARSE_BUFFER")
+        info.SetSparse = 1
+        self.assertEqual(
+            DeviceIoControl(
+                self.hFile, self.library.FSCTL_SET_SPARSE, lpInBuffer=info),
+            0)
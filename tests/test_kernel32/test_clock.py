@@ -0,0 +1,203 @@
+import struct
+import time
+from datetime import datetime, timedelta
+
+from mock import patch
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import (
+    GetSystemTimePreciseAsFileTime, GetTickCount64, QueryPerformanceCounter,
+    QueryPerformanceFrequency, epoch_ns_to_filetimes, filetime_to_epoch_ns,
+    filetimes_to_epoch_ns, perf_counter_ns, time_ns)
+from pywincffi.kernel32 import clock
+from pywincffi.wintypes import FILETIME
+
+# 2017-06-01T12:30:45.1234567Z expressed as a FILETIME
+SAMPLE_FILETIME = 131407938451234567
+SAMPLE_EPOCH_NS = 1496320245123456700
+
+
+class ClockLibrary(StandInLibrary):
+    """
+    Implements the clock functions on top of Python's own clocks and the
+    FILETIME conversion helper from main.c in Python.
+    """
+    FREQUENCY = 10000000
+
+    def __init__(self, ffi):
+        super(ClockLibrary, self).__init__(ffi)
+        self.frequency_calls = 0
+        self.conversions = []
+        self.fail_counter = False
+
+    def QueryPerformanceCounter(self, lpPerformanceCount):
+        if self.fail_counter:
+            return self.fail(self.ERROR_INVALID_PARAMETER)
+        lpPerformanceCount.QuadPart = int(time.time() * self.FREQUENCY)
+        return 1
+
+    def QueryPerformanceFrequency(self, lpFrequency):
+        self.frequency_calls += 1
+        lpFrequency.QuadPart = self.FREQUENCY
+        return 1
+
+    def get_system_time_precise(self, lpSystemTimeAsFileTime):
+        value = int(time.time() * 10000000) + clock.EPOCH_AS_FILETIME
+        lpSystemTimeAsFileTime.dwLowDateTime = value & 0xFFFFFFFF
+        lpSystemTimeAsFileTime.dwHighDateTime = value >> 32
+
+    def GetTickCount64(self):
+        return int(time.time() * 1000)
+
+    def filetimes_to_epoch_ns(self, filetimes, count, results):
+        self.conversions.append(int(count))
+        epoch = clock.EPOCH_AS_FILETIME
+        values = struct.unpack_from(
+            "<%dQ" % count, self.ffi.buffer(filetimes, count * 8))
+        struct.pack_into(
+            "<%dq" % count, self.ffi.buffer(results), 0,
+            *[(value - epoch) * 100 for value in values])
+
+
+class ClockCase(TestCase):
+    def setUp(self):
+        super(ClockCase, self).setUp()
+        self.library = self.standin_library(ClockLibrary)
+        patcher = patch.dict(clock._CLOCK_CACHE, clear=True)
+        patcher.start()
+        self.addCleanup(patcher.stop)
+
+    def filetimes(self, values):
+        filetimes = self.library.ffi.new("FILETIME[]", len(values))
+        for i, value in enumerate(values):
+            filetimes[i].dwLowDateTime = value & 0xFFFFFFFF
+            filetimes[i].dwHighDateTime = value >> 32
+        return filetimes
+
+
+class TestClocks(ClockCase):
+    """
+    Tests for :func:`pywincffi.kernel32.QueryPerformanceCounter`,
+    :func:`pywincffi.kernel32.GetSystemTimePreciseAsFileTime` and
+    :func:`pywincffi.kernel32.GetTickCount64`
+    """
+    def test_performance_counter(self):
+        first = QueryPerformanceCounter()
+        self.assertGreaterEqual(QueryPerformanceCounter(), first)
+        self.assertEqual(
+            QueryPerformanceFrequency(), ClockLibrary.FREQUENCY)
+
+    def test_performance_counter_error(self):
+        self.library.fail_counter = True
+        with self.assertRaises(WindowsAPIError):
+            QueryPerformanceCounter()
+
+    def test_perf_counter_ns_caches_frequency(self):
+        first = perf_counter_ns()
+        second = perf_counter_ns()
+        self.assertGreaterEqual(second, first)
+        self.assertEqual(self.library.frequency_calls, 1)
+
+    def test_system_time(self):
+        self.assertIsInstance(GetSystemTimePreciseAsFileTime(), FILETIME)
+        self.assertAlmostEqual(time_ns() / 1e9, time.time(), delta=5)
+
+    def test_tick_count(self):
+        self.assertAlmostEqual(
+            GetTickCount64() / 1000.0, time.time(), delta=5)
+
+
+class TestFiletimeConversion(ClockCase):
+    """
+    Tests for :func:`pywincffi.kernel32.filetime_to_epoch_ns`,
+    :func:`pywincffi.kernel32.filetimes_to_epoch_ns` and
+    :func:`pywincffi.kernel32.epoch_ns_to_filetimes`
+    """
+    def test_single(self):
+        filetime = FILETIME()
+        filetime.dwLowDateTime = SAMPLE_FILETIME & 0xFFFFFFFF
+        filetime.dwHighDateTime = SAMPLE_FILETIME >> 32
+        self.assertEqual(filetime_to_epoch_ns(filetime), SAMPLE_EPOCH_NS)
+        self.assertEqual(
+            datetime(1970, 1, 1) +
+            timedelta(microseconds=SAMPLE_EPOCH_NS // 1000),
+            datetime(2017, 6, 1, 12, 30, 45, 123456))
+
+    def test_epoch(self):
+        self.assertEqual(
+            list(filetimes_to_epoch_ns(
+                self.filetimes([clock.EPOCH_AS_FILETIME]))),
+            [0])
+
+    def test_single_structure(self):
+        filetime = FILETIME()
+        filetime.dwLowDateTime = SAMPLE_FILETIME & 0xFFFFFFFF
+        filetime.dwHighDateTime = SAMPLE_FILETIME >> 32
+        self.assertEqual(
+            list(filetimes_to_epoch_ns(filetime)), [SAMPLE_EPOCH_NS])
+
+    def test_array(self):
+        values = [SAMPLE_FILETIME + i * 12345 for i in range(100)]
+        self.assertEqual(
+            list(filetimes_to_epoch_ns(self.filetimes(values))),
+            [(value - clock.EPOCH_AS_FILETIME) * 100 for value in values])
+
+    def test_count(self):
+        filetimes = self.filetimes([SAMPLE_FILETIME] * 4)
+        self.assertEqual(len(filetimes_to_epoch_ns(filetimes, count=2)), 2)
+        with self.assertRaises(InputError):
+            filetimes_to_epoch_ns(filetimes, count=5)
+
+    def test_bytes(self):
+        data = struct.pack("<2Q", SAMPLE_FILETIME, clock.EPOCH_AS_FILETIME)
+        self.assertEqual(
+            list(filetimes_to_epoch_ns(data)), [SAMPLE_EPOCH_NS, 0])
+
+    def test_into_existing_results(self):
+        filetimes = self.filetimes([SAMPLE_FILETIME] * 3)
+        # Any writable buffer works, such as array("q") on Python 3.
+        results = bytearray(32)
+        self.assertIs(filetimes_to_epoch_ns(filetimes, results=results),
+                      results)
+        self.assertEqual(
+            struct.unpack("<4q", bytes(results)),
+            (SAMPLE_EPOCH_NS, ) * 3 + (0, ))
+
+        results = self.library.ffi.new("LONGLONG[]", 3)
+        self.assertIs(filetimes_to_epoch_ns(filetimes, results=results),
+                      results)
+        self.assertEqual(list(results), [SAMPLE_EPOCH_NS] * 3)
+
+    def test_results_too_small(self):
+        filetimes = self.filetimes([SAMPLE_FILETIME] * 3)
+        with self.assertRaises(InputError):
+            filetimes_to_epoch_ns(filetimes, results=bytearray(16))
+        with self.assertRaises(InputError):
+            filetimes_to_epoch_ns(filetimes, results=b"\x00" * 24)
+
+    def test_partial_structure(self):
+        with self.assertRaises(InputError):
+            filetimes_to_epoch_ns(b"\x00" * 12)
+
+    def test_round_trip(self):
+        values = [SAMPLE_EPOCH_NS + i * 100 for i in range(50)]
+        self.assertEqual(
+            list(filetimes_to_epoch_ns(epoch_ns_to_filetimes(values))),
+            values)
+
+    def test_into_existing_array(self):
+        filetimes = self.library.ffi.new("FILETIME[]", 4)
+        self.assertIs(
+            epoch_ns_to_filetimes([SAMPLE_EPOCH_NS], filetimes), filetimes)
+        self.assertEqual(
+            filetimes[0].dwHighDateTime << 32 | filetimes[0].dwLowDateTime,
+            SAMPLE_FILETIME)
+        with self.assertRaises(InputError):
+            epoch_ns_to_filetimes([0] * 5, filetimes)
+
+    def test_single_native_call(self):
+        filetimes = self.filetimes([SAMPLE_FILETIME] * 20000)
+        results = filetimes_to_epoch_ns(filetimes)
+        self.assertEqual(self.library.conversions, [20000])
+        self.assertEqual(list(results), [SAMPLE_EPOCH_NS] * 20000)
@@ -1,7 +1,24 @@
+import array
+import os
+import select
+import time
+
+try:
+    import fcntl
+    import pty
+    import termios
+    import tty
+except ImportError:  # pragma: no cover
+    fcntl = pty = termios = tty = None
+
 from pywincffi.core import dist
-from pywincffi.dev.testutil import TestCase
-from pywincffi.kernel32 import CreateFile, ClearCommError, CloseHandle
-from pywincffi.exceptions import WindowsAPIError
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.kernel32 import (
+    CreateFile, ClearCommError, CloseHandle, CommReader, GetCommState,
+    PurgeComm, RingBuffer, SetCommMask, SetCommState, SetCommTimeouts,
+    WaitCommEvent)
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.wintypes import HANDLE, OVERLAPPED
 
 
 class TestClearCommError(TestCase):
@@ -29,3 +46,325 @@ class TestClearCommError(TestCase):
 
         if not found_com_device:
             self.skipTest("No COM devices present.")
+
+
+class PtyCommLibrary(StandInLibrary):
+    """
+    Emulates a serial port using the slave end of a pseudo terminal, so
+    bytes written to the master end arrive as received data.  Baud rates
+    are applied with termios and overlapped waits are completed with
+    select().
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_NOT_FOUND=1168,
+        ERROR_OPERATION_ABORTED=995,
+        CE_RXOVER=0x0001,
+        CE_OVERRUN=0x0002,
+        CE_FRAME=0x0008,
+        EV_RXCHAR=0x0001,
+        EV_ERR=0x0080,
+        PURGE_RXABORT=0x0002,
+        PURGE_RXCLEAR=0x0008,
+        NOPARITY=0,
+        ONESTOPBIT=0
+    )
+    EVENT = 1000
+
+    def __init__(self, ffi):
+        super(PtyCommLibrary, self).__init__(ffi)
+        self.events = 0
+        self.closed = []
+        self.mask = 0
+        self.timeouts = None
+        self.errors = 0
+        self.pending = None
+        self.cancelled = False
+
+    def queued(self, fd):
+        count = array.array("i", [0])
+        fcntl.ioctl(fd, termios.FIONREAD, count)
+        return count[0]
+
+    def CreateEvent(self, lpEventAttributes, bManualReset, bInitialState,
+                    lpName):
+        self.events += 1
+        return self.handle(self.EVENT + self.events)
+
+    def ResetEvent(self, hEvent):
+        return 1
+
+    def CloseHandle(self, hObject):
+        self.closed.append(self.fd(hObject))
+        return 1
+
+    def GetCommState(self, hFile, lpDCB):
+        speed = termios.tcgetattr(self.fd(hFile))[4]
+        lpDCB.BaudRate = int(
+            [name for name in dir(termios)
+             if name.startswith("B") and name[1:].isdigit() and
+             getattr(termios, name) == speed][0][1:])
+        return 1
+
+    def SetCommState(self, hFile, lpDCB):
+        speed = getattr(termios, "B%d" % lpDCB.BaudRate, None)
+        if speed is None:
+            return self.fail(self.ERROR_INVALID_PARAMETER)
+        attributes = termios.tcgetattr(self.fd(hFile))
+        attributes[4] = attributes[5] = speed
+        termios.tcsetattr(self.fd(hFile), termios.TCSANOW, attributes)
+        return 1
+
+    def SetCommTimeouts(self, hFile, lpCommTimeouts):
+        self.timeouts = lpCommTimeouts[0]
+        return 1
+
+    def SetCommMask(self, hFile, dwEvtMask):
+        if self.fd(hFile) < 0:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        self.mask = int(dwEvtMask)
+        return 1
+
+    def WaitCommEvent(self, hFile, lpEvtMask, lpOverlapped):
+        assert self.pending is None, "only one wait may be outstanding"
+        if self.mask & self.EV_RXCHAR and self.queued(self.fd(hFile)):
+            lpEvtMask[0] = self.EV_RXCHAR
+            return 1
+        if lpOverlapped == self.ffi.NULL:
+            return self.fail(self.ERROR_INVALID_PARAMETER)
+        self.pending = (self.fd(hFile), lpEvtMask)
+        return self.fail(self.ERROR_IO_PENDING)
+
+    def WaitForSingleObject(self, hHandle, dwMilliseconds):
+        assert self.pending is not None
+        if self.cancelled:
+            return self.WAIT_OBJECT_0
+        fd, lpEvtMask = self.pending
+        readable, _, _ = select.select(
+            [fd], [], [], int(dwMilliseconds) / 1000.0)
+        if not readable:
+            return self.WAIT_TIMEOUT
+        lpEvtMask[0] = self.EV_RXCHAR
+        return self.WAIT_OBJECT_0
+
+    def CancelIoEx(self, hFile, lpOverlapped):
+        self.cancelled = self.pending is not None
+        return 1
+
+    def GetOverlappedResult(self, hFile, lpOverlapped,
+                            lpNumberOfBytesTransferred, bWait):
+        self.pending = None
+        if self.cancelled:
+            return self.fail(self.ERROR_OPERATION_ABORTED)
+        lpNumberOfBytesTransferred[0] = 0
+        return 1
+
+    def ClearCommError(self, hFile, lpErrors, lpStat):
+        lpErrors[0], self.errors = self.errors, 0
+        lpStat.cbInQue = self.queued(self.fd(hFile))
+        return 1
+
+    def ReadFile(self, hFile, lpBuffer, nNumberOfBytesToRead,
+                 lpNumberOfBytesRead, lpOverlapped):
+        data = os.read(self.fd(hFile), nNumberOfBytesToRead)
+        self.ffi.memmove(lpBuffer, data, len(data))
+        lpNumberOfBytesRead[0] = len(data)
+        return 1
+
+    def PurgeComm(self, hFile, dwFlags):
+        if int(dwFlags) & self.PURGE_RXCLEAR:
+            termios.tcflush(self.fd(hFile), termios.TCIFLUSH)
+        return 1
+
+
+class PtyCommCase(TestCase):
+    """
+    Opens a pseudo terminal and uses its slave end as the serial port.
+    """
+    def setUp(self):
+        super(PtyCommCase, self).setUp()
+        if pty is None:  # pragma: no cover
+            self.skipTest("Pseudo terminals are not available")
+
+        self.library = self.standin_library(PtyCommLibrary)
+        self.master, self.slave = pty.openpty()
+        self.addCleanup(os.close, self.master)
+        self.addCleanup(os.close, self.slave)
+        tty.setraw(self.slave)
+        self.hFile = HANDLE(self.library.handle(self.slave))
+
+    def send(self, data):
+        # Data written to the master end arrives asynchronously so wait
+        # until all of it is queued on the slave end.
+        expected = self.library.queued(self.slave) + len(data)
+        os.write(self.master, data)
+        deadline = time.time() + 5
+        while self.library.queued(self.slave) < expected:
+            self.assertLess(time.time(), deadline)
+            time.sleep(0.001)
+
+
+class TestCommFunctions(PtyCommCase):
+    """
+    Tests for :func:`pywincffi.kernel32.SetCommState`,
+    :func:`pywincffi.kernel32.SetCommTimeouts`,
+    :func:`pywincffi.kernel32.WaitCommEvent` and
+    :func:`pywincffi.kernel32.PurgeComm`
+    """
+    def test_comm_state(self):
+        lpDCB = GetCommState(self.hFile)
+        lpDCB.BaudRate = 9600
+        SetCommState(self.hFile, lpDCB)
+        self.assertEqual(GetCommState(self.hFile).BaudRate, 9600)
+
+    def test_comm_state_error(self):
+        lpDCB = GetCommState(self.hFile)
+        lpDCB.BaudRate = 12345
+        with self.assertRaises(WindowsAPIError):
+            SetCommState(self.hFile, lpDCB)
+
+    def test_comm_state_type(self):
+        with self.assertRaises(InputError):
+            SetCommState(self.hFile, {"BaudRate": 9600})
+
+    def test_timeouts(self):
+        SetCommTimeouts(self.hFile, (0xFFFFFFFF, 0, 0, 0, 500))
+        timeouts = self.library.timeouts
+        self.assertEqual(timeouts.ReadIntervalTimeout, 0xFFFFFFFF)
+        self.assertEqual(timeouts.WriteTotalTimeoutConstant, 500)
+
+    def test_timeouts_length(self):
+        with self.assertRaises(InputError):
+            SetCommTimeouts(self.hFile, (0, 0))
+
+    def test_wait_comm_event(self):
+        SetCommMask(self.hFile, self.library.EV_RXCHAR)
+        self.send(b"x")
+        self.assertEqual(
+            WaitCommEvent(self.hFile), self.library.EV_RXCHAR)
+
+    def test_wait_comm_event_pending(self):
+        SetCommMask(self.hFile, self.library.EV_RXCHAR)
+        lpEvtMask = self.library.ffi.new("LPDWORD")
+        self.assertIsNone(
+            WaitCommEvent(self.hFile, lpEvtMask, OVERLAPPED()))
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_wait_comm_event_requires_mask(self):
+        with self.assertRaises(InputError):
+            WaitCommEvent(self.hFile, lpOverlapped=OVERLAPPED())
+
+    def test_wait_comm_event_error(self):
+        with self.assertRaises(WindowsAPIError):
+            WaitCommEvent(self.hFile)
+
+    def test_purge(self):
+        self.send(b"stale")
+        PurgeComm(
+            self.hFile,
+            self.library.PURGE_RXABORT | self.library.PURGE_RXCLEAR)
+        self.assertEqual(self.library.queued(self.slave), 0)
+
+
+class TestRingBuffer(PtyCommCase):
+    """
+    Tests for :class:`pywincffi.kernel32.RingBuffer`
+    """
+    def store(self, ring, data):
+        while data:
+            pointer, length = ring.reserve(len(data))
+            self.library.ffi.memmove(pointer, data[:length], length)
+            ring.commit(length)
+            data = data[length:]
+
+    def test_wraps_around(self):
+        ring = RingBuffer(8)
+        self.store(ring, b"abcdef")
+        self.assertEqual(ring.read(4), b"abcd")
+        self.store(ring, b"ghijkl")
+        self.assertEqual(len(ring), 8)
+        self.assertEqual(ring.read(), b"efghijkl")
+        self.assertEqual(ring.dropped, 0)
+
+    def test_drops_oldest(self):
+        ring = RingBuffer(4)
+        self.store(ring, b"abc")
+        self.store(ring, b"de")
+        self.assertEqual(ring.dropped, 1)
+        self.assertEqual(ring.read(), b"bcde")
+
+    def test_reserve_limited_to_capacity(self):
+        ring = RingBuffer(4)
+        _, length = ring.reserve(10)
+        self.assertEqual(length, 4)
+
+    def test_commit_too_much(self):
+        ring = RingBuffer(4)
+        with self.assertRaises(InputError):
+            ring.commit(5)
+
+    def test_capacity(self):
+        with self.assertRaises(InputError):
+            RingBuffer(0)
+
+
+class TestCommReader(PtyCommCase):
+    """
+    Tests for :class:`pywincffi.kernel32.CommReader`
+    """
+    def create_reader(self, **kwargs):
+        reader = CommReader(self.hFile, **kwargs)
+        self.addCleanup(reader.close)
+        return reader
+
+    def test_poll_timeout(self):
+        reader = self.create_reader()
+        self.assertEqual(reader.poll(10), 0)
+        self.assertEqual(reader.events, 0)
+        self.assertEqual(
+            self.library.mask,
+            self.library.EV_RXCHAR | self.library.EV_ERR)
+
+    def test_reads_queued_bytes(self):
+        reader = self.create_reader()
+        self.send(b"sample-1\n")
+        self.assertEqual(reader.poll(1000), 9)
+        self.assertEqual(reader.read(), b"sample-1\n")
+        self.assertEqual(reader.status.cbInQue, 9)
+        self.assertEqual(reader.bytes_read, 9)
+
+    def test_pending_wait_completes(self):
+        reader = self.create_reader()
+        self.assertEqual(reader.poll(0), 0)
+        self.assertIsNotNone(self.library.pending)
+        self.send(b"abc")
+        self.assertEqual(reader.poll(1000), 3)
+        self.assertIsNone(self.library.pending)
+        self.assertEqual(reader.events, 1)
+
+    def test_ring_overflow(self):
+        reader = self.create_reader(capacity=16)
+        self.send(b"0123456789abcdefXYZ")
+        self.assertEqual(reader.poll(1000), 19)
+        self.assertEqual(reader.ring.dropped, 3)
+        self.assertEqual(reader.read(), b"3456789abcdefXYZ")
+
+    def test_overruns(self):
+        reader = self.create_reader()
+        self.library.errors = self.library.CE_OVERRUN
+        reader.drain()
+        self.library.errors = self.library.CE_FRAME
+        reader.drain()
+        self.assertEqual(reader.overruns, 1)
+        self.assertEqual(
+            reader.errors, self.library.CE_OVERRUN | self.library.CE_FRAME)
+
+    def test_close_cancels_wait(self):
+        reader = CommReader(self.hFile)
+        reader.poll(0)
+        reader.close()
+        reader.close()
+        self.assertTrue(self.library.cancelled)
+        self.assertIsNone(self.library.pending)
+        self.assertEqual(sorted(self.library.closed), [1001, 1002])
+        self.assertEqual(self.library.ffi.last_error, 0)
@@ -0,0 +1,204 @@
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import (
+    ConsoleInputReader, GetNumberOfConsoleInputEvents, PeekConsoleInputW,
+    ReadConsoleInputW, decode_input_records)
+from pywincffi.kernel32.consoleinput import (
+    FocusEvent, KeyEvent, MenuEvent, MouseEvent, WindowBufferSizeEvent)
+from pywincffi.wintypes import HANDLE
+
+
+class ConsoleInputLibrary(StandInLibrary):
+    """
+    A console input buffer holding synthetic ``INPUT_RECORD`` structures
+    which are copied out by ReadConsoleInputW and PeekConsoleInputW.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        KEY_EVENT=0x0001,
+        MOUSE_EVENT=0x0002,
+        WINDOW_BUFFER_SIZE_EVENT=0x0004,
+        MENU_EVENT=0x0008,
+        FOCUS_EVENT=0x0010,
+        SHIFT_PRESSED=0x0010,
+        MOUSE_WHEELED=0x0004
+    )
+
+    def __init__(self, ffi):
+        super(ConsoleInputLibrary, self).__init__(ffi)
+        self.queue = []
+
+    def record(self, event_type, event, **fields):
+        record = self.ffi.new("INPUT_RECORD *")
+        record.EventType = event_type
+        target = getattr(record.Event, event)
+        for name, value in fields.items():
+            setattr(target, name, value)
+        self.queue.append(record)
+
+    def copy(self, hConsoleInput, lpBuffer, nLength, lpNumberOfEventsRead):
+        if self.fd(hConsoleInput) < 0:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        records = self.queue[:nLength]
+        for index, record in enumerate(records):
+            lpBuffer[index] = record[0]
+        lpNumberOfEventsRead[0] = len(records)
+        return records
+
+    def ReadConsoleInputW(
+            self, hConsoleInput, lpBuffer, nLength, lpNumberOfEventsRead):
+        assert self.queue, "ReadConsoleInputW would block"
+        records = self.copy(
+            hConsoleInput, lpBuffer, nLength, lpNumberOfEventsRead)
+        if records == 0:
+            return records
+        del self.queue[:len(records)]
+        return 1
+
+    def PeekConsoleInputW(
+            self, hConsoleInput, lpBuffer, nLength, lpNumberOfEventsRead):
+        records = self.copy(
+            hConsoleInput, lpBuffer, nLength, lpNumberOfEventsRead)
+        return records if records == 0 else 1
+
+    def GetNumberOfConsoleInputEvents(self, hConsoleInput, lpcNumberOfEvents):
+        if self.fd(hConsoleInput) < 0:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        lpcNumberOfEvents[0] = len(self.queue)
+        return 1
+
+
+class ConsoleInputCase(TestCase):
+    def setUp(self):
+        super(ConsoleInputCase, self).setUp()
+        self.library = self.standin_library(ConsoleInputLibrary)
+        self.handle = HANDLE(self.library.handle(0))
+
+    def key(self, char, key_down=True, **fields):
+        self.library.record(
+            self.library.KEY_EVENT, "KeyEvent", bKeyDown=key_down,
+            wRepeatCount=1, wVirtualKeyCode=ord(char.upper()),
+            wVirtualScanCode=0x1E, uChar=(char, ), **fields)
+
+
+class TestDecodeInputRecords(ConsoleInputCase):
+    """
+    Tests for :func:`pywincffi.kernel32.decode_input_records`
+    """
+    def decode_queue(self):
+        library = self.library
+        records = library.ffi.new("INPUT_RECORD[]", len(library.queue))
+        for index, record in enumerate(library.queue):
+            records[index] = record[0]
+        return decode_input_records(records, len(library.queue))
+
+    def test_key_event(self):
+        self.key(u"a", dwControlKeyState=self.library.SHIFT_PRESSED)
+        self.assertEqual(
+            self.decode_queue(),
+            [KeyEvent(True, 1, ord("A"), 0x1E, u"a", 0x0010)])
+
+    def test_mouse_event(self):
+        self.library.record(
+            self.library.MOUSE_EVENT, "MouseEvent",
+            dwMousePosition=(12, 3), dwButtonState=0x00780000,
+            dwEventFlags=self.library.MOUSE_WHEELED)
+        self.assertEqual(
+            self.decode_queue(), [MouseEvent(12, 3, 0x00780000, 0, 0x0004)])
+
+    def test_other_events(self):
+        library = self.library
+        library.record(
+            library.WINDOW_BUFFER_SIZE_EVENT, "WindowBufferSizeEvent",
+            dwSize=(120, 40))
+        library.record(library.MENU_EVENT, "MenuEvent", dwCommandId=9)
+        library.record(library.FOCUS_EVENT, "FocusEvent", bSetFocus=1)
+        self.assertEqual(
+            self.decode_queue(),
+            [WindowBufferSizeEvent(120, 40), MenuEvent(9), FocusEvent(True)])
+
+    def test_unknown_event_skipped(self):
+        self.library.record(0x0100, "FocusEvent", bSetFocus=1)
+        self.key(u"b")
+        events = self.decode_queue()
+        self.assertEqual(len(events), 1)
+        self.assertEqual(events[0].char, u"b")
+
+    def test_only_count_decoded(self):
+        self.key(u"a")
+        self.key(u"b")
+        records = self.library.ffi.new("INPUT_RECORD[]", 2)
+        records[0] = self.library.queue[0][0]
+        self.assertEqual(len(decode_input_records(records, 1)), 1)
+
+
+class TestConsoleInputFunctions(ConsoleInputCase):
+    """
+    Tests for :func:`pywincffi.kernel32.ReadConsoleInputW`,
+    :func:`pywincffi.kernel32.PeekConsoleInputW` and
+    :func:`pywincffi.kernel32.GetNumberOfConsoleInputEvents`
+    """
+    def test_read_drains_many(self):
+        for char in u"hello":
+            self.key(char)
+        records, count = ReadConsoleInputW(self.handle, nLength=4)
+        self.assertEqual(len(records), 4)
+        self.assertEqual(count, 4)
+        self.assertEqual(GetNumberOfConsoleInputEvents(self.handle), 1)
+
+    def test_read_into_buffer(self):
+        self.key(u"x")
+        buffer_ = self.library.ffi.new("INPUT_RECORD[]", 8)
+        records, count = ReadConsoleInputW(self.handle, buffer_)
+        self.assertIs(records, buffer_)
+        self.assertEqual(count, 1)
+
+    def test_length_larger_than_buffer(self):
+        buffer_ = self.library.ffi.new("INPUT_RECORD[]", 2)
+        with self.assertRaises(InputError):
+            ReadConsoleInputW(self.handle, buffer_, nLength=3)
+
+    def test_peek_leaves_records(self):
+        self.key(u"x")
+        _, count = PeekConsoleInputW(self.handle)
+        self.assertEqual(count, 1)
+        self.assertEqual(GetNumberOfConsoleInputEvents(self.handle), 1)
+
+    def test_error(self):
+        with self.assertRaises(WindowsAPIError):
+            PeekConsoleInputW(HANDLE(self.library.handle(-1)))
+
+
+class TestConsoleInputReader(ConsoleInputCase):
+    """
+    Tests for :class:`pywincffi.kernel32.ConsoleInputReader`
+    """
+    def test_read_reuses_records(self):
+        reader = ConsoleInputReader(self.handle, size=2)
+        records = reader.records
+        for char in u"abc":
+            self.key(char)
+
+        self.assertEqual([e.char for e in reader.read()], [u"a", u"b"])
+        self.assertEqual([e.char for e in reader.read()], [u"c"])
+        self.assertIs(reader.records, records)
+        self.assertEqual(reader.calls, 2)
+        self.assertEqual(reader.events, 3)
+
+    def test_read_available_does_not_block(self):
+        reader = ConsoleInputReader(self.handle)
+        self.assertEqual(reader.read_available(), [])
+        self.key(u"q", key_down=False)
+        self.assertEqual(
+            reader.read_available(),
+            [KeyEvent(False, 1, ord("Q"), 0x1E, u"q", 0)])
+
+    def test_peek(self):
+        reader = ConsoleInputReader(self.handle)
+        self.key(u"z")
+        self.assertEqual(len(reader.peek()), 1)
+        self.assertEqual(reader.pending(), 1)
+
+    def test_size(self):
+        with self.assertRaises(InputError):
+            ConsoleInputReader(self.handle, size=0)
@@ -0,0 +1,217 @@
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import ConsoleWriter, WriteConsoleW
+from pywincffi.wintypes import HANDLE
+
+
+class RecordingConsoleLibrary(StandInLibrary):
+    """
+    Records each SetConsoleTextAttribute and WriteConsoleW call.  At most
+    ``max_write`` characters are accepted by each WriteConsoleW call,
+    none while ``stalled`` is True, and every call after the first
+    ``fail_after`` writes fails.
+    """
+    def __init__(self, ffi):
+        super(RecordingConsoleLibrary, self).__init__(ffi)
+        self.attributes = 7
+        self.max_write = None
+        self.fail_after = None
+        self.stalled = False
+        self.calls = []
+
+    def GetConsoleScreenBufferInfo(self, hConsoleOutput, info):
+        info.wAttributes = self.attributes
+        return 1
+
+    def SetConsoleTextAttribute(self, hConsoleOutput, wAttributes):
+        if self.fd(hConsoleOutput) < 0:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        self.attributes = wAttributes
+        self.calls.append(("attributes", wAttributes))
+        return 1
+
+    def WriteConsoleW(
+            self, hConsoleOutput, lpBuffer, nNumberOfCharsToWrite,
+            lpNumberOfCharsWritten, lpReserved):
+        if self.fd(hConsoleOutput) < 0:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        if self.fail_after is not None and \
+                len(self.output_calls()) >= self.fail_after:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        if self.stalled:
+            lpNumberOfCharsWritten[0] = 0
+            return 1
+        count = min(nNumberOfCharsToWrite, self.max_write or 1 << 31)
+        text = self.ffi.string(self.ffi.cast("WCHAR *", lpBuffer), count)
+        self.calls.append(("write", text))
+        lpNumberOfCharsWritten[0] = count
+        return 1
+
+    def output_calls(self):
+        return [value for kind, value in self.calls if kind == "write"]
+
+    def output(self):
+        return u"".join(self.output_calls())
+
+
+class ConsoleWriterCase(TestCase):
+    def setUp(self):
+        super(ConsoleWriterCase, self).setUp()
+        self.library = self.standin_library(RecordingConsoleLibrary)
+        self.handle = HANDLE(self.library.handle(1))
+
+
+class TestWriteConsoleW(ConsoleWriterCase):
+    """
+    Tests for :func:`pywincffi.kernel32.WriteConsoleW`
+    """
+    def test_write(self):
+        self.assertEqual(WriteConsoleW(self.handle, u"hello"), 5)
+        self.assertEqual(self.library.calls, [("write", u"hello")])
+
+    def test_type_check(self):
+        with self.assertRaises(InputError):
+            WriteConsoleW(self.handle, b"hello")
+
+    def test_error(self):
+        with self.assertRaises(WindowsAPIError):
+            WriteConsoleW(HANDLE(self.library.handle(-1)), u"hello")
+
+
+class TestConsoleWriter(ConsoleWriterCase):
+    """
+    Tests for :class:`pywincffi.kernel32.ConsoleWriter`
+    """
+    def test_default_attributes_from_console(self):
+        writer = ConsoleWriter(self.handle)
+        self.assertEqual(writer.attributes, 7)
+        writer.write(u"plain")
+        writer.flush()
+        self.assertEqual(self.library.calls, [("write", u"plain")])
+
+    def test_coalesces_equal_runs(self):
+        writer = ConsoleWriter(self.handle)
+        writer.write(u"[ ")
+        writer.write(u"O", 2)
+        writer.write(u"K", 2)
+        writer.write(u" ]")
+        writer.writeline(u" started")
+        writer.flush()
+        self.assertEqual(self.library.calls, [
+            ("write", u"[ "),
+            ("attributes", 2),
+            ("write", u"OK"),
+            ("attributes", 7),
+            ("write", u" ] started\n")])
+
+    def test_attributes_cached_between_flushes(self):
+        writer = ConsoleWriter(self.handle)
+        for _ in range(3):
+            writer.writeline(u"error", 4)
+            writer.flush()
+        self.assertEqual(
+            [call for call in self.library.calls if call[0] == "attributes"],
+            [("attributes", 4)])
+        self.assertEqual(writer.switches, 1)
+
+    def test_explicit_attributes_always_set_first(self):
+        writer = ConsoleWriter(self.handle, attributes=7)
+        writer.write(u"x")
+        writer.flush()
+        self.assertEqual(
+            self.library.calls, [("attributes", 7), ("write", u"x")])
+
+    def test_invalidate(self):
+        writer = ConsoleWriter(self.handle)
+        writer.invalidate()
+        writer.write(u"x")
+        writer.flush()
+        self.assertEqual(self.library.calls[0], ("attributes", 7))
+
+    def test_flushes_when_buffer_full(self):
+        writer = ConsoleWriter(self.handle, buffer_size=8)
+        writer.write(u"1234")
+        self.assertEqual(self.library.calls, [])
+        writer.write(u"5678")
+        self.assertEqual(self.library.calls, [("write", u"12345678")])
+
+    def test_partial_writes(self):
+        self.library.max_write = 3
+        writer = ConsoleWriter(self.handle)
+        writer.write(u"abcdefgh")
+        writer.flush()
+        self.assertEqual(self.library.output(), u"abcdefgh")
+        self.assertEqual(writer.writes, 3)
+
+    def test_context_manager_flushes(self):
+        with ConsoleWriter(self.handle) as writer:
+            writer.writeline(u"done")
+        self.assertEqual(self.library.output(), u"done\n")
+
+    def test_empty_text_ignored(self):
+        writer = ConsoleWriter(self.handle)
+        writer.write(u"", 3)
+        writer.flush()
+        self.assertEqual(self.library.calls, [])
+
+    def test_statistics(self):
+        writer = ConsoleWriter(self.handle)
+        self.assertEqual(writer.statistics().lines_per_second, 0.0)
+        for i in range(10):
+            writer.write(u"%d " % i, 3)
+            writer.writeline(u"line", 7)
+        writer.flush()
+        statistics = writer.statistics()
+        self.assertEqual(statistics.lines, 10)
+        self.assertEqual(statistics.writes, 20)
+        self.assertEqual(statistics.switches, 20)
+        self.assertGreaterEqual(statistics.seconds, 0)
+        if statistics.seconds:
+            self.assertAlmostEqual(
+                statistics.lines_per_second, 10 / statistics.seconds)
+
+    def test_error_forgets_attributes(self):
+        writer = ConsoleWriter(HANDLE(self.library.handle(-1)), attributes=7)
+        writer.write(u"x", 2)
+        with self.assertRaises(WindowsAPIError):
+            writer.flush()
+        self.assertIsNone(writer.current)
+
+    def test_failed_flush_keeps_unwritten_text(self):
+        self.library.max_write = 3
+        self.library.fail_after = 2
+        writer = ConsoleWriter(self.handle)
+        writer.write(u"ab")
+        writer.write(u"cdefgh", 2)
+        writer.write(u"ij")
+        with self.assertRaises(WindowsAPIError):
+            writer.flush()
+        self.assertEqual(self.library.output(), u"abcde")
+
+        self.library.fail_after = None
+        writer.flush()
+        self.assertEqual(self.library.output(), u"abcdefghij")
+        writer.flush()
+        self.assertEqual(self.library.output(), u"abcdefghij")
+
+    def test_nothing_written_keeps_text(self):
+        self.library.stalled = True
+        writer = ConsoleWriter(self.handle)
+        writer.write(u"abc")
+        with self.assertRaises(WindowsAPIError):
+            writer.flush()
+        self.assertEqual(self.library.output(), u"")
+
+        self.library.stalled = False
+        writer.flush()
+        self.assertEqual(self.library.output(), u"abc")
+
+    def test_type_check(self):
+        writer = ConsoleWriter(self.handle)
+        with self.assertRaises(InputError):
+            writer.write(b"bytes")
+
+    def test_attributes_type_check(self):
+        writer = ConsoleWriter(self.handle)
+        with self.assertRaises(InputError):
+            writer.write(u"text", "red")
@@ -0,0 +1,354 @@
+import os
+import shutil
+import stat
+import tempfile
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.directory import (
+    FindFirstFileEx, find_files, iter_directory, list_directory,
+    parse_directory_info, walk)
+from pywincffi.wintypes import HANDLE
+
+
+def pack_directory_info(ffi, lpFileInformation, dwBufferSize, entries):
+    """
+    Packs ``(name, attributes, size, file_id)`` tuples into
+    ``lpFileInformation`` as a chain of ``FILE_ID_BOTH_DIR_INFO`` records
+    aligned to 8 bytes, as Windows does.  Returns the entries which did
+    not fit.
+    """
+    name_offset = ffi.offsetof("FILE_ID_BOTH_DIR_INFO", "FileName")
+    address = ffi.cast("char *", lpFileInformation)
+    offset = previous_offset = 0
+    previous = None
+
+    entries = list(entries)
+    while entries:
+        name, attributes, size, file_id = entries[0]
+        encoded = name.encode("utf-16-le")
+        length = (name_offset + len(encoded) + 7) & ~7
+        if offset + name_offset + len(encoded) > dwBufferSize:
+            break
+
+        info = ffi.cast("PFILE_ID_BOTH_DIR_INFO", address + offset)
+        ffi.memmove(info, b"\0" * name_offset, name_offset)
+        info.FileAttributes = attributes
+        info.FileNameLength = len(encoded)
+        info.EndOfFile.QuadPart = size
+        info.LastWriteTime.QuadPart = file_id * 10
+        info.FileId.QuadPart = file_id
+        ffi.memmove(address + offset + name_offset, encoded, len(encoded))
+
+        if previous is not None:
+            previous.NextEntryOffset = offset - previous_offset
+        previous, previous_offset = info, offset
+        offset += length
+        entries.pop(0)
+
+    return entries
+
+
+class DirectoryLibrary(StandInLibrary):
+    """
+    Implements CreateFile for directories, GetFileInformationByHandleEx
+    and the FindFirstFileEx family on top of :func:`os.listdir`.  Each
+    call to GetFileInformationByHandleEx packs as many entries as fit into
+    the buffer provided.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_PATH_NOT_FOUND=3,
+        ERROR_NO_MORE_FILES=18,
+        FILE_LIST_DIRECTORY=0x0001,
+        FILE_SHARE_READ=0x00000001,
+        FILE_SHARE_WRITE=0x00000002,
+        FILE_SHARE_DELETE=0x00000004,
+        CREATE_NEW=1,
+        CREATE_ALWAYS=2,
+        OPEN_EXISTING=3,
+        OPEN_ALWAYS=4,
+        TRUNCATE_EXISTING=5,
+        FILE_FLAG_BACKUP_SEMANTICS=0x02000000,
+        FILE_ATTRIBUTE_DIRECTORY=0x00000010,
+        FILE_ATTRIBUTE_NORMAL=0x00000080,
+        FILE_ATTRIBUTE_REPARSE_POINT=0x00000400,
+        FindExInfoStandard=0,
+        FindExInfoBasic=1,
+        FindExSearchNameMatch=0,
+        FIND_FIRST_EX_LARGE_FETCH=0x00000002,
+        FileIdBothDirectoryInfo=10
+    )
+
+    def __init__(self, ffi):
+        super(DirectoryLibrary, self).__init__(ffi)
+        self.listings = {}
+        self.calls = 0
+        self.flags = None
+
+    def entries(self, path):
+        entries = [(u".", self.FILE_ATTRIBUTE_DIRECTORY, 0, 1),
+                   (u"..", self.FILE_ATTRIBUTE_DIRECTORY, 0, 2)]
+        for name in sorted(os.listdir(path)):
+            info = os.lstat(os.path.join(path, name))
+            if stat.S_ISLNK(info.st_mode):
+                attributes = self.FILE_ATTRIBUTE_REPARSE_POINT
+                if os.path.isdir(os.path.join(path, name)):
+                    attributes |= self.FILE_ATTRIBUTE_DIRECTORY
+            elif stat.S_ISDIR(info.st_mode):
+                attributes = self.FILE_ATTRIBUTE_DIRECTORY
+            else:
+                attributes = self.FILE_ATTRIBUTE_NORMAL
+            entries.append((name, attributes, info.st_size, info.st_ino))
+        return entries
+
+    def CreateFile(  # pylint: disable=too-many-arguments
+            self, lpFileName, dwDesiredAccess, dwShareMode,
+            lpSecurityAttributes, dwCreationDisposition,
+            dwFlagsAndAttributes, hTemplateFile):
+        assert dwFlagsAndAttributes & self.FILE_FLAG_BACKUP_SEMANTICS
+        try:
+            fd = os.open(lpFileName, os.O_RDONLY)
+        except OSError:
+            return self.fail(self.ERROR_PATH_NOT_FOUND, self.handle(-1))
+
+        self.listings[fd] = self.entries(lpFileName)
+        return self.handle(fd)
+
+    def CloseHandle(self, hObject):
+        fd = self.fd(hObject)
+        del self.listings[fd]
+        os.close(fd)
+        return 1
+
+    def GetFileInformationByHandleEx(
+            self, hFile, FileInformationClass, lpFileInformation,
+            dwBufferSize):
+        assert int(FileInformationClass) == self.FileIdBothDirectoryInfo
+        self.calls += 1
+        fd = self.fd(hFile)
+        if not self.listings[fd]:
+            return self.fail(self.ERROR_NO_MORE_FILES)
+
+        self.listings[fd] = pack_directory_info(
+            self.ffi, lpFileInformation, int(dwBufferSize),
+            self.listings[fd])
+        return 1
+
+    def FindFirstFileEx(  # pylint: disable=too-many-arguments
+            self, lpFileName, fInfoLevelId, lpFindFileData, fSearchOp,
+            lpSearchFilter, dwAdditionalFlags):
+        self.flags = int(dwAdditionalFlags)
+        directory, pattern = os.path.split(lpFileName)
+        assert pattern == u"*"
+        entries = self.entries(directory)
+        handle = self.handle(len(self.listings) + 1000)
+        self.listings[self.fd(handle)] = entries
+        if self.FindNextFile(handle, lpFindFileData):
+            return handle
+        return self.handle(-1)
+
+    def FindNextFile(self, hFindFile, lpFindFileData):
+        entries = self.listings[self.fd(hFindFile)]
+        if not entries:
+            return self.fail(self.ERROR_NO_MORE_FILES)
+
+        name, attributes, size, _ = entries.pop(0)
+        lpFindFileData.cFileName = name + u"\0"
+        lpFindFileData.dwFileAttributes = attributes
+        lpFindFileData.nFileSizeHigh = size >> 32
+        lpFindFileData.nFileSizeLow = size & 0xFFFFFFFF
+        return 1
+
+    def FindClose(self, hFindFile):
+        del self.listings[self.fd(hFindFile)]
+        return 1
+
+
+class DirectoryCase(TestCase):
+    """
+    Sets up :class:`DirectoryLibrary` and a small directory tree.
+    """
+    def setUp(self):
+        super(DirectoryCase, self).setUp()
+        self.library = self.standin_library(DirectoryLibrary)
+        self.ffi = self.library.ffi
+        self.top = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, self.top)
+
+        for path in (u"a", u"a/b", u"c"):
+            os.mkdir(os.path.join(self.top, path))
+        for path in (u"one.txt", u"a/two.txt", u"a/b/three.txt"):
+            with open(os.path.join(self.top, path), "w") as file_:
+                file_.write(path)
+
+
+class TestParseDirectoryInfo(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.directory.parse_directory_info`
+    """
+    def setUp(self):
+        super(TestParseDirectoryInfo, self).setUp()
+        self.library = self.standin_library(DirectoryLibrary)
+        self.ffi = self.library.ffi
+
+    def test_parse(self):
+        buffer_ = self.ffi.new("char[]", 1024)
+        remaining = pack_directory_info(self.ffi, buffer_, 1024, [
+            (u"first.txt", 0x80, 12345, 1),
+            (u"\u00e9t\u00e9", 0x10, 0, 2),
+            (u"x" * 40, 0x80, 2 ** 40, 3)
+        ])
+        self.assertEqual(remaining, [])
+
+        entries = list(parse_directory_info(buffer_, 1024))
+        self.assertEqual(
+            [entry.name for entry in entries],
+            [u"first.txt", u"\u00e9t\u00e9", u"x" * 40])
+        self.assertEqual(entries[0].size, 12345)
+        self.assertEqual(entries[2].size, 2 ** 40)
+        self.assertEqual(entries[1].file_id, 2)
+        self.assertEqual(entries[2].last_write_time, 30)
+        self.assertTrue(entries[1].is_directory)
+        self.assertFalse(entries[0].is_directory)
+
+    def test_parse_from_bytearray(self):
+        buffer_ = bytearray(256)
+        pack_directory_info(
+            self.ffi, self.ffi.from_buffer(buffer_), 256,
+            [(u"name", 0x80, 1, 1)])
+        entries = list(parse_directory_info(buffer_, 256))
+        self.assertEqual(entries[0].name, u"name")
+
+    def test_record_beyond_buffer(self):
+        buffer_ = self.ffi.new("char[]", 256)
+        pack_directory_info(self.ffi, buffer_, 256, [(u"x" * 10, 0, 0, 1)])
+        with self.assertRaises(InputError):
+            list(parse_directory_info(buffer_, 110))
+
+    def test_next_entry_beyond_buffer(self):
+        buffer_ = self.ffi.new("char[]", 256)
+        pack_directory_info(self.ffi, buffer_, 256, [(u"x", 0, 0, 1)])
+        self.ffi.cast("PFILE_ID_BOTH_DIR_INFO", buffer_).NextEntryOffset = 200
+        with self.assertRaises(InputError):
+            list(parse_directory_info(buffer_, 256))
+
+
+class TestIterDirectory(DirectoryCase):
+    """
+    Tests for :func:`pywincffi.kernel32.iter_directory` and
+    :func:`pywincffi.kernel32.list_directory`
+    """
+    def test_list_directory(self):
+        entries = list_directory(self.top)
+        self.assertEqual(
+            [entry.name for entry in entries], [u"a", u"c", u"one.txt"])
+        self.assertEqual(entries[2].size, len(u"one.txt"))
+        self.assertEqual(self.library.listings, {})
+
+    def test_small_buffer_needs_many_calls(self):
+        for i in range(20):
+            open(os.path.join(self.top, u"file%02d" % i), "w").close()
+
+        buffer_ = self.ffi.new("char[]", 256)
+        entries = list_directory(
+            self.top, lpFileInformation=buffer_, dwBufferSize=256)
+        self.assertEqual(len(entries), 23)
+        self.assertGreater(self.library.calls, 10)
+
+    def test_reuses_buffer(self):
+        handle = self.library.CreateFile(
+            self.top, 0, 0, None, 0, self.library.FILE_FLAG_BACKUP_SEMANTICS,
+            None)
+        self.addCleanup(self.library.CloseHandle, handle)
+        hDirectory = HANDLE(handle)
+        buffer_ = self.ffi.new("char[]", 1024)
+        entries = list(iter_directory(
+            hDirectory, lpFileInformation=buffer_, dwBufferSize=1024))
+        self.assertEqual(len(entries), 3)
+        self.assertEqual(self.ffi.string(
+            self.ffi.cast("PFILE_ID_BOTH_DIR_INFO", buffer_).FileName), u".")
+
+    def test_missing_directory(self):
+        with self.assertRaises(WindowsAPIError) as error:
+            list_directory(os.path.join(self.top, u"missing"))
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_PATH_NOT_FOUND)
+
+
+class TestFindFiles(DirectoryCase):
+    """
+    Tests for :func:`pywincffi.kernel32.find_files`
+    """
+    def test_find_files(self):
+        entries = list(find_files(os.path.join(self.top, u"*")))
+        self.assertEqual(
+            [entry.name for entry in entries], [u"a", u"c", u"one.txt"])
+        self.assertIsNone(entries[0].file_id)
+        self.assertEqual(
+            self.library.flags, self.library.FIND_FIRST_EX_LARGE_FETCH)
+        self.assertEqual(self.library.listings, {})
+
+    def test_without_large_fetch(self):
+        list(find_files(os.path.join(self.top, u"*"), large_fetch=False))
+        self.assertEqual(self.library.flags, 0)
+
+    def test_no_matches(self):
+        self.library.FindNextFile = \
+            lambda *args: self.library.fail(self.library.ERROR_FILE_NOT_FOUND)
+        self.assertEqual(list(find_files(os.path.join(self.top, u"*"))), [])
+
+    def test_invalid_info_level(self):
+        with self.assertRaises(InputError):
+            FindFirstFileEx(u"*", fInfoLevelId=5)
+
+
+class TestWalk(DirectoryCase):
+    """
+    Tests for :func:`pywincffi.kernel32.walk`
+    """
+    def names(self, results):
+        return [
+            (os.path.relpath(path, self.top),
+             [entry.name for entry in directories],
+             [entry.name for entry in files])
+            for path, directories, files in results]
+
+    def test_topdown(self):
+        self.assertEqual(self.names(walk(self.top)), [
+            (u".", [u"a", u"c"], [u"one.txt"]),
+            (u"a", [u"b"], [u"two.txt"]),
+            (os.path.join(u"a", u"b"), [], [u"three.txt"]),
+            (u"c", [], [])
+        ])
+
+    def test_bottom_up(self):
+        self.assertEqual(self.names(walk(self.top, topdown=False)), [
+            (os.path.join(u"a", u"b"), [], [u"three.txt"]),
+            (u"a", [u"b"], [u"two.txt"]),
+            (u"c", [], []),
+            (u".", [u"a", u"c"], [u"one.txt"])
+        ])
+
+    def test_prune(self):
+        paths = []
+        for path, directories, _ in walk(self.top):
+            paths.append(os.path.relpath(path, self.top))
+            directories[:] = [
+                entry for entry in directories if entry.name != u"a"]
+        self.assertEqual(paths, [u".", u"c"])
+
+    def test_links_not_followed(self):
+        os.symlink(
+            os.path.join(self.top, u"a"), os.path.join(self.top, u"link"))
+        paths = [path for path, _, _ in walk(self.top)]
+        self.assertNotIn(os.path.join(self.top, u"link"), paths)
+
+        paths = [path for path, _, _ in walk(self.top, followlinks=True)]
+        self.assertIn(os.path.join(self.top, u"link", u"b"), paths)
+
+    def test_onerror(self):
+        errors = []
+        list(walk(os.path.join(self.top, u"missing"), onerror=errors.append))
+        self.assertEqual(len(errors), 1)
+        self.assertIsInstance(errors[0], WindowsAPIError)
@@ -3,6 +3,7 @@ import ctypes
 import tempfile
 import subprocess
 import sys
+import threading
 from errno import EEXIST
 from os.path import isfile
 
@@ -10,14 +11,16 @@ from mock import patch
 from six import text_type
 
 from pywincffi.core import dist
-from pywincffi.dev.testutil import TestCase
+from pywincffi.dev.testutil import TestCase, StandInLibrary
 from pywincffi.exceptions import WindowsAPIError
 
 from pywincffi.kernel32 import file as _file  # used for mocks
 from pywincffi.kernel32 import (
     CreateFile, CloseHandle, MoveFileEx, WriteFile, FlushFileBuffers,
-    LockFileEx, UnlockFileEx, ReadFile, GetTempPath)
-from pywincffi.wintypes import handle_from_file
+    LockFileEx, UnlockFileEx, ReadFile, GetTempPath, SetFilePointerEx,
+    GetFileSizeEx, OverlappedPool, pread, pread_into, pwrite,
+    GetDiskFreeSpace, GetDiskFreeSpaceResult, GetVolumePathName, sector_size)
+from pywincffi.wintypes import HANDLE, handle_from_file
 
 
 class TestWriteFile(TestCase):
@@ -304,3 +307,286 @@ class TestGetTempPath(TestCase):
             os.makedirs(path)
         except OSError as err:
             self.assertEqual(err.errno, EEXIST)
+
+
+class PositionedIOLibrary(StandInLibrary):
+    """
+    Implements ReadFile and WriteFile on top of :func:`os.pread` and
+    :func:`os.pwrite` using the offset stored in the OVERLAPPED structure.
+    When ``pending`` is set operations complete through
+    GetOverlappedResult as they would on a FILE_FLAG_OVERLAPPED handle.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS, FILE_BEGIN=0, FILE_CURRENT=1, FILE_END=2)
+
+    def __init__(self, ffi):
+        super(PositionedIOLibrary, self).__init__(ffi)
+        self.pending = False
+        self.error = None
+        self.offsets = []
+        self.events = []
+        self.hEvents = []
+
+    def CreateEvent(self, lpEventAttributes, bManualReset, bInitialState,
+                    lpName):
+        assert bManualReset and not bInitialState
+        self.events.append(self.handle(0x7000 + len(self.events)))
+        return self.events[-1]
+
+    def _transfer(self, lpOverlapped, lpNumberOfBytes, count):
+        lpNumberOfBytes[0] = count
+        if self.pending:
+            lpOverlapped.InternalHigh = count
+            return self.fail(self.ERROR_IO_PENDING)
+        return 1
+
+    def _offset(self, lpOverlapped):
+        self.hEvents.append(lpOverlapped.hEvent)
+        self.offsets.append((lpOverlapped.OffsetHigh, lpOverlapped.Offset))
+        return lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset
+
+    def ReadFile(self, hFile, lpBuffer, nNumberOfBytesToRead,
+                 lpNumberOfBytesRead, lpOverlapped):
+        if self.error is not None:
+            return self.fail(self.error)
+
+        data = os.pread(
+            self.fd(hFile), nNumberOfBytesToRead, self._offset(lpOverlapped))
+        if not data and nNumberOfBytesToRead:
+            return self.fail(self.ERROR_HANDLE_EOF)
+
+        self.ffi.memmove(lpBuffer, data, len(data))
+        return self._transfer(lpOverlapped, lpNumberOfBytesRead, len(data))
+
+    def WriteFile(self, hFile, lpBuffer, nNumberOfBytesToWrite,
+                  lpNumberOfBytesWritten, lpOverlapped):
+        written = os.pwrite(
+            self.fd(hFile), self.ffi.buffer(lpBuffer, nNumberOfBytesToWrite),
+            self._offset(lpOverlapped))
+        return self._transfer(lpOverlapped, lpNumberOfBytesWritten, written)
+
+    def GetOverlappedResult(self, hFile, lpOverlapped,
+                            lpNumberOfBytesTransferred, bWait):
+        lpNumberOfBytesTransferred[0] = lpOverlapped.InternalHigh
+        return 1
+
+    def SetFilePointerEx(self, hFile, liDistanceToMove, lpNewFilePointer,
+                         dwMoveMethod):
+        lpNewFilePointer.QuadPart = os.lseek(
+            self.fd(hFile), liDistanceToMove.QuadPart, int(dwMoveMethod))
+        return 1
+
+    def GetFileSizeEx(self, hFile, lpFileSize):
+        lpFileSize.QuadPart = os.fstat(self.fd(hFile)).st_size
+        return 1
+
+
+class PositionedIOCase(TestCase):
+    """
+    Sets up :class:`PositionedIOLibrary` and a temporary file for each test.
+    """
+    def setUp(self):
+        super(PositionedIOCase, self).setUp()
+        self.library = self.standin_library(PositionedIOLibrary)
+        pool = OverlappedPool(
+            event_factory=_file.DEFAULT_OVERLAPPED_POOL.event_factory)
+        patcher = patch.object(_file, "DEFAULT_OVERLAPPED_POOL", pool)
+        patcher.start()
+        self.addCleanup(patcher.stop)
+        fd, self.path = tempfile.mkstemp()
+        self.addCleanup(os.remove, self.path)
+        self.addCleanup(os.close, fd)
+        os.write(fd, b"0123456789" * 10)
+        os.lseek(fd, 0, os.SEEK_SET)
+        self.fd = fd
+        self.hFile = HANDLE(self.library.handle(fd))
+
+
+class TestSetFilePointerEx(PositionedIOCase):
+    """
+    Tests for :func:`pywincffi.kernel32.SetFilePointerEx`
+    """
+    def test_from_beginning(self):
+        self.assertEqual(SetFilePointerEx(self.hFile, 10), 10)
+        self.assertEqual(os.lseek(self.fd, 0, os.SEEK_CUR), 10)
+
+    def test_from_end(self):
+        self.assertEqual(
+            SetFilePointerEx(self.hFile, -10, self.library.FILE_END), 90)
+
+
+class TestGetFileSizeEx(PositionedIOCase):
+    """
+    Tests for :func:`pywincffi.kernel32.GetFileSizeEx`
+    """
+    def test_size(self):
+        self.assertEqual(GetFileSizeEx(self.hFile), 100)
+
+
+class TestPread(PositionedIOCase):
+    """
+    Tests for :func:`pywincffi.kernel32.pread`
+    """
+    def test_reads_at_offset(self):
+        self.assertEqual(pread(self.hFile, 5, 13), b"34567")
+
+    def test_does_not_move_file_pointer(self):
+        pread(self.hFile, 5, 13)
+        self.assertEqual(os.lseek(self.fd, 0, os.SEEK_CUR), 0)
+
+    def test_end_of_file(self):
+        self.assertEqual(pread(self.hFile, 5, 100), b"")
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_short_read(self):
+        self.assertEqual(pread(self.hFile, 10, 95), b"56789")
+
+    def test_64_bit_offset(self):
+        pread(self.hFile, 5, (3 << 32) + 7)
+        self.assertEqual(self.library.offsets, [(3, 7)])
+
+    def test_pending(self):
+        self.library.pending = True
+        self.assertEqual(pread(self.hFile, 5, 13), b"34567")
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_error(self):
+        self.library.error = self.library.ERROR_ACCESS_DENIED
+        with self.assertRaises(WindowsAPIError) as error:
+            pread(self.hFile, 5, 0)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_ACCESS_DENIED)
+
+    def test_default_pool_waits_on_events(self):
+        pread(self.hFile, 1, 0)
+        pwrite(self.hFile, b"x", 0)
+        self.assertEqual(len(self.library.events), 1)
+        self.assertEqual(self.library.hEvents, self.library.events * 2)
+
+    def test_reuses_pool(self):
+        pool = OverlappedPool()
+        for offset in range(10):
+            pread(self.hFile, 1, offset, pool=pool)
+
+        self.assertEqual(pool.created, 1)
+        self.assertEqual(len(pool), 1)
+
+    def test_concurrent_readers(self):
+        pool = OverlappedPool()
+        errors = []
+
+        def reader(start):
+            try:
+                for offset in range(start, 100, 7):
+                    data = pread(self.hFile, 1, offset, pool=pool)
+                    if data != str(offset % 10).encode("ascii"):
+                        errors.append((offset, data))
+            except Exception as error:  # pylint: disable=broad-except
+                errors.append(error)
+
+        threads = [
+            threading.Thread(target=reader, args=(i, )) for i in range(7)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        self.assertEqual(errors, [])
+        self.assertLessEqual(pool.created, len(threads))
+
+
+class TestPreadInto(PositionedIOCase):
+    """
+    Tests for :func:`pywincffi.kernel32.pread_into`
+    """
+    def test_reads_into_buffer(self):
+        buffer_ = bytearray(4)
+        self.assertEqual(pread_into(self.hFile, buffer_, 20), 4)
+        self.assertEqual(bytes(buffer_), b"0123")
+
+
+class TestPwrite(PositionedIOCase):
+    """
+    Tests for :func:`pywincffi.kernel32.pwrite`
+    """
+    def test_writes_at_offset(self):
+        self.assertEqual(pwrite(self.hFile, b"abc", 50), 3)
+        self.assertEqual(pread(self.hFile, 5, 49), b"9abc3")
+        self.assertEqual(os.lseek(self.fd, 0, os.SEEK_CUR), 0)
+
+    def test_writes_memoryview(self):
+        pwrite(self.hFile, memoryview(b"xyz"), 0)
+        self.assertEqual(pread(self.hFile, 3, 0), b"xyz")
+
+
+class VolumeLibrary(StandInLibrary):
+    """
+    Implements GetVolumePathName and GetDiskFreeSpace for two volumes,
+    ``C:\\`` with 512 byte sectors and ``D:\\`` with 4096 byte sectors.
+    """
+    CONSTANTS = dict(StandInLibrary.CONSTANTS, MAX_PATH=260)
+    SECTORS = {u"C:\\": 512, u"D:\\": 4096}
+
+    def __init__(self, ffi):
+        super(VolumeLibrary, self).__init__(ffi)
+        self.queried = []
+
+    def string(self, value):
+        # Stand-ins receive Python strings as they were passed in
+        if isinstance(value, text_type):
+            return value
+        return self.ffi.string(value)
+
+    def GetVolumePathName(self, lpszFileName, lpszVolumePathName,
+                          cchBufferLength):
+        volume = self.string(lpszFileName)[:3]
+        if volume not in self.SECTORS:
+            return self.fail(self.ERROR_FILE_NOT_FOUND)
+        for index, character in enumerate(volume):
+            lpszVolumePathName[index] = character
+        return 1
+
+    def GetDiskFreeSpace(  # pylint: disable=too-many-arguments
+            self, lpRootPathName, lpSectorsPerCluster, lpBytesPerSector,
+            lpNumberOfFreeClusters, lpTotalNumberOfClusters):
+        volume = self.string(lpRootPathName)
+        self.queried.append(volume)
+        lpSectorsPerCluster[0] = 8
+        lpBytesPerSector[0] = self.SECTORS[volume]
+        lpNumberOfFreeClusters[0] = 10
+        lpTotalNumberOfClusters[0] = 20
+        return 1
+
+
+class TestSectorSize(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.sector_size`
+    """
+    def setUp(self):
+        super(TestSectorSize, self).setUp()
+        self.library = self.standin_library(VolumeLibrary)
+        patcher = patch.dict(_file._SECTOR_SIZE_CACHE, clear=True)
+        patcher.start()
+        self.addCleanup(patcher.stop)
+
+    def test_get_disk_free_space(self):
+        self.assertEqual(
+            GetDiskFreeSpace(u"D:\\"),
+            GetDiskFreeSpaceResult(
+                lpSectorsPerCluster=8, lpBytesPerSector=4096,
+                lpNumberOfFreeClusters=10, lpTotalNumberOfClusters=20))
+
+    def test_get_volume_path_name(self):
+        self.assertEqual(GetVolumePathName(u"C:\\data\\file.bin"), u"C:\\")
+
+    def test_queried_once_per_volume(self):
+        self.assertEqual(sector_size(u"C:\\a"), 512)
+        self.assertEqual(sector_size(u"C:\\b\\c"), 512)
+        self.assertEqual(sector_size(u"D:\\a"), 4096)
+        self.assertEqual(sector_size(u"D:\\b"), 4096)
+        self.assertEqual(self.library.queried, [u"C:\\", u"D:\\"])
+
+    def test_unknown_volume(self):
+        with self.assertRaises(WindowsAPIError):
+            sector_size(u"Q:\\a")
@@ -0,0 +1,506 @@
+import os
+import shutil
+import stat
+import tempfile
+
+from mock import patch
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import filecopy, memory
+from pywincffi.kernel32.filecopy import (
+    Cancellation, CopyFileEx, copy_file, copy_handle)
+from pywincffi.kernel32.memory import AlignedBufferPool
+from pywincffi.kernel32.overlapped import OverlappedPool
+from pywincffi.wintypes import HANDLE
+
+
+class CopyLibrary(StandInLibrary):
+    """
+    Implements CopyFileEx on top of plain file objects, calling the
+    progress routine after each ``CHUNK`` bytes, and ReadFile/WriteFile on
+    top of :func:`os.pread`/:func:`os.pwrite`, or :func:`os.read` and
+    :func:`os.write` for pipes.  When ``pending`` is set reads and writes
+    are only performed once GetOverlappedResult is called, every call is
+    recorded in ``events`` and ``in_flight`` records the functions of the
+    operations which were pending together whenever one is started.
+    ``max_write`` limits how many bytes each write transfers and, like a
+    handle opened with ``FILE_FLAG_NO_BUFFERING``, reads and writes fail
+    unless their offset and length are multiples of ``sector``, if set.
+    """
+    CHUNK = 64 * 1024
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_FILE_EXISTS=80,
+        ERROR_REQUEST_ABORTED=1235,
+        ERROR_WRITE_FAULT=29,
+        COPY_FILE_FAIL_IF_EXISTS=0x00000001,
+        COPY_FILE_NO_BUFFERING=0x00001000,
+        PROGRESS_CONTINUE=0,
+        PROGRESS_CANCEL=1,
+        PROGRESS_STOP=2,
+        PROGRESS_QUIET=3,
+        CALLBACK_CHUNK_FINISHED=0,
+        CALLBACK_STREAM_SWITCH=1,
+        PAGE_READWRITE=0x04,
+        MEM_COMMIT=0x1000,
+        MEM_RESERVE=0x2000,
+        MEM_RELEASE=0x8000,
+        FILE_BEGIN=0,
+        FILE_CURRENT=1,
+        FILE_END=2
+    )
+
+    def __init__(self, ffi):
+        super(CopyLibrary, self).__init__(ffi)
+        self.flags = None
+        self.pending = False
+        self.events = []
+        self.operations = {}
+        self.allocations = {}
+        self.write_error = None
+        self.event_handles = 0
+        self.max_write = None
+        self.sector = None
+        self.in_flight = []
+
+    def CreateEvent(self, lpEventAttributes, bManualReset, bInitialState,
+                    lpName):
+        self.event_handles += 1
+        return self.handle(0x7000 + self.event_handles)
+
+    def large_integer(self, value):
+        integer = self.ffi.new("PLARGE_INTEGER")
+        integer.QuadPart = value
+        return integer[0]
+
+    def CopyFileEx(  # pylint: disable=too-many-arguments
+            self, lpExistingFileName, lpNewFileName, lpProgressRoutine,
+            lpData, pbCancel, dwCopyFlags):
+        self.flags = int(dwCopyFlags)
+        if dwCopyFlags & self.COPY_FILE_FAIL_IF_EXISTS and \
+                os.path.exists(lpNewFileName):
+            return self.fail(self.ERROR_FILE_EXISTS)
+
+        total = os.path.getsize(lpExistingFileName)
+        with open(lpExistingFileName, "rb") as source, \
+                open(lpNewFileName, "wb") as destination:
+            transferred = 0
+            while True:
+                if pbCancel != self.ffi.NULL and pbCancel[0]:
+                    return self.fail(self.ERROR_REQUEST_ABORTED)
+
+                data = source.read(self.CHUNK)
+                if not data:
+                    return 1
+
+                destination.write(data)
+                transferred += len(data)
+                if lpProgressRoutine == self.ffi.NULL:
+                    continue
+
+                result = lpProgressRoutine(
+                    self.large_integer(total),
+                    self.large_integer(transferred),
+                    self.large_integer(total),
+                    self.large_integer(transferred),
+                    1, self.CALLBACK_CHUNK_FINISHED,
+                    self.handle(source.fileno()),
+                    self.handle(destination.fileno()), lpData)
+                if result == self.PROGRESS_CANCEL:
+                    return self.fail(self.ERROR_REQUEST_ABORTED)
+
+    def _perform(self, function, fd, lpBuffer, count, offset):
+        if function == "ReadFile":
+            if stat.S_ISFIFO(os.fstat(fd).st_mode):
+                data = os.read(fd, count)
+            else:
+                data = os.pread(fd, count, offset)
+            if not data:
+                return None
+            self.ffi.memmove(lpBuffer, data, len(data))
+            return len(data)
+
+        if self.write_error is not None:
+            return None
+
+        if self.max_write is not None:
+            count = min(count, self.max_write)
+
+        data = self.ffi.buffer(lpBuffer, count)
+        if stat.S_ISFIFO(os.fstat(fd).st_mode):
+            return os.write(fd, data)
+        return os.pwrite(fd, data, offset)
+
+    def _error(self, function):
+        if function == "ReadFile":
+            return self.ERROR_BROKEN_PIPE
+        return self.write_error
+
+    def _start(  # pylint: disable=too-many-arguments
+            self, function, hFile, lpBuffer, count, lpNumberOfBytes,
+            lpOverlapped):
+        fd = self.fd(hFile)
+        offset = lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset
+        self.events.append(("start", function, offset))
+        if self.sector is not None and (
+                offset % self.sector or int(count) % self.sector):
+            return self.fail(self.ERROR_INVALID_PARAMETER)
+
+        if self.pending:
+            address = int(self.ffi.cast("uintptr_t", lpOverlapped))
+            self.operations[address] = (
+                function, offset,
+                (function, fd, lpBuffer, int(count), offset))
+            self.in_flight.append(sorted(
+                operation[0] for operation in self.operations.values()))
+            return self.fail(self.ERROR_IO_PENDING)
+
+        result = self._perform(function, fd, lpBuffer, int(count), offset)
+        if result is None:
+            return self.fail(self._error(function))
+        lpNumberOfBytes[0] = result
+        return 1
+
+    def ReadFile(self, hFile, lpBuffer, nNumberOfBytesToRead,
+                 lpNumberOfBytesRead, lpOverlapped):
+        return self._start(
+            "ReadFile", hFile, lpBuffer, nNumberOfBytesToRead,
+            lpNumberOfBytesRead, lpOverlapped)
+
+    def WriteFile(self, hFile, lpBuffer, nNumberOfBytesToWrite,
+                  lpNumberOfBytesWritten, lpOverlapped):
+        return self._start(
+            "WriteFile", hFile, lpBuffer, nNumberOfBytesToWrite,
+            lpNumberOfBytesWritten, lpOverlapped)
+
+    def GetOverlappedResult(self, hFile, lpOverlapped,
+                            lpNumberOfBytesTransferred, bWait):
+        function, offset, arguments = self.operations.pop(
+            int(self.ffi.cast("uintptr_t", lpOverlapped)))
+        self.events.append(("finish", function, offset))
+        result = self._perform(*arguments)
+        if result is None:
+            return self.fail(self._error(function))
+        lpNumberOfBytesTransferred[0] = result
+        return 1
+
+    def SetFilePointerEx(self, hFile, liDistanceToMove, lpNewFilePointer,
+                         dwMoveMethod):
+        lpNewFilePointer.QuadPart = os.lseek(
+            self.fd(hFile), liDistanceToMove.QuadPart, int(dwMoveMethod))
+        return 1
+
+    def SetEndOfFile(self, hFile):
+        fd = self.fd(hFile)
+        os.ftruncate(fd, os.lseek(fd, 0, os.SEEK_CUR))
+        return 1
+
+    def GetSystemInfo(self, lpSystemInfo):
+        lpSystemInfo.dwPageSize = 4096
+        lpSystemInfo.dwAllocationGranularity = 65536
+
+    def VirtualAlloc(self, lpAddress, dwSize, flAllocationType, flProtect):
+        # Not aligned, the tests here only rely on the buffers being reused
+        memory_ = self.ffi.new("char[]", int(dwSize))
+        self.allocations[int(self.ffi.cast("uintptr_t", memory_))] = memory_
+        return self.ffi.cast("LPVOID", memory_)
+
+    def VirtualFree(self, lpAddress, dwSize, dwFreeType):
+        del self.allocations[int(self.ffi.cast("uintptr_t", lpAddress))]
+        return 1
+
+
+class CopyTestCase(TestCase):
+    """
+    Sets up :class:`CopyLibrary` and a source file for each test.
+    """
+    def setUp(self):
+        super(CopyTestCase, self).setUp()
+        self.library = self.standin_library(CopyLibrary)
+        pool = OverlappedPool(
+            event_factory=filecopy.DEFAULT_OVERLAPPED_POOL.event_factory)
+        for name, value in (("_PROGRESS_ROUTINE_FFI", []),
+                            ("DEFAULT_OVERLAPPED_POOL", pool)):
+            patcher = patch.object(filecopy, name, value)
+            patcher.start()
+            self.addCleanup(patcher.stop)
+
+        self.directory = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, self.directory)
+        self.contents = os.urandom(CopyLibrary.CHUNK * 3 + 100)
+        self.source = self.path(u"source")
+        with open(self.source, "wb") as file_:
+            file_.write(self.contents)
+
+    def path(self, name):
+        return os.path.join(self.directory, name)
+
+    def read(self, path):
+        with open(path, "rb") as file_:
+            return file_.read()
+
+    def open(self, path, flags):
+        fd = os.open(path, flags, 0o600)
+        self.addCleanup(os.close, fd)
+        return HANDLE(self.library.handle(fd))
+
+
+class TestCopyFileEx(CopyTestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.CopyFileEx`
+    """
+    def test_copy(self):
+        CopyFileEx(self.source, self.path(u"copy"))
+        self.assertEqual(self.read(self.path(u"copy")), self.contents)
+
+    def test_progress_routine(self):
+        calls = []
+
+        def routine(*args):
+            calls.append(args[:6] + (args[-1], ))
+
+        CopyFileEx(self.source, self.path(u"copy"), routine, lpData="data")
+        self.assertEqual(len(calls), 4)
+        self.assertEqual(
+            calls[0], (len(self.contents), CopyLibrary.CHUNK,
+                       len(self.contents), CopyLibrary.CHUNK, 1,
+                       self.library.CALLBACK_CHUNK_FINISHED, "data"))
+        self.assertEqual(calls[-1][1], len(self.contents))
+
+    def test_progress_routine_cancels(self):
+        def routine(*_):
+            return self.library.PROGRESS_CANCEL
+
+        with self.assertRaises(WindowsAPIError) as error:
+            CopyFileEx(self.source, self.path(u"copy"), routine)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_REQUEST_ABORTED)
+
+    def test_progress_routine_raises(self):
+        def routine(*_):
+            raise KeyError("failed")
+
+        with self.assertRaises(KeyError):
+            CopyFileEx(self.source, self.path(u"copy"), routine)
+
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_routine_not_callable(self):
+        with self.assertRaises(InputError):
+            CopyFileEx(self.source, self.path(u"copy"), 1)
+
+
+class TestCopyFile(CopyTestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.copy_file`
+    """
+    def test_progress(self):
+        progress = []
+        copy_file(self.source, self.path(u"copy"),
+                  lambda *args: progress.append(args))
+        self.assertEqual(progress[0], (CopyLibrary.CHUNK, len(self.contents)))
+        self.assertEqual(
+            progress[-1], (len(self.contents), len(self.contents)))
+
+    def test_cancel_from_progress(self):
+        cancel = Cancellation()
+        with self.assertRaises(WindowsAPIError) as error:
+            copy_file(self.source, self.path(u"copy"),
+                      lambda *_: cancel.cancel(), cancel)
+
+        self.assertTrue(cancel.cancelled)
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_REQUEST_ABORTED)
+        self.assertEqual(
+            os.path.getsize(self.path(u"copy")), CopyLibrary.CHUNK)
+
+    def test_overwrite(self):
+        destination = self.path(u"copy")
+        copy_file(self.source, destination)
+        copy_file(self.source, destination)
+        with self.assertRaises(WindowsAPIError) as error:
+            copy_file(self.source, destination, overwrite=False)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_FILE_EXISTS)
+
+    def test_no_buffering_for_large_files(self):
+        copy_file(self.source, self.path(u"copy"))
+        self.assertEqual(self.library.flags, 0)
+
+        with patch.object(
+                filecopy, "NO_BUFFERING_THRESHOLD", len(self.contents)):
+            copy_file(self.source, self.path(u"copy"))
+
+        self.assertEqual(
+            self.library.flags, self.library.COPY_FILE_NO_BUFFERING)
+
+    def test_no_buffering_explicit(self):
+        copy_file(self.source, self.path(u"copy"), no_buffering=True)
+        self.assertEqual(
+            self.library.flags, self.library.COPY_FILE_NO_BUFFERING)
+
+
+class TestCopyHandle(CopyTestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.copy_handle`
+    """
+    def copy(self, **kwargs):
+        destination = self.path(u"copy")
+        copied = copy_handle(
+            self.open(self.source, os.O_RDONLY),
+            self.open(destination, os.O_WRONLY | os.O_CREAT), **kwargs)
+        return copied, self.read(destination)
+
+    def test_copy(self):
+        copied, data = self.copy(chunk_size=1000)
+        self.assertEqual(copied, len(self.contents))
+        self.assertEqual(data, self.contents)
+
+    def test_copy_overlapped(self):
+        self.library.pending = True
+        copied, data = self.copy(chunk_size=1000)
+        self.assertEqual(copied, len(self.contents))
+        self.assertEqual(data, self.contents)
+
+    def test_double_buffered(self):
+        self.library.pending = True
+        chunk_size = len(self.contents) // 2 + 1
+        self.copy(chunk_size=chunk_size)
+
+        # The next read is started before the previous write is finished
+        second, end = chunk_size, len(self.contents)
+        self.assertEqual(self.library.events, [
+            ("start", "ReadFile", 0),
+            ("finish", "ReadFile", 0),
+            ("start", "WriteFile", 0),
+            ("start", "ReadFile", second),
+            ("finish", "WriteFile", 0),
+            ("finish", "ReadFile", second),
+            ("start", "WriteFile", second),
+            ("start", "ReadFile", end),
+            ("finish", "WriteFile", second),
+            ("finish", "ReadFile", end)
+        ])
+
+    def test_size(self):
+        copied, data = self.copy(size=1500, chunk_size=1000)
+        self.assertEqual(copied, 1500)
+        self.assertEqual(data, self.contents[:1500])
+
+    def test_empty_size(self):
+        copied, data = self.copy(size=0)
+        self.assertEqual(copied, 0)
+        self.assertEqual(data, b"")
+        self.assertEqual(self.library.events, [])
+
+    def test_progress(self):
+        progress = []
+        self.copy(size=2500, chunk_size=1000,
+                  progress=lambda *args: progress.append(args))
+        self.assertEqual(progress, [(1000, 2500), (2000, 2500), (2500, 2500)])
+
+    def test_cancel(self):
+        cancel = Cancellation()
+
+        def progress(transferred, _):
+            if transferred >= 2000:
+                cancel.cancel()
+
+        self.library.pending = True
+        with self.assertRaises(WindowsAPIError) as error:
+            self.copy(chunk_size=1000, progress=progress, cancel=cancel)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_REQUEST_ABORTED)
+        self.assertEqual(self.library.operations, {})
+
+    def test_write_error_waits_for_read(self):
+        self.library.pending = True
+        self.library.write_error = self.library.ERROR_ACCESS_DENIED
+        with self.assertRaises(WindowsAPIError) as error:
+            self.copy(chunk_size=1000)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_ACCESS_DENIED)
+        self.assertEqual(self.library.operations, {})
+
+    def test_write_broken_pipe_raises(self):
+        self.library.write_error = self.library.ERROR_BROKEN_PIPE
+        with self.assertRaises(WindowsAPIError) as error:
+            self.copy(chunk_size=1000)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_BROKEN_PIPE)
+
+    def test_short_writes_resubmitted(self):
+        self.library.pending = True
+        self.library.max_write = 300
+        copied, data = self.copy(chunk_size=1000)
+        self.assertEqual(copied, len(self.contents))
+        self.assertEqual(data, self.contents)
+        self.assertIn(("start", "WriteFile", 300), self.library.events)
+        self.assertIn(("start", "WriteFile", 900), self.library.events)
+
+    def test_write_without_progress(self):
+        self.library.max_write = 0
+        with self.assertRaises(WindowsAPIError) as error:
+            self.copy(chunk_size=1000)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_WRITE_FAULT)
+
+    def test_reads_overlap_writes(self):
+        self.library.pending = True
+        copied, data = self.copy(chunk_size=1000)
+        self.assertEqual(data, self.contents)
+
+        # Each read is started while the previous chunk is being written
+        # and no more than one read and one write are ever outstanding.
+        writes = -(-copied // 1000)
+        self.assertEqual(
+            self.library.in_flight.count(["ReadFile", "WriteFile"]), writes)
+        self.assertEqual(max(map(len, self.library.in_flight)), 2)
+
+    def test_pipe(self):
+        reader, writer = os.pipe()
+        self.addCleanup(os.close, reader)
+        os.write(writer, self.contents[:5000])
+        os.close(writer)
+
+        destination = self.path(u"copy")
+        copied = copy_handle(
+            HANDLE(self.library.handle(reader)),
+            self.open(destination, os.O_WRONLY | os.O_CREAT),
+            chunk_size=4096)
+        self.assertEqual(copied, 5000)
+        self.assertEqual(self.read(destination), self.contents[:5000])
+
+    def test_buffer_pool(self):
+        with patch.dict(memory._SYSTEM_INFO_CACHE, clear=True):
+            with AlignedBufferPool(512, 1024) as buffer_pool:
+                copied, data = self.copy(buffer_pool=buffer_pool)
+                self.assertEqual(len(buffer_pool), buffer_pool.created)
+
+        self.assertEqual(copied, len(self.contents))
+        self.assertEqual(data, self.contents)
+
+    def test_buffer_pool_unbuffered(self):
+        # Like FILE_FLAG_NO_BUFFERING handles, every read and write must be
+        # whole sectors so the tail is padded and the copy truncated.
+        self.library.sector = 512
+        with patch.dict(memory._SYSTEM_INFO_CACHE, clear=True):
+            with AlignedBufferPool(512, 1024) as buffer_pool:
+                copied, data = self.copy(buffer_pool=buffer_pool)
+                self.assertEqual(self.copy(
+                    buffer_pool=buffer_pool, size=1500), (1500, data[:1500]))
+
+        self.assertEqual(copied, len(self.contents))
+        self.assertEqual(data, self.contents)
+
+    def test_overlapped_pool(self):
+        pool = OverlappedPool()
+        self.copy(chunk_size=1000, pool=pool)
+        self.assertEqual(pool.created, 2)
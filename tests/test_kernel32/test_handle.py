@@ -1,15 +1,20 @@
+import gc
 import os
 import shutil
 import socket
 import subprocess
 import sys
 import tempfile
+import warnings
 
 from pywincffi.core import dist
-from pywincffi.dev.testutil import TestCase
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import HandleCloseError, InputError
 from pywincffi.kernel32 import (
     GetStdHandle, CloseHandle, GetHandleInformation,
-    SetHandleInformation, DuplicateHandle, GetCurrentProcess, CreateEvent)
+    SetHandleInformation, DuplicateHandle, GetCurrentProcess, CreateEvent,
+    OwnedHandle, HandleGroup)
+from pywincffi.kernel32.handle import LeakWarning
 from pywincffi.wintypes import HANDLE, handle_from_file
 
 
@@ -218,3 +223,161 @@ class TestDuplicateHandle(TestCase):
         self.addCleanup(CloseHandle, handle)
         info = GetHandleInformation(handle)
         self.assertEqual(info, library.HANDLE_FLAG_INHERIT)
+
+
+class CloseHandleLibrary(StandInLibrary):
+    """
+    Implements CloseHandle by recording each handle closed.  Handles in
+    ``invalid`` fail to close with ``ERROR_INVALID_HANDLE``.
+    """
+    def __init__(self, ffi):
+        super(CloseHandleLibrary, self).__init__(ffi)
+        self.closed = []
+        self.invalid = set()
+
+    def CloseHandle(self, hObject):
+        value = self.fd(hObject)
+        if value in self.invalid or value in self.closed:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        self.closed.append(value)
+        return 1
+
+
+class CloseHandleCase(TestCase):
+    """
+    Sets up :class:`CloseHandleLibrary` for each test.
+    """
+    def setUp(self):
+        super(CloseHandleCase, self).setUp()
+        self.library = self.standin_library(CloseHandleLibrary)
+
+    def handle(self, value):
+        return HANDLE(self.library.handle(value))
+
+
+class TestOwnedHandle(CloseHandleCase):
+    """
+    Tests for :class:`pywincffi.kernel32.OwnedHandle`
+    """
+    def test_closed_on_exit(self):
+        with OwnedHandle(self.handle(1)) as handle:
+            self.assertIsInstance(handle, HANDLE)
+        self.assertEqual(self.library.closed, [1])
+
+    def test_closed_on_exception(self):
+        with self.assertRaises(ZeroDivisionError):
+            with OwnedHandle(self.handle(1)):
+                1 / 0
+        self.assertEqual(self.library.closed, [1])
+
+    def test_close_twice(self):
+        owned = OwnedHandle(self.handle(1))
+        owned.close()
+        owned.close()
+        self.assertTrue(owned.closed)
+        self.assertEqual(self.library.closed, [1])
+
+    def test_detach(self):
+        handle = self.handle(1)
+        owned = OwnedHandle(handle)
+        self.assertIs(owned.detach(), handle)
+        owned.close()
+        self.assertEqual(self.library.closed, [])
+
+    def test_safety_net_closes_leaked_handle(self):
+        leaked = OwnedHandle.leaked
+        owned = OwnedHandle(self.handle(5), safety_net=True)
+        with warnings.catch_warnings(record=True) as caught:
+            warnings.simplefilter("always")
+            del owned
+            gc.collect()
+
+        self.assertEqual(self.library.closed, [5])
+        self.assertEqual(OwnedHandle.leaked, leaked + 1)
+        self.assertEqual(caught[0].category, LeakWarning)
+
+    def test_safety_net_ignores_closed_handle(self):
+        leaked = OwnedHandle.leaked
+        owned = OwnedHandle(self.handle(5), safety_net=True)
+        owned.close()
+        del owned
+        gc.collect()
+        self.assertEqual(self.library.closed, [5])
+        self.assertEqual(OwnedHandle.leaked, leaked)
+
+    def test_safety_net_follows_handle(self):
+        leaked = OwnedHandle.leaked
+        handle = OwnedHandle(self.handle(5), safety_net=True).handle
+        gc.collect()
+        self.assertEqual(self.library.closed, [])
+
+        with warnings.catch_warnings(record=True):
+            warnings.simplefilter("always")
+            del handle
+            gc.collect()
+
+        self.assertEqual(self.library.closed, [5])
+        self.assertEqual(OwnedHandle.leaked, leaked + 1)
+
+    def test_close_handle_disarms_safety_net(self):
+        leaked = OwnedHandle.leaked
+        handle = OwnedHandle(self.handle(5), safety_net=True).handle
+        CloseHandle(handle)
+        del handle
+        gc.collect()
+        self.assertEqual(self.library.closed, [5])
+        self.assertEqual(OwnedHandle.leaked, leaked)
+
+
+class TestHandleGroup(CloseHandleCase):
+    """
+    Tests for :class:`pywincffi.kernel32.HandleGroup`
+    """
+    def test_close(self):
+        with HandleGroup() as group:
+            for value in range(1, 101):
+                group.add(self.handle(value))
+            self.assertEqual(len(group), 100)
+
+        self.assertEqual(self.library.closed, list(range(1, 101)))
+        self.assertEqual(len(group), 0)
+
+    def test_errors_are_aggregated(self):
+        self.library.invalid.update((2, 4))
+        group = HandleGroup(self.handle(value) for value in range(1, 6))
+        with self.assertRaises(HandleCloseError) as error:
+            group.close()
+
+        self.assertEqual(self.library.closed, [1, 3, 5])
+        self.assertEqual(error.exception.total, 5)
+        self.assertEqual(
+            [self.library.fd(handle._cdata[0])
+             for handle, _ in error.exception.errors], [2, 4])
+        self.assertEqual(
+            error.exception.errors[0][1].errno,
+            self.library.ERROR_INVALID_HANDLE)
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_close_disarms_safety_net(self):
+        leaked = OwnedHandle.leaked
+        handle = OwnedHandle(self.handle(5), safety_net=True).handle
+        group = HandleGroup([handle])
+        group.close()
+        del handle
+        gc.collect()
+        self.assertEqual(self.library.closed, [5])
+        self.assertEqual(OwnedHandle.leaked, leaked)
+
+    def test_detach(self):
+        handle = self.handle(1)
+        group = HandleGroup([handle, self.handle(2)])
+        group.detach(handle)
+        group.close()
+        self.assertEqual(self.library.closed, [2])
+
+        with self.assertRaises(ValueError):
+            group.detach(handle)
+
+    def test_add_checks_type(self):
+        with self.assertRaises(InputError):
+            HandleGroup().add(1)
@@ -0,0 +1,276 @@
+import errno
+import os
+import random
+import struct
+import tempfile
+import threading
+
+try:
+    import fcntl
+except ImportError:  # pragma: no cover
+    fcntl = None
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError
+from pywincffi.kernel32.locking import IntervalTree, RangeLockManager
+from pywincffi.kernel32.overlapped import OverlappedPool
+from pywincffi.wintypes import HANDLE
+
+
+class FcntlLockLibrary(StandInLibrary):
+    """
+    Implements LockFileEx and UnlockFileEx on top of open file description
+    locks, ``F_OFD_SETLK``, which conflict between two descriptors for the
+    same file even within one process.  This allows two handles to stand
+    in for two processes sharing a file.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_LOCK_VIOLATION=33,
+        LOCKFILE_FAIL_IMMEDIATELY=0x00000001,
+        LOCKFILE_EXCLUSIVE_LOCK=0x00000002
+    )
+
+    def __init__(self, ffi):
+        super(FcntlLockLibrary, self).__init__(ffi)
+        self.calls = []
+
+    def fcntl(self, hFile, command, lock_type, lpOverlapped, low, high):
+        offset = lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset
+        length = int(high) << 32 | int(low)
+        # struct flock: l_type, l_whence, l_start, l_len, l_pid
+        flock = struct.pack(
+            "hhqqixxxx", lock_type, os.SEEK_SET, offset,
+            min(length, 2 ** 63 - 1), 0)
+        try:
+            fcntl.fcntl(self.fd(hFile), command, flock)
+        except (IOError, OSError) as error:
+            if error.errno not in (errno.EAGAIN, errno.EACCES):
+                raise
+            return self.fail(self.ERROR_LOCK_VIOLATION)
+        return 1
+
+    def LockFileEx(  # pylint: disable=too-many-arguments
+            self, hFile, dwFlags, dwReserved, nNumberOfBytesToLockLow,
+            nNumberOfBytesToLockHigh, lpOverlapped):
+        dwFlags = int(dwFlags)
+        assert dwFlags & self.LOCKFILE_FAIL_IMMEDIATELY
+        self.calls.append((
+            "lock", self.fd(hFile),
+            lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset,
+            int(nNumberOfBytesToLockHigh), int(nNumberOfBytesToLockLow)))
+        return self.fcntl(
+            hFile, fcntl.F_OFD_SETLK,
+            fcntl.F_WRLCK if dwFlags & self.LOCKFILE_EXCLUSIVE_LOCK
+            else fcntl.F_RDLCK,
+            lpOverlapped, nNumberOfBytesToLockLow, nNumberOfBytesToLockHigh)
+
+    def UnlockFileEx(
+            self, hFile, dwReserved, nNumberOfBytesToUnlockLow,
+            nNumberOfBytesToUnlockHigh, lpOverlapped):
+        self.calls.append(("unlock", self.fd(hFile)))
+        return self.fcntl(
+            hFile, fcntl.F_OFD_SETLK, fcntl.F_UNLCK, lpOverlapped,
+            nNumberOfBytesToUnlockLow, nNumberOfBytesToUnlockHigh)
+
+
+class TestIntervalTree(TestCase):
+    """
+    Tests for :class:`pywincffi.kernel32.locking.IntervalTree`
+    """
+    def test_matches_brute_force(self):
+        generator = random.Random(42)
+        tree = IntervalTree()
+        intervals = {}
+
+        for i in range(500):
+            start = generator.randrange(1000)
+            end = start + generator.randrange(1, 50)
+            intervals[tree.add(start, end, i)] = (start, end, i)
+
+            if i % 3 == 0:
+                key = generator.choice(list(intervals))
+                tree.remove(key)
+                del intervals[key]
+
+        self.assertEqual(len(tree), len(intervals))
+        for _ in range(200):
+            start = generator.randrange(1050)
+            end = start + generator.randrange(1, 100)
+            expected = sorted(
+                interval for interval in intervals.values()
+                if interval[0] < end and interval[1] > start)
+            self.assertEqual(sorted(tree.overlapping(start, end)), expected)
+
+    def test_half_open(self):
+        tree = IntervalTree()
+        tree.add(10, 20, "a")
+        self.assertEqual(tree.overlapping(0, 10), [])
+        self.assertEqual(tree.overlapping(20, 30), [])
+        self.assertEqual(tree.overlapping(19, 20), [(10, 20, "a")])
+
+    def test_remove_missing(self):
+        tree = IntervalTree()
+        key = tree.add(10, 20)
+        tree.remove(key)
+        with self.assertRaises(KeyError):
+            tree.remove(key)
+        self.assertEqual(len(tree), 0)
+
+    def test_empty_interval(self):
+        with self.assertRaises(InputError):
+            IntervalTree().add(10, 10)
+
+
+class RangeLockCase(TestCase):
+    """
+    Sets up :class:`FcntlLockLibrary` and two handles to the same file,
+    ``hFile`` and ``hOther``, which act like handles in two processes.
+    """
+    def setUp(self):
+        super(RangeLockCase, self).setUp()
+        if not hasattr(fcntl, "F_OFD_SETLK"):  # pragma: no cover
+            self.skipTest("Open file description locks are not available")
+
+        self.library = self.standin_library(FcntlLockLibrary)
+        fd, path = tempfile.mkstemp()
+        os.close(fd)
+        self.addCleanup(os.remove, path)
+
+        self.fd = os.open(path, os.O_RDWR)
+        self.addCleanup(os.close, self.fd)
+        self.other_fd = os.open(path, os.O_RDWR)
+        self.addCleanup(os.close, self.other_fd)
+
+        self.hFile = HANDLE(self.library.handle(self.fd))
+        self.hOther = HANDLE(self.library.handle(self.other_fd))
+
+    def create_manager(self, hFile=None, **kwargs):
+        manager = RangeLockManager(
+            self.hFile if hFile is None else hFile, **kwargs)
+        self.addCleanup(manager.release_all)
+        return manager
+
+
+class TestRangeLockManager(RangeLockCase):
+    """
+    Tests for :class:`pywincffi.kernel32.RangeLockManager`
+    """
+    def test_acquire_and_release(self):
+        manager = self.create_manager()
+        other = self.create_manager(self.hOther)
+
+        with manager.acquire(0, 100) as lock:
+            self.assertEqual(len(manager), 1)
+            self.assertIsNone(other.try_acquire(50, 10))
+            self.assertIsNotNone(other.try_acquire(100, 10))
+
+        self.assertTrue(lock.released)
+        self.assertEqual(len(manager), 0)
+        self.assertIsNotNone(other.try_acquire(50, 10))
+
+    def test_shared_locks(self):
+        manager = self.create_manager()
+        other = self.create_manager(self.hOther)
+
+        manager.acquire(0, 100, exclusive=False)
+        self.assertIsNotNone(other.try_acquire(50, 100, exclusive=False))
+        self.assertIsNone(other.try_acquire(0, 10))
+        self.assertIsNone(manager.try_acquire(60, 10))
+
+    def test_local_conflicts_do_not_call_windows(self):
+        manager = self.create_manager()
+        manager.acquire(0, 100)
+        calls = len(self.library.calls)
+        self.assertIsNone(manager.try_acquire(10, 10))
+        self.assertIsNone(manager.try_acquire(90, 100, exclusive=False))
+        self.assertEqual(len(self.library.calls), calls)
+
+    def test_length_split_into_dwords(self):
+        manager = self.create_manager()
+        manager.acquire(1 << 33, (1 << 32) + 5)
+        self.assertEqual(
+            self.library.calls[-1], ("lock", self.fd, 1 << 33, 1, 5))
+
+    def test_overlapped_structures_are_pooled(self):
+        pool = OverlappedPool()
+        manager = self.create_manager(pool=pool)
+        for offset in range(0, 1000, 10):
+            manager.acquire(offset, 10).release()
+        self.assertEqual(pool.created, 1)
+
+    def test_thread_waits_for_local_release(self):
+        manager = self.create_manager()
+        lock = manager.acquire(0, 100)
+        results = []
+
+        thread = threading.Thread(
+            target=lambda: results.append(manager.acquire(50, 10)))
+        thread.start()
+        thread.join(0.05)
+        self.assertTrue(thread.is_alive())
+
+        lock.release()
+        thread.join(5)
+        self.assertEqual(results[0].offset, 50)
+        self.assertEqual(manager.statistics().contended, 1)
+        self.assertEqual(manager.statistics().retries, 0)
+
+    def test_waits_for_other_process_with_backoff(self):
+        manager = self.create_manager(max_backoff=0.01)
+        other = self.create_manager(self.hOther)
+        held = other.acquire(0, 100)
+
+        timer = threading.Timer(0.05, held.release)
+        timer.start()
+        self.addCleanup(timer.cancel)
+
+        lock = manager.acquire(0, 100, timeout=5)
+        self.assertIsNotNone(lock)
+        statistics = manager.statistics()
+        self.assertEqual(statistics.contended, 1)
+        self.assertGreater(statistics.retries, 1)
+        self.assertGreater(statistics.wait_time, 0)
+
+    def test_timeout(self):
+        manager = self.create_manager(initial_backoff=0.01)
+        other = self.create_manager(self.hOther)
+        other.acquire(0, 100)
+
+        self.assertIsNone(manager.acquire(0, 100, timeout=0.03))
+        statistics = manager.statistics()
+        self.assertEqual(statistics.timeouts, 1)
+        self.assertEqual(statistics.acquired, 0)
+        self.assertGreaterEqual(statistics.wait_time, 0.03)
+
+    def test_statistics(self):
+        manager = self.create_manager()
+        manager.acquire(0, 10).release()
+        manager.acquire(10, 10)
+        statistics = manager.statistics()
+        self.assertEqual(statistics.acquired, 2)
+        self.assertEqual(statistics.released, 1)
+        self.assertEqual(statistics.held, 1)
+        self.assertEqual(statistics.contended, 0)
+
+    def test_release_twice(self):
+        manager = self.create_manager()
+        lock = manager.acquire(0, 10)
+        lock.release()
+        lock.release()
+        self.assertEqual(
+            [call[0] for call in self.library.calls], ["lock", "unlock"])
+
+    def test_release_foreign_lock(self):
+        manager = self.create_manager()
+        other = self.create_manager(self.hOther)
+        lock = other.acquire(0, 10)
+        with self.assertRaises(InputError):
+            manager.release(lock)
+
+    def test_invalid_range(self):
+        manager = self.create_manager()
+        with self.assertRaises(InputError):
+            manager.acquire(0, 0)
+        with self.assertRaises(InputError):
+            manager.acquire(-1, 10)
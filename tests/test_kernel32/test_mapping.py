@@ -0,0 +1,355 @@
+import gc
+import mmap
+import os
+import tempfile
+
+from mock import patch
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import memory
+from pywincffi.kernel32.mapping import (
+    CreateFileMapping, MapViewOfFile, UnmapViewOfFile, MappedView,
+    MappedFileWindow, window_bounds)
+from pywincffi.wintypes import HANDLE
+
+
+class MappingLibrary(StandInLibrary):
+    """
+    Implements the file mapping functions on top of :mod:`mmap`.  Mapping
+    handles are numbered from 0x1000 so they can't collide with the file
+    descriptors used as file handles.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        PAGE_READONLY=0x02,
+        PAGE_READWRITE=0x04,
+        FILE_MAP_COPY=0x01,
+        FILE_MAP_WRITE=0x02,
+        FILE_MAP_READ=0x04,
+        ERROR_MAPPED_ALIGNMENT=1132
+    )
+
+    def __init__(self, ffi):
+        super(MappingLibrary, self).__init__(ffi)
+        self.mappings = {}
+        self.views = {}
+        self.flushed = []
+        self.create_args = None
+
+    def address(self, pointer):
+        return int(self.ffi.cast("uintptr_t", pointer))
+
+    def GetSystemInfo(self, lpSystemInfo):
+        lpSystemInfo.dwPageSize = mmap.PAGESIZE
+        lpSystemInfo.dwAllocationGranularity = mmap.ALLOCATIONGRANULARITY
+
+    def CreateFileMapping(  # pylint: disable=too-many-arguments
+            self, hFile, lpAttributes, flProtect, dwMaximumSizeHigh,
+            dwMaximumSizeLow, lpName):
+        self.create_args = (self.fd(hFile), lpName)
+        if self.fd(hFile) == self.INVALID_HANDLE_VALUE:
+            return self.fail(self.ERROR_ACCESS_DENIED, self.ffi.NULL)
+
+        fd = self.fd(hFile)
+        size = int(dwMaximumSizeHigh) << 32 | int(dwMaximumSizeLow)
+        if size > os.fstat(fd).st_size:
+            os.ftruncate(fd, size)
+
+        handle = 0x1000 + len(self.mappings)
+        self.mappings[handle] = (fd, size or os.fstat(fd).st_size)
+        return self.handle(handle)
+
+    def MapViewOfFile(  # pylint: disable=too-many-arguments
+            self, hFileMappingObject, dwDesiredAccess, dwFileOffsetHigh,
+            dwFileOffsetLow, dwNumberOfBytesToMap):
+        fd, total = self.mappings[self.fd(hFileMappingObject)]
+        offset = int(dwFileOffsetHigh) << 32 | int(dwFileOffsetLow)
+        if offset % mmap.ALLOCATIONGRANULARITY:
+            return self.fail(self.ERROR_MAPPED_ALIGNMENT, self.ffi.NULL)
+
+        writable = int(dwDesiredAccess) & (
+            self.FILE_MAP_WRITE | self.FILE_MAP_COPY)
+        view = mmap.mmap(
+            fd, int(dwNumberOfBytesToMap) or total - offset, offset=offset,
+            access=mmap.ACCESS_WRITE if writable else mmap.ACCESS_READ)
+        pointer = self.ffi.from_buffer(view)
+        address = self.ffi.cast("LPVOID", pointer)
+        self.views[self.address(address)] = (view, pointer)
+        return address
+
+    def FlushViewOfFile(self, lpBaseAddress, dwNumberOfBytesToFlush):
+        self.flushed.append(
+            (self.address(lpBaseAddress), int(dwNumberOfBytesToFlush)))
+        for view, _ in self.views.values():
+            view.flush()
+        return 1
+
+    def UnmapViewOfFile(self, lpBaseAddress):
+        view, pointer = self.views.pop(self.address(lpBaseAddress))
+        self.ffi.release(pointer)
+        view.close()
+        return 1
+
+
+class MappingTestCase(TestCase):
+    """
+    Sets up the stand-in library and a temporary file for each test.
+    """
+    def setUp(self):
+        super(MappingTestCase, self).setUp()
+        self.library = self.standin_library(MappingLibrary)
+        self.ffi = self.library.ffi
+        patcher = patch.dict(memory._SYSTEM_INFO_CACHE, clear=True)
+        patcher.start()
+        self.addCleanup(patcher.stop)
+
+    def create_file(self, contents):
+        fd, path = tempfile.mkstemp()
+        self.addCleanup(os.remove, path)
+        self.addCleanup(os.close, fd)
+        os.write(fd, contents)
+        return HANDLE(self.ffi.cast("HANDLE", fd)), path
+
+    def create_mapping(self, contents):
+        hFile, path = self.create_file(contents)
+        return CreateFileMapping(hFile), path
+
+    def read(self, path):
+        with open(path, "rb") as file_:
+            return file_.read()
+
+
+class TestWindowBounds(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.mapping.window_bounds`
+    """
+    def test_aligned(self):
+        self.assertEqual(window_bounds(8192, 10, 4096, 4096, 65536),
+                         (8192, 4096))
+
+    def test_unaligned_offset_rounds_down(self):
+        self.assertEqual(window_bounds(5000, 10, 4096, 4096, 65536),
+                         (4096, 4096))
+
+    def test_grows_to_cover_range(self):
+        self.assertEqual(window_bounds(5000, 4096, 4096, 4096, 65536),
+                         (4096, 5000))
+
+    def test_clamped_to_total_size(self):
+        self.assertEqual(window_bounds(8192, 10, 4096, 4096, 9000),
+                         (8192, 808))
+
+
+class TestCreateFileMapping(MappingTestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.CreateFileMapping`
+    """
+    def test_paging_file_when_no_handle(self):
+        with self.assertRaises(WindowsAPIError) as error:
+            CreateFileMapping(None, lpName=u"shared")
+
+        self.assertEqual(self.library.create_args, (-1, u"shared"))
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_ACCESS_DENIED)
+
+    def test_grows_file_to_maximum_size(self):
+        hFile, path = self.create_file(b"")
+        CreateFileMapping(hFile, dwMaximumSizeLow=100)
+        self.assertEqual(os.path.getsize(path), 100)
+
+
+class TestMapViewOfFile(MappingTestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.MapViewOfFile`
+    """
+    def test_unaligned_offset_fails(self):
+        hMap, _ = self.create_mapping(b"x" * 8192)
+        with self.assertRaises(WindowsAPIError) as error:
+            MapViewOfFile(
+                hMap, self.library.FILE_MAP_READ, dwFileOffsetLow=1)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_MAPPED_ALIGNMENT)
+
+    def test_map_and_unmap(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        address = MapViewOfFile(hMap, self.library.FILE_MAP_READ)
+        self.assertEqual(
+            self.ffi.buffer(address, 5)[:], b"hello")
+        UnmapViewOfFile(address)
+        self.assertEqual(self.library.views, {})
+
+
+class TestMappedView(MappingTestCase):
+    """
+    Tests for :class:`pywincffi.kernel32.MappedView`
+    """
+    def test_write_through_buffer(self):
+        hMap, path = self.create_mapping(b"hello world")
+        with MappedView(hMap, 0, 11) as view:
+            view.buffer[0:5] = b"HELLO"
+            view.flush()
+
+        self.assertEqual(self.read(path), b"HELLO world")
+        self.assertEqual(len(self.library.flushed), 1)
+
+    def test_unaligned_offset(self):
+        contents = os.urandom(mmap.ALLOCATIONGRANULARITY * 2)
+        hMap, _ = self.create_mapping(contents)
+        offset = mmap.ALLOCATIONGRANULARITY + 10
+        with MappedView(hMap, offset, 100) as view:
+            self.assertEqual(
+                view.buffer.tobytes(), contents[offset:offset + 100])
+
+    def test_unmaps_on_exit(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        with MappedView(hMap, 0, 11) as view:
+            self.assertEqual(len(self.library.views), 1)
+
+        self.assertTrue(view.closed)
+        self.assertEqual(self.library.views, {})
+
+    def test_closed_view_raises(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        view = MappedView(hMap, 0, 11)
+        view.close()
+        view.close()  # closing twice is a no-op
+
+        with self.assertRaises(ValueError):
+            view.buffer  # pylint: disable=pointless-statement
+
+        with self.assertRaises(ValueError):
+            view.slice(0, 1)
+
+    def test_close_releases_exports(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        view = MappedView(hMap, 0, 11)
+        data = view.slice(6, 11)
+        self.assertEqual(data.tobytes(), b"world")
+        view.close()
+
+        if not hasattr(data, "release"):  # pragma: no cover
+            self.skipTest("memoryview.release() requires Python 3")
+
+        with self.assertRaises(ValueError):
+            data.tobytes()
+
+    def test_exports_are_weak(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        with MappedView(hMap, 0, 11) as view:
+            if not hasattr(view.buffer, "release"):  # pragma: no cover
+                self.skipTest("memoryview.release() requires Python 3")
+
+            for _ in range(100):
+                view.slice(0, 5)
+            kept = view.slice(6, 11)
+            gc.collect()
+            # The whole buffer plus `kept`
+            self.assertEqual(len(view._exports), 2)
+            self.assertEqual(kept.tobytes(), b"world")
+
+    def test_close_refuses_while_exported(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        view = MappedView(hMap, 0, 11)
+        data = view.slice(0, 5)
+        if not hasattr(data, "release"):  # pragma: no cover
+            self.skipTest("memoryview.release() requires Python 3")
+
+        # cffi holds the buffer exported by `data` until `consumer` goes
+        consumer = self.library.ffi.from_buffer(data)
+        with self.assertRaises(BufferError):
+            view.close()
+
+        self.assertFalse(view.closed)
+        self.assertEqual(len(self.library.views), 1)
+        self.assertEqual(self.library.ffi.buffer(consumer)[:], b"hello")
+
+        del consumer
+        view.close()
+        self.assertTrue(view.closed)
+        self.assertEqual(self.library.views, {})
+
+    def test_read_only_view(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        with MappedView(hMap, 0, 11, self.library.FILE_MAP_READ) as view:
+            self.assertTrue(view.readonly)
+            if not hasattr(view.buffer, "toreadonly"):  # pragma: no cover
+                self.skipTest("memoryview.toreadonly() requires Python 3.8")
+
+            with self.assertRaises(TypeError):
+                view.buffer[0:1] = b"x"
+
+    def test_invalid_size(self):
+        hMap, _ = self.create_mapping(b"hello world")
+        with self.assertRaises(InputError):
+            MappedView(hMap, 0, 0)
+
+
+class TestMappedFileWindow(MappingTestCase):
+    """
+    Tests for :class:`pywincffi.kernel32.MappedFileWindow`
+    """
+    def setUp(self):
+        super(TestMappedFileWindow, self).setUp()
+        self.granularity = mmap.ALLOCATIONGRANULARITY
+        self.contents = os.urandom(self.granularity * 5 + 123)
+        self.hMap, _ = self.create_mapping(self.contents)
+
+    def test_windows_cover_mapping(self):
+        with MappedFileWindow(
+                self.hMap, len(self.contents),
+                window_size=self.granularity * 2) as window:
+            chunks = [data.tobytes() for _, data in window.windows()]
+
+        self.assertEqual(b"".join(chunks), self.contents)
+        self.assertEqual(window.remaps, 3)
+        self.assertEqual(self.library.views, {})
+
+    def test_window_size_rounded_up(self):
+        window = MappedFileWindow(
+            self.hMap, len(self.contents), window_size=1)
+        self.assertEqual(window.window_size, self.granularity)
+
+    def test_view_within_window_does_not_remap(self):
+        with MappedFileWindow(
+                self.hMap, len(self.contents),
+                window_size=self.granularity * 2) as window:
+            window.view(0, 10)
+            window.view(100, 10)
+            self.assertEqual(window.remaps, 1)
+
+    def test_view_across_window_boundary(self):
+        offset = self.granularity * 2 - 5
+        with MappedFileWindow(
+                self.hMap, len(self.contents),
+                window_size=self.granularity * 2) as window:
+            window.view(0, 10)
+            data = window.view(offset, 10)
+            self.assertEqual(
+                data.tobytes(), self.contents[offset:offset + 10])
+            self.assertEqual(window.remaps, 2)
+
+    def test_slide_releases_previous_window(self):
+        with MappedFileWindow(
+                self.hMap, len(self.contents),
+                window_size=self.granularity) as window:
+            data = window.view(0, 10)
+            window.view(self.granularity * 3, 10)
+
+        if not hasattr(data, "release"):  # pragma: no cover
+            self.skipTest("memoryview.release() requires Python 3")
+
+        with self.assertRaises(ValueError):
+            data.tobytes()
+
+    def test_range_outside_mapping(self):
+        window = MappedFileWindow(self.hMap, len(self.contents))
+        with self.assertRaises(InputError):
+            window.view(len(self.contents) - 1, 10)
+
+    def test_range_larger_than_window(self):
+        window = MappedFileWindow(
+            self.hMap, len(self.contents), window_size=self.granularity)
+        with self.assertRaises(InputError):
+            window.view(0, self.granularity + 1)
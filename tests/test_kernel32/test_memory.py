@@ -0,0 +1,279 @@
+import ctypes
+import ctypes.util
+import mmap
+import os
+import tempfile
+
+from mock import patch
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import memory
+from pywincffi.kernel32.file import pread_into, pwrite
+from pywincffi.kernel32.memory import (
+    AlignedBufferPool, VirtualAlloc, VirtualFree, round_up)
+from pywincffi.kernel32.overlapped import OverlappedPool
+from pywincffi.wintypes import HANDLE
+
+LIBC = ctypes.CDLL(ctypes.util.find_library("c"))
+
+
+class VirtualMemoryLibrary(StandInLibrary):
+    """
+    Implements VirtualAlloc and VirtualFree on top of ``posix_memalign``
+    and ``free``.  Allocations are aligned to the allocation granularity
+    as they are on Windows.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        PAGE_READWRITE=0x04,
+        MEM_COMMIT=0x1000,
+        MEM_RESERVE=0x2000,
+        MEM_DECOMMIT=0x4000,
+        MEM_RELEASE=0x8000
+    )
+
+    def __init__(self, ffi):
+        super(VirtualMemoryLibrary, self).__init__(ffi)
+        self.allocations = {}
+        self.out_of_memory = False
+
+    def address(self, pointer):
+        return int(self.ffi.cast("uintptr_t", pointer))
+
+    def GetSystemInfo(self, lpSystemInfo):
+        lpSystemInfo.dwPageSize = mmap.PAGESIZE
+        lpSystemInfo.dwAllocationGranularity = mmap.ALLOCATIONGRANULARITY
+
+    def VirtualAlloc(self, lpAddress, dwSize, flAllocationType, flProtect):
+        assert lpAddress == self.ffi.NULL
+        assert int(flAllocationType) == self.MEM_COMMIT | self.MEM_RESERVE
+        assert int(flProtect) == self.PAGE_READWRITE
+        if self.out_of_memory:
+            return self.fail(self.ERROR_NOT_ENOUGH_MEMORY, self.ffi.NULL)
+
+        pointer = ctypes.c_void_p()
+        assert LIBC.posix_memalign(
+            ctypes.byref(pointer), mmap.ALLOCATIONGRANULARITY,
+            ctypes.c_size_t(int(dwSize))) == 0
+        ctypes.memset(pointer, 0, int(dwSize))
+        self.allocations[pointer.value] = int(dwSize)
+        return self.ffi.cast("LPVOID", pointer.value)
+
+    def VirtualFree(self, lpAddress, dwSize, dwFreeType):
+        address = self.address(lpAddress)
+        if address not in self.allocations or int(dwSize) != 0 or \
+                int(dwFreeType) != self.MEM_RELEASE:
+            return self.fail(self.ERROR_INVALID_PARAMETER)
+
+        del self.allocations[address]
+        LIBC.free(ctypes.c_void_p(address))
+        return 1
+
+    def ReadFile(self, hFile, lpBuffer, nNumberOfBytesToRead,
+                 lpNumberOfBytesRead, lpOverlapped):
+        offset = lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset
+        data = os.pread(self.fd(hFile), int(nNumberOfBytesToRead), offset)
+        self.ffi.memmove(lpBuffer, data, len(data))
+        lpNumberOfBytesRead[0] = len(data)
+        return 1
+
+    def WriteFile(self, hFile, lpBuffer, nNumberOfBytesToWrite,
+                  lpNumberOfBytesWritten, lpOverlapped):
+        offset = lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset
+        lpNumberOfBytesWritten[0] = os.pwrite(
+            self.fd(hFile), self.ffi.buffer(lpBuffer, nNumberOfBytesToWrite),
+            offset)
+        return 1
+
+
+class VirtualMemoryCase(TestCase):
+    """
+    Sets up :class:`VirtualMemoryLibrary` for each test.
+    """
+    def setUp(self):
+        super(VirtualMemoryCase, self).setUp()
+        self.library = self.standin_library(VirtualMemoryLibrary)
+        self.ffi = self.library.ffi
+        patcher = patch.dict(memory._SYSTEM_INFO_CACHE, clear=True)
+        patcher.start()
+        self.addCleanup(patcher.stop)
+
+    def create_pool(self, alignment, buffer_size, **kwargs):
+        pool = AlignedBufferPool(alignment, buffer_size, **kwargs)
+        self.addCleanup(pool.close)
+        return pool
+
+    def address(self, buffer_):
+        return int(self.ffi.cast("uintptr_t", self.ffi.from_buffer(buffer_)))
+
+
+class TestRoundUp(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.memory.round_up`
+    """
+    def test_round_up(self):
+        self.assertEqual(round_up(1, 512), 512)
+        self.assertEqual(round_up(512, 512), 512)
+        self.assertEqual(round_up(513, 512), 1024)
+
+
+class TestVirtualAlloc(VirtualMemoryCase):
+    """
+    Tests for :func:`pywincffi.kernel32.VirtualAlloc` and
+    :func:`pywincffi.kernel32.VirtualFree`
+    """
+    def test_allocate_and_free(self):
+        address = VirtualAlloc(None, 100)
+        self.assertEqual(
+            self.library.address(address) % mmap.ALLOCATIONGRANULARITY, 0)
+        self.assertEqual(self.ffi.buffer(address, 100)[:], b"\0" * 100)
+        VirtualFree(address)
+        self.assertEqual(self.library.allocations, {})
+
+    def test_allocation_fails(self):
+        self.library.out_of_memory = True
+        with self.assertRaises(WindowsAPIError) as error:
+            VirtualAlloc(None, 100)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_NOT_ENOUGH_MEMORY)
+
+    def test_free_fails(self):
+        address = VirtualAlloc(None, 100)
+        self.addCleanup(VirtualFree, address)
+        with self.assertRaises(WindowsAPIError):
+            VirtualFree(address, 100)
+
+
+class TestAlignedBufferPool(VirtualMemoryCase):
+    """
+    Tests for :class:`pywincffi.kernel32.AlignedBufferPool`
+    """
+    def test_buffers_are_aligned(self):
+        pool = self.create_pool(512, 1000)
+        self.assertEqual(pool.buffer_size, 1024)
+        for _ in range(pool.slab_size // pool.buffer_size + 1):
+            buffer_ = pool.acquire()
+            self.assertEqual(len(buffer_), 1024)
+            self.assertEqual(self.address(buffer_) % 512, 0)
+
+    def test_buffers_carved_from_slab(self):
+        pool = self.create_pool(512, 4096)
+        pool.acquire()
+        self.assertEqual(len(self.library.allocations), 1)
+        self.assertEqual(
+            pool.created, mmap.ALLOCATIONGRANULARITY // 4096)
+
+    def test_buffer_larger_than_slab(self):
+        pool = self.create_pool(
+            4096, mmap.ALLOCATIONGRANULARITY + 1, slab_size=4096)
+        buffer_ = pool.acquire()
+        self.assertEqual(
+            len(buffer_), mmap.ALLOCATIONGRANULARITY + 4096)
+        self.assertEqual(pool.created, 1)
+
+    def test_released_buffers_are_reused(self):
+        pool = self.create_pool(512, 512, slab_size=512)
+        with pool.buffer() as first:
+            first[0:5] = b"hello"
+
+        with pool.buffer() as second:
+            self.assertIs(second, first)
+            self.assertEqual(second[0:5].tobytes(), b"hello")
+
+        self.assertEqual(len(self.library.allocations), 1)
+
+    def test_writable(self):
+        pool = self.create_pool(512, 512)
+        buffer_ = pool.acquire()
+        self.assertFalse(buffer_.readonly)
+
+    def test_release_foreign_buffer(self):
+        pool = self.create_pool(512, 512)
+        with self.assertRaises(InputError):
+            pool.release(memoryview(bytearray(512)))
+
+    def test_double_release(self):
+        pool = self.create_pool(512, 512)
+        buffer_ = pool.acquire()
+        pool.release(buffer_)
+        with self.assertRaises(InputError):
+            pool.release(buffer_)
+
+        self.assertEqual(len(pool), pool.created)
+
+    def test_invalid_alignment(self):
+        for alignment in (0, 500, mmap.ALLOCATIONGRANULARITY * 2):
+            with self.assertRaises(InputError):
+                AlignedBufferPool(alignment, 512)
+
+    def test_invalid_buffer_size(self):
+        with self.assertRaises(InputError):
+            AlignedBufferPool(512, 0)
+
+    def test_close_frees_slabs(self):
+        pool = AlignedBufferPool(512, 512)
+        buffer_ = pool.acquire()
+        pool.close()
+        pool.close()  # closing twice is a no-op
+        self.assertEqual(self.library.allocations, {})
+
+        with self.assertRaises(ValueError):
+            pool.acquire()
+
+        if not hasattr(buffer_, "release"):  # pragma: no cover
+            self.skipTest("memoryview.release() requires Python 3")
+
+        with self.assertRaises(ValueError):
+            buffer_.tobytes()
+
+    def test_release_after_close(self):
+        pool = AlignedBufferPool(512, 512)
+        buffer_ = pool.acquire()
+        with pool.buffer():
+            pool.close()
+        pool.release(buffer_)
+        self.assertEqual(self.library.allocations, {})
+        self.assertEqual(len(pool), 0)
+
+    def test_close_keeps_exported_slabs(self):
+        pool = AlignedBufferPool(512, 512, slab_size=4096)
+        exported = pool.acquire()
+        if not hasattr(exported, "release"):  # pragma: no cover
+            self.skipTest("memoryview.release() requires Python 3")
+
+        for _ in range(pool.created):
+            pool.acquire()  # fills the first slab, allocates a second
+
+        # cffi holds the buffer exported by `exported` until `consumer` goes
+        consumer = self.ffi.from_buffer(exported)
+        with self.assertRaises(BufferError):
+            pool.close()
+
+        self.assertTrue(pool.closed)
+        self.assertEqual(len(self.library.allocations), 1)
+        consumer[0] = b"x"
+
+        del consumer
+        pool.close()
+        self.assertEqual(self.library.allocations, {})
+
+    def test_positioned_io(self):
+        fd, path = tempfile.mkstemp()
+        self.addCleanup(os.remove, path)
+        self.addCleanup(os.close, fd)
+        hFile = HANDLE(self.library.handle(fd))
+
+        pool = self.create_pool(512, 1024)
+        overlapped = OverlappedPool()
+        with pool.buffer() as buffer_:
+            buffer_[:] = b"x" * 1024
+            self.assertEqual(
+                pwrite(hFile, buffer_, 512, pool=overlapped), 1024)
+
+        with pool.buffer() as buffer_:
+            buffer_[:] = b"\0" * 1024
+            self.assertEqual(
+                pread_into(hFile, buffer_, 512, pool=overlapped), 1024)
+            self.assertEqual(buffer_.tobytes(), b"x" * 1024)
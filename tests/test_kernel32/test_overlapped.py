@@ -2,15 +2,19 @@ import os
 import shutil
 import tempfile
 
+from mock import patch
 from six import text_type
 
-from pywincffi.dev.testutil import TestCase
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError
 
 from pywincffi.core import dist
 
+from pywincffi.kernel32 import overlapped
 from pywincffi.kernel32 import (
-    CreateFile, WriteFile, CloseHandle, CreateEvent, GetOverlappedResult)
-from pywincffi.wintypes import OVERLAPPED
+    CreateFile, WriteFile, CloseHandle, CreateEvent, GetOverlappedResult,
+    OverlappedPool)
+from pywincffi.wintypes import HANDLE, OVERLAPPED
 
 
 class TestOverlappedWriteFile(TestCase):
@@ -64,3 +68,80 @@ class TestOverlappedWriteFile(TestCase):
         self.assertEqual(num_bytes_written, len(file_contents))
 
         CloseHandle(handle)
+
+
+class TestOverlappedPool(TestCase):
+    """
+    Tests for :class:`pywincffi.kernel32.OverlappedPool`
+    """
+    def setUp(self):
+        super(TestOverlappedPool, self).setUp()
+        self.library = self.standin_library(StandInLibrary)
+
+    def test_sets_offset(self):
+        pool = OverlappedPool()
+        lpOverlapped = pool.acquire((2 << 32) + 5)
+        self.assertIsInstance(lpOverlapped, OVERLAPPED)
+        self.assertEqual(lpOverlapped.OffsetHigh, 2)
+        self.assertEqual(lpOverlapped.Offset, 5)
+
+    def test_reuse_resets_fields(self):
+        pool = OverlappedPool()
+        lpOverlapped = pool.acquire(10)
+        lpOverlapped.Internal = 259
+        lpOverlapped.InternalHigh = 4
+        pool.release(lpOverlapped)
+
+        reused = pool.acquire(0)
+        self.assertIs(reused, lpOverlapped)
+        self.assertEqual(reused.Internal, 0)
+        self.assertEqual(reused.InternalHigh, 0)
+        self.assertEqual(reused.Offset, 0)
+        self.assertEqual(pool.created, 1)
+
+    def test_maximum(self):
+        pool = OverlappedPool(maximum=1)
+        first = pool.acquire()
+        second = pool.acquire()
+        pool.release(first)
+        pool.release(second)
+        self.assertEqual(len(pool), 1)
+
+    def test_context_manager(self):
+        pool = OverlappedPool()
+        with pool.overlapped(1) as lpOverlapped:
+            self.assertEqual(len(pool), 0)
+        self.assertEqual(len(pool), 1)
+        self.assertEqual(lpOverlapped.Offset, 1)
+
+    def test_event_factory_called_once_per_structure(self):
+        events = []
+
+        def event_factory():
+            events.append(HANDLE(self.library.handle(len(events) + 1)))
+            return events[-1]
+
+        pool = OverlappedPool(event_factory=event_factory)
+        with pool.overlapped() as lpOverlapped:
+            self.assertEqual(lpOverlapped.hEvent, events[0])
+        with pool.overlapped():
+            pass
+
+        self.assertEqual(len(events), 1)
+
+    def test_discarded_event_is_closed(self):
+        events = iter(range(1, 3))
+        pool = OverlappedPool(
+            maximum=1,
+            event_factory=lambda: HANDLE(self.library.handle(next(events))))
+        first = pool.acquire()
+        second = pool.acquire()
+        with patch.object(overlapped, "CloseHandle") as close:
+            pool.release(first)
+            pool.release(second)
+
+        close.assert_called_once_with(second.hEvent)
+
+    def test_negative_offset(self):
+        with self.assertRaises(InputError):
+            OverlappedPool().acquire(-1)
@@ -0,0 +1,245 @@
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import (
+    ConsoleRenderer, FrameBuffer, ReadConsoleOutputW, Rect,
+    WriteConsoleOutputW, diff_frames)
+from pywincffi.wintypes import HANDLE
+
+
+class ConsoleLibrary(StandInLibrary):
+    """
+    Implements WriteConsoleOutputW and ReadConsoleOutputW on an in-memory
+    screen buffer of ``CHAR_INFO`` cells.  Every write is recorded.
+    """
+    COLUMNS = 20
+    ROWS = 10
+
+    def __init__(self, ffi):
+        super(ConsoleLibrary, self).__init__(ffi)
+        self.screen = ffi.new("CHAR_INFO[]", self.COLUMNS * self.ROWS)
+        self.writes = []
+
+    def clip(self, region):
+        region.Right = min(region.Right, self.COLUMNS - 1)
+        region.Bottom = min(region.Bottom, self.ROWS - 1)
+        return region.Left <= region.Right and region.Top <= region.Bottom
+
+    def copy(self, source, source_columns, source_origin, target,
+             target_columns, target_origin, width, height):
+        size = self.ffi.sizeof("CHAR_INFO")
+        for row in range(height):
+            self.ffi.memmove(
+                target + (target_origin[1] + row) * target_columns +
+                target_origin[0],
+                source + (source_origin[1] + row) * source_columns +
+                source_origin[0],
+                width * size)
+
+    def WriteConsoleOutputW(
+            self, hConsoleOutput, lpBuffer, dwBufferSize, dwBufferCoord,
+            lpWriteRegion):
+        if self.fd(hConsoleOutput) < 0:
+            return self.fail(self.ERROR_INVALID_HANDLE)
+        if not self.clip(lpWriteRegion):
+            return 1
+
+        region = lpWriteRegion
+        self.writes.append(
+            (region.Left, region.Top, region.Right, region.Bottom))
+        self.copy(
+            lpBuffer, dwBufferSize[0], dwBufferCoord, self.screen,
+            self.COLUMNS, (region.Left, region.Top),
+            region.Right - region.Left + 1, region.Bottom - region.Top + 1)
+        return 1
+
+    def ReadConsoleOutputW(
+            self, hConsoleOutput, lpBuffer, dwBufferSize, dwBufferCoord,
+            lpReadRegion):
+        if not self.clip(lpReadRegion):
+            return 1
+
+        region = lpReadRegion
+        self.copy(
+            self.screen, self.COLUMNS, (region.Left, region.Top),
+            lpBuffer, dwBufferSize[0], dwBufferCoord,
+            region.Right - region.Left + 1, region.Bottom - region.Top + 1)
+        return 1
+
+    def text(self, y):
+        return u"".join(
+            self.screen[y * self.COLUMNS + x].Char.UnicodeChar
+            for x in range(self.COLUMNS))
+
+
+class ConsoleCase(TestCase):
+    """
+    Sets up :class:`ConsoleLibrary` and a handle to its screen buffer.
+    """
+    def setUp(self):
+        super(ConsoleCase, self).setUp()
+        self.library = self.standin_library(ConsoleLibrary)
+        self.handle = HANDLE(self.library.handle(1))
+
+    def create_renderer(self, **kwargs):
+        return ConsoleRenderer(
+            self.handle, self.library.COLUMNS, self.library.ROWS, **kwargs)
+
+
+class TestWriteAndReadConsoleOutput(ConsoleCase):
+    """
+    Tests for :func:`pywincffi.kernel32.WriteConsoleOutputW` and
+    :func:`pywincffi.kernel32.ReadConsoleOutputW`
+    """
+    def test_round_trip(self):
+        frame = FrameBuffer(4, 2)
+        frame.put(0, 0, u"abcd", 7)
+        frame.put(0, 1, u"efgh", 9)
+        written = WriteConsoleOutputW(
+            self.handle, frame.cells, frame.size, lpWriteRegion=(3, 2, 6, 3))
+        self.assertEqual(written, (3, 2, 6, 3))
+        self.assertEqual(self.library.text(3)[3:7], u"efgh")
+
+        cells, region = ReadConsoleOutputW(
+            self.handle, (2, 2), lpReadRegion=(4, 2, 5, 3))
+        self.assertEqual(region, (4, 2, 5, 3))
+        self.assertEqual(
+            [(cell.Char.UnicodeChar, cell.Attributes)
+             for cell in cells],
+            [(u"b", 7), (u"c", 7), (u"f", 9), (u"g", 9)])
+
+    def test_region_clipped(self):
+        frame = FrameBuffer(4, 1)
+        written = WriteConsoleOutputW(
+            self.handle, frame.cells, frame.size, lpWriteRegion=(18, 9, 21, 9))
+        self.assertEqual(written, (18, 9, 19, 9))
+
+    def test_buffer_too_small(self):
+        frame = FrameBuffer(4, 1)
+        with self.assertRaises(InputError):
+            WriteConsoleOutputW(self.handle, frame.cells, (4, 2))
+
+    def test_invalid_region(self):
+        frame = FrameBuffer(4, 1)
+        with self.assertRaises(InputError):
+            WriteConsoleOutputW(
+                self.handle, frame.cells, frame.size, lpWriteRegion=(0, 0))
+
+    def test_error(self):
+        frame = FrameBuffer(1, 1)
+        with self.assertRaises(WindowsAPIError):
+            WriteConsoleOutputW(
+                HANDLE(self.library.handle(-1)), frame.cells, frame.size)
+
+
+class TestFrameBuffer(ConsoleCase):
+    """
+    Tests for :class:`pywincffi.kernel32.FrameBuffer`
+    """
+    def test_put_clips(self):
+        frame = FrameBuffer(5, 2)
+        self.assertEqual(frame.put(3, 0, u"abcd", 1), 2)
+        self.assertEqual(frame.put(-2, 1, u"xyz", 1), 1)
+        self.assertEqual(frame.put(0, 2, u"abc"), 0)
+        self.assertEqual(frame.cell(4, 0), (u"b", 1))
+        self.assertEqual(frame.cell(0, 1), (u"z", 1))
+
+    def test_fill(self):
+        frame = FrameBuffer(3, 3, attributes=2)
+        frame.fill(u"#", 5, rect=(1, 1, 5, 5))
+        self.assertEqual(frame.cell(0, 0), (u" ", 2))
+        self.assertEqual(frame.cell(2, 2), (u"#", 5))
+
+    def test_outside_bmp(self):
+        frame = FrameBuffer(2, 1)
+        frame.put(0, 0, u"\U0001F600")
+        self.assertEqual(frame.cell(0, 0)[0], u"�")
+
+
+class TestDiffFrames(ConsoleCase):
+    """
+    Tests for :func:`pywincffi.kernel32.diff_frames`
+    """
+    def test_identical(self):
+        self.assertEqual(diff_frames(FrameBuffer(5, 5), FrameBuffer(5, 5)), [])
+
+    def test_span_of_row(self):
+        front, back = FrameBuffer(10, 3), FrameBuffer(10, 3)
+        back.put(2, 1, u"x")
+        back.put(6, 1, u"y")
+        self.assertEqual(diff_frames(front, back), [Rect(2, 1, 6, 1)])
+
+    def test_attribute_change(self):
+        front, back = FrameBuffer(10, 1), FrameBuffer(10, 1)
+        back.fill(attributes=4, rect=(9, 0, 9, 0))
+        self.assertEqual(diff_frames(front, back), [Rect(9, 0, 9, 0)])
+
+    def test_merges_nearby_rows(self):
+        front, back = FrameBuffer(10, 10), FrameBuffer(10, 10)
+        back.put(1, 0, u"a")
+        back.put(5, 1, u"b")
+        back.put(3, 3, u"c")
+        back.put(3, 8, u"d")
+        self.assertEqual(
+            diff_frames(front, back),
+            [Rect(1, 0, 5, 3), Rect(3, 8, 3, 8)])
+        self.assertEqual(
+            diff_frames(front, back, merge_rows=0),
+            [Rect(1, 0, 5, 1), Rect(3, 3, 3, 3), Rect(3, 8, 3, 8)])
+
+    def test_size_mismatch(self):
+        with self.assertRaises(InputError):
+            diff_frames(FrameBuffer(2, 2), FrameBuffer(3, 2))
+
+
+class TestConsoleRenderer(ConsoleCase):
+    """
+    Tests for :class:`pywincffi.kernel32.ConsoleRenderer`
+    """
+    def test_first_flush_writes_everything(self):
+        renderer = self.create_renderer()
+        renderer.back.put(0, 0, u"hello")
+        self.assertEqual(renderer.flush(), [Rect(0, 0, 19, 9)])
+        self.assertEqual(self.library.text(0)[:5], u"hello")
+
+    def test_only_dirty_rects_written(self):
+        renderer = self.create_renderer(merge_rows=0)
+        renderer.back.put(0, 0, u"status: ok")
+        renderer.flush()
+        del self.library.writes[:]
+
+        renderer.back.put(8, 0, u"up")
+        renderer.back.put(2, 5, u"42")
+        renderer.flush()
+        self.assertEqual(
+            self.library.writes, [(8, 0, 9, 0), (2, 5, 3, 5)])
+        self.assertEqual(self.library.text(0)[:10], u"status: up")
+        self.assertEqual(self.library.text(5)[:4], u"  42")
+
+    def test_unchanged_frame_not_written(self):
+        renderer = self.create_renderer()
+        renderer.flush()
+        renderer.flush()
+        self.assertEqual(len(self.library.writes), 1)
+        statistics = renderer.statistics()
+        self.assertEqual(statistics.frames, 2)
+        self.assertEqual(statistics.writes, 1)
+        self.assertEqual(statistics.cells, 200)
+
+    def test_invalidate(self):
+        renderer = self.create_renderer()
+        renderer.flush()
+        renderer.invalidate(rect=(0, 2, 4, 2))
+        self.assertEqual(renderer.flush(), [Rect(0, 2, 4, 2)])
+
+    def test_screen_matches_back_buffer(self):
+        renderer = self.create_renderer()
+        for frame in range(5):
+            renderer.back.fill()
+            renderer.back.put(frame, frame, u"*" * 3, frame)
+            renderer.flush()
+
+        cells, _ = ReadConsoleOutputW(
+            self.handle, renderer.back.size)
+        ffi = self.library.ffi
+        self.assertEqual(
+            ffi.buffer(cells)[:], ffi.buffer(renderer.back.cells)[:])
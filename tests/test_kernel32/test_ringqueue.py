@@ -0,0 +1,307 @@
+import ctypes
+import errno
+import os
+import platform
+import sys
+import threading
+import time
+from unittest import skipUnless
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import (
+    SPMCQueue, WaitOnAddress, WakeByAddressAll, WakeByAddressSingle)
+
+SYS_FUTEX = {"x86_64": 202, "aarch64": 98}.get(platform.machine())
+FUTEX_WAIT_PRIVATE = 128
+FUTEX_WAKE_PRIVATE = 129
+
+HAS_FUTEX = sys.platform.startswith("linux") and SYS_FUTEX is not None
+
+
+class timespec(ctypes.Structure):  # pylint: disable=invalid-name
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+class FutexLibrary(StandInLibrary):
+    """
+    Implements the WaitOnAddress and WakeByAddress* wrappers from main.c
+    with Linux futexes, which only compare 32 bits.  Waits on 64 bit
+    values sleep on the low half in short slices and compare the whole
+    value between them, so a change to only the high half is noticed.
+    ctypes releases the GIL around the system call just as cffi does.
+    The interlocked helpers are serialized with a lock.
+    """
+    SLICE = 0.01
+    CONSTANTS = dict(StandInLibrary.CONSTANTS, ERROR_TIMEOUT=1460)
+
+    def __init__(self, ffi):
+        super(FutexLibrary, self).__init__(ffi)
+        self.libc = ctypes.CDLL(None, use_errno=True)
+        self.libc.syscall.restype = ctypes.c_long
+        self.atomic = threading.Lock()
+        self.waits = 0
+        self.wakes = 0
+
+    def futex(self, address, operation, value, timeout=None):
+        return self.libc.syscall(
+            SYS_FUTEX,
+            ctypes.c_void_p(int(self.ffi.cast("uintptr_t", address))),
+            ctypes.c_int(operation), ctypes.c_int(value),
+            None if timeout is None else ctypes.byref(timeout),
+            None, ctypes.c_int(0))
+
+    def wait_on_address_available(self):
+        return 1
+
+    def wait_on_address(
+            self, Address, CompareAddress, AddressSize, dwMilliseconds):
+        assert AddressSize in (4, 8)
+        self.waits += 1
+        cdecl = "int32_t *" if AddressSize == 4 else "int64_t *"
+        current = self.ffi.cast(cdecl, Address)
+        compare = self.ffi.cast(cdecl, CompareAddress)[0]
+        deadline = None
+        if dwMilliseconds != self.INFINITE:
+            deadline = time.time() + int(dwMilliseconds) / 1000.0
+
+        while current[0] == compare:
+            remaining = self.SLICE
+            if deadline is not None:
+                remaining = min(remaining, deadline - time.time())
+                if remaining <= 0:
+                    return self.fail(self.ERROR_TIMEOUT)
+
+            timeout = timespec(0, int(remaining * 1e9))
+            if self.futex(Address, FUTEX_WAIT_PRIVATE,
+                          compare & 0xFFFFFFFF, timeout) == 0:
+                return 1
+
+            error = ctypes.get_errno()
+            assert error in (errno.EAGAIN, errno.EINTR, errno.ETIMEDOUT), \
+                os.strerror(error)
+        return 1
+
+    def wake_by_address_single(self, Address):
+        self.wakes += 1
+        self.futex(Address, FUTEX_WAKE_PRIVATE, 1)
+
+    def wake_by_address_all(self, Address):
+        self.wakes += 1
+        self.futex(Address, FUTEX_WAKE_PRIVATE, 0x7FFFFFFF)
+
+    def interlocked_compare_exchange64(self, destination, exchange, comparand):
+        with self.atomic:
+            original = destination[0]
+            if original == comparand:
+                destination[0] = exchange
+            return original
+
+    def interlocked_exchange64(self, target, value):
+        with self.atomic:
+            original = target[0]
+            target[0] = value
+            return original
+
+    def interlocked_exchange_add64(self, addend, value):
+        with self.atomic:
+            original = addend[0]
+            addend[0] = original + value
+            return original
+
+
+class UnavailableLibrary(StandInLibrary):
+    """
+    Behaves like Windows 7, where WaitOnAddress and WakeByAddress* are not
+    available.
+    """
+    CONSTANTS = dict(StandInLibrary.CONSTANTS, ERROR_NOT_SUPPORTED=50)
+
+    def wait_on_address_available(self):
+        return 0
+
+
+class TestWaitOnAddressUnavailable(TestCase):
+    def setUp(self):
+        super(TestWaitOnAddressUnavailable, self).setUp()
+        self.library = self.standin_library(UnavailableLibrary)
+        self.word = self.library.ffi.new("LONGLONG *")
+
+    def test_wait(self):
+        with self.assertRaises(WindowsAPIError) as error:
+            WaitOnAddress(self.word, self.word, 8, 0)
+        self.assertEqual(error.exception.errno, 50)
+
+    def test_wake(self):
+        with self.assertRaises(WindowsAPIError):
+            WakeByAddressSingle(self.word)
+        with self.assertRaises(WindowsAPIError):
+            WakeByAddressAll(self.word)
+
+    def test_queue(self):
+        with self.assertRaises(WindowsAPIError):
+            SPMCQueue(4, 8)
+
+
+@skipUnless(HAS_FUTEX, "Requires Linux futexes")
+class FutexCase(TestCase):
+    def setUp(self):
+        super(FutexCase, self).setUp()
+        self.library = self.standin_library(FutexLibrary)
+        self.ffi = self.library.ffi
+
+    def in_thread(self, target):
+        thread = threading.Thread(target=target)
+        thread.daemon = True
+        thread.start()
+        self.addCleanup(thread.join, 5)
+        return thread
+
+    def wait_until(self, predicate):
+        deadline = time.time() + 5
+        while not predicate():
+            self.assertLess(time.time(), deadline)
+            time.sleep(0.001)
+
+
+class TestWaitOnAddress(FutexCase):
+    def test_value_already_changed(self):
+        word = self.ffi.new("LONGLONG *", 1)
+        compare = self.ffi.new("LONGLONG *", 0)
+        self.assertTrue(WaitOnAddress(word, compare, 8, 1000))
+
+    def test_timeout(self):
+        word = self.ffi.new("LONGLONG *", 0)
+        compare = self.ffi.new("LONGLONG *", 0)
+        self.assertFalse(WaitOnAddress(word, compare, 8, 10))
+        self.assertEqual(self.ffi.last_error, 0)
+
+    def test_wake_single(self):
+        word = self.ffi.new("LONGLONG *", 0)
+        compare = self.ffi.new("LONGLONG *", 0)
+        results = []
+        thread = self.in_thread(
+            lambda: results.append(WaitOnAddress(word, compare, 8, 5000)))
+        self.wait_until(lambda: self.library.waits)
+        word[0] = 1
+        WakeByAddressSingle(word)
+        thread.join(5)
+        self.assertEqual(results, [True])
+
+    def test_wake_all(self):
+        word = self.ffi.new("LONGLONG *", 0)
+        WakeByAddressAll(word)
+        self.assertEqual(self.library.wakes, 1)
+
+    def test_invalid_size(self):
+        word = self.ffi.new("LONGLONG *")
+        with self.assertRaises(InputError):
+            WaitOnAddress(word, word, 3, 0)
+
+    def test_not_a_pointer(self):
+        with self.assertRaises(InputError):
+            WakeByAddressSingle(0)
+
+
+class TestSPMCQueue(FutexCase):
+    def test_fifo(self):
+        queue = SPMCQueue(4, 16)
+        for item in (b"a", b"bb", b"", b"dddd"):
+            self.assertTrue(queue.put(item))
+        self.assertEqual(len(queue), 4)
+        self.assertEqual(
+            [queue.get(timeout=0) for _ in range(4)],
+            [b"a", b"bb", b"", b"dddd"])
+        self.assertIsNone(queue.get(timeout=0))
+
+    def test_uncontended_makes_no_calls(self):
+        queue = SPMCQueue(8, 8)
+        for _ in range(20):
+            queue.put(b"x")
+            queue.get()
+        self.assertEqual((self.library.waits, self.library.wakes), (0, 0))
+        self.assertEqual(queue.statistics(), (20, 20, 0, 0, 0))
+
+    def test_full_times_out(self):
+        queue = SPMCQueue(2, 8, spin=0)
+        queue.put(b"1")
+        queue.put(b"2")
+        self.assertFalse(queue.put(b"3", timeout=0.01))
+        self.assertEqual(queue.full, 1)
+        self.assertEqual(queue.get(), b"1")
+        self.assertTrue(queue.put(b"3", timeout=0))
+
+    def test_producer_waits_for_space(self):
+        queue = SPMCQueue(2, 8, spin=0)
+        queue.put(b"1")
+        queue.put(b"2")
+        got = []
+        thread = self.in_thread(
+            lambda: (time.sleep(0.05), got.append(queue.get())))
+        self.assertTrue(queue.put(b"3", timeout=5))
+        thread.join(5)
+        self.assertEqual(got, [b"1"])
+        self.assertEqual([queue.get(), queue.get()], [b"2", b"3"])
+
+    def test_consumer_parks_until_put(self):
+        queue = SPMCQueue(4, 8, spin=0)
+        got = []
+        thread = self.in_thread(lambda: got.append(queue.get(timeout=5)))
+        self.wait_until(lambda: self.library.waits)
+        queue.put(b"late")
+        thread.join(5)
+        self.assertEqual(got, [b"late"])
+        self.assertEqual(queue.parks, 1)
+        self.assertEqual(self.library.wakes, 1)
+
+    def test_many_consumers(self):
+        queue = SPMCQueue(16, 8, spin=10)
+        received = []
+        lock = threading.Lock()
+
+        def consumer():
+            while True:
+                item = queue.get(timeout=5)
+                if item is None:
+                    return
+                with lock:
+                    received.append(int(item))
+
+        threads = [self.in_thread(consumer) for _ in range(4)]
+        for value in range(2000):
+            queue.put(str(value).encode("ascii"), timeout=5)
+        queue.close()
+        for thread in threads:
+            thread.join(5)
+        self.assertEqual(sorted(received), list(range(2000)))
+        self.assertEqual(queue.gets, 2000)
+
+    def test_close_wakes_consumers(self):
+        queue = SPMCQueue(4, 8, spin=0)
+        got = []
+        threads = [
+            self.in_thread(lambda: got.append(queue.get()))
+            for _ in range(3)]
+        self.wait_until(lambda: self.library.waits >= 3)
+        queue.close()
+        for thread in threads:
+            thread.join(5)
+        self.assertEqual(got, [None, None, None])
+        self.assertTrue(queue.closed)
+        with self.assertRaises(InputError):
+            queue.put(b"x")
+
+    def test_items_drain_after_close(self):
+        queue = SPMCQueue(4, 8)
+        queue.put(b"last")
+        queue.close()
+        self.assertEqual(queue.get(), b"last")
+        self.assertIsNone(queue.get())
+
+    def test_item_too_large(self):
+        with self.assertRaises(InputError):
+            SPMCQueue(4, 2).put(b"abc")
+
+    def test_capacity_power_of_two(self):
+        with self.assertRaises(InputError):
+            SPMCQueue(3, 8)
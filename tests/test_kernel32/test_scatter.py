@@ -0,0 +1,285 @@
+import mmap
+import os
+import tempfile
+
+from mock import patch
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import memory, scatter
+from pywincffi.kernel32.scatter import (
+    ReadFileScatter, SegmentArray, read_scatter, write_gather,
+    check_alignment)
+from pywincffi.kernel32.overlapped import OverlappedPool
+from pywincffi.wintypes import HANDLE
+
+
+class ScatterGatherLibrary(StandInLibrary):
+    """
+    Implements ReadFileScatter and WriteFileGather on top of
+    :func:`os.preadv` and :func:`os.pwritev`.  Both complete through
+    GetOverlappedResult as they would on Windows.
+    """
+    def __init__(self, ffi):
+        super(ScatterGatherLibrary, self).__init__(ffi)
+        self.calls = []
+        self.error = None
+        self.event_handles = 0
+
+    def CreateEvent(self, lpEventAttributes, bManualReset, bInitialState,
+                    lpName):
+        self.event_handles += 1
+        return self.handle(0x7000 + self.event_handles)
+
+    def GetSystemInfo(self, lpSystemInfo):
+        lpSystemInfo.dwPageSize = mmap.PAGESIZE
+        lpSystemInfo.dwAllocationGranularity = mmap.ALLOCATIONGRANULARITY
+
+    def _segments(self, aSegmentArray, count):
+        pages = []
+        while aSegmentArray[len(pages)].Alignment:
+            pages.append(self.ffi.buffer(
+                self.ffi.cast("char *", aSegmentArray[len(pages)].Alignment),
+                mmap.PAGESIZE))
+        self.calls.append(len(pages))
+        return pages[:-(-int(count) // mmap.PAGESIZE)]
+
+    def _complete(self, lpOverlapped, count):
+        lpOverlapped.InternalHigh = count
+        return self.fail(self.ERROR_IO_PENDING)
+
+    def _offset(self, lpOverlapped):
+        return lpOverlapped.OffsetHigh << 32 | lpOverlapped.Offset
+
+    def ReadFileScatter(self, hFile, aSegmentArray, nNumberOfBytesToRead,
+                        lpReserved, lpOverlapped):
+        if self.error is not None:
+            return self.fail(self.error)
+        assert lpReserved == self.ffi.NULL
+        count = os.preadv(
+            self.fd(hFile),
+            self._segments(aSegmentArray, nNumberOfBytesToRead),
+            self._offset(lpOverlapped))
+        if not count:
+            return self.fail(self.ERROR_HANDLE_EOF)
+        return self._complete(lpOverlapped, count)
+
+    def WriteFileGather(self, hFile, aSegmentArray, nNumberOfBytesToWrite,
+                        lpReserved, lpOverlapped):
+        count = os.pwritev(
+            self.fd(hFile),
+            self._segments(aSegmentArray, nNumberOfBytesToWrite),
+            self._offset(lpOverlapped))
+        return self._complete(lpOverlapped, count)
+
+    def GetOverlappedResult(self, hFile, lpOverlapped,
+                            lpNumberOfBytesTransferred, bWait):
+        lpNumberOfBytesTransferred[0] = lpOverlapped.InternalHigh
+        return 1
+
+
+class ScatterGatherCase(TestCase):
+    """
+    Sets up :class:`ScatterGatherLibrary` and a temporary file for each test.
+    """
+    def setUp(self):
+        super(ScatterGatherCase, self).setUp()
+        if not hasattr(os, "preadv"):  # pragma: no cover
+            self.skipTest("os.preadv() requires Python 3.7")
+
+        self.library = self.standin_library(ScatterGatherLibrary)
+        pool = OverlappedPool(
+            event_factory=scatter.DEFAULT_OVERLAPPED_POOL.event_factory)
+        for patcher in (
+                patch.dict(memory._SYSTEM_INFO_CACHE, clear=True),
+                patch.object(scatter, "DEFAULT_OVERLAPPED_POOL", pool)):
+            patcher.start()
+            self.addCleanup(patcher.stop)
+
+        fd, self.path = tempfile.mkstemp()
+        self.addCleanup(os.remove, self.path)
+        self.addCleanup(os.close, fd)
+        self.contents = os.urandom(mmap.PAGESIZE * 4)
+        os.write(fd, self.contents)
+        self.hFile = HANDLE(self.library.handle(fd))
+
+    def pages(self, count, size=mmap.PAGESIZE):
+        pages = [mmap.mmap(-1, size) for _ in range(count)]
+        for page in pages:
+            self.addCleanup(page.close)
+        return pages
+
+
+class TestCheckAlignment(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.scatter.check_alignment`
+    """
+    def test_aligned(self):
+        check_alignment("buffer", 8192, 4096, 4096)
+
+    def test_unaligned_address(self):
+        with self.assertRaises(InputError):
+            check_alignment("buffer", 8193, 4096, 4096)
+
+    def test_unaligned_size(self):
+        with self.assertRaises(InputError):
+            check_alignment("buffer", 8192, 4095, 4096)
+
+    def test_empty(self):
+        with self.assertRaises(InputError):
+            check_alignment("buffer", 8192, 0, 4096)
+
+
+class TestSegmentArray(ScatterGatherCase):
+    """
+    Tests for :class:`pywincffi.kernel32.SegmentArray`
+    """
+    def test_one_element_per_page(self):
+        segments = SegmentArray(
+            self.pages(1, mmap.PAGESIZE * 2) + self.pages(1))
+        self.assertEqual(len(segments), 3)
+        self.assertEqual(segments.nbytes, mmap.PAGESIZE * 3)
+        self.assertEqual(
+            segments.aSegmentArray[1].Alignment -
+            segments.aSegmentArray[0].Alignment, mmap.PAGESIZE)
+
+    def test_null_terminated(self):
+        segments = SegmentArray(self.pages(2))
+        self.assertEqual(segments.aSegmentArray[2].Alignment, 0)
+
+    def test_unaligned_buffer(self):
+        page = self.pages(1, mmap.PAGESIZE * 2)[0]
+        with self.assertRaises(InputError):
+            SegmentArray([memoryview(page)[1:mmap.PAGESIZE + 1]])
+
+    def test_partial_page(self):
+        with self.assertRaises(InputError):
+            SegmentArray(self.pages(1, 100))
+
+    def test_read_only_buffer(self):
+        with self.assertRaises(InputError):
+            SegmentArray([b"x" * mmap.PAGESIZE])
+
+    def test_read_only_memoryview(self):
+        view = memoryview(self.pages(1)[0])
+        if not hasattr(view, "toreadonly"):  # pragma: no cover
+            self.skipTest("memoryview.toreadonly() requires Python 3.8")
+
+        with self.assertRaises(InputError):
+            SegmentArray([view.toreadonly()])
+
+        self.assertEqual(
+            len(SegmentArray([view.toreadonly()], writable=False)), 1)
+
+    def test_empty(self):
+        with self.assertRaises(InputError):
+            SegmentArray([])
+
+
+class TestReadFileScatter(ScatterGatherCase):
+    """
+    Tests for :func:`pywincffi.kernel32.ReadFileScatter`
+    """
+    def test_error(self):
+        self.library.error = self.library.ERROR_INVALID_PARAMETER
+        with self.assertRaises(WindowsAPIError) as error:
+            read_scatter(self.hFile, self.pages(1), 0)
+
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_INVALID_PARAMETER)
+
+    def test_too_many_bytes(self):
+        segments = SegmentArray(self.pages(1))
+        with OverlappedPool().overlapped(0) as lpOverlapped:
+            with self.assertRaises(InputError):
+                ReadFileScatter(
+                    self.hFile, segments, mmap.PAGESIZE + 1, lpOverlapped)
+
+    def test_unaligned_length(self):
+        segments = SegmentArray(self.pages(1))
+        with OverlappedPool().overlapped(0) as lpOverlapped:
+            with self.assertRaises(InputError):
+                ReadFileScatter(self.hFile, segments, 100, lpOverlapped)
+            with self.assertRaises(InputError):
+                ReadFileScatter(
+                    self.hFile, segments, 512, lpOverlapped,
+                    sector_size=4096)
+        self.assertEqual(self.library.calls, [])
+
+    def test_unaligned_offset(self):
+        with self.assertRaises(InputError):
+            read_scatter(self.hFile, self.pages(1), 100)
+        with self.assertRaises(InputError):
+            read_scatter(self.hFile, self.pages(1), 512, sector_size=4096)
+        self.assertEqual(self.library.calls, [])
+
+
+class TestReadScatter(ScatterGatherCase):
+    """
+    Tests for :func:`pywincffi.kernel32.read_scatter`
+    """
+    def test_read_at_offset(self):
+        pages = self.pages(2)
+        self.assertEqual(
+            read_scatter(self.hFile, pages, mmap.PAGESIZE),
+            mmap.PAGESIZE * 2)
+        self.assertEqual(
+            b"".join(page[:] for page in pages),
+            self.contents[mmap.PAGESIZE:mmap.PAGESIZE * 3])
+        self.assertEqual(self.library.calls, [2])
+
+    def test_reuse_segment_array(self):
+        pages = self.pages(1)
+        segments = SegmentArray(pages)
+        for index in range(4):
+            read_scatter(self.hFile, segments, mmap.PAGESIZE * index)
+            self.assertEqual(
+                pages[0][:],
+                self.contents[mmap.PAGESIZE * index:
+                              mmap.PAGESIZE * (index + 1)])
+
+    def test_end_of_file(self):
+        self.assertEqual(
+            read_scatter(self.hFile, self.pages(1), mmap.PAGESIZE * 4), 0)
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_pool_returned(self):
+        pool = OverlappedPool()
+        read_scatter(self.hFile, self.pages(1), 0, pool=pool)
+        read_scatter(self.hFile, self.pages(1), 0, pool=pool)
+        self.assertEqual(pool.created, 1)
+
+
+class TestWriteGather(ScatterGatherCase):
+    """
+    Tests for :func:`pywincffi.kernel32.write_gather`
+    """
+    def test_round_trip(self):
+        pages = self.pages(3)
+        data = os.urandom(mmap.PAGESIZE * 3)
+        for index, page in enumerate(pages):
+            page[:] = data[mmap.PAGESIZE * index:mmap.PAGESIZE * (index + 1)]
+
+        self.assertEqual(
+            write_gather(self.hFile, pages, mmap.PAGESIZE),
+            mmap.PAGESIZE * 3)
+        self.assertEqual(self.library.calls, [3])
+
+        readback = self.pages(3)
+        read_scatter(self.hFile, readback, mmap.PAGESIZE)
+        self.assertEqual(b"".join(page[:] for page in readback), data)
+
+        with open(self.path, "rb") as file_:
+            self.assertEqual(file_.read()[mmap.PAGESIZE:], data)
+
+    def test_read_only_buffers_allowed(self):
+        data = os.urandom(mmap.PAGESIZE)
+        page = self.pages(1)[0]
+        page[:] = data
+        view = memoryview(page)
+        if hasattr(view, "toreadonly"):
+            view = view.toreadonly()
+        write_gather(self.hFile, [view], 0)
+
+        with open(self.path, "rb") as file_:
+            self.assertEqual(file_.read(mmap.PAGESIZE), data)
@@ -1,7 +1,303 @@
+import threading
+import time
+
 from pywincffi.core import dist
-from pywincffi.dev.testutil import TestCase
-from pywincffi.exceptions import WindowsAPIError
-from pywincffi.kernel32 import CloseHandle, OpenProcess, WaitForSingleObject
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import (
+    AcquireSRWLockShared, CloseHandle, Condition, CreateMutexEx,
+    CreateSemaphoreEx, InitializeConditionVariable, InitializeSRWLock, Mutex,
+    OpenProcess, ReleaseMutex, ReleaseSemaphore, ReleaseSRWLockShared,
+    RWLock, Semaphore, SleepConditionVariableSRW, TryAcquireSRWLockExclusive,
+    TryAcquireSRWLockShared, WaitForMultipleObjects, WaitForSingleObject,
+    WakeConditionVariable, wait_any)
+
+
+class SyncLibrary(StandInLibrary):
+    """
+    Implements semaphores and mutexes as Python objects guarded by a
+    single :class:`threading.Condition`.  Handles are indexes into
+    :attr:`objects` and opening a named object again returns a new handle
+    to the same object.  :meth:`abandon` stands in for the owning thread
+    exiting without releasing a mutex.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_NOT_OWNER=288,
+        ERROR_TOO_MANY_POSTS=298,
+        SEMAPHORE_ALL_ACCESS=0x1F0003,
+        MUTEX_ALL_ACCESS=0x1F0001,
+        CREATE_MUTEX_INITIAL_OWNER=0x00000001
+    )
+
+    def __init__(self, ffi):
+        super(SyncLibrary, self).__init__(ffi)
+        self.condition = threading.Condition()
+        self.objects = {}
+        self.names = {}
+        self.closed = []
+
+    def create(self, lpName, state):
+        if lpName in self.names:
+            state = self.names[lpName]
+            self.SetLastError(self.ERROR_ALREADY_EXISTS)
+        elif lpName != self.ffi.NULL:
+            self.names[lpName] = state
+        handle = len(self.objects) + 100
+        self.objects[handle] = state
+        return self.handle(handle)
+
+    def CreateSemaphoreEx(  # pylint: disable=too-many-arguments
+            self, lpSemaphoreAttributes, lInitialCount, lMaximumCount,
+            lpName, dwFlags, dwDesiredAccess):
+        return self.create(lpName, {
+            "count": lInitialCount, "maximum": lMaximumCount})
+
+    def CreateMutexEx(
+            self, lpMutexAttributes, lpName, dwFlags, dwDesiredAccess):
+        owner = None
+        if int(dwFlags) & self.CREATE_MUTEX_INITIAL_OWNER:
+            owner = threading.current_thread().ident
+        return self.create(lpName, {
+            "owner": owner, "recursion": int(owner is not None),
+            "abandoned": False})
+
+    def ReleaseSemaphore(self, hSemaphore, lReleaseCount, lpPreviousCount):
+        state = self.objects[self.fd(hSemaphore)]
+        with self.condition:
+            if state["count"] + lReleaseCount > state["maximum"]:
+                return self.fail(self.ERROR_TOO_MANY_POSTS)
+            lpPreviousCount[0] = state["count"]
+            state["count"] += lReleaseCount
+            self.condition.notify_all()
+        return 1
+
+    def ReleaseMutex(self, hMutex):
+        state = self.objects[self.fd(hMutex)]
+        with self.condition:
+            if state["owner"] != threading.current_thread().ident:
+                return self.fail(self.ERROR_NOT_OWNER)
+            state["recursion"] -= 1
+            if not state["recursion"]:
+                state["owner"] = None
+                self.condition.notify_all()
+        return 1
+
+    def abandon(self, handle):
+        state = self.objects[handle]
+        with self.condition:
+            state.update(owner=None, recursion=0, abandoned=True)
+            self.condition.notify_all()
+
+    def take(self, state):
+        # Returns WAIT_OBJECT_0 or WAIT_ABANDONED if the object was
+        # acquired, None otherwise.
+        if "count" in state:
+            if state["count"]:
+                state["count"] -= 1
+                return self.WAIT_OBJECT_0
+            return None
+
+        me = threading.current_thread().ident
+        if state["owner"] not in (None, me):
+            return None
+
+        state["owner"] = me
+        state["recursion"] += 1
+        if state["abandoned"]:
+            state["abandoned"] = False
+            return self.WAIT_ABANDONED
+        return self.WAIT_OBJECT_0
+
+    def wait(self, handles, dwMilliseconds):
+        states = [self.objects[self.fd(handle)] for handle in handles]
+        deadline = None
+        if dwMilliseconds != self.INFINITE:
+            deadline = time.time() + int(dwMilliseconds) / 1000.0
+
+        with self.condition:
+            while True:
+                for index, state in enumerate(states):
+                    result = self.take(state)
+                    if result is not None:
+                        return result + index
+
+                if deadline is None:
+                    self.condition.wait()
+                elif deadline <= time.time():
+                    return self.WAIT_TIMEOUT
+                else:
+                    self.condition.wait(deadline - time.time())
+
+    def WaitForSingleObject(self, hHandle, dwMilliseconds):
+        return self.wait([hHandle], dwMilliseconds)
+
+    def WaitForMultipleObjects(
+            self, nCount, lpHandles, bWaitAll, dwMilliseconds):
+        return self.wait(
+            [lpHandles[index] for index in range(nCount)], dwMilliseconds)
+
+    def CloseHandle(self, hObject):
+        self.closed.append(self.fd(hObject))
+        return 1
+
+
+class SyncCase(TestCase):
+    def setUp(self):
+        super(SyncCase, self).setUp()
+        self.library = self.standin_library(SyncLibrary)
+
+    def in_thread(self, target):
+        thread = threading.Thread(target=target)
+        thread.daemon = True
+        thread.start()
+        self.addCleanup(thread.join, 5)
+        return thread
+
+
+class TestSemaphoreFunctions(SyncCase):
+    def test_release_returns_previous_count(self):
+        hSemaphore = CreateSemaphoreEx(lInitialCount=1, lMaximumCount=3)
+        self.assertEqual(ReleaseSemaphore(hSemaphore, 2), 1)
+        self.assertEqual(self.library.objects[100]["count"], 3)
+
+    def test_release_above_maximum(self):
+        hSemaphore = CreateSemaphoreEx(lInitialCount=1, lMaximumCount=1)
+        with self.assertRaises(WindowsAPIError) as error:
+            ReleaseSemaphore(hSemaphore)
+        self.assertEqual(error.exception.errno, 298)
+
+    def test_open_existing_named(self):
+        first = CreateSemaphoreEx(lpName=u"slots")
+        second = CreateSemaphoreEx(lpName=u"slots")
+        self.assertIsNot(first, second)
+        self.assertIs(self.library.objects[100], self.library.objects[101])
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+
+class TestMutexFunctions(SyncCase):
+    def test_initial_owner(self):
+        hMutex = CreateMutexEx(
+            dwFlags=self.library.CREATE_MUTEX_INITIAL_OWNER)
+        ReleaseMutex(hMutex)
+        self.assertIsNone(self.library.objects[100]["owner"])
+
+    def test_release_not_owner(self):
+        with self.assertRaises(WindowsAPIError) as error:
+            ReleaseMutex(CreateMutexEx())
+        self.assertEqual(error.exception.errno, 288)
+
+
+class TestWaitForMultipleObjects(SyncCase):
+    def test_returns_index_of_signaled_object(self):
+        empty = CreateSemaphoreEx(lInitialCount=0)
+        full = CreateSemaphoreEx(lInitialCount=1)
+        self.assertEqual(
+            WaitForMultipleObjects([empty, full], False, 0),
+            self.library.WAIT_OBJECT_0 + 1)
+        self.assertEqual(
+            WaitForMultipleObjects([empty, full], False, 0),
+            self.library.WAIT_TIMEOUT)
+
+    def test_no_handles(self):
+        with self.assertRaises(InputError):
+            WaitForMultipleObjects([], False, 0)
+
+
+class TestSemaphore(SyncCase):
+    def test_context_manager(self):
+        semaphore = Semaphore(1, 1)
+        with semaphore:
+            self.assertFalse(semaphore.acquire(timeout=0))
+        self.assertTrue(semaphore.acquire(timeout=0))
+        self.assertEqual(semaphore.statistics(), (2, 0, 1, 0))
+
+    def test_contention(self):
+        semaphore = Semaphore(0, 1)
+        self.in_thread(lambda: (time.sleep(0.05), semaphore.release()))
+        self.assertTrue(semaphore.acquire(timeout=5))
+        self.assertEqual(semaphore.contentions, 1)
+        self.assertEqual(semaphore.acquisitions, 1)
+
+    def test_timeout(self):
+        semaphore = Semaphore(0, 1)
+        self.assertFalse(semaphore.acquire(timeout=0.01))
+        self.assertEqual(semaphore.statistics(), (0, 1, 1, 0))
+
+    def test_invalid_counts(self):
+        with self.assertRaises(InputError):
+            Semaphore(2, 1)
+        with self.assertRaises(InputError):
+            Semaphore(0, 0)
+
+    def test_close(self):
+        semaphore = Semaphore()
+        semaphore.close()
+        semaphore.close()
+        self.assertEqual(self.library.closed, [100])
+
+
+class TestMutex(SyncCase):
+    def test_excludes_other_threads(self):
+        mutex = Mutex()
+        acquired = []
+        with mutex:
+            self.in_thread(
+                lambda: acquired.append(mutex.acquire(timeout=0))).join(5)
+        self.assertEqual(acquired, [False])
+
+    def test_abandoned_recovery(self):
+        recovered = []
+        mutex = Mutex(
+            name=u"jobs", on_abandoned=lambda: recovered.append(True))
+        self.library.abandon(100)
+        with mutex:
+            self.assertEqual(recovered, [True])
+        self.assertEqual(mutex.statistics(), (1, 0, 0, 1))
+        self.assertIsNone(self.library.objects[100]["owner"])
+
+    def test_abandoned_without_handler(self):
+        mutex = Mutex(initial_owner=True)
+        self.library.abandon(100)
+        self.assertTrue(mutex.acquire())
+        self.assertEqual(mutex.abandoned, 1)
+
+    def test_failed_recovery_releases(self):
+        def on_abandoned():
+            raise ValueError("corrupt")
+
+        mutex = Mutex(on_abandoned=on_abandoned)
+        self.library.abandon(100)
+        with self.assertRaises(ValueError):
+            mutex.acquire()
+        self.assertIsNone(self.library.objects[100]["owner"])
+
+    def test_on_abandoned_not_callable(self):
+        with self.assertRaises(InputError):
+            Mutex(on_abandoned=1)
+
+
+class TestWaitAny(SyncCase):
+    def test_returns_acquired_object(self):
+        semaphore = Semaphore(0, 1)
+        mutex = Mutex()
+        self.assertIs(wait_any([semaphore, mutex], timeout=0), mutex)
+        self.assertEqual(mutex.acquisitions, 1)
+        self.assertEqual(semaphore.acquisitions, 0)
+
+    def test_abandoned(self):
+        recovered = []
+        semaphore = Semaphore(0, 1)
+        mutex = Mutex(on_abandoned=lambda: recovered.append(True))
+        self.library.abandon(101)
+        self.assertIs(wait_any([semaphore, mutex]), mutex)
+        self.assertEqual(recovered, [True])
+        self.assertEqual(mutex.abandoned, 1)
+
+    def test_timeout(self):
+        semaphore = Semaphore(0, 1)
+        self.assertIsNone(wait_any([semaphore], timeout=0.01))
+        self.assertEqual(semaphore.statistics(), (0, 1, 1, 0))
 
 
 class TestWaitForSingleObject(TestCase):
@@ -49,3 +345,263 @@ class TestWaitForSingleObject(TestCase):
         self.assertEqual(
             WaitForSingleObject(hProcess, library.INFINITE),
             library.WAIT_OBJECT_0)
+
+
+class SRWLibrary(StandInLibrary):
+    """
+    Implements SRW locks and condition variables, keyed by the address of
+    the ``SRWLOCK`` or ``CONDITION_VARIABLE``, with a single
+    :class:`threading.Condition`.  Waiting on it releases the GIL the way
+    cffi does for the real functions.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_TIMEOUT=1460,
+        CONDITION_VARIABLE_LOCKMODE_SHARED=0x1
+    )
+
+    def __init__(self, ffi):
+        super(SRWLibrary, self).__init__(ffi)
+        self.monitor = threading.Condition()
+        self.locks = {}
+        self.sleepers = {}
+
+    def lock(self, SRWLock):
+        return self.locks[int(self.ffi.cast("uintptr_t", SRWLock))]
+
+    def InitializeSRWLock(self, SRWLock):
+        self.locks[int(self.ffi.cast("uintptr_t", SRWLock))] = {
+            "readers": 0, "writer": None}
+
+    def try_shared(self, state):
+        if state["writer"] is None:
+            state["readers"] += 1
+            return True
+        return False
+
+    def try_exclusive(self, state):
+        if state["writer"] is None and not state["readers"]:
+            state["writer"] = threading.current_thread().ident
+            return True
+        return False
+
+    def TryAcquireSRWLockShared(self, SRWLock):
+        with self.monitor:
+            return int(self.try_shared(self.lock(SRWLock)))
+
+    def TryAcquireSRWLockExclusive(self, SRWLock):
+        with self.monitor:
+            return int(self.try_exclusive(self.lock(SRWLock)))
+
+    def AcquireSRWLockShared(self, SRWLock):
+        state = self.lock(SRWLock)
+        with self.monitor:
+            while not self.try_shared(state):
+                self.monitor.wait()
+
+    def AcquireSRWLockExclusive(self, SRWLock):
+        state = self.lock(SRWLock)
+        with self.monitor:
+            while not self.try_exclusive(state):
+                self.monitor.wait()
+
+    def ReleaseSRWLockShared(self, SRWLock):
+        state = self.lock(SRWLock)
+        with self.monitor:
+            assert state["readers"] > 0, "not held in shared mode"
+            state["readers"] -= 1
+            self.monitor.notify_all()
+
+    def ReleaseSRWLockExclusive(self, SRWLock):
+        state = self.lock(SRWLock)
+        with self.monitor:
+            assert state["writer"] == threading.current_thread().ident, \
+                "not held in exclusive mode by this thread"
+            state["writer"] = None
+            self.monitor.notify_all()
+
+    def InitializeConditionVariable(self, ConditionVariable):
+        self.sleepers[int(self.ffi.cast("uintptr_t", ConditionVariable))] = []
+
+    def SleepConditionVariableSRW(
+            self, ConditionVariable, SRWLock, dwMilliseconds, Flags):
+        shared = int(Flags) & self.CONDITION_VARIABLE_LOCKMODE_SHARED
+        if shared:
+            release, take = self.ReleaseSRWLockShared, self.try_shared
+        else:
+            release, take = self.ReleaseSRWLockExclusive, self.try_exclusive
+
+        sleepers = self.sleepers[
+            int(self.ffi.cast("uintptr_t", ConditionVariable))]
+        state = self.lock(SRWLock)
+        deadline = None
+        if dwMilliseconds != self.INFINITE:
+            deadline = time.time() + int(dwMilliseconds) / 1000.0
+
+        woken = []
+        with self.monitor:
+            sleepers.append(woken)
+            release(SRWLock)
+            while not woken:
+                if deadline is None:
+                    self.monitor.wait()
+                elif deadline <= time.time():
+                    sleepers.remove(woken)
+                    break
+                else:
+                    self.monitor.wait(deadline - time.time())
+
+            while not take(state):
+                self.monitor.wait()
+
+        return 1 if woken else self.fail(self.ERROR_TIMEOUT)
+
+    def WakeConditionVariable(self, ConditionVariable):
+        sleepers = self.sleepers[
+            int(self.ffi.cast("uintptr_t", ConditionVariable))]
+        with self.monitor:
+            if sleepers:
+                sleepers.pop(0).append(True)
+                self.monitor.notify_all()
+
+    def WakeAllConditionVariable(self, ConditionVariable):
+        sleepers = self.sleepers[
+            int(self.ffi.cast("uintptr_t", ConditionVariable))]
+        with self.monitor:
+            while sleepers:
+                sleepers.pop(0).append(True)
+            self.monitor.notify_all()
+
+
+class SRWCase(SyncCase):
+    def setUp(self):
+        super(SRWCase, self).setUp()
+        self.library = self.standin_library(SRWLibrary)
+
+
+class TestSRWLockFunctions(SRWCase):
+    def test_shared_excludes_exclusive(self):
+        SRWLock = self.library.ffi.new("PSRWLOCK")
+        InitializeSRWLock(SRWLock)
+        AcquireSRWLockShared(SRWLock)
+        self.assertTrue(TryAcquireSRWLockShared(SRWLock))
+        self.assertFalse(TryAcquireSRWLockExclusive(SRWLock))
+        ReleaseSRWLockShared(SRWLock)
+        ReleaseSRWLockShared(SRWLock)
+        self.assertTrue(TryAcquireSRWLockExclusive(SRWLock))
+
+    def test_wrong_pointer_type(self):
+        with self.assertRaises(InputError):
+            InitializeSRWLock(self.library.ffi.new("PCONDITION_VARIABLE"))
+        with self.assertRaises(InputError):
+            InitializeSRWLock(None)
+
+    def test_sleep_times_out(self):
+        ffi = self.library.ffi
+        SRWLock = ffi.new("PSRWLOCK")
+        ConditionVariable = ffi.new("PCONDITION_VARIABLE")
+        InitializeSRWLock(SRWLock)
+        InitializeConditionVariable(ConditionVariable)
+        AcquireSRWLockShared(SRWLock)
+        self.assertFalse(SleepConditionVariableSRW(
+            ConditionVariable, SRWLock, 10,
+            self.library.CONDITION_VARIABLE_LOCKMODE_SHARED))
+        self.assertEqual(ffi.last_error, 0)
+        self.assertEqual(self.library.lock(SRWLock)["readers"], 1)
+        WakeConditionVariable(ConditionVariable)
+
+
+class TestRWLock(SRWCase):
+    def test_readers_share(self):
+        lock = RWLock()
+        with lock.shared:
+            self.assertTrue(lock.acquire_shared(blocking=False))
+            self.assertFalse(lock.acquire_exclusive(blocking=False))
+            lock.release_shared()
+        self.assertEqual(lock.statistics(), (2, 0, 0))
+
+    def test_writer_excludes_readers(self):
+        lock = RWLock()
+        results = []
+        with lock.exclusive:
+            self.in_thread(lambda: results.append(
+                lock.acquire_shared(blocking=False))).join(5)
+        self.assertEqual(results, [False])
+
+    def test_contention(self):
+        lock = RWLock()
+        acquired = threading.Event()
+
+        def reader():
+            with lock.shared:
+                acquired.set()
+
+        with lock:
+            thread = self.in_thread(reader)
+            time.sleep(0.05)
+            self.assertFalse(acquired.is_set())
+        thread.join(5)
+        self.assertTrue(acquired.is_set())
+        self.assertEqual(lock.statistics(), (1, 1, 1))
+
+
+class TestCondition(SRWCase):
+    def test_producer_consumer(self):
+        condition = Condition()
+        queue = []
+
+        def producer():
+            for value in range(3):
+                with condition:
+                    queue.append(value)
+                    condition.notify()
+
+        received = []
+        self.in_thread(producer)
+        while len(received) < 3:
+            with condition:
+                self.assertTrue(condition.wait_for(lambda: queue, timeout=5))
+                received.extend(queue)
+                del queue[:]
+        self.assertEqual(received, [0, 1, 2])
+
+    def test_wait_timeout(self):
+        condition = Condition()
+        with condition:
+            self.assertFalse(condition.wait(timeout=0.01))
+        self.assertEqual((condition.waits, condition.timeouts), (1, 1))
+
+    def test_wait_for_timeout(self):
+        condition = Condition()
+        with condition:
+            self.assertFalse(condition.wait_for(lambda: False, timeout=0.02))
+        self.assertGreaterEqual(condition.timeouts, 1)
+
+    def test_notify_all_shared(self):
+        lock = RWLock()
+        condition = Condition(lock)
+        state = {"ready": False}
+        woken = []
+
+        def waiter():
+            with lock.shared:
+                condition.wait_for(
+                    lambda: state["ready"], timeout=5, shared=True)
+                woken.append(state["ready"])
+
+        threads = [self.in_thread(waiter) for _ in range(3)]
+        sleepers = self.library.sleepers[
+            int(self.library.ffi.cast("uintptr_t", condition.pointer))]
+        deadline = time.time() + 5
+        while len(sleepers) < 3 and time.time() < deadline:
+            time.sleep(0.001)
+        with condition:
+            state["ready"] = True
+            condition.notify_all()
+        for thread in threads:
+            thread.join(5)
+        self.assertEqual(woken, [True, True, True])
+
+    def test_lock_type(self):
+        with self.assertRaises(InputError):
+            Condition(threading.Lock())
@@ -0,0 +1,301 @@
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32 import (
+    CancelWaitableTimer, CreateTimerQueueTimer, CreateWaitableTimerEx,
+    DeleteTimerQueueTimer, SetWaitableTimer, TimerScheduler)
+from pywincffi.kernel32 import timers
+from pywincffi.wintypes import HANDLE
+
+MILLISECOND = 1000000
+
+
+class TimerLibrary(StandInLibrary):
+    """
+    Implements waitable timers and timer queues on top of a fake clock,
+    :attr:`now`, in nanoseconds.  Waiting on a timer moves the clock to
+    the timer's due time plus :attr:`latency`, which stands in for the
+    time the system takes to wake the waiting thread.  Timer queue
+    callbacks only run when a test calls :meth:`fire`.  High resolution
+    waitable timers are rejected unless :attr:`high_resolution` is set,
+    like versions of Windows before Windows 10 1803.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        TIMER_ALL_ACCESS=0x1F0003,
+        CREATE_WAITABLE_TIMER_MANUAL_RESET=0x00000001,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION=0x00000002,
+        WT_EXECUTEDEFAULT=0x00000000,
+        WT_EXECUTEONLYONCE=0x00000008
+    )
+
+    def __init__(self, ffi):
+        super(TimerLibrary, self).__init__(ffi)
+        self.now = 0
+        self.latency = 0
+        self.high_resolution = True
+        self.next_handle = 100
+        self.due = {}
+        self.calls = []
+        self.closed = []
+        self.queue_timers = {}
+
+    def clock(self):
+        return self.now
+
+    def new_handle(self):
+        self.next_handle += 1
+        return self.handle(self.next_handle)
+
+    def CreateWaitableTimerEx(
+            self, lpTimerAttributes, lpTimerName, dwFlags, dwDesiredAccess):
+        self.calls.append(
+            ("CreateWaitableTimerEx", int(dwFlags), int(dwDesiredAccess)))
+        if lpTimerName == u"fail":
+            return self.fail(self.ERROR_ACCESS_DENIED, self.ffi.NULL)
+        if int(dwFlags) & self.CREATE_WAITABLE_TIMER_HIGH_RESOLUTION and \
+                not self.high_resolution:
+            return self.fail(self.ERROR_INVALID_PARAMETER, self.ffi.NULL)
+        return self.new_handle()
+
+    def SetWaitableTimer(  # pylint: disable=too-many-arguments
+            self, hTimer, pDueTime, lPeriod, pfnCompletionRoutine,
+            lpArgToCompletionRoutine, fResume):
+        due = pDueTime.QuadPart
+        self.calls.append(("SetWaitableTimer", due, lPeriod, fResume))
+        if due == 0:
+            return self.fail(self.ERROR_INVALID_PARAMETER)
+        self.due[self.fd(hTimer)] = self.now - due * 100 if due < 0 else due
+        return 1
+
+    def CancelWaitableTimer(self, hTimer):
+        self.calls.append(("CancelWaitableTimer", self.fd(hTimer)))
+        self.due.pop(self.fd(hTimer), None)
+        return 1
+
+    def WaitForSingleObject(self, hHandle, dwMilliseconds):
+        due = self.due.get(self.fd(hHandle))
+        if dwMilliseconds != self.INFINITE and (
+                due is None or
+                due > self.now + int(dwMilliseconds) * MILLISECOND):
+            self.now += int(dwMilliseconds) * MILLISECOND
+            return self.WAIT_TIMEOUT
+        if due is None:
+            raise AssertionError("waiting forever on an unset timer")
+        del self.due[self.fd(hHandle)]
+        self.now = max(self.now, due) + self.latency
+        return self.WAIT_OBJECT_0
+
+    def CloseHandle(self, hObject):
+        self.closed.append(self.fd(hObject))
+        return 1
+
+    def CreateTimerQueueTimer(  # pylint: disable=too-many-arguments
+            self, phNewTimer, TimerQueue, Callback, Parameter, DueTime,
+            Period, Flags):
+        timer = self.new_handle()
+        self.queue_timers[self.fd(timer)] = (
+            Callback, Parameter, int(DueTime), int(Period), int(Flags))
+        phNewTimer[0] = timer
+        return 1
+
+    def DeleteTimerQueueTimer(self, TimerQueue, Timer, CompletionEvent):
+        self.calls.append(
+            ("DeleteTimerQueueTimer", self.fd(CompletionEvent)))
+        self.queue_timers.pop(self.fd(Timer))
+        return 1
+
+    def fire(self, timer):
+        callback, parameter = self.queue_timers[timer][:2]
+        callback(parameter, 1)
+
+
+class TimerCase(TestCase):
+    def setUp(self):
+        super(TimerCase, self).setUp()
+        self.library = self.standin_library(TimerLibrary)
+
+
+class TestWaitableTimer(TimerCase):
+    def test_defaults_to_high_resolution(self):
+        hTimer = CreateWaitableTimerEx()
+        self.assertIsInstance(hTimer, HANDLE)
+        self.assertEqual(
+            self.library.calls,
+            [("CreateWaitableTimerEx", 0x00000002, 0x1F0003)])
+
+    def test_falls_back_without_high_resolution(self):
+        self.library.high_resolution = False
+        self.assertIsInstance(CreateWaitableTimerEx(), HANDLE)
+        self.assertEqual(
+            self.library.calls,
+            [("CreateWaitableTimerEx", 0x00000002, 0x1F0003),
+             ("CreateWaitableTimerEx", 0x00000000, 0x1F0003)])
+
+    def test_explicit_high_resolution_not_retried(self):
+        self.library.high_resolution = False
+        with self.assertRaises(WindowsAPIError):
+            CreateWaitableTimerEx(dwFlags=0x00000002)
+
+    def test_create_failure(self):
+        with self.assertRaises(WindowsAPIError):
+            CreateWaitableTimerEx(lpTimerName=u"fail")
+
+    def test_set_and_cancel(self):
+        hTimer = CreateWaitableTimerEx()
+        SetWaitableTimer(hTimer, -5000, lPeriod=10)
+        self.assertEqual(self.library.due, {101: 500000})
+        CancelWaitableTimer(hTimer)
+        self.assertEqual(self.library.due, {})
+        self.assertEqual(
+            self.library.calls[1:],
+            [("SetWaitableTimer", -5000, 10, 0), ("CancelWaitableTimer", 101)])
+
+    def test_set_failure(self):
+        with self.assertRaises(WindowsAPIError):
+            SetWaitableTimer(CreateWaitableTimerEx(), 0)
+
+
+class TestTimerQueueTimer(TimerCase):
+    def test_callback_receives_parameter(self):
+        received = []
+        Timer = CreateTimerQueueTimer(
+            received.append, Parameter="tick", DueTime=5, Period=10)
+        self.assertEqual(
+            self.library.queue_timers[101][2:],
+            (5, 10, 0))
+        self.library.fire(101)
+        self.library.fire(101)
+        self.assertEqual(received, ["tick", "tick"])
+        DeleteTimerQueueTimer(Timer)
+        self.assertEqual(timers._TIMER_CONTEXTS, {})
+
+    def test_delete_waits_for_callbacks(self):
+        DeleteTimerQueueTimer(CreateTimerQueueTimer(lambda _: None))
+        self.assertEqual(
+            self.library.calls, [("DeleteTimerQueueTimer", -1)])
+
+    def test_callback_error_raised_by_delete(self):
+        def callback(_):
+            raise ValueError("boom")
+
+        Timer = CreateTimerQueueTimer(callback)
+        self.library.fire(101)
+        with self.assertRaises(ValueError):
+            DeleteTimerQueueTimer(Timer)
+        self.assertEqual(timers._TIMER_CONTEXTS, {})
+
+    def test_callback_not_callable(self):
+        with self.assertRaises(InputError):
+            CreateTimerQueueTimer(None)
+
+
+class TestTimerScheduler(TimerCase):
+    def setUp(self):
+        super(TestTimerScheduler, self).setUp()
+        self.scheduler = TimerScheduler(clock=self.library.clock)
+        self.addCleanup(self.scheduler.close)
+        self.ran = []
+
+    def record(self, name):
+        return lambda: self.ran.append((name, self.library.now))
+
+    def armed(self):
+        return [
+            call[1] for call in self.library.calls
+            if call[0] == "SetWaitableTimer"]
+
+    def test_runs_in_deadline_order(self):
+        self.scheduler.schedule(self.record("b"), 0.002)
+        self.scheduler.schedule(self.record("a"), 0.001)
+        self.scheduler.schedule(self.record("c"), 0.003)
+        for _ in range(3):
+            self.assertEqual(self.scheduler.wait(), 1)
+        self.assertEqual(
+            self.ran,
+            [("a", MILLISECOND), ("b", 2 * MILLISECOND),
+             ("c", 3 * MILLISECOND)])
+        self.assertEqual(len(self.scheduler), 0)
+
+    def test_timer_only_set_when_earliest_deadline_changes(self):
+        self.scheduler.schedule(self.record("a"), 0.005)
+        self.scheduler.schedule(self.record("b"), 0.010)
+        self.scheduler.schedule(self.record("c"), 0.001)
+        self.scheduler.schedule(self.record("d"), 0.020)
+        self.assertEqual(self.armed(), [-50000, -10000])
+
+    def test_periodic_timer_does_not_drift(self):
+        self.library.latency = 300000
+        timer = self.scheduler.schedule(
+            self.record("tick"), 0.001, period=0.001)
+        for _ in range(5):
+            self.scheduler.wait()
+        self.assertEqual(
+            [now for _, now in self.ran],
+            [n * MILLISECOND + 300000 for n in range(1, 6)])
+        self.assertEqual(timer.runs, 5)
+        self.assertEqual(timer.skipped, 0)
+        self.assertEqual(timer.max_lateness, 300000)
+
+    def test_missed_periods_are_skipped(self):
+        timer = self.scheduler.schedule(
+            self.record("tick"), 0.001, period=0.001)
+        self.library.now = int(3.5 * MILLISECOND)
+        self.assertEqual(self.scheduler.run_pending(), 1)
+        self.assertEqual(timer.skipped, 2)
+        self.assertEqual(timer.deadline, 4 * MILLISECOND)
+        self.assertEqual(self.armed()[-1], -5000)
+
+    def test_cancel(self):
+        first = self.scheduler.schedule(self.record("a"), 0.001)
+        self.scheduler.schedule(self.record("b"), 0.002)
+        first.cancel()
+        self.library.now = 3 * MILLISECOND
+        self.assertEqual(self.scheduler.run_pending(), 1)
+        self.assertEqual(self.ran, [("b", 3 * MILLISECOND)])
+
+    def test_cancel_from_callback(self):
+        timer = self.scheduler.schedule(
+            lambda: timer.cancel(), 0.001, period=0.001)
+        self.scheduler.wait()
+        self.assertEqual(len(self.scheduler), 0)
+
+    def test_callback_error_keeps_timers_armed(self):
+        def tick():
+            self.ran.append(("tick", self.library.now))
+            if len(self.ran) == 1:
+                raise ValueError("tick")
+
+        timer = self.scheduler.schedule(tick, 0.001, period=0.001)
+        self.scheduler.schedule(self.record("b"), 0.0015)
+        with self.assertRaises(ValueError):
+            self.scheduler.wait()
+        self.assertEqual(len(self.scheduler), 2)
+        self.assertEqual(timer.deadline, 2 * MILLISECOND)
+
+        self.assertEqual(self.scheduler.wait(), 1)
+        self.assertEqual(self.scheduler.wait(), 1)
+        self.assertEqual(
+            self.ran,
+            [("tick", MILLISECOND), ("b", int(1.5 * MILLISECOND)),
+             ("tick", 2 * MILLISECOND)])
+
+    def test_nothing_due(self):
+        self.scheduler.schedule(self.record("a"), 0.010)
+        self.assertEqual(self.scheduler.run_pending(), 0)
+        self.assertEqual(self.scheduler.wait(1), 0)
+        self.assertEqual(self.library.now, MILLISECOND)
+
+    def test_invalid_period(self):
+        with self.assertRaises(InputError):
+            self.scheduler.schedule(self.record("a"), 0, period=0)
+
+    def test_close_owned_timer(self):
+        self.scheduler.close()
+        self.scheduler.close()
+        self.assertEqual(self.library.closed, [101])
+
+    def test_close_keeps_given_timer(self):
+        hTimer = CreateWaitableTimerEx()
+        with TimerScheduler(hTimer, clock=self.library.clock):
+            pass
+        self.assertEqual(self.library.closed, [])
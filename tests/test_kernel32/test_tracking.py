@@ -0,0 +1,143 @@
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.kernel32 import (
+    CloseHandle, CreateEvent, CreatePipe, HandleGroup, OpenProcess,
+    tracking)
+from pywincffi.kernel32.tracking import HandleTracker, format_stack
+
+
+class TrackedLibrary(StandInLibrary):
+    """
+    Implements the functions which create and close handles by handing
+    out increasing handle values, reusing closed ones as Windows does.
+    """
+    def __init__(self, ffi):
+        super(TrackedLibrary, self).__init__(ffi)
+        self.free = []
+        self.next_value = 4
+
+    def new_handle(self):
+        if self.free:
+            return self.handle(self.free.pop())
+        self.next_value += 4
+        return self.handle(self.next_value)
+
+    def CreateEvent(self, lpEventAttributes, bManualReset, bInitialState,
+                    lpName):
+        return self.new_handle()
+
+    def CreatePipe(self, hReadPipe, hWritePipe, lpPipeAttributes, nSize):
+        hReadPipe[0] = self.new_handle()
+        hWritePipe[0] = self.new_handle()
+        return 1
+
+    def OpenProcess(self, dwDesiredAccess, bInheritHandle, dwProcessId):
+        return self.new_handle()
+
+    def CloseHandle(self, hObject):
+        self.free.append(self.fd(hObject))
+        return 1
+
+
+def leaky_events(count):
+    events = []
+    for _ in range(count):
+        events.append(CreateEvent())
+    return events
+
+
+class TestHandleTracking(TestCase):
+    """
+    Tests for :mod:`pywincffi.kernel32.tracking`
+    """
+    def setUp(self):
+        super(TestHandleTracking, self).setUp()
+        self.library = self.standin_library(TrackedLibrary)
+        self.addCleanup(tracking.disable)
+
+    def test_disabled_by_default(self):
+        self.assertIsNone(tracking.tracker)
+        CloseHandle(CreateEvent())
+
+    def test_enable_returns_active_tracker(self):
+        tracker = tracking.enable()
+        self.assertIs(tracking.enable(), tracker)
+        self.assertIs(tracking.disable(), tracker)
+        self.assertIsNone(tracking.disable())
+
+    def test_census(self):
+        tracker = tracking.enable()
+        events = leaky_events(3)
+        reader, writer = CreatePipe()
+        process = OpenProcess(0, False, 42)
+        self.assertEqual(
+            tracker.census(),
+            {"CreateEvent": 3, "CreatePipe": 2, "OpenProcess": 1})
+
+        for handle in events + [reader, writer, process]:
+            CloseHandle(handle)
+        self.assertEqual(tracker.census(), {})
+        self.assertEqual(len(tracker), 0)
+        self.assertEqual(tracker.opened, 6)
+        self.assertEqual(tracker.closed, 6)
+
+    def test_stack_starts_at_caller_of_wrapper(self):
+        tracker = tracking.enable(depth=2)
+        leaky_events(1)
+        record, = tracker.live()
+        self.assertEqual(len(record.stack), 2)
+        filename, _, name = record.stack[0]
+        self.assertTrue(filename.endswith("test_tracking.py"))
+        self.assertEqual(name, "leaky_events")
+        self.assertEqual(
+            record.stack[1][2], "test_stack_starts_at_caller_of_wrapper")
+        self.assertIn("test_tracking.py:", format_stack(record.stack))
+
+    def test_top_leakers(self):
+        tracker = tracking.enable()
+        leaky_events(5)
+        OpenProcess(0, False, 42)
+        CreateEvent()
+
+        leaks = tracker.top_leakers()
+        self.assertEqual(
+            [(leak.function, leak.count) for leak in leaks],
+            [("CreateEvent", 5), ("CreateEvent", 1), ("OpenProcess", 1)])
+        self.assertEqual(len(tracker.top_leakers(1)), 1)
+
+        report = tracker.dump(count=2).splitlines()
+        self.assertEqual(
+            report[0], "7 open handle(s), 7 opened, 0 closed, 0 unmatched")
+        self.assertEqual(len(report), 3)
+        self.assertIn("leaky_events", report[1])
+
+    def test_handles_created_before_enable_are_unmatched(self):
+        handle = CreateEvent()
+        tracker = tracking.enable()
+        CloseHandle(handle)
+        self.assertEqual(tracker.unmatched, 1)
+        self.assertEqual(tracker.closed, 0)
+
+    def test_reused_value_replaces_record(self):
+        tracker = tracking.enable()
+        handle = CreateEvent()
+        tracking.disable()
+        CloseHandle(handle)
+
+        tracking.tracker = tracker
+        OpenProcess(0, False, 42)
+        self.assertEqual(tracker.census(), {"OpenProcess": 1})
+
+    def test_handle_group_untracks(self):
+        tracker = tracking.enable()
+        with HandleGroup(leaky_events(4)):
+            self.assertEqual(len(tracker), 4)
+        self.assertEqual(len(tracker), 0)
+        self.assertEqual(tracker.closed, 4)
+
+    def test_reset(self):
+        tracker = HandleTracker()
+        tracking.tracker = tracker
+        leaky_events(2)
+        tracker.reset()
+        self.assertEqual(len(tracker), 0)
+        self.assertEqual(tracker.opened, 0)
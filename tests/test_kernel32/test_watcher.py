@@ -0,0 +1,305 @@
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.kernel32.watcher import (
+    DirectoryWatcher, FileChange, coalesce, parse_notify_information)
+
+ADDED, REMOVED, MODIFIED, RENAMED_OLD_NAME, RENAMED_NEW_NAME = range(1, 6)
+
+
+def pack_notify_information(ffi, lpBuffer, changes):
+    """
+    Packs ``(action, name)`` tuples into ``lpBuffer`` as a chain of
+    ``FILE_NOTIFY_INFORMATION`` records aligned to 4 bytes, as Windows
+    does, and returns the number of bytes used.
+    """
+    name_offset = ffi.offsetof("FILE_NOTIFY_INFORMATION", "FileName")
+    address = ffi.cast("char *", lpBuffer)
+    offset = 0
+
+    for i, (action, name) in enumerate(changes):
+        encoded = name.encode("utf-16-le")
+        length = (name_offset + len(encoded) + 3) & ~3
+        info = ffi.cast("PFILE_NOTIFY_INFORMATION", address + offset)
+        info.NextEntryOffset = length if i < len(changes) - 1 else 0
+        info.Action = action
+        info.FileNameLength = len(encoded)
+        ffi.memmove(address + offset + name_offset, encoded, len(encoded))
+        offset += length
+
+    return offset
+
+
+class WatchLibrary(StandInLibrary):
+    """
+    Implements ReadDirectoryChangesW and the functions DirectoryWatcher
+    waits with.  Each item in ``batches`` completes one read.  An item is
+    either a list of ``(action, name)`` tuples, ``None`` for a read which
+    overflowed or an error code the read fails with.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        ERROR_NOT_FOUND=1168,
+        ERROR_OPERATION_ABORTED=995,
+        ERROR_NOTIFY_ENUM_DIR=1022,
+        FILE_LIST_DIRECTORY=0x0001,
+        FILE_SHARE_READ=0x00000001,
+        FILE_SHARE_WRITE=0x00000002,
+        FILE_SHARE_DELETE=0x00000004,
+        CREATE_NEW=1,
+        CREATE_ALWAYS=2,
+        OPEN_EXISTING=3,
+        OPEN_ALWAYS=4,
+        TRUNCATE_EXISTING=5,
+        FILE_FLAG_BACKUP_SEMANTICS=0x02000000,
+        FILE_FLAG_OVERLAPPED=0x40000000,
+        FILE_NOTIFY_CHANGE_FILE_NAME=0x00000001,
+        FILE_NOTIFY_CHANGE_DIR_NAME=0x00000002,
+        FILE_NOTIFY_CHANGE_SIZE=0x00000008,
+        FILE_NOTIFY_CHANGE_LAST_WRITE=0x00000010,
+        FILE_NOTIFY_CHANGE_CREATION=0x00000040,
+        FILE_ACTION_ADDED=ADDED,
+        FILE_ACTION_REMOVED=REMOVED,
+        FILE_ACTION_MODIFIED=MODIFIED,
+        FILE_ACTION_RENAMED_OLD_NAME=RENAMED_OLD_NAME,
+        FILE_ACTION_RENAMED_NEW_NAME=RENAMED_NEW_NAME
+    )
+    DIRECTORY = 100
+    EVENT = 200
+
+    def __init__(self, ffi):
+        super(WatchLibrary, self).__init__(ffi)
+        self.batches = []
+        self.reads = []
+        self.closed = []
+        self.cancelled = False
+        self.pending = None
+
+    def address(self, pointer):
+        return int(self.ffi.cast("uintptr_t", pointer))
+
+    def CreateFile(  # pylint: disable=too-many-arguments
+            self, lpFileName, dwDesiredAccess, dwShareMode,
+            lpSecurityAttributes, dwCreationDisposition,
+            dwFlagsAndAttributes, hTemplateFile):
+        assert dwFlagsAndAttributes & self.FILE_FLAG_OVERLAPPED
+        return self.handle(self.DIRECTORY)
+
+    def CreateEvent(self, lpEventAttributes, bManualReset, bInitialState,
+                    lpName):
+        return self.handle(self.EVENT)
+
+    def ResetEvent(self, hEvent):
+        return 1
+
+    def CloseHandle(self, hObject):
+        self.closed.append(self.fd(hObject))
+        return 1
+
+    def ReadDirectoryChangesW(  # pylint: disable=too-many-arguments
+            self, hDirectory, lpBuffer, nBufferLength, bWatchSubtree,
+            dwNotifyFilter, lpBytesReturned, lpOverlapped,
+            lpCompletionRoutine):
+        assert lpBytesReturned == self.ffi.NULL
+        assert self.fd(lpOverlapped.hEvent) == self.EVENT
+        assert self.pending is None, "only one read may be outstanding"
+        self.reads.append(self.address(lpBuffer))
+        self.pending = lpBuffer
+        return 1
+
+    def CancelIoEx(self, hFile, lpOverlapped):
+        self.cancelled = True
+        return 1
+
+    def WaitForSingleObject(self, hHandle, dwMilliseconds):
+        assert self.fd(hHandle) == self.EVENT
+        if self.batches or self.cancelled:
+            return self.WAIT_OBJECT_0
+        return self.WAIT_TIMEOUT
+
+    def GetOverlappedResult(self, hFile, lpOverlapped,
+                            lpNumberOfBytesTransferred, bWait):
+        lpBuffer, self.pending = self.pending, None
+        if self.cancelled:
+            return self.fail(self.ERROR_OPERATION_ABORTED)
+
+        batch = self.batches.pop(0)
+        if isinstance(batch, int):
+            return self.fail(batch)
+
+        lpNumberOfBytesTransferred[0] = 0
+        if batch is not None:
+            lpNumberOfBytesTransferred[0] = pack_notify_information(
+                self.ffi, lpBuffer, batch)
+        return 1
+
+
+class TestParseNotifyInformation(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.watcher.parse_notify_information`
+    """
+    def setUp(self):
+        super(TestParseNotifyInformation, self).setUp()
+        self.library = self.standin_library(WatchLibrary)
+        self.ffi = self.library.ffi
+
+    def test_parse(self):
+        buffer_ = self.ffi.new("char[]", 1024)
+        length = pack_notify_information(self.ffi, buffer_, [
+            (ADDED, u"a.txt"),
+            (MODIFIED, u"sub\\b\u00e9.txt"),
+            (REMOVED, u"c")
+        ])
+        self.assertEqual(list(parse_notify_information(buffer_, length)), [
+            FileChange(ADDED, u"a.txt"),
+            FileChange(MODIFIED, u"sub\\b\u00e9.txt"),
+            FileChange(REMOVED, u"c")
+        ])
+
+    def test_parse_from_bytearray(self):
+        buffer_ = bytearray(64)
+        length = pack_notify_information(
+            self.ffi, self.ffi.from_buffer(buffer_), [(ADDED, u"name")])
+        self.assertEqual(
+            list(parse_notify_information(buffer_, length)),
+            [FileChange(ADDED, u"name")])
+
+    def test_empty(self):
+        buffer_ = self.ffi.new("char[]", 64)
+        self.assertEqual(list(parse_notify_information(buffer_, 0)), [])
+
+    def test_record_beyond_length(self):
+        buffer_ = self.ffi.new("char[]", 64)
+        pack_notify_information(self.ffi, buffer_, [(ADDED, u"x" * 10)])
+        with self.assertRaises(InputError):
+            list(parse_notify_information(buffer_, 20))
+
+    def test_next_entry_beyond_length(self):
+        buffer_ = self.ffi.new("char[]", 64)
+        length = pack_notify_information(self.ffi, buffer_, [(ADDED, u"x")])
+        self.ffi.cast("PFILE_NOTIFY_INFORMATION", buffer_).NextEntryOffset = 60
+        with self.assertRaises(InputError):
+            list(parse_notify_information(buffer_, length))
+
+
+class TestCoalesce(TestCase):
+    """
+    Tests for :func:`pywincffi.kernel32.watcher.coalesce`
+    """
+    def setUp(self):
+        super(TestCoalesce, self).setUp()
+        self.standin_library(WatchLibrary)
+
+    def coalesce(self, *changes):
+        return coalesce(FileChange(*change) for change in changes)
+
+    def test_duplicates(self):
+        self.assertEqual(
+            self.coalesce(
+                (MODIFIED, u"a"), (MODIFIED, u"b"), (MODIFIED, u"a")),
+            [FileChange(MODIFIED, u"a"), FileChange(MODIFIED, u"b")])
+
+    def test_added_then_modified(self):
+        self.assertEqual(
+            self.coalesce((ADDED, u"a"), (MODIFIED, u"a")),
+            [FileChange(ADDED, u"a")])
+
+    def test_added_then_removed(self):
+        self.assertEqual(
+            self.coalesce((ADDED, u"a"), (MODIFIED, u"a"), (REMOVED, u"a")),
+            [])
+
+    def test_removed_then_added(self):
+        self.assertEqual(
+            self.coalesce((REMOVED, u"a"), (ADDED, u"a")),
+            [FileChange(MODIFIED, u"a")])
+
+    def test_modified_then_removed(self):
+        self.assertEqual(
+            self.coalesce((MODIFIED, u"a"), (REMOVED, u"a")),
+            [FileChange(REMOVED, u"a")])
+
+    def test_renamed_into_place(self):
+        self.assertEqual(
+            self.coalesce(
+                (ADDED, u"a.tmp"), (MODIFIED, u"a.tmp"),
+                (RENAMED_OLD_NAME, u"a.tmp"), (RENAMED_NEW_NAME, u"a")),
+            [FileChange(ADDED, u"a")])
+
+
+class TestDirectoryWatcher(TestCase):
+    """
+    Tests for :class:`pywincffi.kernel32.DirectoryWatcher`
+    """
+    def setUp(self):
+        super(TestDirectoryWatcher, self).setUp()
+        self.library = self.standin_library(WatchLibrary)
+        self.rescans = []
+
+    def create_watcher(self, **kwargs):
+        watcher = DirectoryWatcher(
+            u"watched", rescan=self.rescans.append, **kwargs)
+        self.addCleanup(watcher.close)
+        return watcher
+
+    def test_read(self):
+        watcher = self.create_watcher()
+        self.library.batches.append([
+            (ADDED, u"a"), (MODIFIED, u"a"), (MODIFIED, u"b")])
+        self.assertEqual(watcher.read(), [
+            FileChange(ADDED, u"a"), FileChange(MODIFIED, u"b")])
+
+    def test_next_read_uses_other_buffer(self):
+        watcher = self.create_watcher()
+        self.library.batches.extend([[(ADDED, u"a")], [(ADDED, u"b")]])
+        self.assertEqual(len(self.library.reads), 1)
+
+        self.assertEqual(watcher.read(), [FileChange(ADDED, u"a")])
+        self.assertEqual(len(self.library.reads), 2)
+        self.assertIsNotNone(self.library.pending)
+
+        self.assertEqual(watcher.read(), [FileChange(ADDED, u"b")])
+        first, second, third = self.library.reads
+        self.assertNotEqual(first, second)
+        self.assertEqual(first, third)
+
+    def test_timeout(self):
+        watcher = self.create_watcher()
+        self.assertEqual(watcher.read(dwMilliseconds=0), [])
+        self.assertEqual(len(self.library.reads), 1)
+
+    def test_overflow(self):
+        watcher = self.create_watcher()
+        self.library.batches.extend(
+            [None, self.library.ERROR_NOTIFY_ENUM_DIR, [(ADDED, u"a")]])
+        self.assertEqual(watcher.read(), [])
+        self.assertEqual(watcher.read(), [])
+        self.assertEqual(watcher.overflows, 2)
+        self.assertEqual(self.rescans, [u"watched", u"watched"])
+        self.assertEqual(watcher.read(), [FileChange(ADDED, u"a")])
+
+    def test_error(self):
+        watcher = self.create_watcher()
+        self.library.batches.append(self.library.ERROR_ACCESS_DENIED)
+        with self.assertRaises(WindowsAPIError) as error:
+            watcher.read()
+        self.assertEqual(
+            error.exception.errno, self.library.ERROR_ACCESS_DENIED)
+
+    def test_close(self):
+        with DirectoryWatcher(u"watched") as watcher:
+            pass
+
+        self.assertTrue(self.library.cancelled)
+        self.assertIsNone(self.library.pending)
+        self.assertEqual(
+            self.library.closed,
+            [self.library.DIRECTORY, self.library.EVENT])
+
+        watcher.close()
+        self.assertEqual(len(self.library.closed), 2)
+        with self.assertRaises(ValueError):
+            watcher.read()
+
+    def test_invalid_buffer_size(self):
+        with self.assertRaises(InputError):
+            DirectoryWatcher(u"watched", buffer_size=1001)
@@ -4,11 +4,12 @@ import tempfile
 from errno import EBADF
 
 from pywincffi.core import dist
-from pywincffi.dev.testutil import TestCase
+from pywincffi.dev.testutil import TestCase, StandInLibrary
 from pywincffi.exceptions import InputError
 from pywincffi.kernel32 import CloseHandle
 from pywincffi.wintypes import (
-    SOCKET, handle_from_file, socket_from_object)
+    SOCKET, handle_from_file, socket_from_object, split_dwords)
+from pywincffi.wintypes.functions import socket_cache
 
 try:
     WindowsError
@@ -98,3 +99,83 @@ class TestSocketFromObject(TestCase):
         self.assertEqual(library.closesocket(sock._cdata[0]), -1)
 
         self.assert_last_error(library.WSAENOTSOCK)
+
+
+class TestSocketCache(TestCase):
+    """
+    Tests for :class:`pywincffi.wintypes.functions.SocketCache` through
+    :func:`pywincffi.wintypes.socket_from_object`
+    """
+    def setUp(self):
+        super(TestSocketCache, self).setUp()
+        self.standin_library(StandInLibrary)
+        socket_cache.clear()
+        self.addCleanup(socket_cache.clear)
+        self.left, self.right = socket.socketpair()
+        self.addCleanup(self.left.close)
+        self.addCleanup(self.right.close)
+
+    def test_hit(self):
+        first = socket_from_object(self.left)
+        second = socket_from_object(self.left)
+        self.assertIs(first, second)
+        self.assertIsNot(socket_from_object(self.right), first)
+        self.assertEqual((socket_cache.hits, socket_cache.misses), (1, 2))
+        self.assertEqual(socket_cache.hit_rate(), 1.0 / 3)
+
+    def test_value(self):
+        sock = socket_from_object(self.left)
+        self.assertEqual(
+            int(sock._cdata[0]),  # pylint: disable=protected-access
+            self.left.fileno())
+
+    def test_invalidated_on_close(self):
+        socket_from_object(self.left)
+        self.left.close()
+        with self.assertRaises(InputError):
+            socket_from_object(self.left)
+        self.assertEqual(len(socket_cache), 0)
+        self.assertEqual(socket_cache.invalidations, 1)
+
+    def test_invalidated_on_fileno_change(self):
+        class Wrapper(object):  # pylint: disable=too-few-public-methods
+            def __init__(self, fileno):
+                self.fileno = lambda: fileno
+
+        wrapper = Wrapper(self.left.fileno())
+        first = socket_from_object(wrapper)
+        wrapper.fileno = self.right.fileno
+        second = socket_from_object(wrapper)
+        self.assertIsNot(first, second)
+        self.assertEqual(
+            int(second._cdata[0]),  # pylint: disable=protected-access
+            self.right.fileno())
+        self.assertEqual(socket_cache.invalidations, 1)
+        self.assertIs(socket_from_object(wrapper), second)
+
+    def test_held_weakly(self):
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        socket_from_object(sock)
+        self.assertEqual(len(socket_cache), 1)
+        sock.close()
+        del sock
+        self.assertEqual(len(socket_cache), 0)
+
+
+class TestSplitDwords(TestCase):
+    """
+    Tests for :func:`pywincffi.wintypes.split_dwords`
+    """
+    def test_low_only(self):
+        self.assertEqual(split_dwords(0xFFFFFFFF), (0, 0xFFFFFFFF))
+
+    def test_high_and_low(self):
+        self.assertEqual(split_dwords(0x100000002), (1, 2))
+
+    def test_negative(self):
+        with self.assertRaises(InputError):
+            split_dwords(-1)
+
+    def test_too_large(self):
+        with self.assertRaises(InputError):
+            split_dwords(1 << 64)
@@ -1,10 +1,12 @@
 import socket
 
 from pywincffi.core import dist
-from pywincffi.dev.testutil import TestCase, mock_library
-from pywincffi.exceptions import WindowsAPIError
+from pywincffi.dev.testutil import TestCase, StandInLibrary, mock_library
+from pywincffi.exceptions import InputError, WindowsAPIError
 from pywincffi.kernel32 import CloseHandle
-from pywincffi.wintypes import LPWSANETWORKEVENTS, socket_from_object
+from pywincffi.wintypes import (
+    LPWSANETWORKEVENTS, WSAEVENT, socket_from_object)
+from pywincffi.wintypes.functions import socket_cache
 from pywincffi.ws2_32 import (
     WSAGetLastError, WSACreateEvent, WSAEventSelect, WSAEnumNetworkEvents)
 
@@ -139,3 +141,50 @@ class TestWSAEnumNetworkEvents(EventsCase):
         WSAEventSelect(sock_client_wintype, event, library.FD_WRITE)
         events = WSAEnumNetworkEvents(sock_client_wintype, hEventObject=waiter)
         self.assertEqual(events.lNetworkEvents, library.FD_WRITE)
+
+
+class SocketEventsLibrary(StandInLibrary):
+    """
+    Records the sockets WSAEventSelect and WSAEnumNetworkEvents are called
+    with.
+    """
+    CONSTANTS = dict(StandInLibrary.CONSTANTS, SOCKET_ERROR=-1)
+
+    def __init__(self, ffi):
+        super(SocketEventsLibrary, self).__init__(ffi)
+        self.sockets = []
+
+    def WSAEventSelect(self, s, hEventObject, lNetworkEvents):
+        self.sockets.append(int(s))
+        return 0
+
+    def WSAEnumNetworkEvents(self, s, hEventObject, lpNetworkEvents):
+        self.sockets.append(int(s))
+        lpNetworkEvents.lNetworkEvents = 1
+        return 0
+
+
+class TestPythonSockets(TestCase):
+    """
+    Tests that :func:`pywincffi.ws2_32.WSAEventSelect` and
+    :func:`pywincffi.ws2_32.WSAEnumNetworkEvents` accept Python sockets.
+    """
+    def setUp(self):
+        super(TestPythonSockets, self).setUp()
+        self.library = self.standin_library(SocketEventsLibrary)
+        socket_cache.clear()
+        self.addCleanup(socket_cache.clear)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.addCleanup(self.sock.close)
+
+    def test_python_socket(self):
+        event = WSAEVENT(self.library.handle(100))
+        WSAEventSelect(self.sock, event, 1)
+        events = WSAEnumNetworkEvents(self.sock)
+        self.assertEqual(events.lNetworkEvents, 1)
+        self.assertEqual(self.library.sockets, [self.sock.fileno()] * 2)
+        self.assertEqual(socket_cache.hits, 1)
+
+    def test_invalid_type(self):
+        with self.assertRaises(InputError):
+            WSAEnumNetworkEvents(self.sock.fileno())
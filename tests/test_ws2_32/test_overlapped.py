@@ -0,0 +1,372 @@
+import os
+import socket
+import struct
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.wintypes import OVERLAPPED, socket_from_object
+from pywincffi.ws2_32 import (
+    AcceptEx, ConnectEx, SocketBufferPool, WSABufArray, WSAGetOverlappedResult,
+    WSARecv, WSASend, get_extension_function)
+from pywincffi.ws2_32 import overlapped
+from pywincffi.ws2_32.overlapped import EXTENSION_FUNCTIONS, sockaddr
+
+
+class SocketIOLibrary(StandInLibrary):
+    """
+    Implements WSARecv and WSASend with :func:`os.readv` and
+    :func:`os.writev`, and returns Python callbacks for the AcceptEx and
+    ConnectEx extension functions.  When :attr:`pending` is True
+    overlapped operations are deferred until WSAGetOverlappedResult.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        SOCKET_ERROR=-1,
+        WSAEINVAL=10022,
+        WSAECONNRESET=10054,
+        WSA_IO_PENDING=997,
+        SIO_GET_EXTENSION_FUNCTION_POINTER=0xC8000006
+    )
+
+    def __init__(self, ffi):
+        super(SocketIOLibrary, self).__init__(ffi)
+        self.pending = False
+        self.deferred = {}
+        self.ioctls = []
+        self.callbacks = {
+            "LPFN_ACCEPTEX": ffi.callback("LPFN_ACCEPTEX", self.AcceptEx),
+            "LPFN_CONNECTEX": ffi.callback("LPFN_CONNECTEX", self.ConnectEx)
+        }
+
+    def WSAGetLastError(self):
+        return self.ffi.last_error
+
+    def views(self, lpBuffers, dwBufferCount):
+        return [
+            self.ffi.buffer(lpBuffers[i].buf, lpBuffers[i].len)
+            for i in range(dwBufferCount)]
+
+    def defer(self, lpOverlapped, operation):
+        if self.pending and lpOverlapped != self.ffi.NULL:
+            self.deferred[int(self.ffi.cast("intptr_t", lpOverlapped))] = \
+                operation
+            return self.fail(self.WSA_IO_PENDING, self.SOCKET_ERROR)
+
+        try:
+            count = operation()
+        except OSError:
+            return self.fail(self.WSAECONNRESET, self.SOCKET_ERROR)
+        return count
+
+    def WSARecv(  # pylint: disable=too-many-arguments
+            self, s, lpBuffers, dwBufferCount, lpNumberOfBytesRecvd,
+            lpFlags, lpOverlapped, lpCompletionRoutine):
+        views = self.views(lpBuffers, dwBufferCount)
+        result = self.defer(
+            lpOverlapped, lambda: os.readv(int(s), views))
+        if result == self.SOCKET_ERROR:
+            return result
+        lpNumberOfBytesRecvd[0] = result
+        return 0
+
+    def WSASend(  # pylint: disable=too-many-arguments
+            self, s, lpBuffers, dwBufferCount, lpNumberOfBytesSent,
+            dwFlags, lpOverlapped, lpCompletionRoutine):
+        views = self.views(lpBuffers, dwBufferCount)
+        result = self.defer(
+            lpOverlapped, lambda: os.writev(int(s), views))
+        if result == self.SOCKET_ERROR:
+            return result
+        lpNumberOfBytesSent[0] = result
+        return 0
+
+    def WSAGetOverlappedResult(
+            self, s, lpOverlapped, lpcbTransfer, fWait, lpdwFlags):
+        key = int(self.ffi.cast("intptr_t", lpOverlapped))
+        lpcbTransfer[0] = self.deferred.pop(key)()
+        return 1
+
+    def WSAIoctl(  # pylint: disable=too-many-arguments
+            self, s, dwIoControlCode, lpvInBuffer, cbInBuffer, lpvOutBuffer,
+            cbOutBuffer, lpcbBytesReturned, lpOverlapped,
+            lpCompletionRoutine):
+        if dwIoControlCode != self.SIO_GET_EXTENSION_FUNCTION_POINTER or \
+                cbInBuffer != self.ffi.sizeof("GUID"):
+            return self.fail(self.WSAEINVAL, self.SOCKET_ERROR)
+
+        guid = self.ffi.cast("GUID *", lpvInBuffer)
+        for ctype, (data1, data2, data3, data4) in \
+                EXTENSION_FUNCTIONS.values():
+            if (guid.Data1, guid.Data2, guid.Data3, tuple(guid.Data4)) == \
+                    (data1, data2, data3, data4):
+                break
+        else:
+            return self.fail(self.WSAEINVAL, self.SOCKET_ERROR)
+
+        self.ioctls.append(ctype)
+        self.ffi.cast(ctype + " *", lpvOutBuffer)[0] = self.callbacks[ctype]
+        lpcbBytesReturned[0] = cbOutBuffer
+        return 0
+
+    def AcceptEx(  # pylint: disable=too-many-arguments
+            self, sListenSocket, sAcceptSocket, lpOutputBuffer,
+            dwReceiveDataLength, dwLocalAddressLength, dwRemoteAddressLength,
+            lpdwBytesReceived, lpOverlapped):
+        # Accepts the connection and moves it onto the descriptor of the
+        # accept socket.
+        listener = socket.fromfd(
+            int(sListenSocket), socket.AF_INET, socket.SOCK_STREAM)
+        connection, _ = listener.accept()
+        os.dup2(connection.fileno(), int(sAcceptSocket))
+        connection.close()
+        listener.close()
+        lpdwBytesReceived[0] = 0
+        return 1
+
+    def ConnectEx(  # pylint: disable=too-many-arguments
+            self, s, name, namelen, lpSendBuffer, dwSendDataLength,
+            lpdwBytesSent, lpOverlapped):
+        if self.pending:
+            return self.fail(self.WSA_IO_PENDING)
+
+        packed = self.ffi.buffer(name, namelen)[:]
+        family, = struct.unpack("<H", packed[:2])
+        port, = struct.unpack(">H", packed[2:4])
+        host = socket.inet_ntoa(packed[4:8])
+        sock = socket.fromfd(int(s), family, socket.SOCK_STREAM)
+        sock.connect((host, port))
+        sent = 0
+        if dwSendDataLength:
+            sent = sock.send(self.ffi.buffer(lpSendBuffer, dwSendDataLength))
+        sock.close()
+        lpdwBytesSent[0] = sent
+        return 1
+
+
+class SocketIOCase(TestCase):
+    """
+    Sets up :class:`SocketIOLibrary` and a pair of connected sockets.
+    """
+    def setUp(self):
+        super(SocketIOCase, self).setUp()
+        self.library = self.standin_library(SocketIOLibrary)
+        self.addCleanup(overlapped._extensions.clear)
+        overlapped._extensions.clear()
+
+        self.left, self.right = socket.socketpair()
+        self.addCleanup(self.left.close)
+        self.addCleanup(self.right.close)
+
+    def tcp_listener(self):
+        listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.addCleanup(listener.close)
+        listener.bind(("127.0.0.1", 0))
+        listener.listen(1)
+        return listener
+
+    def tcp_socket(self):
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.addCleanup(sock.close)
+        return sock
+
+
+class TestWSABufArray(SocketIOCase):
+    """
+    Tests for :class:`pywincffi.ws2_32.WSABufArray`
+    """
+    def test_assign(self):
+        data = bytearray(b"world")
+        buffers = WSABufArray([b"hello ", data])
+        self.assertEqual(len(buffers), 2)
+        self.assertEqual(buffers.nbytes, 11)
+
+        ffi = self.library.ffi
+        self.assertEqual(
+            ffi.buffer(buffers.lpBuffers[1].buf, 5)[:], b"world")
+        data[0:1] = b"W"
+        self.assertEqual(
+            ffi.buffer(buffers.lpBuffers[1].buf, 5)[:], b"World")
+
+    def test_grows(self):
+        buffers = WSABufArray(capacity=1)
+        buffers.assign([b"a", b"bc", b"def"])
+        self.assertEqual(buffers.capacity, 3)
+        self.assertEqual(buffers.nbytes, 6)
+
+    def test_consume(self):
+        buffers = WSABufArray([b"abc", b"", b"defg"])
+        buffers.consume(2)
+        self.assertEqual(len(buffers), 3)
+        self.assertEqual(buffers.nbytes, 5)
+
+        buffers.consume(1)
+        self.assertEqual(len(buffers), 1)
+        ffi = self.library.ffi
+        self.assertEqual(ffi.buffer(buffers.lpBuffers[0].buf, 4)[:], b"defg")
+
+        buffers.consume(4)
+        self.assertEqual(len(buffers), 0)
+        self.assertEqual(buffers.nbytes, 0)
+
+    def test_consume_too_much(self):
+        with self.assertRaises(InputError):
+            WSABufArray([b"abc"]).consume(4)
+
+
+class TestWSASendRecv(SocketIOCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.WSASend` and
+    :func:`pywincffi.ws2_32.WSARecv`
+    """
+    def test_gather_and_scatter(self):
+        sent = WSASend(
+            socket_from_object(self.left), [b"head", bytearray(b"er"), b"!"])
+        self.assertEqual(sent, 7)
+
+        first, second = bytearray(3), bytearray(10)
+        received = WSARecv(socket_from_object(self.right), [first, second])
+        self.assertEqual(received, 7)
+        self.assertEqual(bytes(first), b"hea")
+        self.assertEqual(bytes(second[:4]), b"der!")
+
+    def test_recv_rejects_bytes(self):
+        sock = socket_from_object(self.right)
+        with self.assertRaises(InputError):
+            WSARecv(sock, [bytearray(3), b"readonly"])
+        with self.assertRaises(InputError):
+            WSARecv(sock, WSABufArray([b"readonly"]))
+        self.assertFalse(WSABufArray([b"readonly"]).writable)
+        self.assertTrue(WSABufArray([bytearray(3)]).writable)
+
+    def test_resume_partial_send(self):
+        buffers = WSABufArray([b"abc", b"defgh"])
+        buffers.consume(4)
+        WSASend(socket_from_object(self.left), buffers)
+        self.assertEqual(self.right.recv(16), b"efgh")
+
+    def test_pending(self):
+        self.library.pending = True
+        lpOverlapped = OVERLAPPED()
+        self.left.sendall(b"later")
+
+        with SocketBufferPool(buffer_size=16).buffer() as buf:
+            sock = socket_from_object(self.right)
+            self.assertIsNone(
+                WSARecv(sock, buf.buffers, lpOverlapped=lpOverlapped))
+            self.assertEqual(self.library.ffi.last_error, 0)
+            count = WSAGetOverlappedResult(sock, lpOverlapped)
+            self.assertEqual(buf.data(count), b"later")
+
+    def test_error(self):
+        self.right.close()
+        sock = socket_from_object(self.left)
+        with self.assertRaises(WindowsAPIError) as error:
+            for _ in range(100):
+                WSASend(sock, [b"x" * 65536])
+        self.assertEqual(error.exception.errno, self.library.WSAECONNRESET)
+
+
+class TestExtensionFunctions(SocketIOCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.AcceptEx`,
+    :func:`pywincffi.ws2_32.ConnectEx` and the cache of extension function
+    pointers.
+    """
+    def test_looked_up_once(self):
+        sock = socket_from_object(self.left)
+        first = get_extension_function(sock, "AcceptEx")
+        second = get_extension_function(sock, "AcceptEx")
+        get_extension_function(sock, "ConnectEx")
+        self.assertEqual(first, second)
+        self.assertEqual(
+            self.library.ioctls, ["LPFN_ACCEPTEX", "LPFN_CONNECTEX"])
+
+    def test_unknown_function(self):
+        with self.assertRaises(InputError):
+            get_extension_function(socket_from_object(self.left), "Foo")
+
+    def test_accept_and_connect(self):
+        listener = self.tcp_listener()
+        client = self.tcp_socket()
+        client.bind(("127.0.0.1", 0))
+        accepted = self.tcp_socket()
+        pool = SocketBufferPool(buffer_size=128)
+
+        with pool.buffer() as buf:
+            sent = ConnectEx(
+                socket_from_object(client), socket.AF_INET,
+                listener.getsockname(), buf.lpOverlapped,
+                lpSendBuffer=b"hello")
+            self.assertEqual(sent, 5)
+
+        with pool.buffer() as buf:
+            received = AcceptEx(
+                socket_from_object(listener), socket_from_object(accepted),
+                buf.buffer, buf.lpOverlapped)
+            self.assertEqual(received, 0)
+
+        self.assertEqual(accepted.recv(16), b"hello")
+        self.assertEqual(pool.created, 1)
+        self.assertEqual(len(self.library.ioctls), 2)
+
+    def test_connect_pending(self):
+        self.library.pending = True
+        listener = self.tcp_listener()
+        client = self.tcp_socket()
+        self.assertIsNone(ConnectEx(
+            socket_from_object(client), socket.AF_INET,
+            listener.getsockname(), OVERLAPPED()))
+        self.assertEqual(self.library.ffi.last_error, 0)
+
+    def test_accept_buffer_too_small(self):
+        buf = self.library.ffi.new("char[]", 16)
+        with self.assertRaises(InputError):
+            AcceptEx(
+                socket_from_object(self.left), socket_from_object(self.right),
+                buf, OVERLAPPED())
+
+
+class TestSockaddr(TestCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.overlapped.sockaddr`
+    """
+    def test_inet(self):
+        packed = sockaddr(socket.AF_INET, ("127.0.0.1", 0x1234))
+        self.assertEqual(len(packed), 16)
+        self.assertEqual(packed[2:8], b"\x12\x34\x7f\x00\x00\x01")
+
+    def test_inet6(self):
+        packed = sockaddr(socket.AF_INET6, ("::1", 80))
+        self.assertEqual(len(packed), 28)
+        self.assertEqual(packed[2:4], b"\x00\x50")
+        self.assertEqual(packed[8:24], b"\x00" * 15 + b"\x01")
+
+    def test_unsupported_family(self):
+        with self.assertRaises(InputError):
+            sockaddr(-1, ("127.0.0.1", 80))
+
+
+class TestSocketBufferPool(SocketIOCase):
+    """
+    Tests for :class:`pywincffi.ws2_32.SocketBufferPool`
+    """
+    def test_reuses_buffers(self):
+        pool = SocketBufferPool(buffer_size=32)
+        first = pool.acquire()
+        first.buffers.consume(10)
+        first.lpOverlapped.Internal = 5
+        pool.release(first)
+
+        second = pool.acquire()
+        self.assertIs(second, first)
+        self.assertEqual(second.buffers.nbytes, 32)
+        self.assertEqual(second.lpOverlapped.Internal, 0)
+        self.assertEqual(pool.created, 1)
+
+    def test_maximum(self):
+        pool = SocketBufferPool(buffer_size=8, maximum=1)
+        buffers = [pool.acquire(), pool.acquire()]
+        for buf in buffers:
+            pool.release(buf)
+        self.assertEqual(len(pool), 1)
+        self.assertEqual(pool.created, 2)
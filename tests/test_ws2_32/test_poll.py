@@ -0,0 +1,236 @@
+import select
+import socket
+import time
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.wintypes import WSAEVENT, socket_from_object
+from pywincffi.ws2_32 import PollSet, WSAPoll, WSAWaitForMultipleEvents
+
+
+class PollLibrary(StandInLibrary):
+    """
+    Implements WSAPoll on top of :func:`select.poll` using the POSIX
+    values of the ``POLL*`` flags, and WSAWaitForMultipleEvents on a set
+    of signaled events.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        SOCKET_ERROR=-1,
+        WSAEINVAL=10022,
+        WSA_INFINITE=0xFFFFFFFF,
+        WSA_WAIT_EVENT_0=0,
+        WSA_WAIT_IO_COMPLETION=0xC0,
+        WSA_WAIT_TIMEOUT=0x102,
+        WSA_WAIT_FAILED=0xFFFFFFFF,
+        **dict(
+            (name, getattr(select, name)) for name in (
+                "POLLIN", "POLLPRI", "POLLOUT", "POLLERR", "POLLHUP",
+                "POLLNVAL", "POLLRDNORM", "POLLRDBAND", "POLLWRNORM",
+                "POLLWRBAND"))
+    )
+
+    def __init__(self, ffi):
+        super(PollLibrary, self).__init__(ffi)
+        self.polled = []
+        self.signaled = set()
+
+    def WSAGetLastError(self):
+        return self.ffi.last_error
+
+    def WSAPoll(self, fdArray, fds, timeout):
+        if fds == 0:
+            return self.fail(self.WSAEINVAL, self.SOCKET_ERROR)
+
+        poller = select.poll()
+        entries = {}
+        for i in range(fds):
+            entry = fdArray[i]
+            entry.revents = 0
+            poller.register(int(entry.fd), entry.events)
+            entries[int(entry.fd)] = entry
+
+        self.polled.append(sorted(entries))
+        ready = poller.poll(None if timeout < 0 else timeout)
+        for fd, revents in ready:
+            entries[fd].revents = revents
+        return len(ready)
+
+    def WSAWaitForMultipleEvents(
+            self, cEvents, lphEvents, fWaitAll, dwTimeout, fAlertable):
+        values = [self.fd(lphEvents[i]) for i in range(cEvents)]
+        if any(value < 0 for value in values):
+            return self.fail(self.WSAEINVAL, self.WSA_WAIT_FAILED)
+
+        signaled = [value in self.signaled for value in values]
+        if fWaitAll:
+            return self.WSA_WAIT_EVENT_0 if all(signaled) \
+                else self.WSA_WAIT_TIMEOUT
+        if any(signaled):
+            return self.WSA_WAIT_EVENT_0 + signaled.index(True)
+        return self.WSA_WAIT_TIMEOUT
+
+
+class PollCase(TestCase):
+    """
+    Sets up :class:`PollLibrary` and creates pairs of connected sockets.
+    """
+    def setUp(self):
+        super(PollCase, self).setUp()
+        self.library = self.standin_library(PollLibrary)
+
+    def socketpair(self):
+        left, right = socket.socketpair()
+        self.addCleanup(left.close)
+        self.addCleanup(right.close)
+        return left, right
+
+
+class TestWSAPoll(PollCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.WSAPoll`
+    """
+    def test_poll(self):
+        left, right = self.socketpair()
+        fdArray = self.library.ffi.new("WSAPOLLFD[]", 2)
+        fdArray[0].fd = left.fileno()
+        fdArray[0].events = self.library.POLLIN
+        fdArray[1].fd = right.fileno()
+        fdArray[1].events = self.library.POLLIN
+
+        self.assertEqual(WSAPoll(fdArray, timeout=0), 0)
+        left.send(b"x")
+        self.assertEqual(WSAPoll(fdArray, timeout=0), 1)
+        self.assertEqual(fdArray[0].revents, 0)
+        self.assertEqual(fdArray[1].revents, self.library.POLLIN)
+
+    def test_error(self):
+        with self.assertRaises(WindowsAPIError) as error:
+            WSAPoll(self.library.ffi.new("WSAPOLLFD[]", 1), fds=0)
+        self.assertEqual(error.exception.errno, self.library.WSAEINVAL)
+        self.assertEqual(
+            error.exception.error,
+            self.library.ffi.getwinerror(self.library.WSAEINVAL)[1])
+        self.library.SetLastError(0)
+
+
+class TestWSAWaitForMultipleEvents(PollCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.WSAWaitForMultipleEvents`
+    """
+    def event(self, value):
+        return WSAEVENT(self.library.handle(value))
+
+    def test_wait_any(self):
+        library = self.library
+        library.signaled.add(11)
+        events = [self.event(10), self.event(11)]
+        self.assertEqual(
+            WSAWaitForMultipleEvents(events), library.WSA_WAIT_EVENT_0 + 1)
+        self.assertEqual(
+            WSAWaitForMultipleEvents(events, fWaitAll=True, dwTimeout=0),
+            library.WSA_WAIT_TIMEOUT)
+
+    def test_failed(self):
+        with self.assertRaises(WindowsAPIError):
+            WSAWaitForMultipleEvents([self.event(-5)])
+        self.library.SetLastError(0)
+
+    def test_invalid_event(self):
+        with self.assertRaises(InputError):
+            WSAWaitForMultipleEvents([10])
+
+
+class TestPollSet(PollCase):
+    """
+    Tests for :class:`pywincffi.ws2_32.PollSet`
+    """
+    def register(self, poll_set, sock, events=None):
+        sock = socket_from_object(sock)
+        poll_set.register(
+            sock, self.library.POLLIN if events is None else events)
+        return sock
+
+    def test_poll(self):
+        poll_set = PollSet()
+        left, right = self.socketpair()
+        self.register(poll_set, left)
+        wrapped = self.register(poll_set, right)
+        self.assertEqual(poll_set.poll(0), [])
+
+        left.send(b"x")
+        self.assertEqual(
+            poll_set.poll(0), [(wrapped, self.library.POLLIN)])
+
+    def test_array_reused(self):
+        poll_set = PollSet()
+        left, _ = self.socketpair()
+        self.register(poll_set, left)
+        fds = poll_set._fds
+        for _ in range(3):
+            poll_set.poll(0)
+        self.assertIs(poll_set._fds, fds)
+
+    def test_grows(self):
+        poll_set = PollSet(capacity=1)
+        pairs = [self.socketpair() for _ in range(3)]
+        wrapped = [self.register(poll_set, right) for _, right in pairs]
+        self.assertEqual(poll_set.capacity, 4)
+
+        pairs[0][0].send(b"x")
+        pairs[2][0].send(b"x")
+        self.assertEqual(
+            [sock for sock, _ in poll_set.poll(0)],
+            [wrapped[0], wrapped[2]])
+
+    def test_modify(self):
+        poll_set = PollSet()
+        left, _ = self.socketpair()
+        wrapped = self.register(poll_set, left)
+        self.assertEqual(poll_set.poll(0), [])
+        poll_set.modify(wrapped, self.library.POLLOUT)
+        self.assertEqual(poll_set.poll(0), [(wrapped, self.library.POLLOUT)])
+
+    def test_unregister_moves_last_socket(self):
+        poll_set = PollSet()
+        pairs = [self.socketpair() for _ in range(3)]
+        wrapped = [self.register(poll_set, right) for _, right in pairs]
+
+        poll_set.unregister(wrapped[0])
+        self.assertEqual(len(poll_set), 2)
+        poll_set.poll(0)
+        self.assertEqual(
+            self.library.polled[-1],
+            sorted(right.fileno() for _, right in pairs[1:]))
+
+        pairs[2][0].send(b"x")
+        self.assertEqual(
+            poll_set.poll(0), [(wrapped[2], self.library.POLLIN)])
+        poll_set.modify(wrapped[2], self.library.POLLOUT)
+        poll_set.unregister(wrapped[1])
+        self.assertEqual(
+            poll_set.poll(0), [(wrapped[2], self.library.POLLOUT)])
+
+    def test_empty_sleeps_for_timeout(self):
+        start = time.time()
+        self.assertEqual(PollSet().poll(50), [])
+        self.assertGreaterEqual(time.time() - start, 0.04)
+        self.assertEqual(PollSet().poll(0), [])
+        self.assertEqual(self.library.polled, [])
+
+    def test_empty_without_timeout(self):
+        for timeout in (None, -1):
+            with self.assertRaises(InputError):
+                PollSet().poll(timeout)
+
+    def test_register_twice(self):
+        poll_set = PollSet()
+        left, _ = self.socketpair()
+        self.register(poll_set, left)
+        with self.assertRaises(InputError):
+            self.register(poll_set, left)
+
+    def test_unregister_unknown(self):
+        left, _ = self.socketpair()
+        with self.assertRaises(InputError):
+            PollSet().unregister(socket_from_object(left))
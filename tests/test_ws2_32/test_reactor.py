@@ -0,0 +1,298 @@
+import time
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.wintypes import LPWSANETWORKEVENTS, SOCKET, wintype_to_cdata
+from pywincffi.ws2_32 import (
+    SocketReactor, WSAEnumNetworkEvents, decode_network_events)
+
+FD_BITS = dict(
+    FD_READ_BIT=0, FD_WRITE_BIT=1, FD_OOB_BIT=2, FD_ACCEPT_BIT=3,
+    FD_CONNECT_BIT=4, FD_CLOSE_BIT=5)
+
+
+class NetworkEventLibrary(StandInLibrary):
+    """
+    Simulates sockets selected with WSAEventSelect.  Tests call
+    :meth:`network_event` to make an event occur, which signals the
+    socket's event object until WSAEnumNetworkEvents collects it.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        # Groups of four sockets keep the tests small
+        MAXIMUM_WAIT_OBJECTS=5,
+        SOCKET_ERROR=-1,
+        WSAENOTSOCK=10038,
+        WSAECONNRESET=10054,
+        QS_ALLINPUT=0x04FF,
+        FD_READ=1 << FD_BITS["FD_READ_BIT"],
+        FD_WRITE=1 << FD_BITS["FD_WRITE_BIT"],
+        FD_OOB=1 << FD_BITS["FD_OOB_BIT"],
+        FD_ACCEPT=1 << FD_BITS["FD_ACCEPT_BIT"],
+        FD_CONNECT=1 << FD_BITS["FD_CONNECT_BIT"],
+        FD_CLOSE=1 << FD_BITS["FD_CLOSE_BIT"],
+        **FD_BITS
+    )
+
+    def __init__(self, ffi):
+        super(NetworkEventLibrary, self).__init__(ffi)
+        self.next_event = 1000
+        self.selected = {}
+        self.invalid = set()
+        self.pending = {}
+        self.signaled = set()
+        self.closed = []
+        self.waits = []
+        self.input = False
+
+    def socket(self, value):
+        socket = SOCKET()
+        socket._cdata[0] = self.ffi.cast("SOCKET", value)
+        return socket
+
+    def network_event(self, value, event, error=0):
+        events, errors = self.pending.setdefault(value, [0, {}])
+        self.pending[value][0] = events | event
+        errors[event] = error
+        hEvent, selected = self.selected[value]
+        if selected & event:
+            self.signaled.add(hEvent)
+
+    def WSAGetLastError(self):
+        return self.ffi.last_error
+
+    def WSACreateEvent(self):
+        self.next_event += 1
+        return self.handle(self.next_event)
+
+    def wsa_invalid_event(self, event):
+        return False
+
+    def CloseHandle(self, hObject):
+        self.closed.append(self.fd(hObject))
+        return 1
+
+    def WSAEventSelect(self, s, hEventObject, lNetworkEvents):
+        if int(s) in self.invalid:
+            return self.fail(self.WSAENOTSOCK, self.SOCKET_ERROR)
+        self.selected[int(s)] = (self.fd(hEventObject), int(lNetworkEvents))
+        return 0
+
+    def WSAEnumNetworkEvents(self, s, hEventObject, lpNetworkEvents):
+        hEvent, selected = self.selected[int(s)]
+        assert self.fd(hEventObject) == hEvent
+        self.signaled.discard(hEvent)
+        events, errors = self.pending.pop(int(s), [0, {}])
+        lpNetworkEvents.lNetworkEvents = events & selected
+        for event, error in errors.items():
+            bit = event.bit_length() - 1
+            lpNetworkEvents.iErrorCode[bit] = error
+        return 0
+
+    def MsgWaitForMultipleObjects(
+            self, nCount, pHandles, bWaitAll, dwMilliseconds, dwWakeMask):
+        self.waits.append((int(nCount), int(dwMilliseconds)))
+        if nCount > self.MAXIMUM_WAIT_OBJECTS - 1:
+            return self.fail(self.ERROR_INVALID_PARAMETER, self.WAIT_FAILED)
+        for i in range(nCount):
+            if self.fd(pHandles[i]) in self.signaled:
+                return self.WAIT_OBJECT_0 + i
+        if self.input and dwWakeMask:
+            return self.WAIT_OBJECT_0 + nCount
+        assert dwMilliseconds != self.INFINITE, "nothing would wake the wait"
+        time.sleep(dwMilliseconds / 1000.0)
+        return self.WAIT_TIMEOUT
+
+
+class ReactorCase(TestCase):
+    """
+    Sets up :class:`NetworkEventLibrary` and a :class:`SocketReactor`
+    which records every callback.
+    """
+    def setUp(self):
+        super(ReactorCase, self).setUp()
+        self.library = self.standin_library(NetworkEventLibrary)
+        self.reactor = SocketReactor()
+        self.addCleanup(self.reactor.close)
+        self.events = []
+
+    def callback(self, socket, event, error):
+        self.events.append((int(socket._cdata[0]), event, error))
+
+    def register(self, value, events=None):
+        socket = self.library.socket(value)
+        if events is None:
+            events = self.library.FD_READ | self.library.FD_CLOSE
+        self.reactor.register(socket, events, self.callback)
+        return socket
+
+
+class TestDecodeNetworkEvents(ReactorCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.decode_network_events`
+    """
+    def test_decode(self):
+        library = self.library
+        events = LPWSANETWORKEVENTS()
+        events.lNetworkEvents = library.FD_CLOSE | library.FD_READ
+        wintype_to_cdata(events).iErrorCode[library.FD_CLOSE_BIT] = \
+            library.WSAECONNRESET
+        self.assertEqual(decode_network_events(events), [
+            (library.FD_READ, 0), (library.FD_CLOSE, library.WSAECONNRESET)])
+
+    def test_nothing_set(self):
+        self.assertEqual(decode_network_events(LPWSANETWORKEVENTS()), [])
+
+
+class TestWSAEnumNetworkEvents(ReactorCase):
+    """
+    Tests for :func:`pywincffi.ws2_32.WSAEnumNetworkEvents`
+    """
+    def test_reuses_structure(self):
+        socket = self.register(5)
+        registration = self.reactor._get(socket)
+        self.library.network_event(5, self.library.FD_READ)
+        lpNetworkEvents = LPWSANETWORKEVENTS()
+        result = WSAEnumNetworkEvents(
+            socket, registration.event, lpNetworkEvents=lpNetworkEvents)
+        self.assertIs(result, lpNetworkEvents)
+        self.assertEqual(result.lNetworkEvents, self.library.FD_READ)
+
+
+class TestSocketReactor(ReactorCase):
+    """
+    Tests for :class:`pywincffi.ws2_32.SocketReactor`
+    """
+    def test_dispatch(self):
+        library = self.library
+        self.register(5)
+        self.register(6, library.FD_ACCEPT)
+        library.network_event(5, library.FD_CLOSE, library.WSAECONNRESET)
+        library.network_event(5, library.FD_READ)
+        library.network_event(6, library.FD_ACCEPT)
+
+        self.assertEqual(self.reactor.poll(0), 3)
+        self.assertEqual(self.events, [
+            (5, library.FD_READ, 0),
+            (5, library.FD_CLOSE, library.WSAECONNRESET),
+            (6, library.FD_ACCEPT, 0)])
+        self.assertEqual(library.signaled, set())
+
+    def test_unselected_events_are_not_dispatched(self):
+        self.register(5)
+        self.library.network_event(5, self.library.FD_WRITE)
+        self.assertEqual(self.reactor.poll(0), 0)
+
+    def test_structure_reused_per_socket(self):
+        socket = self.register(5)
+        lpNetworkEvents = self.reactor._get(socket).lpNetworkEvents
+        for _ in range(3):
+            self.library.network_event(5, self.library.FD_READ)
+            self.reactor.poll(0)
+        self.assertIs(
+            self.reactor._get(socket).lpNetworkEvents, lpNetworkEvents)
+        self.assertEqual(len(self.events), 3)
+
+    def test_groups(self):
+        library = self.library
+        for value in range(10):
+            self.register(value)
+        self.assertEqual(len(self.reactor._groups), 3)
+
+        for value in (1, 3, 4, 9):
+            library.network_event(value, library.FD_READ)
+        self.assertEqual(self.reactor.poll(0), 4)
+        self.assertEqual(
+            [value for value, _, _ in self.events], [1, 3, 4, 9])
+
+    def test_maximum_wait_objects(self):
+        library = self.library
+        library.CONSTANTS = dict(library.CONSTANTS, MAXIMUM_WAIT_OBJECTS=64)
+        self.reactor = SocketReactor()
+        self.addCleanup(self.reactor.close)
+        for value in range(64):
+            self.register(value)
+        self.assertEqual(
+            [len(group.registrations) for group in self.reactor._groups],
+            [63, 1])
+
+        library.network_event(62, library.FD_READ)
+        library.network_event(63, library.FD_READ)
+        self.assertEqual(self.reactor.poll(0), 2)
+        self.assertEqual([value for value, _, _ in self.events], [62, 63])
+        self.assertLessEqual(max(count for count, _ in library.waits), 63)
+
+    def test_timeout_waits_in_slices(self):
+        for value in range(5):
+            self.register(value)
+        del self.library.waits[:]
+        self.assertEqual(self.reactor.poll(25), 0)
+        self.assertTrue(all(
+            milliseconds <= self.reactor.slice_ms
+            for _, milliseconds in self.library.waits))
+
+    def test_single_group_waits_for_whole_timeout(self):
+        self.register(5)
+        self.assertEqual(self.reactor.poll(30), 0)
+        self.assertGreater(
+            max(milliseconds for _, milliseconds in self.library.waits),
+            self.reactor.slice_ms)
+
+    def test_unregister_keeps_groups_packed(self):
+        sockets = [self.register(value) for value in range(6)]
+        self.reactor.unregister(sockets[1])
+        self.assertEqual(len(self.reactor), 5)
+        self.assertEqual(len(self.reactor._groups), 2)
+        self.reactor.unregister(sockets[0])
+        self.assertEqual(len(self.reactor._groups), 1)
+
+        for value in (2, 3, 4, 5):
+            self.library.network_event(value, self.library.FD_READ)
+        self.assertEqual(self.reactor.poll(0), 4)
+        self.assertEqual(
+            sorted(value for value, _, _ in self.events), [2, 3, 4, 5])
+        self.assertEqual(self.library.selected[1][1], 0)
+        self.assertEqual(len(self.library.closed), 2)
+
+    def test_callback_unregisters_other_socket(self):
+        library = self.library
+        self.register(5)
+        other = self.register(6)
+
+        def callback(socket, event, error):
+            self.events.append(int(socket._cdata[0]))
+            self.reactor.unregister(other)
+
+        self.reactor.modify(self.library.socket(5), library.FD_READ, callback)
+        library.network_event(5, library.FD_READ)
+        library.network_event(6, library.FD_READ)
+        self.assertEqual(self.reactor.poll(0), 1)
+        self.assertEqual(self.events, [5])
+
+    def test_wake_mask(self):
+        reactor = SocketReactor(dwWakeMask=self.library.QS_ALLINPUT)
+        self.library.input = True
+        self.assertEqual(reactor.poll(), 0)
+
+    def test_nothing_registered(self):
+        with self.assertRaises(InputError):
+            self.reactor.poll()
+        self.assertEqual(self.reactor.poll(10), 0)
+        self.assertEqual([nCount for nCount, _ in self.library.waits], [0])
+
+    def test_register_twice(self):
+        self.register(5)
+        with self.assertRaises(InputError):
+            self.register(5)
+
+    def test_register_failure_closes_event(self):
+        self.library.invalid.add(5)
+        with self.assertRaises(WindowsAPIError):
+            self.register(5)
+        self.assertEqual(len(self.library.closed), 1)
+        self.assertEqual(len(self.reactor), 0)
+        self.library.SetLastError(0)
+
+    def test_unregister_unknown(self):
+        with self.assertRaises(InputError):
+            self.reactor.unregister(self.library.socket(5))
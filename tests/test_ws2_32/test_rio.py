@@ -0,0 +1,386 @@
+import socket
+from collections import deque
+
+from pywincffi.dev.testutil import TestCase, StandInLibrary
+from pywincffi.exceptions import InputError, WindowsAPIError
+from pywincffi.wintypes import socket_from_object
+from pywincffi.ws2_32 import BufferSlab, RIOEngine, get_rio_functions
+from pywincffi.ws2_32 import rio
+
+
+class RIOLibrary(StandInLibrary):
+    """
+    Implements the RIO function table with Python callbacks.  Completion
+    queues are lists of results and a request queue's receives are
+    satisfied, when completions are dequeued, by reading datagrams from
+    its socket without blocking.  Sends are written to the socket as soon
+    as they're committed.
+    """
+    CONSTANTS = dict(
+        StandInLibrary.CONSTANTS,
+        SOCKET_ERROR=-1,
+        WSAEINVAL=10022,
+        WSAENOBUFS=10055,
+        SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER=0xC8000024,
+        RIO_CORRUPT_CQ=0xFFFFFFFF,
+        RIO_MSG_DONT_NOTIFY=0x1,
+        RIO_MSG_DEFER=0x2,
+        RIO_MSG_WAITALL=0x4,
+        RIO_MSG_COMMIT_ONLY=0x8,
+        PAGE_READWRITE=0x04,
+        MEM_COMMIT=0x1000,
+        MEM_RESERVE=0x2000,
+        MEM_RELEASE=0x8000
+    )
+
+    FUNCTIONS = (
+        ("RIOReceive", "LPFN_RIORECEIVE"),
+        ("RIOSend", "LPFN_RIOSEND"),
+        ("RIOCloseCompletionQueue", "LPFN_RIOCLOSECOMPLETIONQUEUE"),
+        ("RIOCreateCompletionQueue", "LPFN_RIOCREATECOMPLETIONQUEUE"),
+        ("RIOCreateRequestQueue", "LPFN_RIOCREATEREQUESTQUEUE"),
+        ("RIODequeueCompletion", "LPFN_RIODEQUEUECOMPLETION"),
+        ("RIODeregisterBuffer", "LPFN_RIODEREGISTERBUFFER"),
+        ("RIONotify", "LPFN_RIONOTIFY"),
+        ("RIORegisterBuffer", "LPFN_RIOREGISTERBUFFER"),
+    )
+
+    def __init__(self, ffi):
+        super(RIOLibrary, self).__init__(ffi)
+        self.ioctls = 0
+        self.buffers = {}
+        self.queues = {}
+        self.requests = {}
+        self.calls = []
+        self.allocations = {}
+        self.send_error = None
+        self.receive_error = None
+        self.callbacks = dict(
+            (name, ffi.callback(ctype, getattr(self, "rio_" + name)))
+            for name, ctype in self.FUNCTIONS)
+
+    def WSAGetLastError(self):
+        return self.ffi.last_error
+
+    def key(self, value):
+        return int(self.ffi.cast("uintptr_t", value))
+
+    def WSAIoctl(  # pylint: disable=too-many-arguments
+            self, s, dwIoControlCode, lpvInBuffer, cbInBuffer, lpvOutBuffer,
+            cbOutBuffer, lpcbBytesReturned, lpOverlapped,
+            lpCompletionRoutine):
+        guid = self.ffi.cast("GUID *", lpvInBuffer)
+        if dwIoControlCode != \
+                self.SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER or \
+                guid.Data1 != rio.WSAID_MULTIPLE_RIO[0]:
+            return self.fail(self.WSAEINVAL, self.SOCKET_ERROR)
+
+        self.ioctls += 1
+        table = self.ffi.cast("RIO_EXTENSION_FUNCTION_TABLE *", lpvOutBuffer)
+        assert table.cbSize == cbOutBuffer
+        for name, _ in self.FUNCTIONS:
+            setattr(table, name, self.callbacks[name])
+        return 0
+
+    def VirtualAlloc(self, lpAddress, dwSize, flAllocationType, flProtect):
+        memory_ = self.ffi.new("char[]", int(dwSize))
+        self.allocations[self.key(memory_)] = memory_
+        return self.ffi.cast("LPVOID", memory_)
+
+    def VirtualFree(self, lpAddress, dwSize, dwFreeType):
+        del self.allocations[self.key(lpAddress)]
+        return 1
+
+    def rio_RIORegisterBuffer(self, DataBuffer, DataLength):
+        key = len(self.buffers) + 1
+        self.buffers[key] = (DataBuffer, DataLength)
+        return self.ffi.cast("RIO_BUFFERID", key)
+
+    def rio_RIODeregisterBuffer(self, BufferId):
+        del self.buffers[self.key(BufferId)]
+
+    def rio_RIOCreateCompletionQueue(self, QueueSize, NotificationCompletion):
+        key = len(self.queues) + 1
+        self.queues[key] = deque()
+        return self.ffi.cast("RIO_CQ", key)
+
+    def rio_RIOCloseCompletionQueue(self, CQ):
+        del self.queues[self.key(CQ)]
+
+    def rio_RIOCreateRequestQueue(  # pylint: disable=too-many-arguments
+            self, Socket, MaxOutstandingReceive, MaxReceiveDataBuffers,
+            MaxOutstandingSend, MaxSendDataBuffers, ReceiveCQ, SendCQ,
+            SocketContext):
+        sock = socket.fromfd(int(Socket), socket.AF_UNIX, socket.SOCK_DGRAM)
+        sock.setblocking(False)
+        key = len(self.requests) + 1
+        self.requests[key] = {
+            "socket": sock, "receives": deque(), "sends": deque(),
+            "cq": self.key(ReceiveCQ)}
+        return self.ffi.cast("RIO_RQ", key)
+
+    def region(self, pData):
+        base, _ = self.buffers[self.key(pData.BufferId)]
+        return self.ffi.buffer(base + pData.Offset, pData.Length)
+
+    def rio_RIOReceive(  # pylint: disable=too-many-arguments
+            self, SocketQueue, pData, DataBufferCount, Flags,
+            RequestContext):
+        self.calls.append(("receive", DataBufferCount, Flags))
+        if self.receive_error is not None:
+            return self.fail(self.receive_error)
+        request = self.requests[self.key(SocketQueue)]
+        if DataBufferCount:
+            request["receives"].append(
+                (self.region(pData), self.key(RequestContext)))
+        return 1
+
+    def rio_RIOSend(  # pylint: disable=too-many-arguments
+            self, SocketQueue, pData, DataBufferCount, Flags,
+            RequestContext):
+        self.calls.append(("send", DataBufferCount, Flags))
+        if self.send_error is not None:
+            return self.fail(self.send_error)
+        request = self.requests[self.key(SocketQueue)]
+        if DataBufferCount:
+            request["sends"].append(
+                (self.region(pData)[:], self.key(RequestContext)))
+        if Flags & self.RIO_MSG_DEFER:
+            return 1
+
+        queue = self.queues[request["cq"]]
+        while request["sends"]:
+            data, context = request["sends"].popleft()
+            queue.append((0, request["socket"].send(data), context))
+        return 1
+
+    def rio_RIODequeueCompletion(self, CQ, Array, ArraySize):
+        queue = self.queues[self.key(CQ)]
+        for request in self.requests.values():
+            receives = request["receives"]
+            while receives:
+                try:
+                    count = request["socket"].recv_into(receives[0][0])
+                except (IOError, OSError):
+                    break
+                queue.append((0, count, receives.popleft()[1]))
+
+        count = 0
+        while queue and count < ArraySize:
+            status, transferred, context = queue.popleft()
+            Array[count].Status = status
+            Array[count].BytesTransferred = transferred
+            Array[count].RequestContext = context
+            count += 1
+        return count
+
+    def rio_RIONotify(self, CQ):
+        return 0
+
+
+class RIOCase(TestCase):
+    """
+    Sets up :class:`RIOLibrary` and a pair of connected datagram sockets.
+    """
+    def setUp(self):
+        super(RIOCase, self).setUp()
+        self.library = self.standin_library(RIOLibrary)
+        self.addCleanup(setattr, rio, "_functions", None)
+        rio._functions = None
+
+        self.local, self.remote = socket.socketpair(
+            socket.AF_UNIX, socket.SOCK_DGRAM)
+        self.addCleanup(self.local.close)
+        self.addCleanup(self.remote.close)
+        self.remote.settimeout(5)
+        self.addCleanup(self.close_requests)
+
+    def close_requests(self):
+        for request in self.library.requests.values():
+            request["socket"].close()
+
+    def create_engine(self, **kwargs):
+        engine = RIOEngine(socket_from_object(self.local), **kwargs)
+        self.addCleanup(engine.close)
+        return engine
+
+
+class TestBufferSlab(RIOCase):
+    """
+    Tests for :class:`pywincffi.ws2_32.BufferSlab`
+    """
+    def test_slices(self):
+        slab = BufferSlab(100, 4)
+        self.assertEqual(len(slab), 4)
+        indexes = [slab.acquire() for _ in range(4)]
+        self.assertEqual(indexes, [0, 1, 2, 3])
+        self.assertIsNone(slab.acquire())
+        self.assertEqual(
+            [slab.rio_buf(i).Offset for i in indexes], [0, 100, 200, 300])
+
+        slab.release(2)
+        self.assertEqual(slab.acquire(), 2)
+
+    def test_write_and_read(self):
+        slab = BufferSlab(8, 2)
+        index = slab.acquire()
+        slab.write(1, b"abc")
+        self.assertEqual(slab.rio_buf(1).Length, 3)
+        self.assertEqual(slab.read(1, 3), b"abc")
+        self.assertEqual(slab.read(index, 1), b"\x00")
+
+        with self.assertRaises(InputError):
+            slab.write(0, b"x" * 9)
+
+    def test_acquire_resets_length(self):
+        slab = BufferSlab(8, 1)
+        index = slab.acquire()
+        slab.write(index, b"a")
+        slab.release(index)
+        self.assertEqual(slab.rio_buf(slab.acquire()).Length, 8)
+
+    def test_release_twice(self):
+        slab = BufferSlab(8, 2)
+        index = slab.acquire()
+        slab.release(index)
+        with self.assertRaises(InputError):
+            slab.release(index)
+        with self.assertRaises(InputError):
+            slab.release(5)
+
+    def test_register(self):
+        slab = BufferSlab(8, 3)
+        get_rio_functions(socket_from_object(self.local))
+        slab.register()
+        self.assertEqual(len(self.library.buffers), 1)
+        self.assertEqual(
+            set(self.library.key(slab.rio_buf(i).BufferId)
+                for i in range(3)), set(self.library.buffers))
+
+        slab.deregister()
+        self.assertEqual(self.library.buffers, {})
+
+
+class TestRIOEngine(RIOCase):
+    """
+    Tests for :class:`pywincffi.ws2_32.RIOEngine`
+    """
+    def test_function_table_looked_up_once(self):
+        self.create_engine()
+        self.create_engine()
+        self.assertEqual(self.library.ioctls, 1)
+
+    def test_requires_socket_first(self):
+        with self.assertRaises(InputError):
+            get_rio_functions()
+
+    def test_receives_posted_in_one_batch(self):
+        self.create_engine(receives=8)
+        self.assertEqual(len(self.library.calls), 8)
+        flags = [call[2] for call in self.library.calls]
+        self.assertEqual(flags, [self.library.RIO_MSG_DEFER] * 7 + [0])
+
+    def test_dequeue_in_batches(self):
+        engine = self.create_engine(receives=16, batch=4)
+        for i in range(10):
+            self.remote.send(b"datagram %d" % i)
+
+        sizes = []
+        received = []
+        while True:
+            completions = engine.dequeue()
+            if not completions:
+                break
+            sizes.append(len(completions))
+            received.extend(completion.data for completion in completions)
+
+        self.assertEqual(sizes, [4, 4, 2])
+        self.assertEqual(received, [b"datagram %d" % i for i in range(10)])
+        self.assertEqual(engine.batches, 3)
+        self.assertEqual(engine.completions, 10)
+
+    def test_receives_are_reposted(self):
+        engine = self.create_engine(receives=2, batch=8)
+        for round_ in range(3):
+            for i in range(2):
+                self.remote.send(b"%d-%d" % (round_, i))
+            self.assertEqual(
+                [completion.data for completion in engine.dequeue()],
+                [b"%d-0" % round_, b"%d-1" % round_])
+        self.assertEqual(len(engine.slab), engine.slab.count - 2)
+
+    def test_send(self):
+        engine = self.create_engine(receives=1, sends=2)
+        self.assertTrue(engine.send(b"hello"))
+        self.assertEqual(self.remote.recv(16), b"hello")
+        self.assertEqual(
+            engine.dequeue(),
+            [rio.RIOCompletion(RIOEngine.SEND, 0, 5)])
+        self.assertEqual(len(engine.slab), 2)
+
+    def test_send_limit(self):
+        engine = self.create_engine(receives=1, sends=2)
+        self.assertTrue(engine.send(b"a"))
+        self.assertTrue(engine.send(b"b"))
+        self.assertFalse(engine.send(b"c"))
+        engine.dequeue()
+        self.assertTrue(engine.send(b"c"))
+
+    def test_send_failure_frees_slice(self):
+        engine = self.create_engine(receives=1, sends=2)
+        free = len(engine.slab)
+        self.library.send_error = self.library.WSAENOBUFS
+        with self.assertRaises(WindowsAPIError):
+            engine.send(b"hello")
+        self.assertEqual(len(engine.slab), free)
+
+        self.library.send_error = None
+        self.assertTrue(engine.send(b"hello"))
+        self.assertTrue(engine.send(b"world"))
+        self.assertEqual(self.remote.recv(16), b"hello")
+
+    def test_deferred_sends(self):
+        engine = self.create_engine(receives=1, sends=4)
+        engine.send(b"a", defer=True)
+        engine.send(b"b", defer=True)
+        self.remote.settimeout(0)
+        with self.assertRaises((IOError, OSError)):
+            self.remote.recv(16)
+
+        engine.commit()
+        self.assertEqual(self.remote.recv(16), b"a")
+        self.assertEqual(self.remote.recv(16), b"b")
+        self.assertEqual(
+            self.library.calls[-1],
+            ("send", 0, self.library.RIO_MSG_COMMIT_ONLY))
+
+    def test_repost_failure_frees_slices(self):
+        engine = self.create_engine(receives=2, sends=1, batch=8)
+        self.remote.send(b"a")
+        self.remote.send(b"b")
+        self.library.receive_error = self.library.WSAENOBUFS
+        with self.assertRaises(WindowsAPIError):
+            engine.dequeue()
+        self.assertEqual(len(engine.slab), engine.slab.count)
+        self.library.SetLastError(0)
+
+    def test_close(self):
+        engine = RIOEngine(socket_from_object(self.local))
+        engine.close()
+        self.assertEqual(self.library.buffers, {})
+        self.assertEqual(self.library.queues, {})
+        self.assertEqual(self.library.allocations, {})
+        engine.slab.close()
+
+    def test_register_failure(self):
+        ffi = self.library.ffi
+        table = get_rio_functions(socket_from_object(self.local))
+        callback = ffi.callback(
+            "LPFN_RIOREGISTERBUFFER",
+            lambda DataBuffer, DataLength: ffi.cast(
+                "RIO_BUFFERID",
+                self.library.fail(self.library.WSAENOBUFS, 0xFFFFFFFF)))
+        table.RIORegisterBuffer = callback
+        with self.assertRaises(WindowsAPIError) as error:
+            BufferSlab(8, 1).register()
+        self.assertEqual(error.exception.errno, self.library.WSAENOBUFS)